@@ -1,5 +1,7 @@
 #include <iostream>
 #include <cstdlib>
+#include <cstdio>
+#include <cstring>
 #include <GL/glew.h>
 #include <IL/il.h>
 
@@ -26,10 +28,8 @@ void GLFWCALL windowResize(int width, int height)
 	wWidth = width;
 	wHeight = height;
 
-	try {
-		g_pRenderer->initViewport(0, 0, width, height);
-	}
-	catch(Error e) { e.showError(); }
+	// the viewport is set by the render stage
+	g_bWindowResized = true;
 }
 
 /**
@@ -63,6 +63,7 @@ void GLFWCALL draw()
 		g_pRenderer->render();
 		if( g_bDisplayHelp )
 			g_pHelpHud->draw();
+		g_pPerformanceHud->draw( wWidth, wHeight );
 	}
 	catch(Error e) { e.showError(); }
 }
@@ -74,43 +75,61 @@ bool createApplication()
 {
 	srand(time(NULL));
 
-	glfwInit();
-	// Open window
-	int iErr = glfwOpenWindow(	wWidth, wHeight,   // Width and height of window
-								8, 8, 8,           // Number of red, green, and blue bits for color buffer
-								8,                 // Number of bits for alpha buffer
-								24,                // Number of bits for depth buffer (Z-buffer)
-								0,                 // Number of bits for stencil buffer
-								GLFW_WINDOW        // We want a desktop window (could be GLFW_FULLSCREEN)
-							 );
-	if( !iErr )
+	if( g_bHeadless )
 	{
-		glfwTerminate();
-		return false;
+		// GLFW still provides the threads and the timer
+		if( glfwInit() != GL_TRUE )
+		{
+			cout << "Error! failed to initialize GLFW, it needs a display connection even in headless mode (use xvfb-run)" << endl;
+			return false;
+		}
+
+		try {
+			g_pHeadlessContext = new HeadlessContext( wWidth, wHeight );
+		}
+		catch(Error e)
+		{
+			e.showError();
+			glfwTerminate();
+			return false;
+		}
 	}
+	else
+	{
+		glfwInit();
+		// Open window
+		int iErr = glfwOpenWindow(	wWidth, wHeight,   // Width and height of window
+									8, 8, 8,           // Number of red, green, and blue bits for color buffer
+									8,                 // Number of bits for alpha buffer
+									24,                // Number of bits for depth buffer (Z-buffer)
+									0,                 // Number of bits for stencil buffer
+									GLFW_WINDOW        // We want a desktop window (could be GLFW_FULLSCREEN)
+								 );
+		if( !iErr )
+		{
+			glfwTerminate();
+			return false;
+		}
 
-	glfwSetWindowTitle( "HDRR demo" );
+		glfwSetWindowTitle( "HDRR demo" );
 
-	glfwEnable( GLFW_STICKY_KEYS );
-	glfwEnable( GLFW_KEY_REPEAT );
+		glfwEnable( GLFW_STICKY_KEYS );
+		glfwEnable( GLFW_KEY_REPEAT );
+	}
 
 	g_pScene1Desc = new SceneDesc;
 	g_pScene2Desc = new SceneDesc;
 	g_pScene3Desc = new SceneDesc;
 
-	g_pScene1Desc->oSceneNeedUpdateLock = glfwCreateMutex();
-	g_pScene2Desc->oSceneNeedUpdateLock = glfwCreateMutex();
-	g_pScene3Desc->oSceneNeedUpdateLock = glfwCreateMutex();
-
-	if( g_pScene1Desc->oSceneNeedUpdateLock == NULL || 
-		g_pScene2Desc->oSceneNeedUpdateLock == NULL || 
-		g_pScene3Desc->oSceneNeedUpdateLock == NULL )
-		return false;
+	g_pSceneDescArray[ 0 ] = g_pScene1Desc;
+	g_pSceneDescArray[ 1 ] = g_pScene2Desc;
+	g_pSceneDescArray[ 2 ] = g_pScene3Desc;
 
 	g_pCurrentSceneDesc = g_pScene1Desc;
 
 	// Glew init for the use of OpenGL extensions
-	if( glewInit() != GLEW_OK )
+	// GLEW builds without EGL support fail to load their GLX entry points with an EGL context, after the OpenGL ones
+	if( glewInit() != GLEW_OK && !( g_pHeadlessContext != NULL && GLEW_VERSION_2_0 ) )
 		return false;
 
 	// Check if hardware is able to run the demo
@@ -144,11 +163,29 @@ bool createApplication()
 		cout << "Error! Float textures not supported on current hardware" << endl;
 		return false;
 	}
+	if( sExtentions.find( "GL_ARB_half_float_pixel" ) == string::npos )
+	{
+		cout << "Error! Half float pixel uploads not supported on current hardware" << endl;
+		return false;
+	}
+	if( sExtentions.find( "GL_ARB_texture_compression_bptc" ) == string::npos )
+		cout << "Warning! BC6H textures not supported on current hardware, environment maps are loaded uncompressed" << endl;
 
-	// DevIL init
-	ilInit();
-	ilEnable( IL_ORIGIN_SET );
-	ilSetInteger( IL_ORIGIN_MODE, IL_ORIGIN_UPPER_LEFT );
+	// DevIL init, before the streaming threads use it
+	initDevIL();
+
+	// the frames are rendered to a texture instead of the window framebuffer
+	if( g_pHeadlessContext != NULL )
+	{
+		try {
+			g_pHeadlessContext->initRenderTarget();
+		}
+		catch(Error e)
+		{
+			e.showError();
+			return false;
+		}
+	}
 
 	return true;
 }
@@ -200,9 +237,6 @@ void GLFWCALL mouseClick(int iButton, int iState )
 	{
 		g_bZoomCamera=false;
 	}
-
-	g_oCamPos = g_pCurrentSceneDesc->pCamera->getPosition();
-	g_pGiFx->refreshParameter( g_iCamPosFxID );
 }
 
 /**
@@ -212,51 +246,19 @@ void GLFWCALL mouseClick(int iButton, int iState )
 */
 void GLFWCALL mouseMove( int iMouseX, int iMouseY )
 {
-	if(g_bRotateCamera) // if camera rotation allowed, rotate camera
+	// the move is applied by the update stage
+	if( g_bRotateCamera || g_bTrackCamera || g_bZoomCamera || g_bMoveObject )
 	{
-		g_pCurrentSceneDesc->pCamera->reComputeTargetPos( g_iLastMouseX - iMouseX, g_iLastMouseY - iMouseY );
-
-// 		cout << "pos : " << g_pCurrentSceneDesc->pCamera->getPosition() << endl;
-// 		cout << "target : " << g_pCurrentSceneDesc->pCamera->getTarget() << endl;
+		MouseMove oMove;
+		oMove.iDeltaX = g_iLastMouseX - iMouseX;
+		oMove.iDeltaY = g_iLastMouseY - iMouseY;
+		oMove.bRotateCamera = g_bRotateCamera;
+		oMove.bTrackCamera = g_bTrackCamera;
+		oMove.bZoomCamera = g_bZoomCamera;
+		oMove.bMoveObject = g_bMoveObject;
+		g_oFrameInput.vMouseMoves.push_back( oMove );
 	}
 
-	if(g_bTrackCamera) // if camera tracking allowed, move camera
-	{
-		g_pCurrentSceneDesc->pCamera->moveX( g_iLastMouseX - iMouseX );
-		g_pCurrentSceneDesc->pCamera->moveY( iMouseY - g_iLastMouseY );
-	}
-
-	if(g_bZoomCamera) // if camera zooming allowed, move camera
-	{
-		Vec3 oDistVec = g_pCurrentSceneDesc->pCamera->getTarget() - g_pCurrentSceneDesc->pCamera->getPosition();
-		float fDist = oDistVec.length();
-		Vec3 oViewAxis = g_pCurrentSceneDesc->pCamera->getViewAxis();
-		float fDot = oDistVec | oViewAxis;
-		int iDeltaPos = g_iLastMouseY-iMouseY;
-
-		if( ( iDeltaPos > 0 && ( ( fDot < 0 && fDist < 10.f ) || fDot > 0 ) ) ||
-			( iDeltaPos < 0 && ( ( fDot > 0 && fDist < 10.f ) || fDot < 0 ) ) )
-		{
-				g_pCurrentSceneDesc->pCamera->moveZ( iDeltaPos );
-		}
-	}
-
-	if( g_bMoveObject )
-	{
-		Mesh * pMesh = g_pCurrentSceneDesc->pMesh;
-		Matrix4x4 oMat = pMesh->getTransformer().getTransformMatrix();
-		oMat.invert();
-		Vec3 oVertAxis = g_pCurrentSceneDesc->pCamera->getVerticalAxis();
-		oVertAxis = oMat * oVertAxis;
-		pMesh->getTransformer().rotate( g_iLastMouseX - iMouseX, oVertAxis );
-		Vec3 oHoriAxis = g_pCurrentSceneDesc->pCamera->getStrafeAxis();
-		oHoriAxis = oMat * oHoriAxis;
-		pMesh->getTransformer().rotate( g_iLastMouseY - iMouseY, oHoriAxis );
-	}
-
-	g_oCamPos = g_pCurrentSceneDesc->pCamera->getPosition();
-	g_pGiFx->refreshParameter( g_iCamPosFxID );
-
 	g_iLastMouseX = iMouseX;
 	g_iLastMouseY = iMouseY;
 }
@@ -267,6 +269,7 @@ void GLFWCALL mouseMove( int iMouseX, int iMouseY )
 void cleanup()
 {
 	delete g_pRenderer;
+	delete g_pFrameState;
 	delete g_pGiFx;
 
 	delete g_pScene1Desc;
@@ -276,6 +279,21 @@ void cleanup()
 	delete g_pHelpHud;
 }
 
+/**
+* @brief stops recording the camera path and writes it
+*/
+void stopCameraPathRecording()
+{
+	g_oCameraPath.stopRecording();
+
+	try
+	{
+		g_oCameraPath.save( g_sCameraPathFilename );
+		cout << "Camera path of " << g_oCameraPath.getFrameNb() << " frames written to " << g_sCameraPathFilename << endl;
+	}
+	catch(Error e) { e.showError(); }
+}
+
 /**
 * @brief Keyboard callback
 * @param iKey ID of the key pressed
@@ -290,6 +308,30 @@ void GLFWCALL keyboard( int iKey, int iState )
 		else
 			g_bDisplayHelp = true;
 	}
+	if( iKey == GLFW_KEY_F2 && iState == GLFW_PRESS )
+	{
+		// the HUD creates or deletes its pipeline statistics queries, it is shown or hidden by the render stage
+		g_oFrameInput.bToggleHud = true;
+	}
+	if( ( iKey == GLFW_KEY_F4 || iKey == GLFW_KEY_F5 ) && iState == GLFW_PRESS )
+	{
+		CaptureMode eMode = iKey == GLFW_KEY_F4 ? CAPTURE_PNG : CAPTURE_EXR;
+		if( g_eCaptureMode == eMode )
+		{
+			g_eCaptureMode = CAPTURE_NONE;
+			cout << "Frame capture stopped, " << g_iCaptureFrameNb << " frames captured" << endl;
+		}
+		else
+		{
+			g_eCaptureMode = eMode;
+			cout << "Capturing the frames to " << g_sCapturePrefix << "*" << ( eMode == CAPTURE_PNG ? ".png" : ".exr" ) << endl;
+		}
+	}
+	if( iKey == GLFW_KEY_F3 && iState == GLFW_PRESS )
+	{
+		// the recording is started or stopped by the update stage
+		g_oFrameInput.bToggleCameraPath = true;
+	}
 	if( iKey == GLFW_KEY_LCTRL && iState == GLFW_PRESS )
 	{
 		g_bMoveObjectMode = true;
@@ -305,61 +347,210 @@ void GLFWCALL keyboard( int iKey, int iState )
 		else 
 			g_bRun = false;
 	}
+#ifdef OGLF_PROFILING
+	if( iKey == 'P' && iState == GLFW_PRESS )
+	{
+		try
+		{
+			Profiler::exportChromeTrace( g_sProfileTraceFilename );
+			cout << "Profile trace written to " << g_sProfileTraceFilename << endl;
+		}
+		catch(Error e) { e.showError(); }
+	}
+#endif
 	if( iKey == 'Z' && iState == GLFW_PRESS && g_pCurrentSceneDesc->iSceneID != 1 )
 	{
-		glfwLockMutex( g_pScene2Desc->oSceneNeedUpdateLock );
+		g_dSceneSwitchStart = getTime();
+		g_bSceneSwitchPrefetched = isSceneResident( g_pScene2Desc );
+
 		g_pCurrentSceneDesc = g_pScene2Desc;
 		g_pCurrentSceneDesc->bSceneNeedUpdate = true;
 		g_fCurrentLum = 0.f;
-		glfwUnlockMutex( g_pScene2Desc->oSceneNeedUpdateLock );
 	}
 	if( iKey == 'A' && iState == GLFW_PRESS && g_pCurrentSceneDesc->iSceneID != 0 )
 	{
-		glfwLockMutex( g_pScene1Desc->oSceneNeedUpdateLock );
+		g_dSceneSwitchStart = getTime();
+		g_bSceneSwitchPrefetched = isSceneResident( g_pScene1Desc );
+
 		g_pCurrentSceneDesc = g_pScene1Desc;
 		g_pCurrentSceneDesc->bSceneNeedUpdate = true;
 		g_fCurrentLum = 0.f;
-		glfwUnlockMutex( g_pScene1Desc->oSceneNeedUpdateLock );
 	}
 	if( iKey == 'E' && iState == GLFW_PRESS && g_pCurrentSceneDesc->iSceneID != 2 )
 	{
-		glfwLockMutex( g_pScene3Desc->oSceneNeedUpdateLock );
+		g_dSceneSwitchStart = getTime();
+		g_bSceneSwitchPrefetched = isSceneResident( g_pScene3Desc );
+
 		g_pCurrentSceneDesc = g_pScene3Desc;
 		g_pCurrentSceneDesc->bSceneNeedUpdate = true;
 		g_fCurrentLum = 0.f;
-		glfwUnlockMutex( g_pScene3Desc->oSceneNeedUpdateLock );
+	}
+}
+
+/**
+* @brief applies a mouse move to the update camera of a scene, or to its mesh transform
+* @param pDesc the scene
+* @param oMove the mouse move
+*/
+void applyMouseMove( SceneDesc* pDesc, const MouseMove& oMove )
+{
+	Camera* pCamera = pDesc->pUpdateCamera;
+
+	if( oMove.bRotateCamera ) // if camera rotation allowed, rotate camera
+	{
+		pCamera->reComputeTargetPos( oMove.iDeltaX, oMove.iDeltaY );
+		g_oCameraPath.record( CAMERA_PATH_ROTATE, oMove.iDeltaX, oMove.iDeltaY );
 	}
 
-	g_oCamPos = g_pCurrentSceneDesc->pCamera->getPosition();
-	g_pGiFx->refreshParameter( g_iCamPosFxID );
+	if( oMove.bTrackCamera ) // if camera tracking allowed, move camera
+	{
+		pCamera->moveX( oMove.iDeltaX );
+		pCamera->moveY( -oMove.iDeltaY );
+		g_oCameraPath.record( CAMERA_PATH_TRACK, oMove.iDeltaX, -oMove.iDeltaY );
+	}
+
+	if( oMove.bZoomCamera ) // if camera zooming allowed, move camera
+	{
+		Vec3 oDistVec = pCamera->getTarget() - pCamera->getPosition();
+		float fDist = oDistVec.length();
+		Vec3 oViewAxis = pCamera->getViewAxis();
+		float fDot = oDistVec | oViewAxis;
+		int iDeltaPos = oMove.iDeltaY;
+
+		if( ( iDeltaPos > 0 && ( ( fDot < 0 && fDist < 10.f ) || fDot > 0 ) ) ||
+			( iDeltaPos < 0 && ( ( fDot > 0 && fDist < 10.f ) || fDot < 0 ) ) )
+		{
+				pCamera->moveZ( iDeltaPos );
+				g_oCameraPath.record( CAMERA_PATH_ZOOM, 0, iDeltaPos );
+		}
+	}
+
+	if( oMove.bMoveObject )
+	{
+		GLtransformer3D& oTransformer = pDesc->oMeshTransformer;
+		// the camera axes are brought to the object space by the inverse of the object rotation
+		Quaternion oInverse = oTransformer.getRotation().getConjugate();
+		oTransformer.rotate( oMove.iDeltaX, oInverse.rotateVector( pCamera->getVerticalAxis() ) );
+		oTransformer.rotate( oMove.iDeltaY, oInverse.rotateVector( pCamera->getStrafeAxis() ) );
+	}
 }
 
 /**
-* @brief Thread used to compute the average luminance in a texture
-* @param pData the texture data
+* @brief writes the camera and the mesh transform of a scene to the frame state
+* @param pDesc the scene
 */
-void GLFWCALL computeAvgColor( void* pData )
+void writeSceneState( SceneDesc* pDesc )
 {
-	GLfloat* pfData = ( GLfloat* )pData;
-	int iPixelsNb = g_iTMtexSize * g_iTMtexSize;
+	g_pFrameState->setVec3( pDesc->iCameraPositionBlock, pDesc->pUpdateCamera->getPosition() );
+	g_pFrameState->setMatrix( pDesc->iCameraRotationBlock, pDesc->pUpdateCamera->getTransformer().getTransformMatrix() );
+	g_pFrameState->setMatrix( pDesc->iMeshTransformBlock, pDesc->oMeshTransformer.getTransformMatrix() );
+}
+
+/**
+* @brief update stage job: applies the input of a frame to the scene updated and writes its state to the frame state,
+* it only touches the update cameras, the mesh transforms, the camera path and the write state
+* @param pData the frame update
+*/
+void updateFrame( void* pData )
+{
+	FrameUpdate* pUpdate = ( FrameUpdate* )pData;
+	SceneDesc* pDesc = pUpdate->pSceneDesc;
+
+	// a camera path is recorded in a single scene
+	if( pDesc != pUpdate->pLastSceneDesc && g_oCameraPath.isRecording() )
+		stopCameraPathRecording();
+	pUpdate->pLastSceneDesc = pDesc;
+
+	if( pUpdate->oInput.bToggleCameraPath )
+	{
+		// the benchmark replays the paths in the first scene
+		if( g_oCameraPath.isRecording() )
+			stopCameraPathRecording();
+		else if( pDesc->iSceneID != 0 )
+			cout << "Camera paths are recorded in the first scene" << endl;
+		else
+		{
+			g_oCameraPath.startRecording( *pDesc->pUpdateCamera );
+			cout << "Recording the camera path, press F3 to stop" << endl;
+		}
+	}
+
+	if( pUpdate->iReplayFrame == 0 )
+		g_oCameraPath.startReplay( *pDesc->pUpdateCamera );
+	if( pUpdate->iReplayFrame >= 0 )
+		g_oCameraPath.replay( *pDesc->pUpdateCamera, pUpdate->iReplayFrame );
+
+	for( size_t i = 0; i < pUpdate->oInput.vMouseMoves.size(); ++i )
+		applyMouseMove( pDesc, pUpdate->oInput.vMouseMoves[ i ] );
+	g_oCameraPath.nextFrame();
+
+	writeSceneState( pDesc );
+	g_pFrameState->setVec3( g_iEyePosBlock, pDesc->pUpdateCamera->getPosition() );
+}
+
+/**
+* @brief render stage: sets the scene camera and mesh transform from the read state and refreshes the effect
+* parameters of the frame state
+* @param pDesc the scene drawn, the one of the update which wrote the read state
+*/
+void applyFrameState( SceneDesc* pDesc )
+{
+	Vec3 oCameraPosition;
+	g_pFrameState->getVec3( pDesc->iCameraPositionBlock, oCameraPosition );
+	pDesc->pCamera->setPosition( oCameraPosition );
+	Matrix4x4 oMat;
+	g_pFrameState->getMatrix( pDesc->iCameraRotationBlock, oMat );
+	pDesc->pCamera->getTransformer().setTransformMatrix( oMat );
+
+	if( pDesc->pMesh != NULL )
+	{
+		g_pFrameState->getMatrix( pDesc->iMeshTransformBlock, oMat );
+		pDesc->pMesh->getTransformer().setTransformMatrix( oMat );
+	}
+
+	g_pFrameState->applyParameters();
+}
+
+/**
+* @brief job summing the luminance of a part of the texture read back
+* @param pData the luminance sum
+*/
+void sumLuminance( void* pData )
+{
+	LuminanceSum* pSum = ( LuminanceSum* )pData;
+	const GLfloat* pfData = pSum->pData + 4 * pSum->iFirstPixel;
 	GLfloat r, g, b;
 	r = g = b = 0.f;
 
-	for( int i = 0; i < iPixelsNb; ++i )
+	for( int i = 0; i < pSum->iPixelNb; ++i )
 	{
 		r += pfData[ 4 * i ];
 		g += pfData[ 4 * i + 1 ];
 		b += pfData[ 4 * i + 2 ];
 	}
 
-	g_fAvgLuminance = ( r + g + b ) / 3.f;
-	g_fAvgLuminance /= ( GLfloat )iPixelsNb;
+	pSum->fSum = r + g + b;
+}
 
-	// Compute the luminance at most every 100 ms interval
-	Sleep( 100 );
+/**
+* @brief main thread job computing the average luminance once the sums are done
+* @param pData unused
+*/
+void averageLuminance( void* pData )
+{
+	GLfloat fSum = 0.f;
+	for( int i = 0; i < g_iLuminanceJobNb; ++i )
+		fSum += g_pLuminanceSums[ i ].fSum;
+
+	g_fAvgLuminance = fSum / 3.f;
+	g_fAvgLuminance /= ( GLfloat )( g_iTMtexSize * g_iTMtexSize );
 }
 
-void GLFWCALL loadMesh( void* pData )
+/**
+* @brief job importing a scene mesh
+* @param pData the scene
+*/
+void importMesh( void* pData )
 {
 	SceneDesc* pDesc = ( SceneDesc* )pData;
 
@@ -368,60 +559,242 @@ void GLFWCALL loadMesh( void* pData )
 	// Load scene geometry
 	//
 	pDesc->pMesh->importOBJ( sMeshPath );
-	pDesc->pMesh->centerPivotToObjectCenter();
-	pDesc->pMesh->boundSize(1.0);
+	pDesc->pMesh->centerPivotToObjectCenter( g_pJobSystem );
+	pDesc->pMesh->boundSize( 1.0, g_pJobSystem );
+}
 
-	glfwLockMutex( pDesc->oSceneNeedUpdateLock );
+/**
+* @brief upload function compiling a scene mesh renderable batch
+* @param pData the scene
+*/
+void uploadMesh( void* pData )
+{
+	SceneDesc* pDesc = ( SceneDesc* )pData;
+
+	pDesc->iMeshBatch = pDesc->pMesh->compileRenderableBatch();
+}
+
+/**
+* @brief completion function run by the main thread once a scene mesh renderable batch is compiled
+* @param pData the scene
+*/
+void meshUploaded( void* pData )
+{
+	SceneDesc* pDesc = ( SceneDesc* )pData;
+
+	pDesc->pMesh->setRenderableBatch( pDesc->iMeshBatch );
+	pDesc->bMeshReady = true;
 	pDesc->bSceneNeedUpdate = true;
-	pDesc->bMeshNeedUpdate = true;
-	glfwUnlockMutex( pDesc->oSceneNeedUpdateLock );
+}
+
+/**
+* @brief main thread job run once a scene mesh is imported, queues the compilation of its renderable batch
+* @param pData the scene
+*/
+void meshImported( void* pData )
+{
+	g_pUploadContext->upload( uploadMesh, pData, meshUploaded );
+}
+
+/**
+* @brief streams a scene cube map, from its BC6H cache file when there is one and the
+* hardware supports it, from the EXR source picture otherwise. The cube map residency is
+* then managed: it is evicted to a low resolution when unused and the memory is short.
+* @param pCubeMap the cube map
+* @param sEnvName the scene environment name
+* @param sSuffix the cube map suffix: env, diffuse or specular
+*/
+void streamEnvCubeMap( CubeMap* pCubeMap, const string& sEnvName, const string& sSuffix )
+{
+	string sCachePath = "./img/BC6H/" + sEnvName + "_" + sSuffix + ".bc6h";
+
+	FILE* pCacheFile = fopen( sCachePath.c_str(), "rb" );
+	if( pCacheFile != NULL && GLEW_ARB_texture_compression_bptc )
+	{
+		fclose( pCacheFile );
+		g_pTextureResidency->addCubeMap( pCubeMap, sCachePath );
+		return;
+	}
+	if( pCacheFile != NULL )
+		fclose( pCacheFile );
+
+	g_pTextureResidency->addCubeMap( pCubeMap, "./img/EXR_RLE/" + sEnvName + "_" + sSuffix + ".exr" );
 }
 
 void loadSceneData( void* pData )
 {
 	SceneDesc* pDesc = ( SceneDesc* )pData;
 
-	string sSkyBoxEnvPath = "./img/EXR_RLE/" + pDesc->sEnvName + "_env.exr";
-	string sSkyBoxDiffPath = "./img/EXR_RLE/" + pDesc->sEnvName + "_diffuse.exr";
-	string sSkyBoxSpecPath = "./img/EXR_RLE/" + pDesc->sEnvName + "_specular.exr";
+	// the previous mesh may still be imported or compiled
+	g_pJobSystem->wait( pDesc->oMeshLoad );
+	if( pDesc->pMesh != NULL )
+		g_pUploadContext->flush();
 
 	if( pDesc->pMesh != NULL )
 		delete pDesc->pMesh;
 	if( pDesc->pSkyBoxEnv != NULL )
+	{
+		g_pTextureResidency->remove( pDesc->pSkyBoxEnv );
 		delete pDesc->pSkyBoxEnv;
+	}
 	if( pDesc->pSkyBoxDif != NULL )
+	{
+		g_pTextureResidency->remove( pDesc->pSkyBoxDif );
 		delete pDesc->pSkyBoxDif;
+	}
 	if( pDesc->pSkyBoxSpec != NULL )
+	{
+		g_pTextureResidency->remove( pDesc->pSkyBoxSpec );
 		delete pDesc->pSkyBoxSpec;
+	}
 
 	pDesc->pMesh = new Mesh( pDesc->sMeshName );
-	glfwCreateThread( loadMesh, pDesc );
+	pDesc->bMeshReady = false;
+	pDesc->bLoaded = true;
+	g_pJobSystem->run( importMesh, pDesc, &pDesc->oMeshImport );
+	g_pJobSystem->runOnMainThread( meshImported, pDesc, &pDesc->oMeshLoad, &pDesc->oMeshImport );
 
 	pDesc->pScene->removeAllMeshes();
 	pDesc->pScene->addRenderingFX( *g_pGiFx );
 	pDesc->pScene->addMesh( *pDesc->pMesh, g_iGiFxID );
 
 
-	// Load scene global lighting environment
+	// Stream scene global lighting environment, the cube maps show their smallest mipmap levels until they are complete
 	//
 	pDesc->pSkyBoxDif = new CubeMap;
 	pDesc->pSkyBoxDif->setFilters( LINEAR, LINEAR );
 	pDesc->pSkyBoxDif->setWrapMode( CLAMP_TO_EDGE );
-	pDesc->pSkyBoxDif->loadFile( EXR, sSkyBoxDiffPath );
+	streamEnvCubeMap( pDesc->pSkyBoxDif, pDesc->sEnvName, "diffuse" );
 
 	pDesc->pSkyBoxSpec = new CubeMap;
 	pDesc->pSkyBoxSpec->setFilters( LINEAR, LINEAR );
 	pDesc->pSkyBoxSpec->setWrapMode( CLAMP_TO_EDGE );
-	pDesc->pSkyBoxSpec->loadFile( EXR, sSkyBoxSpecPath );
+	streamEnvCubeMap( pDesc->pSkyBoxSpec, pDesc->sEnvName, "specular" );
 
 	pDesc->pSkyBoxEnv = new CubeMap( true );
 	pDesc->pSkyBoxEnv->setFilters( LINEAR, LINEAR );
 	pDesc->pSkyBoxEnv->setWrapMode( CLAMP_TO_EDGE );
-	pDesc->pSkyBoxEnv->loadFile( EXR, sSkyBoxEnvPath );
+	streamEnvCubeMap( pDesc->pSkyBoxEnv, pDesc->sEnvName, "env" );
+}
+
+/**
+* @brief returns the distance between two scenes in the scene list, which wraps around
+* @param iScene1 the first scene ID
+* @param iScene2 the second scene ID
+* @return the number of A, Z or E key presses between them in the list order
+*/
+int getSceneDistance( int iScene1, int iScene2 )
+{
+	int iDistance = abs( iScene1 - iScene2 );
+
+	return iDistance < g_iSceneNb - iDistance ? iDistance : g_iSceneNb - iDistance;
+}
+
+/**
+* @brief returns whether a scene can be drawn at once at full resolution: its mesh is ready to
+* be rendered and its cube maps are completely resident
+* @param pDesc the scene
+* @return true if switching to the scene only swaps resident resources
+*/
+bool isSceneResident( SceneDesc* pDesc )
+{
+	if( !pDesc->bLoaded || !pDesc->bMeshReady )
+		return false;
+
+	CubeMap* pCubeMaps[ 3 ] = { pDesc->pSkyBoxDif, pDesc->pSkyBoxSpec, pDesc->pSkyBoxEnv };
+	for( int i = 0; i < 3; ++i )
+		if( g_pTextureResidency->isEvicted( pCubeMaps[ i ] ) || g_pTextureStreamer->isStreaming( pCubeMaps[ i ] ) )
+			return false;
+
+	return true;
+}
+
+/**
+* @brief prefetches the scenes close to the current one so that switching to them only swaps resident
+* resources: they are loaded in the background, their meshes are compiled by the upload context and their cube
+* maps are pinned as long as they fit in the texture budget with the cube maps of the closer scenes.
+* The cube maps of the other scenes are left to the residency manager, which evicts them when memory is short.
+*/
+void prefetchScenes()
+{
+	OGLF_PROFILE_SCOPE( "prefetchScenes" );
+
+	int iCurrentScene = g_pCurrentSceneDesc->iSceneID;
+	GLuint iPinnedSize = 0;
+
+	for( int iDistance = 0; iDistance <= g_iSceneNb / 2; ++iDistance )
+	{
+		for( int i = 0; i < g_iSceneNb; ++i )
+		{
+			SceneDesc* pDesc = g_pSceneDescArray[ i ];
+			if( getSceneDistance( i, iCurrentScene ) != iDistance )
+				continue;
+
+			bool bPrefetch = iDistance <= g_iPrefetchDistance;
+			if( bPrefetch && !pDesc->bLoaded )
+				loadSceneData( pDesc );
+
+			if( !pDesc->bLoaded )
+				continue;
+
+			CubeMap* pCubeMaps[ 3 ] = { pDesc->pSkyBoxDif, pDesc->pSkyBoxSpec, pDesc->pSkyBoxEnv };
+			GLuint iSceneSize = 0;
+			for( int j = 0; j < 3; ++j )
+				iSceneSize += g_pTextureResidency->getResidentSize( pCubeMaps[ j ] );
+
+			// the current scene is always pinned, even over budget
+			bool bPin = bPrefetch && ( iDistance == 0 || iPinnedSize + iSceneSize <= g_pTextureResidency->getBudget() );
+			if( bPin )
+				iPinnedSize += iSceneSize;
+
+			for( int j = 0; j < 3; ++j )
+				g_pTextureResidency->setPinned( pCubeMaps[ j ], bPin );
+		}
+	}
 }
 
 int main(int argc, char* argv[])
 {
+	for( int i = 1; i < argc; ++i )
+	{
+		if( strcmp( argv[ i ], "-headless" ) == 0 )
+		{
+			g_bHeadless = true;
+			g_bDisplayHelp = false;
+			if( i + 1 < argc && atoi( argv[ i + 1 ] ) > 0 )
+				g_iHeadlessFrameNb = atoi( argv[ ++i ] );
+		}
+		else if( strcmp( argv[ i ], "-benchmark" ) == 0 )
+		{
+			g_bBenchmark = true;
+			g_bDisplayHelp = false;
+			if( i + 1 < argc && argv[ i + 1 ][ 0 ] != '-' )
+			{
+				try {
+					g_oCameraPath.load( argv[ ++i ] );
+				}
+				catch(Error e)
+				{
+					e.showError();
+					return -1;
+				}
+			}
+		}
+		else if( strcmp( argv[ i ], "-capture" ) == 0 && i + 1 < argc )
+		{
+			++i;
+			g_eCaptureMode = strcmp( argv[ i ], "exr" ) == 0 ? CAPTURE_EXR : CAPTURE_PNG;
+		}
+		else if( strcmp( argv[ i ], "-report" ) == 0 && i + 1 < argc )
+			g_sBenchmarkReportFilename = argv[ ++i ];
+		else if( strcmp( argv[ i ], "-baseline" ) == 0 && i + 1 < argc )
+			g_sBenchmarkBaselineFilename = argv[ ++i ];
+		else if( strcmp( argv[ i ], "-tolerance" ) == 0 && i + 1 < argc )
+			g_fBenchmarkTolerance = ( float )atof( argv[ ++i ] );
+	}
+
+	int iExitCode = 0;
+
 	if( !createApplication() )
 	{
 		system( "pause" );
@@ -435,9 +808,22 @@ int main(int argc, char* argv[])
 		g_pRenderer = new Renderer(wWidth, wHeight);
 		//pRenderer->disablePostProcessings();
 
+		// Start the job system worker threads
+		//
+		g_pJobSystem = new JobSystem;
+
+		// Start the upload resource thread, the texture streaming threads and the residency manager
+		//
+		g_pUploadContext = new UploadContext;
+		cout << "Uploads run on " << ( g_pUploadContext->isShared() ? "a shared context" : "the main thread" ) << endl;
+		g_pTextureStreamer = new TextureStreamer( g_iStreamingStagingSize, g_iStreamingBytesPerFrame, 2, g_pUploadContext );
+		g_pTextureResidency = new TextureResidencyManager( *g_pTextureStreamer, g_iTextureBudget );
+
 		// Load Help HUD
 		//
 		g_pHelpHud = new Hud( "img/help.tga", 0.1f, 0.1f, 0.9f, 0.7f );
+		g_pPerformanceHud = new PerformanceHud( g_pTextureStreamer );
+		g_pFrameCapture = new FrameCapture;
 
 		// Prepare post-processing effects
 		//
@@ -472,7 +858,7 @@ int main(int argc, char* argv[])
 		g_pGiFx->setShaders("shaders/GI.vert", "shaders/GI.frag");
 		g_iCubeDiffSamplerID = g_pGiFx->addTexture( NULL, 0, "u_cubeMapDiffuseSampler" );
 		g_iCubeSpecSamplerID = g_pGiFx->addTexture( NULL, 1, "u_cubeMapSpecularSampler" );
-		g_iCamPosFxID = g_pGiFx->addParameter( g_oCamPos.v, FR_FLOAT_VEC3, 1, "u_wsvEyePos" );
+		g_iCamPosFxID = g_pGiFx->addParameter< FR_FLOAT_VEC3 >( NULL, 1, "u_wsvEyePos" );
 
 
 		// Create the scenes
@@ -519,10 +905,24 @@ int main(int argc, char* argv[])
 		g_pRenderer->addScene( *g_pScene2Desc->pScene );
 		g_pRenderer->addScene( *g_pScene3Desc->pScene );
 
-		loadSceneData( g_pScene1Desc );
-		loadSceneData( g_pScene2Desc );
-		loadSceneData( g_pScene3Desc );
+		// Register the frame state, the update stage moves copies of the scene cameras
+		//
+		g_pFrameState = new FrameState;
+		for( int i = 0; i < g_iSceneNb; ++i )
+		{
+			SceneDesc* pDesc = g_pSceneDescArray[ i ];
+
+			pDesc->pUpdateCamera = new Camera( *pDesc->pCamera );
+			pDesc->iCameraPositionBlock = g_pFrameState->addVec3( pDesc->pCamera->getPosition() );
+			pDesc->iCameraRotationBlock = g_pFrameState->addMatrix( pDesc->pCamera->getTransformer().getTransformMatrix() );
+			pDesc->iMeshTransformBlock = g_pFrameState->addMatrix( pDesc->oMeshTransformer.getTransformMatrix() );
+		}
+		g_iEyePosBlock = g_pFrameState->addParameter( *g_pGiFx, g_iCamPosFxID, 3, g_pCurrentSceneDesc->pCamera->getPosition().v );
+
+		// Load the first scene and prefetch its neighbours
+		//
 		g_pCurrentSceneDesc = g_pScene1Desc;
+		prefetchScenes();
 
 		g_pGiFx->updateTextureLocation( g_iCubeDiffSamplerID, *g_pCurrentSceneDesc->pSkyBoxDif );
 		g_pGiFx->updateTextureLocation( g_iCubeSpecSamplerID, *g_pCurrentSceneDesc->pSkyBoxSpec );
@@ -530,13 +930,22 @@ int main(int argc, char* argv[])
 
 		Error::checkGLerror("main::");
 
-		glfwSetKeyCallback( keyboard );
-		glfwSetMousePosCallback( mouseMove );
-		glfwSetMouseButtonCallback( mouseClick );
-		glfwSetWindowSizeCallback( windowResize );
-		//glfwSetWindowRefreshCallback( draw );
+		if( g_pHeadlessContext == NULL )
+		{
+			glfwSetKeyCallback( keyboard );
+			glfwSetWindowSizeCallback( windowResize );
+			//glfwSetWindowRefreshCallback( draw );
 
-		glfwSwapInterval( 1 );
+			// the mouse would move the camera replayed by the benchmark
+			if( !g_bBenchmark )
+			{
+				glfwSetMousePosCallback( mouseMove );
+				glfwSetMouseButtonCallback( mouseClick );
+			}
+
+			// the benchmark frames are not paced by the display
+			glfwSwapInterval( g_bBenchmark ? 0 : 1 );
+		}
 
 		Texture2DCopier oTexCopier( g_pRenderer );
 
@@ -548,75 +957,271 @@ int main(int argc, char* argv[])
 
 		GLfloat* pTMdata = new GLfloat[ 4 * g_iTMtexSize * g_iTMtexSize ];
 
-		GLFWthread oThread = -1;
-
-		bool bWait = true;
-		while( bWait )
+		int iPixelNb = g_iTMtexSize * g_iTMtexSize;
+		for( int i = 0; i < g_iLuminanceJobNb; ++i )
 		{
-			glfwLockMutex( g_pCurrentSceneDesc->oSceneNeedUpdateLock );
-			if( g_pCurrentSceneDesc->bSceneNeedUpdate )
-				bWait = false;
-			glfwUnlockMutex( g_pCurrentSceneDesc->oSceneNeedUpdateLock );
+			g_pLuminanceSums[ i ].pData = pTMdata;
+			g_pLuminanceSums[ i ].iFirstPixel = i * iPixelNb / g_iLuminanceJobNb;
+			g_pLuminanceSums[ i ].iPixelNb = ( i + 1 ) * iPixelNb / g_iLuminanceJobNb - g_pLuminanceSums[ i ].iFirstPixel;
 		}
+		JobCounter oLuminanceSums;
+		JobCounter oLuminanceDone;			// the sums and the average
+		double dLuminanceStart = -g_dLuminancePeriod;
+
+		// Wait for the first scene mesh
+		//
+		g_pJobSystem->wait( g_pCurrentSceneDesc->oMeshLoad );
+		g_pUploadContext->flush();
 
 		float fShutterSpeed = 0.1f;
+		int iFrameNb = 0;
+		double dLoopStart = getTime();
+
+		// the benchmark frames are timed once the scene is resident and the warm-up frames are drawn
+		BenchmarkReport oBenchmarkReport( g_pScene1Desc->sMeshName + "_" + g_pScene1Desc->sEnvName );
+		int iBenchmarkFrameNb = g_oCameraPath.getFrameNb() > 0 ? g_oCameraPath.getFrameNb() : g_iHeadlessFrameNb;
+		int iBenchmarkFrame = -1;			// the camera path frame drawn
+		int iReplayFrame = -1;				// the camera path frame replayed by the next update
+		int iWarmupFrameNb = 0;
+		double dFrameEnd = dLoopStart;
+
+		// The first update writes the state drawn by the first frame
+		JobCounter oUpdateDone;
+		g_oFrameUpdate.pSceneDesc = g_pCurrentSceneDesc;
+		updateFrame( &g_oFrameUpdate );
 
 		// Render loop
 		do
 		{
-			// If the thread that compute the average scene luminance is terminated,
-			// create it once again a recompute the luminance.
-			if( glfwWaitThread( oThread, GLFW_NOWAIT ) && !g_bDisplayHelp )
+			double dUpdateStart = getTime();
+
+			g_pJobSystem->processMainThreadJobs();
+
+			// Once the previous average scene luminance is computed, and at most every 100 ms,
+			// read the scene back and sum its luminance again on the workers.
+			if( g_pJobSystem->isDone( oLuminanceDone ) && getTime() - dLuminanceStart >= g_dLuminancePeriod && !g_bDisplayHelp )
 			{
+				OGLF_PROFILE_GPU_SCOPE( "Luminance readback" );
+
+				dLuminanceStart = getTime();
 				oTexCopier.copy( g_pRenderer->getRenderOutputTexture(), &oTMtex );
 				oTMtex.bind();
 				glGetTexImage( GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, pTMdata ); 
 				oTMtex.bind( false );
 
-				oThread = glfwCreateThread( computeAvgColor, pTMdata );
+				for( int i = 0; i < g_iLuminanceJobNb; ++i )
+					g_pJobSystem->run( sumLuminance, &g_pLuminanceSums[ i ], &oLuminanceSums );
+				g_pJobSystem->runOnMainThread( averageLuminance, NULL, &oLuminanceDone, &oLuminanceSums );
 			}
 			if( g_bDisplayHelp )
 			{
 				g_fAvgLuminance = 20.f;
 			}
 
+			prefetchScenes();
+			g_pUploadContext->update();
+			g_pTextureResidency->update();
+			g_pTextureStreamer->update();
+
 			g_fCurrentLum += fShutterSpeed * ( g_fAvgLuminance - g_fCurrentLum );
 			pFinalGlowPass->refreshParameter( iAvgLumID );
 
-			glfwLockMutex( g_pCurrentSceneDesc->oSceneNeedUpdateLock );
-			if( g_pCurrentSceneDesc->bSceneNeedUpdate )
+			// Publish the state written by the last update, then update the next frame on the workers with the input
+			// recorded meanwhile while this one is drawn
 			{
-				g_pCurrentSceneDesc->bSceneNeedUpdate = false;
-				g_pRenderer->setActiveScene( g_pCurrentSceneDesc->iSceneID );
-				g_pRenderer->setSkyBox( *g_pCurrentSceneDesc->pSkyBoxEnv );
-				g_pGiFx->updateTextureLocation( g_iCubeDiffSamplerID, *g_pCurrentSceneDesc->pSkyBoxDif );
-				g_pGiFx->updateTextureLocation( g_iCubeSpecSamplerID, *g_pCurrentSceneDesc->pSkyBoxSpec );
-				
-				if( g_pCurrentSceneDesc->bMeshNeedUpdate )
-				{	
-					g_pCurrentSceneDesc->pMesh->prepareRenderableBatch();
-					g_pCurrentSceneDesc->bMeshNeedUpdate = false;
+				OGLF_PROFILE_SCOPE( "Update wait" );
+				g_pJobSystem->wait( oUpdateDone );
+			}
+			g_pFrameState->publish();
+			SceneDesc* pDrawnSceneDesc = g_oFrameUpdate.pSceneDesc;
+			iBenchmarkFrame = g_oFrameUpdate.iReplayFrame;
+
+			if( g_bBenchmark && iReplayFrame < 0 && isSceneResident( g_pCurrentSceneDesc ) && ++iWarmupFrameNb > g_iBenchmarkWarmupFrameNb )
+				iReplayFrame = 0;
+
+			g_oFrameUpdate.pSceneDesc = g_pCurrentSceneDesc;
+			g_oFrameUpdate.oInput.vMouseMoves.swap( g_oFrameInput.vMouseMoves );
+			g_oFrameInput.vMouseMoves.clear();
+			g_oFrameUpdate.oInput.bToggleCameraPath = g_oFrameInput.bToggleCameraPath;
+			g_oFrameInput.bToggleCameraPath = false;
+			g_oFrameUpdate.iReplayFrame = iReplayFrame;
+			if( iReplayFrame >= 0 )
+				++iReplayFrame;
+			g_pJobSystem->run( updateFrame, &g_oFrameUpdate, &oUpdateDone );
+
+			if( g_bWindowResized )
+			{
+				g_bWindowResized = false;
+
+				try {
+					g_pRenderer->initViewport( 0, 0, wWidth, wHeight );
 				}
+				catch(Error e) { e.showError(); }
+			}
+
+			bool bSceneSwitched = false;
+
+			if( pDrawnSceneDesc->bSceneNeedUpdate )
+			{
+				bSceneSwitched = true;
+				pDrawnSceneDesc->bSceneNeedUpdate = false;
+				g_pRenderer->setActiveScene( pDrawnSceneDesc->iSceneID );
+				g_pRenderer->setSkyBox( *pDrawnSceneDesc->pSkyBoxEnv );
+				g_pGiFx->updateTextureLocation( g_iCubeDiffSamplerID, *pDrawnSceneDesc->pSkyBoxDif );
+				g_pGiFx->updateTextureLocation( g_iCubeSpecSamplerID, *pDrawnSceneDesc->pSkyBoxSpec );
 			}
-			glfwUnlockMutex( g_pCurrentSceneDesc->oSceneNeedUpdateLock );
 
+			applyFrameState( pDrawnSceneDesc );
+
+			if( g_oFrameInput.bToggleHud )
+			{
+				g_oFrameInput.bToggleHud = false;
+				g_pPerformanceHud->setVisible( !g_pPerformanceHud->isVisible() );
+			}
+
+			double dRenderStart = getTime();
 			draw();
 
-			glfwSwapBuffers();
+			if( g_eCaptureMode != CAPTURE_NONE )
+			{
+				OGLF_PROFILE_SCOPE( "Frame capture" );
+
+				char sFrameNb[ 16 ];
+				sprintf( sFrameNb, "%05d", g_iCaptureFrameNb++ );
+				if( g_eCaptureMode == CAPTURE_PNG )
+					g_pFrameCapture->captureFramebuffer( g_sCapturePrefix + sFrameNb + ".png", wWidth, wHeight );
+				else
+					g_pFrameCapture->captureTexture( g_sCapturePrefix + sFrameNb + ".exr", *g_pRenderer->getRenderOutputTexture() );
+			}
+			g_pFrameCapture->update();
+
+			double dPresentStart = getTime();
+
+			{
+				OGLF_PROFILE_SCOPE( "glfwSwapBuffers" );
+				if( g_pHeadlessContext != NULL )
+					g_pHeadlessContext->swapBuffers();
+				else
+					glfwSwapBuffers();
+			}
+			++iFrameNb;
+			OGLF_PROFILE_NEXT_FRAME();
+			RenderStats::nextFrame();
+			g_pPerformanceHud->nextFrame();
+
+			double dLastFrameEnd = dFrameEnd;
+			dFrameEnd = getTime();
+			if( iBenchmarkFrame >= 0 )
+			{
+				oBenchmarkReport.addFrameTime( ( float )( ( dFrameEnd - dLastFrameEnd ) * 1000.0 ) );
+				oBenchmarkReport.addStageTime( "update", ( float )( ( dRenderStart - dUpdateStart ) * 1000.0 ) );
+				oBenchmarkReport.addStageTime( "render", ( float )( ( dPresentStart - dRenderStart ) * 1000.0 ) );
+				oBenchmarkReport.addStageTime( "present", ( float )( ( dFrameEnd - dPresentStart ) * 1000.0 ) );
+#ifdef OGLF_PROFILING
+				// the profiled scopes are read back PROFILER_FRAME_LATENCY frames late
+				for( int i = 0; i < Profiler::getScopeNb() && Profiler::getHistoryLength() > 0; ++i )
+				{
+					const ProfileScopeStats& oScope = Profiler::getScopeStats( i );
+					int iLastFrame = Profiler::getHistoryLength() - 1;
+
+					oBenchmarkReport.addStageTime( string( oScope.sName ) + " CPU", Profiler::getCpuTime( i, iLastFrame ) );
+					if( Profiler::getGpuTime( i, iLastFrame ) >= 0.f )
+						oBenchmarkReport.addStageTime( string( oScope.sName ) + " GPU", Profiler::getGpuTime( i, iLastFrame ) );
+				}
+#endif
+				++iBenchmarkFrame;
+			}
+
+			// Scene switch latency, from the key press to the first frame of the new scene
+			if( bSceneSwitched && g_dSceneSwitchStart >= 0.0 )
+			{
+				cout << "Scene switch: " << ( getTime() - g_dSceneSwitchStart ) * 1000.0 << " ms to the first frame"
+					<< ( g_bSceneSwitchPrefetched ? " (prefetched)" : " (not resident)" ) << endl;
+				g_dSceneSwitchStart = -1.0;
+			}
 
-			g_bRun = g_bRun && glfwGetWindowParam( GLFW_OPENED );
+			if( g_bBenchmark )
+				g_bRun = iBenchmarkFrame < iBenchmarkFrameNb && ( g_pHeadlessContext != NULL || ( g_bRun && glfwGetWindowParam( GLFW_OPENED ) ) );
+			else if( g_pHeadlessContext != NULL )
+				g_bRun = iFrameNb < g_iHeadlessFrameNb;
+			else
+				g_bRun = g_bRun && glfwGetWindowParam( GLFW_OPENED );
 		}
 		while( g_bRun );
 
-		glfwDestroyThread( oThread );
+		double dLoopTime = getTime() - dLoopStart;
+		cout << iFrameNb << " frames in " << dLoopTime << " s, " << dLoopTime * 1000.0 / iFrameNb << " ms per frame" << endl;
+
+		if( g_bBenchmark )
+		{
+			BenchmarkTiming oTiming;
+			oBenchmarkReport.getFrameTiming( oTiming );
+			oBenchmarkReport.save( g_sBenchmarkReportFilename );
+			cout << "Benchmark: " << oBenchmarkReport.getFrameNb() << " frames, min " << oTiming.fMin << " ms, median " << oTiming.fMedian
+				<< " ms, p95 " << oTiming.fP95 << " ms, p99 " << oTiming.fP99 << " ms, written to " << g_sBenchmarkReportFilename << endl;
+
+			if( !g_sBenchmarkBaselineFilename.empty() && !oBenchmarkReport.compare( g_sBenchmarkBaselineFilename, g_fBenchmarkTolerance ) )
+				iExitCode = 1;
+		}
+
+		// the luminance jobs still read the texture data, the update job the scenes
+		g_pJobSystem->wait( oLuminanceDone );
+		g_pJobSystem->wait( oUpdateDone );
+
+		cout << "Texture memory: " << g_pTextureResidency->getUsage() / 1024 << " KB, peak " << g_pTextureResidency->getPeakUsage() / 1024
+			<< " KB, budget " << g_pTextureResidency->getBudget() / 1024 << " KB, " << g_pTextureResidency->getEvictionCount() << " evictions, "
+			<< g_pTextureResidency->getRestorationCount() << " restorations" << endl;
+
+		MemoryStats oMemoryStats;
+		MemoryTracker::getStats( oMemoryStats );
+		cout << "Memory: " << oMemoryStats.iAllocatedBytes / 1024 << " KB, peak " << oMemoryStats.iPeakBytes / 1024 << " KB, "
+			<< oMemoryStats.iThreadNb << " threads" << endl;
+		for( int i = 0; i < MEMORY_CATEGORY_NB; ++i )
+			cout << "  " << MemoryTracker::getCategoryName( ( MemoryCategory )i ) << ": " << oMemoryStats.pAllocatedBytes[ i ] / 1024
+				<< " KB, peak " << oMemoryStats.pPeakBytes[ i ] / 1024 << " KB, " << oMemoryStats.pTotalAllocationNb[ i ] << " allocations" << endl;
+
+#ifdef OGLF_PROFILING
+		cout << "Profile of the last " << Profiler::getHistoryLength() << " frames (average / max, ms):" << endl;
+		for( int i = 0; i < Profiler::getScopeNb(); ++i )
+		{
+			const ProfileScopeStats& oScope = Profiler::getScopeStats( i );
+
+			cout << "  " << string( 2 * oScope.iDepth, ' ' ) << oScope.sName << ": CPU " << oScope.fCpuAverage << " / " << oScope.fCpuMax;
+			if( oScope.fGpuAverage >= 0.f )
+				cout << ", GPU " << oScope.fGpuAverage << " / " << oScope.fGpuMax;
+			cout << endl;
+		}
+		Profiler::release();
+#endif
+
+		delete g_pPerformanceHud;
+		RenderStats::release();
+
+		// writes the frames still captured
+		if( g_iCaptureFrameNb > 0 )
+			cout << "Writing " << g_pFrameCapture->getPendingNb() << " of the " << g_iCaptureFrameNb << " captured frames" << endl;
+		delete g_pFrameCapture;
+
+		// stops the workers, the mesh imports still write the scenes
+		delete g_pJobSystem;
+
+		// stops streaming while the context still exists
+		delete g_pTextureResidency;
+		delete g_pTextureStreamer;
+		delete g_pUploadContext;
+
 		glfwTerminate();
 
 		cleanup();
 		delete pTMdata;
+
+		// deleted after the renderer, which still needs the context
+		delete g_pHeadlessContext;
 	}
 	catch (Error e)
 	{
 		e.showError();
+		iExitCode = -1;
 #ifdef WIN32
 		system( "pause" );
 #endif
@@ -624,7 +1229,8 @@ int main(int argc, char* argv[])
 	catch( exception e )
 	{
 		system( "pause" );
+		iExitCode = -1;
 	}
 
-	return 0;
+	return iExitCode;
 }
@@ -11,6 +11,41 @@ int wHeight = 512;                      // window height
 // Hud
 Oglf::Hud* g_pHelpHud;
 bool	   g_bDisplayHelp = true;
+Oglf::PerformanceHud* g_pPerformanceHud;	// toggled with F2
+
+// Headless rendering, enabled with -headless [frames]
+bool					g_bHeadless = false;
+Oglf::HeadlessContext*	g_pHeadlessContext = NULL;
+int						g_iHeadlessFrameNb = 300;		// frames rendered before exiting
+
+// Benchmark, enabled with -benchmark [camera path]: replays the camera path recorded with F3 in the first scene
+bool					g_bBenchmark = false;
+std::string				g_sBenchmarkReportFilename = "benchmark.json";	// set with -report <file>
+std::string				g_sBenchmarkBaselineFilename;					// compared with the report when set with -baseline <file>
+float					g_fBenchmarkTolerance = 0.1f;					// relative regression tolerated, set with -tolerance <ratio>
+const int				g_iBenchmarkWarmupFrameNb = 30;				// frames drawn once the scene is resident, before the timed ones
+
+// Frame capture: F4 records the displayed frames as PNG pictures, F5 the HDR render output as EXR pictures,
+// -capture png|exr records them from the first frame
+enum CaptureMode
+{
+	CAPTURE_NONE,
+	CAPTURE_PNG,
+	CAPTURE_EXR
+};
+CaptureMode				g_eCaptureMode = CAPTURE_NONE;
+Oglf::FrameCapture*		g_pFrameCapture = NULL;
+int						g_iCaptureFrameNb = 0;		// numbers the pictures
+std::string				g_sCapturePrefix = "capture_";
+
+// Camera path, recorded with F3 and written when the recording stops
+Oglf::CameraPath		g_oCameraPath;
+std::string				g_sCameraPathFilename = "camera.path";
+
+#ifdef OGLF_PROFILING
+// written when P is pressed
+std::string g_sProfileTraceFilename = "profile.json";
+#endif
 
 
 // Camera setup
@@ -40,10 +75,18 @@ struct SceneDesc
 	Oglf::CubeMap*	pSkyBoxDif;
 	Oglf::CubeMap*	pSkyBoxSpec;
 	Oglf::CubeMap*	pSkyBoxEnv;
-	GLFWmutex		oSceneNeedUpdateLock;
+	Oglf::JobCounter	oMeshImport;	// the mesh import job, run on the workers
+	Oglf::JobCounter	oMeshLoad;		// the mesh import job and the main thread job queuing its upload
+	GLuint			iMeshBatch;			// the mesh display list compiled by the upload context
 	bool			bSceneNeedUpdate;
-	bool			bMeshNeedUpdate;
-	Oglf::Camera*	pCamera;
+	bool			bLoaded;			// loadSceneData() has been called
+	bool			bMeshReady;			// the mesh renderable batch has been prepared
+	Oglf::Camera*	pCamera;			// the scene camera, set from the frame state by the render stage
+	Oglf::Camera*	pUpdateCamera;		// moved by the update stage
+	Oglf::GLtransformer3D	oMeshTransformer;	// the mesh transform, rotated by the update stage
+	int				iCameraPositionBlock;	// frame state blocks
+	int				iCameraRotationBlock;
+	int				iMeshTransformBlock;
 
 	SceneDesc()
 		: iSceneID( 0 )
@@ -52,10 +95,15 @@ struct SceneDesc
 		, pSkyBoxDif( NULL )
 		, pSkyBoxSpec( NULL )
 		, pSkyBoxEnv( NULL )
-		, oSceneNeedUpdateLock( NULL )
+		, iMeshBatch( 0 )
 		, bSceneNeedUpdate( false )
-		, bMeshNeedUpdate( false )
+		, bLoaded( false )
+		, bMeshReady( false )
 		, pCamera( NULL )
+		, pUpdateCamera( NULL )
+		, iCameraPositionBlock( 0 )
+		, iCameraRotationBlock( 0 )
+		, iMeshTransformBlock( 0 )
 	{
 	}
 	~SceneDesc()
@@ -77,6 +125,8 @@ struct SceneDesc
 			delete pSkyBoxEnv;
 		if( pCamera )
 			delete pCamera;
+		if( pUpdateCamera )
+			delete pUpdateCamera;
 	}
 };
 
@@ -85,13 +135,30 @@ SceneDesc*	g_pScene2Desc;
 SceneDesc*	g_pScene3Desc;
 SceneDesc*	g_pCurrentSceneDesc;
 
+bool isSceneResident( SceneDesc* pDesc );
+
+// Scene prefetching
+const int	g_iSceneNb = 3;
+SceneDesc*	g_pSceneDescArray[ g_iSceneNb ];	// scenes in iSceneID order, which is the A, Z, E keys order
+const int	g_iPrefetchDistance = 1;			// scenes this close to the current one are loaded and kept resident
+double		g_dSceneSwitchStart = -1.0;			// time of the last scene switch key press, negative once its first frame is drawn
+bool		g_bSceneSwitchPrefetched;			// the scene was resident when its switch key was pressed
+
 
 Oglf::Renderer* g_pRenderer;
 
+// Texture streaming
+Oglf::TextureStreamer*	g_pTextureStreamer;
+const unsigned int		g_iStreamingStagingSize = 32 << 20;		// staging buffer size, holds a 1024x1024 RGBA16F face level
+const unsigned int		g_iStreamingBytesPerFrame = 4 << 20;	// upload budget per frame
+
+// Texture residency
+Oglf::TextureResidencyManager*	g_pTextureResidency;
+const unsigned int				g_iTextureBudget = 128 << 20;		// video memory budget of all the textures
+
 //GI Fx
 Oglf::RenderingFX*	g_pGiFx;
 int					g_iGiFxID;
-Oglf::Vec3			g_oCamPos;
 int					g_iCamPosFxID;
 int					g_iCubeDiffSamplerID;
 int					g_iCubeSpecSamplerID;
@@ -100,6 +167,65 @@ GLfloat				g_fAvgLuminance;
 GLfloat				g_fCurrentLum = 100.f;
 const int			g_iTMtexSize = 64;
 
+// Average luminance, summed by jobs over parts of the texture read back at most every g_dLuminancePeriod
+struct LuminanceSum
+{
+	const GLfloat*	pData;
+	int				iFirstPixel;
+	int				iPixelNb;
+	GLfloat			fSum;
+};
+const int			g_iLuminanceJobNb = 4;
+LuminanceSum		g_pLuminanceSums[ g_iLuminanceJobNb ];
+const double		g_dLuminancePeriod = 0.1;
+
+// Frame pipeline: the input callbacks only record the input of the frame. The update stage, a job run on the
+// workers, applies it to the update cameras and the mesh transforms and writes them to the frame state while the
+// render stage draws the state written by the previous update.
+struct MouseMove
+{
+	int		iDeltaX;
+	int		iDeltaY;
+	bool	bRotateCamera;
+	bool	bTrackCamera;
+	bool	bZoomCamera;
+	bool	bMoveObject;
+};
+struct FrameInput
+{
+	std::vector< MouseMove >	vMouseMoves;
+	bool						bToggleCameraPath;		// F3 has been pressed
+	bool						bToggleHud;				// F2 has been pressed, applied by the render stage
+
+	FrameInput()
+		: bToggleCameraPath( false )
+		, bToggleHud( false )
+	{
+	}
+};
+struct FrameUpdate
+{
+	SceneDesc*	pSceneDesc;			// the scene updated
+	SceneDesc*	pLastSceneDesc;		// the scene of the previous update
+	FrameInput	oInput;
+	int			iReplayFrame;		// the camera path frame replayed by the benchmark, negative when none
+
+	FrameUpdate()
+		: pSceneDesc( NULL )
+		, pLastSceneDesc( NULL )
+		, iReplayFrame( -1 )
+	{
+	}
+};
+FrameInput			g_oFrameInput;			// recorded by the callbacks
+FrameUpdate			g_oFrameUpdate;			// only accessed by the main thread while the update job is done
+Oglf::FrameState*	g_pFrameState = NULL;
+int					g_iEyePosBlock;			// bound to the GI effect eye position
+bool				g_bWindowResized = false;	// the render stage resizes the viewport
+
+Oglf::JobSystem*	g_pJobSystem = NULL;
+Oglf::UploadContext*	g_pUploadContext = NULL;	// compiles the meshes and uploads the streamed textures
+
 class HDRdemoRenderingConfiguration : public Oglf::RenderingConfiguration
 {
 public:
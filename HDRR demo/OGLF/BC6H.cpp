@@ -0,0 +1,448 @@
+#include <cstring>
+#include <cmath>
+#include <cstdlib>
+#include "BC6H.h"
+
+
+namespace Oglf
+{
+	// one region mode 11: 5 mode bits, two 10 bits RGB endpoints and 4 bits indices
+	static const int s_iModeBits = 5;
+	static const int s_iMode11 = 0x03;
+	static const int s_iEndpointBits = 10;
+	static const int s_iEndpointMax = ( 1 << s_iEndpointBits ) - 1;
+	static const int s_iIndexNb = 16;
+	static const int s_iMaxHalf = 0x7bff; // largest finite half float
+	static const int s_pWeights[ s_iIndexNb ] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	/**
+	* @brief one 4x4 block being encoded: texels are half float bit patterns, which BC6H interpolates
+	*/
+	struct BC6Hblock
+	{
+		int pTexels[ 16 ][ 3 ];
+		int pEndpoints[ 2 ][ 3 ]; // quantized endpoints
+		int pIndices[ 16 ];
+		double dError;
+	};
+
+	/**
+	* @brief expands a quantized endpoint component to 16 bits, as a decoder does
+	*/
+	static inline int unquantize( int iComp )
+	{
+		if( iComp == 0 )
+			return 0;
+		if( iComp == s_iEndpointMax )
+			return 0xffff;
+		return ( ( iComp << 16 ) + 0x8000 ) >> s_iEndpointBits;
+	}
+
+	/**
+	* @brief scales an interpolated 16 bits component back to the unsigned half float range
+	*/
+	static inline int finishUnquantize( int iComp )
+	{
+		return ( iComp * 31 ) >> 6;
+	}
+
+	/**
+	* @brief returns the quantized endpoint component that decodes the closest to a half float
+	*/
+	static int quantize( int iHalf )
+	{
+		int iBest = ( ( iHalf << s_iEndpointBits ) + ( s_iMaxHalf + 1 ) / 2 ) / ( s_iMaxHalf + 1 );
+		int iBestError = 0x10000;
+
+		for( int q = iBest - 1; q <= iBest + 1; ++q )
+		{
+			if( q < 0 || q > s_iEndpointMax )
+				continue;
+
+			int iError = abs( finishUnquantize( unquantize( q ) ) - iHalf );
+			if( iError < iBestError )
+			{
+				iBestError = iError;
+				iBest = q;
+			}
+		}
+		return iBest;
+	}
+
+	static inline int clampHalf( float fVal )
+	{
+		if( fVal < 0.f )
+			return 0;
+		if( fVal > ( float )s_iMaxHalf )
+			return s_iMaxHalf;
+		return ( int )( fVal + 0.5f );
+	}
+
+	/**
+	* @brief computes the 16 colors a pair of endpoints decodes to
+	*/
+	static void computePalette( const int pEndpoints[ 2 ][ 3 ], int pPalette[ s_iIndexNb ][ 3 ] )
+	{
+		for( int c = 0; c < 3; ++c )
+		{
+			int iA = unquantize( pEndpoints[ 0 ][ c ] );
+			int iB = unquantize( pEndpoints[ 1 ][ c ] );
+
+			for( int i = 0; i < s_iIndexNb; ++i )
+				pPalette[ i ][ c ] = finishUnquantize( ( iA * ( 64 - s_pWeights[ i ] ) + iB * s_pWeights[ i ] + 32 ) >> 6 );
+		}
+	}
+
+	/**
+	* @brief picks the closest palette entry for each texel and returns the block squared error
+	*/
+	static double assignIndices( const BC6Hblock& oBlock, const int pEndpoints[ 2 ][ 3 ], int pIndices[ 16 ] )
+	{
+		int pPalette[ s_iIndexNb ][ 3 ];
+		computePalette( pEndpoints, pPalette );
+
+		double dError = 0.0;
+		for( int t = 0; t < 16; ++t )
+		{
+			const int* pTexel = oBlock.pTexels[ t ];
+			double dBest = 1e30;
+
+			for( int i = 0; i < s_iIndexNb; ++i )
+			{
+				double dR = pPalette[ i ][ 0 ] - pTexel[ 0 ];
+				double dG = pPalette[ i ][ 1 ] - pTexel[ 1 ];
+				double dB = pPalette[ i ][ 2 ] - pTexel[ 2 ];
+				double d = dR * dR + dG * dG + dB * dB;
+
+				if( d < dBest )
+				{
+					dBest = d;
+					pIndices[ t ] = i;
+				}
+			}
+			dError += dBest;
+		}
+		return dError;
+	}
+
+	/**
+	* @brief keeps the given endpoints if they lower the block error
+	* @return true if the block has been improved
+	*/
+	static bool tryEndpoints( BC6Hblock& oBlock, const int pEndpoints[ 2 ][ 3 ] )
+	{
+		int pIndices[ 16 ];
+		double dError = assignIndices( oBlock, pEndpoints, pIndices );
+
+		if( dError >= oBlock.dError )
+			return false;
+
+		oBlock.dError = dError;
+		memcpy( oBlock.pEndpoints, pEndpoints, sizeof( oBlock.pEndpoints ) );
+		memcpy( oBlock.pIndices, pIndices, sizeof( oBlock.pIndices ) );
+		return true;
+	}
+
+	/**
+	* @brief fits the endpoints on the texels principal axis
+	*/
+	static void fitPrincipalAxis( BC6Hblock& oBlock )
+	{
+		float pMean[ 3 ] = { 0.f, 0.f, 0.f };
+		for( int t = 0; t < 16; ++t )
+			for( int c = 0; c < 3; ++c )
+				pMean[ c ] += oBlock.pTexels[ t ][ c ];
+		for( int c = 0; c < 3; ++c )
+			pMean[ c ] /= 16.f;
+
+		float pCov[ 6 ] = { 0.f, 0.f, 0.f, 0.f, 0.f, 0.f }; // xx, xy, xz, yy, yz, zz
+		for( int t = 0; t < 16; ++t )
+		{
+			float fX = oBlock.pTexels[ t ][ 0 ] - pMean[ 0 ];
+			float fY = oBlock.pTexels[ t ][ 1 ] - pMean[ 1 ];
+			float fZ = oBlock.pTexels[ t ][ 2 ] - pMean[ 2 ];
+			pCov[ 0 ] += fX * fX; pCov[ 1 ] += fX * fY; pCov[ 2 ] += fX * fZ;
+			pCov[ 3 ] += fY * fY; pCov[ 4 ] += fY * fZ; pCov[ 5 ] += fZ * fZ;
+		}
+
+		// power iterations converge to the covariance matrix dominant eigen vector
+		float pAxis[ 3 ] = { 1.f, 1.f, 1.f };
+		for( int i = 0; i < 8; ++i )
+		{
+			float fX = pCov[ 0 ] * pAxis[ 0 ] + pCov[ 1 ] * pAxis[ 1 ] + pCov[ 2 ] * pAxis[ 2 ];
+			float fY = pCov[ 1 ] * pAxis[ 0 ] + pCov[ 3 ] * pAxis[ 1 ] + pCov[ 4 ] * pAxis[ 2 ];
+			float fZ = pCov[ 2 ] * pAxis[ 0 ] + pCov[ 4 ] * pAxis[ 1 ] + pCov[ 5 ] * pAxis[ 2 ];
+			float fLength = sqrtf( fX * fX + fY * fY + fZ * fZ );
+
+			if( fLength < 1e-6f )
+				break;
+
+			pAxis[ 0 ] = fX / fLength;
+			pAxis[ 1 ] = fY / fLength;
+			pAxis[ 2 ] = fZ / fLength;
+		}
+
+		float fMin = 0.f, fMax = 0.f;
+		for( int t = 0; t < 16; ++t )
+		{
+			float fProj = ( oBlock.pTexels[ t ][ 0 ] - pMean[ 0 ] ) * pAxis[ 0 ]
+						+ ( oBlock.pTexels[ t ][ 1 ] - pMean[ 1 ] ) * pAxis[ 1 ]
+						+ ( oBlock.pTexels[ t ][ 2 ] - pMean[ 2 ] ) * pAxis[ 2 ];
+			if( fProj < fMin ) fMin = fProj;
+			if( fProj > fMax ) fMax = fProj;
+		}
+
+		for( int c = 0; c < 3; ++c )
+		{
+			oBlock.pEndpoints[ 0 ][ c ] = quantize( clampHalf( pMean[ c ] + fMin * pAxis[ c ] ) );
+			oBlock.pEndpoints[ 1 ][ c ] = quantize( clampHalf( pMean[ c ] + fMax * pAxis[ c ] ) );
+		}
+		oBlock.dError = assignIndices( oBlock, oBlock.pEndpoints, oBlock.pIndices );
+	}
+
+	/**
+	* @brief solves the least squares endpoints for the current indices, until the error stops decreasing
+	*/
+	static void refineLeastSquares( BC6Hblock& oBlock )
+	{
+		for( int iIter = 0; iIter < 8; ++iIter )
+		{
+			double dAA = 0.0, dAB = 0.0, dBB = 0.0;
+			double pAX[ 3 ] = { 0.0, 0.0, 0.0 };
+			double pBX[ 3 ] = { 0.0, 0.0, 0.0 };
+
+			for( int t = 0; t < 16; ++t )
+			{
+				double dW = s_pWeights[ oBlock.pIndices[ t ] ] / 64.0;
+				double dA = 1.0 - dW;
+
+				dAA += dA * dA;
+				dAB += dA * dW;
+				dBB += dW * dW;
+				for( int c = 0; c < 3; ++c )
+				{
+					pAX[ c ] += dA * oBlock.pTexels[ t ][ c ];
+					pBX[ c ] += dW * oBlock.pTexels[ t ][ c ];
+				}
+			}
+
+			double dDet = dAA * dBB - dAB * dAB;
+			if( fabs( dDet ) < 1e-9 )
+				return;
+
+			int pEndpoints[ 2 ][ 3 ];
+			for( int c = 0; c < 3; ++c )
+			{
+				pEndpoints[ 0 ][ c ] = quantize( clampHalf( ( float )( ( pAX[ c ] * dBB - pBX[ c ] * dAB ) / dDet ) ) );
+				pEndpoints[ 1 ][ c ] = quantize( clampHalf( ( float )( ( pBX[ c ] * dAA - pAX[ c ] * dAB ) / dDet ) ) );
+			}
+
+			if( !tryEndpoints( oBlock, pEndpoints ) )
+				return;
+		}
+	}
+
+	/**
+	* @brief nudges each quantized endpoint component by one step while it lowers the error
+	*/
+	static void refineEndpointsSearch( BC6Hblock& oBlock )
+	{
+		for( int iPass = 0; iPass < 4; ++iPass )
+		{
+			bool bImproved = false;
+
+			for( int e = 0; e < 2; ++e )
+			{
+				for( int c = 0; c < 3; ++c )
+				{
+					for( int iStep = -1; iStep <= 1; iStep += 2 )
+					{
+						int pEndpoints[ 2 ][ 3 ];
+						memcpy( pEndpoints, oBlock.pEndpoints, sizeof( pEndpoints ) );
+						pEndpoints[ e ][ c ] += iStep;
+
+						if( pEndpoints[ e ][ c ] < 0 || pEndpoints[ e ][ c ] > s_iEndpointMax )
+							continue;
+
+						bImproved |= tryEndpoints( oBlock, pEndpoints );
+					}
+				}
+			}
+
+			if( !bImproved )
+				return;
+		}
+	}
+
+	/**
+	* @brief appends bits to a block, least significant bit first
+	*/
+	static void writeBits( unsigned char* pBlock, int& iPos, int iValue, int iBitNb )
+	{
+		for( int b = 0; b < iBitNb; ++b, ++iPos )
+		{
+			if( ( iValue >> b ) & 1 )
+				pBlock[ iPos >> 3 ] |= ( unsigned char )( 1 << ( iPos & 7 ) );
+		}
+	}
+
+	static int readBits( const unsigned char* pBlock, int& iPos, int iBitNb )
+	{
+		int iValue = 0;
+		for( int b = 0; b < iBitNb; ++b, ++iPos )
+			iValue |= ( ( pBlock[ iPos >> 3 ] >> ( iPos & 7 ) ) & 1 ) << b;
+		return iValue;
+	}
+
+	static void writeBlock( BC6Hblock& oBlock, unsigned char* pBlock )
+	{
+		// the first texel index is stored without its most significant bit, which must then be 0
+		if( oBlock.pIndices[ 0 ] & 8 )
+		{
+			for( int c = 0; c < 3; ++c )
+			{
+				int iTmp = oBlock.pEndpoints[ 0 ][ c ];
+				oBlock.pEndpoints[ 0 ][ c ] = oBlock.pEndpoints[ 1 ][ c ];
+				oBlock.pEndpoints[ 1 ][ c ] = iTmp;
+			}
+			for( int t = 0; t < 16; ++t )
+				oBlock.pIndices[ t ] = s_iIndexNb - 1 - oBlock.pIndices[ t ];
+		}
+
+		memset( pBlock, 0, BC6H_BLOCK_BYTES );
+		int iPos = 0;
+
+		writeBits( pBlock, iPos, s_iMode11, s_iModeBits );
+		for( int e = 0; e < 2; ++e )
+			for( int c = 0; c < 3; ++c )
+				writeBits( pBlock, iPos, oBlock.pEndpoints[ e ][ c ], s_iEndpointBits );
+
+		writeBits( pBlock, iPos, oBlock.pIndices[ 0 ], 3 );
+		for( int t = 1; t < 16; ++t )
+			writeBits( pBlock, iPos, oBlock.pIndices[ t ], 4 );
+	}
+
+	/**
+	* @brief returns the BC6H compressed size of a picture
+	* @param iWidth the picture width
+	* @param iHeight the picture height
+	* @return the compressed size in bytes
+	*/
+	unsigned int getBC6Hsize( unsigned int iWidth, unsigned int iHeight )
+	{
+		return ( ( iWidth + 3 ) / 4 ) * ( ( iHeight + 3 ) / 4 ) * BC6H_BLOCK_BYTES;
+	}
+
+	/**
+	* @brief compresses a RGBA half float picture to unsigned BC6H (GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT_ARB).
+	* Only the one region mode with 10 bits endpoints is emitted, negative values are clamped to zero and
+	* the alpha channel is ignored.
+	* @param pRGBA the picture texels, 4 half floats per texel
+	* @param iWidth the picture width
+	* @param iHeight the picture height
+	* @param eQuality the encoder preset
+	* @param pBlocks the compressed picture, getBC6Hsize() bytes
+	* @param iFirstBlockRow the first row of blocks to compress, to split a picture between threads
+	* @param iBlockRowNb the number of rows of blocks to compress, -1 for all remaining rows
+	*/
+	void encodeBC6H( const Half* pRGBA, unsigned int iWidth, unsigned int iHeight, BC6Hquality eQuality,
+		unsigned char* pBlocks, int iFirstBlockRow, int iBlockRowNb )
+	{
+		int iBlocksX = ( iWidth + 3 ) / 4;
+		int iBlocksY = ( iHeight + 3 ) / 4;
+		int iLastBlockRow = ( iBlockRowNb < 0 ) ? iBlocksY : iFirstBlockRow + iBlockRowNb;
+		if( iLastBlockRow > iBlocksY )
+			iLastBlockRow = iBlocksY;
+
+		BC6Hblock oBlock;
+
+		for( int by = iFirstBlockRow; by < iLastBlockRow; ++by )
+		{
+			for( int bx = 0; bx < iBlocksX; ++bx )
+			{
+				// texels outside the picture replicate the last row or column
+				for( int t = 0; t < 16; ++t )
+				{
+					unsigned int x = bx * 4 + ( t & 3 );
+					unsigned int y = by * 4 + ( t >> 2 );
+					if( x >= iWidth )  x = iWidth - 1;
+					if( y >= iHeight ) y = iHeight - 1;
+
+					const Half* pTexel = pRGBA + 4 * ( y * iWidth + x );
+					for( int c = 0; c < 3; ++c )
+					{
+						int iHalf = pTexel[ c ];
+						// negative values clamp to 0, infinities and NaNs to the largest half
+						if( iHalf & 0x8000 )
+							iHalf = 0;
+						else if( iHalf > s_iMaxHalf )
+							iHalf = s_iMaxHalf;
+						oBlock.pTexels[ t ][ c ] = iHalf;
+					}
+				}
+
+				fitPrincipalAxis( oBlock );
+
+				if( eQuality == BC6H_QUALITY && oBlock.dError > 0.0 )
+				{
+					refineLeastSquares( oBlock );
+					refineEndpointsSearch( oBlock );
+				}
+
+				writeBlock( oBlock, pBlocks + ( by * iBlocksX + bx ) * BC6H_BLOCK_BYTES );
+			}
+		}
+	}
+
+	/**
+	* @brief decompresses a BC6H picture produced by encodeBC6H(), used to measure the encoding quality
+	* @param pBlocks the compressed picture
+	* @param iWidth the picture width
+	* @param iHeight the picture height
+	* @param pRGBA the decompressed picture, 4 half floats per texel with an alpha of 1
+	*/
+	void decodeBC6H( const unsigned char* pBlocks, unsigned int iWidth, unsigned int iHeight, Half* pRGBA )
+	{
+		int iBlocksX = ( iWidth + 3 ) / 4;
+		int iBlocksY = ( iHeight + 3 ) / 4;
+
+		for( int by = 0; by < iBlocksY; ++by )
+		{
+			for( int bx = 0; bx < iBlocksX; ++bx )
+			{
+				const unsigned char* pBlock = pBlocks + ( by * iBlocksX + bx ) * BC6H_BLOCK_BYTES;
+				int pEndpoints[ 2 ][ 3 ];
+				int pIndices[ 16 ];
+				int iPos = 0;
+
+				int iMode = readBits( pBlock, iPos, s_iModeBits );
+				for( int e = 0; e < 2; ++e )
+					for( int c = 0; c < 3; ++c )
+						pEndpoints[ e ][ c ] = readBits( pBlock, iPos, s_iEndpointBits );
+
+				pIndices[ 0 ] = readBits( pBlock, iPos, 3 );
+				for( int t = 1; t < 16; ++t )
+					pIndices[ t ] = readBits( pBlock, iPos, 4 );
+
+				int pPalette[ s_iIndexNb ][ 3 ];
+				if( iMode == s_iMode11 )
+					computePalette( pEndpoints, pPalette );
+				else
+					memset( pPalette, 0, sizeof( pPalette ) ); // modes we never emit decode to black
+
+				for( int t = 0; t < 16; ++t )
+				{
+					unsigned int x = bx * 4 + ( t & 3 );
+					unsigned int y = by * 4 + ( t >> 2 );
+					if( x >= iWidth || y >= iHeight )
+						continue;
+
+					Half* pTexel = pRGBA + 4 * ( y * iWidth + x );
+					for( int c = 0; c < 3; ++c )
+						pTexel[ c ] = ( Half )pPalette[ pIndices[ t ] ][ c ];
+					pTexel[ 3 ] = 0x3c00;
+				}
+			}
+		}
+	}
+}
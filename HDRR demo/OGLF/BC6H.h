@@ -0,0 +1,52 @@
+#ifndef BC6H_H
+#define BC6H_H
+
+#include "HalfFloat.h"
+
+namespace Oglf
+{
+	/**
+	* @brief BC6H encoder presets
+	*/
+	enum BC6Hquality
+	{
+		BC6H_FAST,		// principal axis endpoints only
+		BC6H_QUALITY	// least squares endpoints refinement and endpoints search
+	};
+
+	const unsigned int BC6H_BLOCK_BYTES = 16; // a 4x4 texels block is stored in 128 bits
+
+	/**
+	* @brief returns the BC6H compressed size of a picture
+	* @param iWidth the picture width
+	* @param iHeight the picture height
+	* @return the compressed size in bytes
+	*/
+	unsigned int getBC6Hsize( unsigned int iWidth, unsigned int iHeight );
+
+	/**
+	* @brief compresses a RGBA half float picture to unsigned BC6H (GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT_ARB).
+	* Only the one region mode with 10 bits endpoints is emitted, negative values are clamped to zero and
+	* the alpha channel is ignored.
+	* @param pRGBA the picture texels, 4 half floats per texel
+	* @param iWidth the picture width
+	* @param iHeight the picture height
+	* @param eQuality the encoder preset
+	* @param pBlocks the compressed picture, getBC6Hsize() bytes
+	* @param iFirstBlockRow the first row of blocks to compress, to split a picture between threads
+	* @param iBlockRowNb the number of rows of blocks to compress, -1 for all remaining rows
+	*/
+	void encodeBC6H( const Half* pRGBA, unsigned int iWidth, unsigned int iHeight, BC6Hquality eQuality,
+		unsigned char* pBlocks, int iFirstBlockRow = 0, int iBlockRowNb = -1 );
+
+	/**
+	* @brief decompresses a BC6H picture produced by encodeBC6H(), used to measure the encoding quality
+	* @param pBlocks the compressed picture
+	* @param iWidth the picture width
+	* @param iHeight the picture height
+	* @param pRGBA the decompressed picture, 4 half floats per texel with an alpha of 1
+	*/
+	void decodeBC6H( const unsigned char* pBlocks, unsigned int iWidth, unsigned int iHeight, Half* pRGBA );
+}
+
+#endif /* BC6H_H */
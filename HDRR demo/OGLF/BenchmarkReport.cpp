@@ -0,0 +1,279 @@
+#include "BenchmarkReport.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <cstdlib>
+#include <cctype>
+#include "Error.h"
+
+using namespace std;
+
+namespace Oglf
+{
+	/**
+	* @brief constructor
+	* @param sName the benchmark name
+	*/
+	BenchmarkReport::BenchmarkReport( const string& sName )
+		: m_sName( sName )
+	{
+	}
+
+	/**
+	* @brief adds the time of a frame
+	* @param fTime the time in ms
+	*/
+	void BenchmarkReport::addFrameTime( float fTime )
+	{
+		m_vFrameTimes.push_back( fTime );
+	}
+
+	/**
+	* @brief adds the time spent in a stage during a frame
+	* @param sStage the stage name
+	* @param fTime the time in ms
+	*/
+	void BenchmarkReport::addStageTime( const string& sStage, float fTime )
+	{
+		size_t i = 0;
+		while( i < m_vStages.size() && m_vStages[ i ].sName != sStage )
+			++i;
+
+		if( i == m_vStages.size() )
+		{
+			m_vStages.push_back( Stage() );
+			m_vStages.back().sName = sStage;
+		}
+
+		m_vStages[ i ].vTimes.push_back( fTime );
+	}
+
+	/**
+	* @brief computes the distribution of samples
+	* @param vTimes the samples
+	* @param oTiming the distribution, zero when there is no sample
+	*/
+	void BenchmarkReport::computeTiming( const vector<float>& vTimes, BenchmarkTiming& oTiming )
+	{
+		if( vTimes.empty() )
+		{
+			oTiming.fMin = oTiming.fMedian = oTiming.fP95 = oTiming.fP99 = oTiming.fMax = oTiming.fMean = 0.f;
+			return;
+		}
+
+		vector<float> vSorted( vTimes );
+		sort( vSorted.begin(), vSorted.end() );
+
+		// a percentile is the sample closest to its rank in the sorted samples, without interpolation
+		size_t iLast = vSorted.size() - 1;
+		oTiming.fMin = vSorted.front();
+		oTiming.fMedian = vSorted[ iLast / 2 ];
+		oTiming.fP95 = vSorted[ ( size_t )( 0.95 * iLast + 0.5 ) ];
+		oTiming.fP99 = vSorted[ ( size_t )( 0.99 * iLast + 0.5 ) ];
+		oTiming.fMax = vSorted.back();
+
+		double dSum = 0.0;
+		for( size_t i = 0; i < vSorted.size(); ++i )
+			dSum += vSorted[ i ];
+		oTiming.fMean = ( float )( dSum / vSorted.size() );
+	}
+
+	/**
+	* @brief returns the distribution of the frame times
+	* @param oTiming the distribution
+	*/
+	void BenchmarkReport::getFrameTiming( BenchmarkTiming& oTiming ) const
+	{
+		computeTiming( m_vFrameTimes, oTiming );
+	}
+
+	/**
+	* @brief writes a timing distribution in a JSON file
+	* @param oFile the file
+	* @param oTiming the distribution
+	*/
+	static void writeTiming( ofstream& oFile, const BenchmarkTiming& oTiming )
+	{
+		oFile << "{ \"min\": " << oTiming.fMin << ", \"median\": " << oTiming.fMedian << ", \"p95\": " << oTiming.fP95
+			<< ", \"p99\": " << oTiming.fP99 << ", \"max\": " << oTiming.fMax << ", \"mean\": " << oTiming.fMean << " }";
+	}
+
+	/**
+	* @brief writes the report to a JSON file
+	* @param sFilename the file name
+	*/
+	void BenchmarkReport::save( const string& sFilename ) const
+	{
+		ofstream oFile( sFilename.c_str() );
+		if( !oFile )
+			throw Error( "BenchmarkReport::save error : Failed to create the report file", sFilename );
+
+		BenchmarkTiming oTiming;
+		oFile << fixed << setprecision( 3 );
+		oFile << "{" << endl;
+		oFile << "\t\"name\": \"" << m_sName << "\"," << endl;
+		oFile << "\t\"frames\": " << m_vFrameTimes.size() << "," << endl;
+
+		computeTiming( m_vFrameTimes, oTiming );
+		oFile << "\t\"frame\": ";
+		writeTiming( oFile, oTiming );
+		oFile << "," << endl;
+
+		oFile << "\t\"stages\": {";
+		for( size_t i = 0; i < m_vStages.size(); ++i )
+		{
+			computeTiming( m_vStages[ i ].vTimes, oTiming );
+			oFile << ( i > 0 ? "," : "" ) << endl << "\t\t\"" << m_vStages[ i ].sName << "\": ";
+			writeTiming( oFile, oTiming );
+		}
+		oFile << endl << "\t}" << endl;
+		oFile << "}" << endl;
+
+		if( !oFile )
+			throw Error( "BenchmarkReport::save error : Failed to write the report file", sFilename );
+	}
+
+	/**
+	* @brief reads the numbers of a JSON report
+	* @param sFilename the file name
+	* @param mValues the numbers, by their keys path joined with dots: "frame.p95", "stages.render.median"
+	*/
+	void BenchmarkReport::readValues( const string& sFilename, map<string, float>& mValues )
+	{
+		ifstream oFile( sFilename.c_str() );
+		if( !oFile )
+			throw Error( "BenchmarkReport::readValues error : Failed to open the report file", sFilename );
+
+		stringstream oStream;
+		oStream << oFile.rdbuf();
+		const string sText = oStream.str();
+
+		// only the objects, the string keys and the numbers written by save() are parsed
+		vector<string> vPath;
+		string sKey;
+		size_t i = 0;
+		while( i < sText.size() )
+		{
+			char cChar = sText[ i ];
+			if( cChar == '"' )
+			{
+				size_t iEnd = sText.find( '"', i + 1 );
+				if( iEnd == string::npos )
+					throw Error( "BenchmarkReport::readValues error : Unterminated string", sFilename );
+
+				sKey = sText.substr( i + 1, iEnd - i - 1 );
+				i = iEnd + 1;
+				while( i < sText.size() && isspace( ( unsigned char )sText[ i ] ) )
+					++i;
+
+				// a string value is skipped with its key
+				if( i < sText.size() && sText[ i ] == ':' )
+				{
+					++i;
+					while( i < sText.size() && isspace( ( unsigned char )sText[ i ] ) )
+						++i;
+					if( i < sText.size() && sText[ i ] == '"' )
+					{
+						i = sText.find( '"', i + 1 );
+						if( i == string::npos )
+							throw Error( "BenchmarkReport::readValues error : Unterminated string", sFilename );
+						++i;
+						sKey.clear();
+					}
+				}
+				continue;
+			}
+			else if( cChar == '{' )
+			{
+				if( !sKey.empty() )
+					vPath.push_back( sKey );
+				sKey.clear();
+			}
+			else if( cChar == '}' )
+			{
+				if( !vPath.empty() )
+					vPath.pop_back();
+			}
+			else if( !sKey.empty() && ( isdigit( ( unsigned char )cChar ) || cChar == '-' ) )
+			{
+				char* pEnd;
+				float fValue = ( float )strtod( sText.c_str() + i, &pEnd );
+
+				string sPath;
+				for( size_t j = 0; j < vPath.size(); ++j )
+					sPath += vPath[ j ] + ".";
+				mValues[ sPath + sKey ] = fValue;
+
+				sKey.clear();
+				i = pEnd - sText.c_str();
+				continue;
+			}
+			++i;
+		}
+	}
+
+	/**
+	* @brief compares a timing with the baseline and prints it
+	* @param sName the timing name
+	* @param sPath the timing path in the reports
+	* @param fValue the timing
+	* @param mBaseline the baseline numbers
+	* @param fTolerance the relative increase tolerated
+	* @return false when the timing regressed
+	*/
+	static bool compareTiming( const string& sName, const string& sPath, float fValue, const map<string, float>& mBaseline, float fTolerance )
+	{
+		map<string, float>::const_iterator it = mBaseline.find( sPath );
+		if( it == mBaseline.end() )
+			return true;
+
+		float fBaseline = it->second;
+		float fChange = fBaseline > 0.f ? ( fValue - fBaseline ) / fBaseline : 0.f;
+		bool bRegressed = fChange > fTolerance;
+
+		cout << "  " << left << setw( 32 ) << sName << right << setw( 9 ) << fBaseline << " -> " << setw( 9 ) << fValue << " ms  "
+			<< showpos << fChange * 100.f << noshowpos << "%" << ( bRegressed ? "  REGRESSION" : "" ) << endl;
+
+		return !bRegressed;
+	}
+
+	/**
+	* @brief compares the median and the percentiles with a baseline report and prints the regressions
+	* @param sBaselineFilename the baseline report, written by save()
+	* @param fTolerance the relative increase over the baseline tolerated, 0.1 for 10%
+	* @return false when a timing regressed
+	*/
+	bool BenchmarkReport::compare( const string& sBaselineFilename, float fTolerance ) const
+	{
+		map<string, float> mBaseline;
+		readValues( sBaselineFilename, mBaseline );
+
+		static const char* pMetrics[] = { "median", "p95", "p99" };
+		bool bPassed = true;
+		BenchmarkTiming oTiming;
+
+		cout << "Benchmark comparison with " << sBaselineFilename << " (tolerance " << fTolerance * 100.f << "%):" << endl;
+		cout << fixed << setprecision( 3 );
+
+		for( int iStage = -1; iStage < ( int )m_vStages.size(); ++iStage )
+		{
+			string sStage = iStage < 0 ? "frame" : m_vStages[ iStage ].sName;
+			string sPath = iStage < 0 ? "frame." : "stages." + sStage + ".";
+			computeTiming( iStage < 0 ? m_vFrameTimes : m_vStages[ iStage ].vTimes, oTiming );
+
+			float pValues[] = { oTiming.fMedian, oTiming.fP95, oTiming.fP99 };
+			for( int i = 0; i < 3; ++i )
+			{
+				if( !compareTiming( sStage + " " + pMetrics[ i ], sPath + pMetrics[ i ], pValues[ i ], mBaseline, fTolerance ) )
+					bPassed = false;
+			}
+		}
+
+		cout.unsetf( ios::floatfield );
+		cout << setprecision( 6 );
+
+		return bPassed;
+	}
+}
@@ -0,0 +1,110 @@
+#ifndef BENCHMARKREPORT_H
+#define BENCHMARKREPORT_H
+
+#include <string>
+#include <vector>
+#include <map>
+
+namespace Oglf
+{
+	/**
+	* @brief the distribution of a timing over the benchmarked frames, in ms
+	*/
+	struct BenchmarkTiming
+	{
+		float	fMin;
+		float	fMedian;
+		float	fP95;
+		float	fP99;
+		float	fMax;
+		float	fMean;
+	};
+
+	/**
+	* class BenchmarkReport collects the frame times and the per stage times of a benchmark run, reports their
+	* min, median, 95th and 99th percentiles in a JSON file and compares them with a baseline report. Percentiles
+	* are used rather than averages because a stutter every few frames hardly moves the average. The stage names
+	* are written as is and must not contain quotes or dots.
+	*/
+	class BenchmarkReport
+	{
+		/**
+		* @brief the samples of a stage
+		*/
+		struct Stage
+		{
+			std::string			sName;
+			std::vector<float>	vTimes;
+		};
+
+		std::string			m_sName;
+		std::vector<float>	m_vFrameTimes;
+		std::vector<Stage>	m_vStages;		// in the order they were first timed
+
+		/**
+		* @brief computes the distribution of samples
+		* @param vTimes the samples
+		* @param oTiming the distribution, zero when there is no sample
+		*/
+		static void computeTiming( const std::vector<float>& vTimes, BenchmarkTiming& oTiming );
+
+		/**
+		* @brief reads the numbers of a JSON report
+		* @param sFilename the file name
+		* @param mValues the numbers, by their keys path joined with dots: "frame.p95", "stages.render.median"
+		*/
+		static void readValues( const std::string& sFilename, std::map<std::string, float>& mValues );
+
+	public:
+
+		/**
+		* @brief constructor
+		* @param sName the benchmark name
+		*/
+		BenchmarkReport( const std::string& sName );
+
+		/**
+		* @brief adds the time of a frame
+		* @param fTime the time in ms
+		*/
+		void addFrameTime( float fTime );
+
+		/**
+		* @brief adds the time spent in a stage during a frame
+		* @param sStage the stage name
+		* @param fTime the time in ms
+		*/
+		void addStageTime( const std::string& sStage, float fTime );
+
+		/**
+		* @brief returns the number of frames timed
+		* @return the number of frame times
+		*/
+		int getFrameNb() const
+		{
+			return ( int )m_vFrameTimes.size();
+		}
+
+		/**
+		* @brief returns the distribution of the frame times
+		* @param oTiming the distribution
+		*/
+		void getFrameTiming( BenchmarkTiming& oTiming ) const;
+
+		/**
+		* @brief writes the report to a JSON file
+		* @param sFilename the file name
+		*/
+		void save( const std::string& sFilename ) const;
+
+		/**
+		* @brief compares the median and the percentiles with a baseline report and prints the regressions
+		* @param sBaselineFilename the baseline report, written by save()
+		* @param fTolerance the relative increase over the baseline tolerated, 0.1 for 10%
+		* @return false when a timing regressed
+		*/
+		bool compare( const std::string& sBaselineFilename, float fTolerance ) const;
+	};
+}
+
+#endif /* BENCHMARKREPORT_H */
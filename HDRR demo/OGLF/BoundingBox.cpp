@@ -0,0 +1,473 @@
+#include <math.h>
+#include <float.h>
+#include <vector>
+#include <algorithm>
+#include "BoundingBox.h"
+#include "JobSystem.h"
+#include "utils.h"
+
+using namespace std;
+
+
+namespace Oglf
+{
+	// vertices reduced by a job, large meshes are split in ranges of about this size
+	static const int g_iBoundsJobSize = 16384;
+
+	// vertices whose covariance sums are accumulated in floats before being added to the double ones
+	static const int g_iCovarianceBlockSize = 1024;
+
+	/**
+	* @brief the reductions of the vertices of a range
+	*/
+	enum BoundsMode
+	{
+		BOUNDS_BOX,			// the minimum and maximum coordinates
+		BOUNDS_SPHERE,		// the maximum squared distance to the origin
+		BOUNDS_COVARIANCE,	// the sums of the coordinates and of their products, relative to the origin
+		BOUNDS_PROJECTION	// the minimum and maximum projections on the axes
+	};
+
+	/**
+	* @brief a range of vertices reduced by a job, and its result
+	*/
+	struct BoundsRange
+	{
+		BoundsMode		eMode;
+		const Vec3*		pVertices;
+		int				iStart;
+		int				iEnd;
+		Vec3			oOrigin;
+		Vec3			pAxes[ 3 ];
+		float			pMin[ 3 ];
+		float			pMax[ 3 ];
+		float			fMaxDistance2;
+		double			pSums[ 9 ];		// x, y, z, xx, xy, xz, yy, yz, zz
+	};
+
+	/**
+	* @brief computes the minimum and maximum coordinates of a range. The Vec3 are packed: 4 vertices are 3 packets,
+	* whose minimum and maximum are accumulated, each lane always holding the same coordinate, and gathered at the end
+	*/
+	static void reduceBox( BoundsRange& oRange )
+	{
+		const Vec3* pVertices = oRange.pVertices + oRange.iStart;
+		int iNb = oRange.iEnd - oRange.iStart;
+		int i = 0;
+
+		for( int c = 0; c < 3; ++c )
+			oRange.pMin[ c ] = oRange.pMax[ c ] = pVertices[ 0 ].v[ c ];
+
+		if( iNb >= 4 )
+		{
+			const float* pData = pVertices[ 0 ].v;
+
+			Float4 pPacketMin[ 3 ], pPacketMax[ 3 ];
+			for( int j = 0; j < 3; ++j )
+				pPacketMin[ j ] = pPacketMax[ j ] = Float4::load( pData + 4 * j );
+
+			for( i = 4; i + 4 <= iNb; i += 4 )
+			{
+				for( int j = 0; j < 3; ++j )
+				{
+					Float4 oPacket = Float4::load( pData + 3 * i + 4 * j );
+					pPacketMin[ j ] = Float4::minimum( pPacketMin[ j ], oPacket );
+					pPacketMax[ j ] = Float4::maximum( pPacketMax[ j ], oPacket );
+				}
+			}
+
+			// the lane k of the packet j holds the coordinate ( 4 * j + k ) % 3
+			for( int j = 0; j < 3; ++j )
+			{
+				for( int k = 0; k < 4; ++k )
+				{
+					int c = ( 4 * j + k ) % 3;
+					oRange.pMin[ c ] = minT( oRange.pMin[ c ], pPacketMin[ j ][ k ] );
+					oRange.pMax[ c ] = maxT( oRange.pMax[ c ], pPacketMax[ j ][ k ] );
+				}
+			}
+		}
+
+		for( ; i < iNb; ++i )
+		{
+			for( int c = 0; c < 3; ++c )
+			{
+				oRange.pMin[ c ] = minT( oRange.pMin[ c ], pVertices[ i ].v[ c ] );
+				oRange.pMax[ c ] = maxT( oRange.pMax[ c ], pVertices[ i ].v[ c ] );
+			}
+		}
+	}
+
+	/**
+	* @brief computes the maximum squared distance of the vertices of a range to the origin
+	*/
+	static void reduceSphere( BoundsRange& oRange )
+	{
+		const Vec3* pVertices = oRange.pVertices + oRange.iStart;
+		int iNb = oRange.iEnd - oRange.iStart;
+		int i = 0;
+
+		Vec3x4 oOrigin( oRange.oOrigin );
+		Float4 oMax;
+		for( ; i + 4 <= iNb; i += 4 )
+			oMax = Float4::maximum( oMax, ( Vec3x4::load( pVertices + i ) - oOrigin ).length2() );
+
+		oRange.fMaxDistance2 = 0.f;
+		for( int k = 0; k < 4; ++k )
+			oRange.fMaxDistance2 = maxT( oRange.fMaxDistance2, oMax[ k ] );
+
+		for( ; i < iNb; ++i )
+			oRange.fMaxDistance2 = maxT( oRange.fMaxDistance2, ( pVertices[ i ] - oRange.oOrigin ).length2() );
+	}
+
+	/**
+	* @brief sums the coordinates of the vertices of a range and their products, relative to the origin. The sums are
+	* accumulated by blocks in floats, then added to doubles so that large meshes lose no precision.
+	*/
+	static void reduceCovariance( BoundsRange& oRange )
+	{
+		const Vec3* pVertices = oRange.pVertices + oRange.iStart;
+		int iNb = oRange.iEnd - oRange.iStart;
+
+		for( int k = 0; k < 9; ++k )
+			oRange.pSums[ k ] = 0.0;
+
+		Vec3x4 oOrigin( oRange.oOrigin );
+		for( int iBlock = 0; iBlock < iNb; iBlock += g_iCovarianceBlockSize )
+		{
+			int iBlockEnd = minT( iBlock + g_iCovarianceBlockSize, iNb );
+			int i = iBlock;
+
+			Float4 pSums[ 9 ];
+			for( ; i + 4 <= iBlockEnd; i += 4 )
+			{
+				Vec3x4 p = Vec3x4::load( pVertices + i ) - oOrigin;
+				pSums[ 0 ] = pSums[ 0 ] + p.x;
+				pSums[ 1 ] = pSums[ 1 ] + p.y;
+				pSums[ 2 ] = pSums[ 2 ] + p.z;
+				pSums[ 3 ] = pSums[ 3 ] + p.x * p.x;
+				pSums[ 4 ] = pSums[ 4 ] + p.x * p.y;
+				pSums[ 5 ] = pSums[ 5 ] + p.x * p.z;
+				pSums[ 6 ] = pSums[ 6 ] + p.y * p.y;
+				pSums[ 7 ] = pSums[ 7 ] + p.y * p.z;
+				pSums[ 8 ] = pSums[ 8 ] + p.z * p.z;
+			}
+
+			for( int k = 0; k < 9; ++k )
+				oRange.pSums[ k ] += pSums[ k ].sum();
+
+			for( ; i < iBlockEnd; ++i )
+			{
+				Vec3 p = pVertices[ i ] - oRange.oOrigin;
+				oRange.pSums[ 0 ] += p.v[ 0 ];
+				oRange.pSums[ 1 ] += p.v[ 1 ];
+				oRange.pSums[ 2 ] += p.v[ 2 ];
+				oRange.pSums[ 3 ] += p.v[ 0 ] * p.v[ 0 ];
+				oRange.pSums[ 4 ] += p.v[ 0 ] * p.v[ 1 ];
+				oRange.pSums[ 5 ] += p.v[ 0 ] * p.v[ 2 ];
+				oRange.pSums[ 6 ] += p.v[ 1 ] * p.v[ 1 ];
+				oRange.pSums[ 7 ] += p.v[ 1 ] * p.v[ 2 ];
+				oRange.pSums[ 8 ] += p.v[ 2 ] * p.v[ 2 ];
+			}
+		}
+	}
+
+	/**
+	* @brief computes the minimum and maximum projections of the vertices of a range on the axes
+	*/
+	static void reduceProjection( BoundsRange& oRange )
+	{
+		const Vec3* pVertices = oRange.pVertices + oRange.iStart;
+		int iNb = oRange.iEnd - oRange.iStart;
+		int i = 0;
+
+		for( int c = 0; c < 3; ++c )
+			oRange.pMin[ c ] = oRange.pMax[ c ] = pVertices[ 0 ] | oRange.pAxes[ c ];
+
+		if( iNb >= 4 )
+		{
+			Vec3x4 pAxes[ 3 ];
+			Float4 pPacketMin[ 3 ], pPacketMax[ 3 ];
+
+			Vec3x4 p = Vec3x4::load( pVertices );
+			for( int c = 0; c < 3; ++c )
+			{
+				pAxes[ c ] = Vec3x4( oRange.pAxes[ c ] );
+				pPacketMin[ c ] = pPacketMax[ c ] = p | pAxes[ c ];
+			}
+
+			for( i = 4; i + 4 <= iNb; i += 4 )
+			{
+				p = Vec3x4::load( pVertices + i );
+				for( int c = 0; c < 3; ++c )
+				{
+					Float4 oProjection = p | pAxes[ c ];
+					pPacketMin[ c ] = Float4::minimum( pPacketMin[ c ], oProjection );
+					pPacketMax[ c ] = Float4::maximum( pPacketMax[ c ], oProjection );
+				}
+			}
+
+			for( int c = 0; c < 3; ++c )
+			{
+				for( int k = 0; k < 4; ++k )
+				{
+					oRange.pMin[ c ] = minT( oRange.pMin[ c ], pPacketMin[ c ][ k ] );
+					oRange.pMax[ c ] = maxT( oRange.pMax[ c ], pPacketMax[ c ][ k ] );
+				}
+			}
+		}
+
+		for( ; i < iNb; ++i )
+		{
+			for( int c = 0; c < 3; ++c )
+			{
+				float fProjection = pVertices[ i ] | oRange.pAxes[ c ];
+				oRange.pMin[ c ] = minT( oRange.pMin[ c ], fProjection );
+				oRange.pMax[ c ] = maxT( oRange.pMax[ c ], fProjection );
+			}
+		}
+	}
+
+	/**
+	* @brief job reducing a range of vertices
+	* @param pData the BoundsRange
+	*/
+	static void boundsJob( void* pData )
+	{
+		BoundsRange& oRange = *static_cast< BoundsRange* >( pData );
+
+		switch( oRange.eMode )
+		{
+		case BOUNDS_BOX:		reduceBox( oRange );		break;
+		case BOUNDS_SPHERE:		reduceSphere( oRange );		break;
+		case BOUNDS_COVARIANCE:	reduceCovariance( oRange );	break;
+		case BOUNDS_PROJECTION:	reduceProjection( oRange );	break;
+		}
+	}
+
+	/**
+	* @brief reduces vertices, split in ranges reduced by the job system workers for large meshes, and merges the
+	* ranges results
+	* @param oReduction the mode, the vertices and the origin or the axes of the reduction
+	* @param iNb the number of vertices, at least 1
+	* @param pJobSystem the job system, may be NULL
+	* @return the result, in the fields of the mode
+	*/
+	static BoundsRange runBounds( const BoundsRange& oReduction, int iNb, JobSystem* pJobSystem )
+	{
+		// the ranges start on a multiple of 4 vertices, for the SSE packets
+		vector< BoundsRange > vRanges;
+		BoundsRange oResult = runRanges( pJobSystem, boundsJob, oReduction, iNb, g_iBoundsJobSize, 4, vRanges );
+
+		// the fields the mode does not compute are merged as well, their result is unused
+		oResult.iStart = 0;
+		oResult.iEnd = iNb;
+		for( size_t i = 1; i < vRanges.size(); ++i )
+		{
+			for( int c = 0; c < 3; ++c )
+			{
+				oResult.pMin[ c ] = minT( oResult.pMin[ c ], vRanges[ i ].pMin[ c ] );
+				oResult.pMax[ c ] = maxT( oResult.pMax[ c ], vRanges[ i ].pMax[ c ] );
+			}
+			oResult.fMaxDistance2 = maxT( oResult.fMaxDistance2, vRanges[ i ].fMaxDistance2 );
+			for( int k = 0; k < 9; ++k )
+				oResult.pSums[ k ] += vRanges[ i ].pSums[ k ];
+		}
+
+		return oResult;
+	}
+
+	/**
+	* @brief builds a reduction of the vertices
+	*/
+	static BoundsRange makeBounds( BoundsMode eMode, const MeshVec3Array& vVertices )
+	{
+		BoundsRange oReduction;
+		oReduction.eMode = eMode;
+		oReduction.pVertices = &vVertices[ 0 ];
+		oReduction.iStart = oReduction.iEnd = 0;
+		for( int c = 0; c < 3; ++c )
+		{
+			oReduction.pMin[ c ] = FLT_MAX;
+			oReduction.pMax[ c ] = -FLT_MAX;
+		}
+		oReduction.fMaxDistance2 = 0.f;
+		for( int k = 0; k < 9; ++k )
+			oReduction.pSums[ k ] = 0.0;
+		return oReduction;
+	}
+
+	/**
+	* @brief diagonalizes a symmetric 3x3 matrix with Jacobi rotations
+	* @param a the matrix, its diagonal holds the eigenvalues on return
+	* @param v the eigenvectors, in columns
+	*/
+	static void diagonalize( double a[ 3 ][ 3 ], double v[ 3 ][ 3 ] )
+	{
+		for( int i = 0; i < 3; ++i )
+			for( int j = 0; j < 3; ++j )
+				v[ i ][ j ] = i == j ? 1.0 : 0.0;
+
+		for( int iSweep = 0; iSweep < 32; ++iSweep )
+		{
+			double dOff = a[ 0 ][ 1 ] * a[ 0 ][ 1 ] + a[ 0 ][ 2 ] * a[ 0 ][ 2 ] + a[ 1 ][ 2 ] * a[ 1 ][ 2 ];
+			double dDiagonal = a[ 0 ][ 0 ] * a[ 0 ][ 0 ] + a[ 1 ][ 1 ] * a[ 1 ][ 1 ] + a[ 2 ][ 2 ] * a[ 2 ][ 2 ];
+			if( dOff <= 1e-24 * dDiagonal || dOff == 0.0 )
+				break;
+
+			for( int p = 0; p < 2; ++p )
+			{
+				for( int q = p + 1; q < 3; ++q )
+				{
+					if( a[ p ][ q ] == 0.0 )
+						continue;
+
+					// the rotation in the plane (p, q) zeroing a[ p ][ q ]
+					double dTheta = ( a[ q ][ q ] - a[ p ][ p ] ) / ( 2.0 * a[ p ][ q ] );
+					double t = ( dTheta >= 0.0 ? 1.0 : -1.0 ) / ( fabs( dTheta ) + sqrt( dTheta * dTheta + 1.0 ) );
+					double c = 1.0 / sqrt( t * t + 1.0 );
+					double s = t * c;
+
+					for( int k = 0; k < 3; ++k )
+					{
+						double dP = a[ k ][ p ], dQ = a[ k ][ q ];
+						a[ k ][ p ] = c * dP - s * dQ;
+						a[ k ][ q ] = s * dP + c * dQ;
+					}
+					for( int k = 0; k < 3; ++k )
+					{
+						double dP = a[ p ][ k ], dQ = a[ q ][ k ];
+						a[ p ][ k ] = c * dP - s * dQ;
+						a[ q ][ k ] = s * dP + c * dQ;
+					}
+					for( int k = 0; k < 3; ++k )
+					{
+						double dP = v[ k ][ p ], dQ = v[ k ][ q ];
+						v[ k ][ p ] = c * dP - s * dQ;
+						v[ k ][ q ] = s * dP + c * dQ;
+					}
+				}
+			}
+		}
+	}
+
+	/**
+	* @brief empties the volumes: they are reduced to the origin
+	*/
+	void BoundingBox::clear()
+	{
+		left = right = front = back = top = bottom = 0.f;
+		maxX = maxY = maxZ = 0.f;
+		sphereCenter = Vec3();
+		sphereRadius = 0.f;
+		obbCenter = Vec3();
+		obbAxes[ 0 ] = Vec3( 1.f, 0.f, 0.f );
+		obbAxes[ 1 ] = Vec3( 0.f, 1.f, 0.f );
+		obbAxes[ 2 ] = Vec3( 0.f, 0.f, 1.f );
+		obbHalfSizes = Vec3();
+	}
+
+	/**
+	* @brief computes the axis aligned box, whose planes are the minimum and maximum vertices coordinates
+	* @param pJobSystem spreads the reduction of large meshes over its workers, may be NULL
+	*/
+	void BoundingBox::build( JobSystem* pJobSystem )
+	{
+		if( vertices->empty() )
+		{
+			clear();
+			return;
+		}
+
+		BoundsRange oBox = runBounds( makeBounds( BOUNDS_BOX, *vertices ), ( int )vertices->size(), pJobSystem );
+
+		left = oBox.pMin[ 0 ];		right = oBox.pMax[ 0 ];
+		bottom = oBox.pMin[ 1 ];	top = oBox.pMax[ 1 ];
+		back = oBox.pMin[ 2 ];		front = oBox.pMax[ 2 ];
+
+		maxX= Oglf::maxT<float>( fabs( left ),	fabs( right ) );
+		maxY= Oglf::maxT<float>( fabs( top ),	fabs( bottom ) );
+		maxZ= Oglf::maxT<float>( fabs( front ),	fabs( back ) );
+	}
+
+	/**
+	* @brief computes a sphere bounding the vertices, centered on the box built by build()
+	* @param pJobSystem spreads the reduction of large meshes over its workers, may be NULL
+	*/
+	void BoundingBox::buildSphere( JobSystem* pJobSystem )
+	{
+		sphereCenter = Vec3( ( left + right ) * 0.5f, ( bottom + top ) * 0.5f, ( back + front ) * 0.5f );
+		sphereRadius = 0.f;
+
+		if( vertices->empty() )
+			return;
+
+		BoundsRange oReduction = makeBounds( BOUNDS_SPHERE, *vertices );
+		oReduction.oOrigin = sphereCenter;
+
+		sphereRadius = sqrt( runBounds( oReduction, ( int )vertices->size(), pJobSystem ).fMaxDistance2 );
+	}
+
+	/**
+	* @brief computes a box bounding the vertices oriented along their principal axes: the eigenvectors of their
+	* covariance matrix. Uses the box built by build().
+	* @param pJobSystem spreads the reduction of large meshes over its workers, may be NULL
+	*/
+	void BoundingBox::buildOrientedBox( JobSystem* pJobSystem )
+	{
+		if( vertices->empty() )
+		{
+			obbCenter = Vec3();
+			obbHalfSizes = Vec3();
+			return;
+		}
+
+		int iNb = ( int )vertices->size();
+
+		// the sums are taken relative to the box center, which keeps them small
+		BoundsRange oReduction = makeBounds( BOUNDS_COVARIANCE, *vertices );
+		oReduction.oOrigin = Vec3( ( left + right ) * 0.5f, ( bottom + top ) * 0.5f, ( back + front ) * 0.5f );
+		BoundsRange oSums = runBounds( oReduction, iNb, pJobSystem );
+
+		double pMean[ 3 ];
+		for( int c = 0; c < 3; ++c )
+			pMean[ c ] = oSums.pSums[ c ] / iNb;
+
+		double pCovariance[ 3 ][ 3 ];
+		const int pProducts[ 3 ][ 3 ] = { { 3, 4, 5 }, { 4, 6, 7 }, { 5, 7, 8 } };
+		for( int i = 0; i < 3; ++i )
+			for( int j = 0; j < 3; ++j )
+				pCovariance[ i ][ j ] = oSums.pSums[ pProducts[ i ][ j ] ] / iNb - pMean[ i ] * pMean[ j ];
+
+		double pEigenvectors[ 3 ][ 3 ];
+		diagonalize( pCovariance, pEigenvectors );
+
+		// the axes by decreasing variance, the third one is the cross product of the first two
+		int pOrder[ 3 ] = { 0, 1, 2 };
+		for( int i = 0; i < 2; ++i )
+			for( int j = i + 1; j < 3; ++j )
+				if( pCovariance[ pOrder[ j ] ][ pOrder[ j ] ] > pCovariance[ pOrder[ i ] ][ pOrder[ i ] ] )
+					swap( pOrder[ i ], pOrder[ j ] );
+
+		for( int i = 0; i < 2; ++i )
+		{
+			for( int c = 0; c < 3; ++c )
+				obbAxes[ i ].v[ c ] = ( float )pEigenvectors[ c ][ pOrder[ i ] ];
+			obbAxes[ i ].normalize();
+		}
+		obbAxes[ 2 ] = obbAxes[ 0 ] ^ obbAxes[ 1 ];
+		obbAxes[ 2 ].normalize();
+
+		oReduction = makeBounds( BOUNDS_PROJECTION, *vertices );
+		for( int c = 0; c < 3; ++c )
+			oReduction.pAxes[ c ] = obbAxes[ c ];
+		BoundsRange oProjections = runBounds( oReduction, iNb, pJobSystem );
+
+		obbCenter = Vec3();
+		for( int c = 0; c < 3; ++c )
+		{
+			obbCenter += obbAxes[ c ] * ( ( oProjections.pMin[ c ] + oProjections.pMax[ c ] ) * 0.5f );
+			obbHalfSizes.v[ c ] = ( oProjections.pMax[ c ] - oProjections.pMin[ c ] ) * 0.5f;
+		}
+	}
+}
@@ -0,0 +1,68 @@
+#ifndef BOUNDINGBOX_H
+#define BOUNDINGBOX_H
+
+#include <vector>
+#include "Vec.h"
+#include "Core.h"
+
+
+namespace Oglf
+{
+	class JobSystem;
+
+	typedef std::vector< Vec3, CoreAllocator< Vec3, MEMORY_MESH > >		MeshVec3Array;
+
+	/**
+	* struct BoundingBox holds the bounding volumes of a mesh vertices: the axis aligned box computed by build() and,
+	* for a tighter culling, the sphere and the oriented box computed on demand by buildSphere() and
+	* buildOrientedBox(). The vertices are reduced by SIMD packets, large meshes are split in ranges reduced by the
+	* workers of a job system. The volumes are not updated when the vertices change, they must be built again.
+	*/
+	struct BoundingBox
+	{
+		float left, right; // planes parallel to Oyz
+		float front, back; // planes parallel to Oxy
+		float top, bottom; // planes parallel to Oxz
+		float maxX; // max absolute x value
+		float maxY; // max absolute y value
+		float maxZ; // max absolute z value
+		Vec3 sphereCenter; // the bounding sphere, built by buildSphere()
+		float sphereRadius;
+		Vec3 obbCenter; // the oriented box, built by buildOrientedBox()
+		Vec3 obbAxes[ 3 ]; // orthonormal and right handed, the first one is the axis of largest variance
+		Vec3 obbHalfSizes; // along each axis
+		MeshVec3Array* vertices;
+
+		BoundingBox(MeshVec3Array& vertices)
+		{
+			this->vertices=&vertices;
+			this->clear();
+		}
+
+		/**
+		* @brief empties the volumes: they are reduced to the origin
+		*/
+		void clear();
+
+		/**
+		* @brief computes the axis aligned box, whose planes are the minimum and maximum vertices coordinates
+		* @param pJobSystem spreads the reduction of large meshes over its workers, may be NULL
+		*/
+		void build( JobSystem* pJobSystem = NULL );
+
+		/**
+		* @brief computes a sphere bounding the vertices, centered on the box built by build()
+		* @param pJobSystem spreads the reduction of large meshes over its workers, may be NULL
+		*/
+		void buildSphere( JobSystem* pJobSystem = NULL );
+
+		/**
+		* @brief computes a box bounding the vertices oriented along their principal axes: the eigenvectors of their
+		* covariance matrix. Uses the box built by build().
+		* @param pJobSystem spreads the reduction of large meshes over its workers, may be NULL
+		*/
+		void buildOrientedBox( JobSystem* pJobSystem = NULL );
+	};
+}
+
+#endif /* BOUNDINGBOX_H */
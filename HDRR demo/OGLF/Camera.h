@@ -148,28 +148,12 @@ namespace Oglf
 			m_strafeAxis.normalize();
 			m_vertAxis = m_strafeAxis ^ m_viewAxis;
 
-			Matrix4x4 rotMatrix;
-			rotMatrix.m[0] = m_strafeAxis.v[0];
-			rotMatrix.m[1] = m_vertAxis.v[0];
-			rotMatrix.m[2] = -m_viewAxis.v[0];
-			rotMatrix.m[3] = 0.0;
-
-			rotMatrix.m[4] = m_strafeAxis.v[1];
-			rotMatrix.m[5] = m_vertAxis.v[1];
-			rotMatrix.m[6] = -m_viewAxis.v[1];
-			rotMatrix.m[7] = 0.0;
-
-			rotMatrix.m[8] = m_strafeAxis.v[2];
-			rotMatrix.m[9] = m_vertAxis.v[2];
-			rotMatrix.m[10] = -m_viewAxis.v[2];
-			rotMatrix.m[11] = 0.0;
-
-			rotMatrix.m[12] = 0.0;
-			rotMatrix.m[13] = 0.0;
-			rotMatrix.m[14] = 0.0;
-			rotMatrix.m[15] = 1.0;
-
-			this->getTransformer().getTransformMatrix() = rotMatrix;
+			// the camera rotation maps the strafe, vertical and opposite view axes onto the X, Y and Z axes
+			Quaternion axesQ;
+			axesQ.fromAxes(m_strafeAxis, m_vertAxis, -m_viewAxis);
+
+			this->getTransformer().reset();
+			this->getTransformer().setRotation(axesQ.getConjugate());
 		}
 
 		/**
@@ -335,31 +319,27 @@ namespace Oglf
 			float dPitch = (float)dy * m_pitchSpeed * (180.f / (float)M_PI);
 			float dYaw = (float)dx * m_yawSpeed * (180.f / (float)M_PI);
 
+			// the axes are rotated by the quaternions, the camera rotation by their conjugates, its inverse
 			Quaternion pitchQ, yawQ;
-			Matrix4x4 pitchMat, yawMat;
 
 			yawQ.createRotation(dYaw, 0.f, 1.f, 0.f);
-			yawQ.createRotationMatrix(yawMat.m);
-			this->getTransformer().getTransformMatrix() = this->getTransformer().getTransformMatrix() * yawMat;
+			this->getTransformer().rotate(yawQ.getConjugate());
 
-			yawMat.transpose();
-			m_strafeAxis = yawMat * m_strafeAxis;
-			m_viewAxis   = yawMat * m_viewAxis;
-			m_vertAxis   = yawMat * m_vertAxis;
+			m_strafeAxis = yawQ.rotateVector(m_strafeAxis);
+			m_viewAxis   = yawQ.rotateVector(m_viewAxis);
+			m_vertAxis   = yawQ.rotateVector(m_vertAxis);
 			if(m_camMode == TARGET_CAMERA) {
-				m_position = yawMat * (m_position - m_targetPos) + m_targetPos;
+				m_position = yawQ.rotateVector(m_position - m_targetPos) + m_targetPos;
 			}
 
 			pitchQ.createRotation(dPitch, m_strafeAxis.v[0], m_strafeAxis.v[1], m_strafeAxis.v[2]);
-			pitchQ.createRotationMatrix(pitchMat.m);
-			this->getTransformer().getTransformMatrix() = this->getTransformer().getTransformMatrix() * pitchMat;
+			this->getTransformer().rotate(pitchQ.getConjugate());
 
-			pitchMat.transpose();
-			m_strafeAxis = pitchMat * m_strafeAxis;
-			m_viewAxis   = pitchMat * m_viewAxis;
-			m_vertAxis   = pitchMat * m_vertAxis;
+			m_strafeAxis = pitchQ.rotateVector(m_strafeAxis);
+			m_viewAxis   = pitchQ.rotateVector(m_viewAxis);
+			m_vertAxis   = pitchQ.rotateVector(m_vertAxis);
 			if(m_camMode == TARGET_CAMERA) {
-				m_position = pitchMat * (m_position - m_targetPos) + m_targetPos;
+				m_position = pitchQ.rotateVector(m_position - m_targetPos) + m_targetPos;
 			}
 
 			// compensate the camera vertical axis inversion
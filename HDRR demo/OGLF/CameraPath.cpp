@@ -0,0 +1,178 @@
+#include "CameraPath.h"
+#include <fstream>
+#include <iomanip>
+#include "Error.h"
+
+using namespace std;
+
+namespace Oglf
+{
+	static const char* s_sCameraPathHeader = "OGLFcameraPath1";
+
+	/**
+	* @brief constructor: creates an empty path
+	*/
+	CameraPath::CameraPath()
+		: m_iFrameNb( 0 )
+		, m_bRecording( false )
+		, m_iReplayEvent( 0 )
+	{
+	}
+
+	/**
+	* @brief clears the path and starts recording the moves of a camera
+	* @param oCamera the camera, its current position and target start the path
+	*/
+	void CameraPath::startRecording( const Camera& oCamera )
+	{
+		m_oStartPosition = oCamera.getPosition();
+		m_oStartTarget = oCamera.getTarget();
+		m_vEvents.clear();
+		m_iFrameNb = 0;
+		m_bRecording = true;
+	}
+
+	/**
+	* @brief stops recording
+	*/
+	void CameraPath::stopRecording()
+	{
+		m_bRecording = false;
+	}
+
+	/**
+	* @brief records a move applied to the camera during the current frame, ignored when not recording
+	* @param eMove the move
+	* @param iDeltaX the horizontal mouse motion passed to the camera
+	* @param iDeltaY the vertical mouse motion passed to the camera
+	*/
+	void CameraPath::record( CameraPathMove eMove, int iDeltaX, int iDeltaY )
+	{
+		if( !m_bRecording )
+			return;
+
+		CameraPathEvent oEvent;
+		oEvent.iFrame = m_iFrameNb;
+		oEvent.eMove = eMove;
+		oEvent.iDeltaX = iDeltaX;
+		oEvent.iDeltaY = iDeltaY;
+		m_vEvents.push_back( oEvent );
+	}
+
+	/**
+	* @brief ends the current recorded frame, to be called once per frame while recording
+	*/
+	void CameraPath::nextFrame()
+	{
+		if( m_bRecording )
+			++m_iFrameNb;
+	}
+
+	/**
+	* @brief restores the camera position and target at the start of the path
+	* @param oCamera the camera the path was recorded on
+	*/
+	void CameraPath::startReplay( Camera& oCamera )
+	{
+		// setTarget() rebuilds the camera axes and its transform matrix from the position
+		oCamera.setPosition( m_oStartPosition );
+		oCamera.setTarget( m_oStartTarget );
+		m_iReplayEvent = 0;
+	}
+
+	/**
+	* @brief applies the moves recorded during a frame, the frames must be replayed in order from startReplay()
+	* @param oCamera the camera
+	* @param iFrame the frame, the camera does not move after the last recorded one
+	*/
+	void CameraPath::replay( Camera& oCamera, int iFrame )
+	{
+		for( ; m_iReplayEvent < m_vEvents.size() && m_vEvents[ m_iReplayEvent ].iFrame <= iFrame; ++m_iReplayEvent )
+		{
+			const CameraPathEvent& oEvent = m_vEvents[ m_iReplayEvent ];
+
+			switch( oEvent.eMove )
+			{
+			case CAMERA_PATH_ROTATE:
+				oCamera.reComputeTargetPos( oEvent.iDeltaX, oEvent.iDeltaY );
+				break;
+			case CAMERA_PATH_TRACK:
+				oCamera.moveX( oEvent.iDeltaX );
+				oCamera.moveY( oEvent.iDeltaY );
+				break;
+			case CAMERA_PATH_ZOOM:
+				oCamera.moveZ( oEvent.iDeltaY );
+				break;
+			}
+		}
+	}
+
+	/**
+	* @brief writes the path to a text file
+	* @param sFilename the file name
+	*/
+	void CameraPath::save( const string& sFilename ) const
+	{
+		ofstream oFile( sFilename.c_str() );
+		if( !oFile )
+			throw Error( "CameraPath::save error : Failed to create the path file", sFilename );
+
+		// the start position must be restored exactly for the replay to be deterministic
+		oFile << setprecision( 9 );
+		oFile << s_sCameraPathHeader << endl;
+		oFile << m_iFrameNb << " " << m_vEvents.size() << endl;
+		oFile << m_oStartPosition.v[ 0 ] << " " << m_oStartPosition.v[ 1 ] << " " << m_oStartPosition.v[ 2 ] << endl;
+		oFile << m_oStartTarget.v[ 0 ] << " " << m_oStartTarget.v[ 1 ] << " " << m_oStartTarget.v[ 2 ] << endl;
+
+		for( size_t i = 0; i < m_vEvents.size(); ++i )
+		{
+			const CameraPathEvent& oEvent = m_vEvents[ i ];
+			oFile << oEvent.iFrame << " " << ( int )oEvent.eMove << " " << oEvent.iDeltaX << " " << oEvent.iDeltaY << endl;
+		}
+
+		if( !oFile )
+			throw Error( "CameraPath::save error : Failed to write the path file", sFilename );
+	}
+
+	/**
+	* @brief reads a path written by save()
+	* @param sFilename the file name
+	*/
+	void CameraPath::load( const string& sFilename )
+	{
+		ifstream oFile( sFilename.c_str() );
+		if( !oFile )
+			throw Error( "CameraPath::load error : Failed to open the path file", sFilename );
+
+		string sHeader;
+		int iFrameNb = 0;
+		int iEventNb = 0;
+		oFile >> sHeader >> iFrameNb >> iEventNb;
+		if( !oFile || sHeader != s_sCameraPathHeader || iFrameNb < 0 || iEventNb < 0 )
+			throw Error( "CameraPath::load error : Not a camera path file", sFilename );
+
+		Vec3 oStartPosition;
+		Vec3 oStartTarget;
+		oFile >> oStartPosition.v[ 0 ] >> oStartPosition.v[ 1 ] >> oStartPosition.v[ 2 ];
+		oFile >> oStartTarget.v[ 0 ] >> oStartTarget.v[ 1 ] >> oStartTarget.v[ 2 ];
+
+		vector<CameraPathEvent> vEvents( iEventNb );
+		for( int i = 0; i < iEventNb && oFile; ++i )
+		{
+			int iMove;
+			oFile >> vEvents[ i ].iFrame >> iMove >> vEvents[ i ].iDeltaX >> vEvents[ i ].iDeltaY;
+			if( iMove < CAMERA_PATH_ROTATE || iMove > CAMERA_PATH_ZOOM || ( i > 0 && vEvents[ i ].iFrame < vEvents[ i - 1 ].iFrame ) )
+				throw Error( "CameraPath::load error : Invalid camera move", sFilename );
+			vEvents[ i ].eMove = ( CameraPathMove )iMove;
+		}
+		if( !oFile )
+			throw Error( "CameraPath::load error : Truncated path file", sFilename );
+
+		m_oStartPosition = oStartPosition;
+		m_oStartTarget = oStartTarget;
+		m_vEvents.swap( vEvents );
+		m_iFrameNb = iFrameNb;
+		m_bRecording = false;
+		m_iReplayEvent = 0;
+	}
+}
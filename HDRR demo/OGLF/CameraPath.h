@@ -0,0 +1,121 @@
+#ifndef CAMERAPATH_H
+#define CAMERAPATH_H
+
+#include <string>
+#include <vector>
+#include "Camera.h"
+#include "Vec.h"
+
+namespace Oglf
+{
+	enum CameraPathMove
+	{
+		CAMERA_PATH_ROTATE,		// Camera::reComputeTargetPos( dx, dy )
+		CAMERA_PATH_TRACK,		// Camera::moveX( dx ) then Camera::moveY( dy )
+		CAMERA_PATH_ZOOM		// Camera::moveZ( dy )
+	};
+
+	/**
+	* @brief a camera move recorded during a frame
+	*/
+	struct CameraPathEvent
+	{
+		int				iFrame;
+		CameraPathMove	eMove;
+		int				iDeltaX;
+		int				iDeltaY;
+	};
+
+	/**
+	* class CameraPath records the camera moves driven by the mouse, frame by frame, and replays them on the same
+	* camera. The moves are recorded rather than the camera positions so that the replay goes through the same
+	* Camera calls as the interaction, which makes it deterministic: a replayed frame always renders the same view
+	* whatever the frame rate of the recording. The camera position and target at the start of the recording are
+	* restored before the replay.
+	*/
+	class CameraPath
+	{
+		Vec3							m_oStartPosition;
+		Vec3							m_oStartTarget;
+		std::vector<CameraPathEvent>	m_vEvents;
+		int								m_iFrameNb;			// number of recorded frames
+		bool							m_bRecording;
+		size_t							m_iReplayEvent;		// next event to replay
+
+	public:
+
+		/**
+		* @brief constructor: creates an empty path
+		*/
+		CameraPath();
+
+		/**
+		* @brief clears the path and starts recording the moves of a camera
+		* @param oCamera the camera, its current position and target start the path
+		*/
+		void startRecording( const Camera& oCamera );
+
+		/**
+		* @brief stops recording
+		*/
+		void stopRecording();
+
+		/**
+		* @brief returns whether the moves are being recorded
+		* @return true while recording
+		*/
+		bool isRecording() const
+		{
+			return m_bRecording;
+		}
+
+		/**
+		* @brief records a move applied to the camera during the current frame, ignored when not recording
+		* @param eMove the move
+		* @param iDeltaX the horizontal mouse motion passed to the camera
+		* @param iDeltaY the vertical mouse motion passed to the camera
+		*/
+		void record( CameraPathMove eMove, int iDeltaX, int iDeltaY );
+
+		/**
+		* @brief ends the current recorded frame, to be called once per frame while recording
+		*/
+		void nextFrame();
+
+		/**
+		* @brief restores the camera position and target at the start of the path
+		* @param oCamera the camera the path was recorded on
+		*/
+		void startReplay( Camera& oCamera );
+
+		/**
+		* @brief applies the moves recorded during a frame, the frames must be replayed in order from startReplay()
+		* @param oCamera the camera
+		* @param iFrame the frame, the camera does not move after the last recorded one
+		*/
+		void replay( Camera& oCamera, int iFrame );
+
+		/**
+		* @brief returns the number of recorded frames
+		* @return the number of frames
+		*/
+		int getFrameNb() const
+		{
+			return m_iFrameNb;
+		}
+
+		/**
+		* @brief writes the path to a text file
+		* @param sFilename the file name
+		*/
+		void save( const std::string& sFilename ) const;
+
+		/**
+		* @brief reads a path written by save()
+		* @param sFilename the file name
+		*/
+		void load( const std::string& sFilename );
+	};
+}
+
+#endif /* CAMERAPATH_H */
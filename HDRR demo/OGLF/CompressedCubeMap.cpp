@@ -0,0 +1,160 @@
+#include <cstdio>
+#include <cstring>
+#include "CompressedCubeMap.h"
+#include "BC6H.h"
+#include "Error.h"
+#include "utils.h"
+
+using namespace std;
+
+namespace Oglf
+{
+	static const char			s_pMagic[ 4 ] = { 'O', 'C', 'B', 'C' };
+	static const unsigned int	s_iVersion = 1;
+
+	/**
+	* @brief cache file header, followed by the CompressedCubeMapData::vData bytes
+	*/
+	struct CompressedCubeMapHeader
+	{
+		char			pMagic[ 4 ];
+		unsigned int	iVersion;
+		unsigned int	iFormat;
+		unsigned int	iFaceSize;
+		unsigned int	iMipCount;
+		unsigned int	iDataSize;
+	};
+
+	/**
+	* @brief where each face lies in a vertical cross picture, in GL_TEXTURE_CUBE_MAP_POSITIVE_X_ARB + i order.
+	* The copy starts at row iRowMul * size + iRowAdd and column iColMul * size + iColAdd.
+	*/
+	struct CrossFace
+	{
+		int		iRowMul, iRowAdd;
+		int		iColMul, iColAdd;
+		bool	bPositive;		// true: read from top left to bottom right, false: from bottom right to top left
+	};
+
+	static const CrossFace s_pCrossFaces[ 6 ] =
+	{
+		{ 2, -1, 1, -1, false },	// +X
+		{ 2, -1, 3, -1, false },	// -X
+		{ 3, -1, 2, -1, false },	// +Y
+		{ 1, -1, 2, -1, false },	// -Y
+		{ 2, -1, 2, -1, false },	// +Z
+		{ 3,  0, 1,  0, true  }		// -Z
+	};
+
+	/**
+	* @brief returns the compressed size of one face of a mipmap level
+	* @param iMip the mipmap level
+	* @return the size in bytes
+	*/
+	unsigned int CompressedCubeMapData::getFaceDataSize( unsigned int iMip ) const
+	{
+		return getBC6Hsize( getMipSize( iMip ), getMipSize( iMip ) );
+	}
+
+	/**
+	* @brief returns where a face of a mipmap level is stored in vData
+	* @param iFace the face index, in GL_TEXTURE_CUBE_MAP_POSITIVE_X_ARB + i order
+	* @param iMip the mipmap level
+	* @return the offset in bytes
+	*/
+	unsigned int CompressedCubeMapData::getFaceDataOffset( unsigned int iFace, unsigned int iMip ) const
+	{
+		unsigned int iOffset = 0;
+		for( unsigned int i = 0; i < iMip; ++i )
+			iOffset += 6 * getFaceDataSize( i );
+
+		return iOffset + iFace * getFaceDataSize( iMip );
+	}
+
+	/**
+	* @brief allocates vData for the current size and mipmap count
+	*/
+	void CompressedCubeMapData::allocate()
+	{
+		vData.resize( getFaceDataOffset( 0, iMipCount ) );
+	}
+
+	/**
+	* @brief writes a compressed cube map cache file, throws an Error on failure
+	* @param sFilename the file name
+	* @param oCubeMap the compressed cube map
+	*/
+	void writeCompressedCubeMap( const string& sFilename, const CompressedCubeMapData& oCubeMap )
+	{
+		FILE* pFile = fopen( sFilename.c_str(), "wb" );
+		if( pFile == NULL )
+			throw Error( "writeCompressedCubeMap error: failed to open file", sFilename );
+
+		CompressedCubeMapHeader oHeader;
+		memcpy( oHeader.pMagic, s_pMagic, sizeof( s_pMagic ) );
+		oHeader.iVersion  = s_iVersion;
+		oHeader.iFormat   = oCubeMap.iFormat;
+		oHeader.iFaceSize = oCubeMap.iFaceSize;
+		oHeader.iMipCount = oCubeMap.iMipCount;
+		oHeader.iDataSize = ( unsigned int )oCubeMap.vData.size();
+
+		bool bOk = fwrite( &oHeader, sizeof( oHeader ), 1, pFile ) == 1;
+		if( bOk && !oCubeMap.vData.empty() )
+			bOk = fwrite( &oCubeMap.vData[ 0 ], oCubeMap.vData.size(), 1, pFile ) == 1;
+
+		fclose( pFile );
+
+		if( !bOk )
+			throw Error( "writeCompressedCubeMap error: failed to write file", sFilename );
+	}
+
+	/**
+	* @brief reads a compressed cube map cache file, throws an Error on failure
+	* @param sFilename the file name
+	* @param oCubeMap the read compressed cube map
+	*/
+	void readCompressedCubeMap( const string& sFilename, CompressedCubeMapData& oCubeMap )
+	{
+		FILE* pFile = fopen( sFilename.c_str(), "rb" );
+		if( pFile == NULL )
+			throw Error( "readCompressedCubeMap error: failed to open file", sFilename );
+
+		CompressedCubeMapHeader oHeader;
+		if( fread( &oHeader, sizeof( oHeader ), 1, pFile ) != 1 ||
+			memcmp( oHeader.pMagic, s_pMagic, sizeof( s_pMagic ) ) != 0 || oHeader.iVersion != s_iVersion )
+		{
+			fclose( pFile );
+			throw Error( "readCompressedCubeMap error: not a compressed cube map or unsupported version", sFilename );
+		}
+
+		oCubeMap.iFormat   = oHeader.iFormat;
+		oCubeMap.iFaceSize = oHeader.iFaceSize;
+		oCubeMap.iMipCount = oHeader.iMipCount;
+		oCubeMap.allocate();
+
+		bool bOk = oHeader.iDataSize == oCubeMap.vData.size();
+		if( bOk && !oCubeMap.vData.empty() )
+			bOk = fread( &oCubeMap.vData[ 0 ], oCubeMap.vData.size(), 1, pFile ) == 1;
+
+		fclose( pFile );
+
+		if( !bOk )
+			throw Error( "readCompressedCubeMap error: truncated or corrupted file", sFilename );
+	}
+
+	/**
+	* @brief extracts one face from a vertical cross cube map picture
+	* @param pCross the vertical cross picture data, 3 faces wide and 4 faces high
+	* @param iFaceSize the faces width and height (pixels)
+	* @param iPixelSize the pixel size (bytes)
+	* @param iFace the face index, in GL_TEXTURE_CUBE_MAP_POSITIVE_X_ARB + i order
+	* @return the face data, to be deleted with delete[]
+	*/
+	unsigned char* extractCubeMapFace( const unsigned char* pCross, int iFaceSize, int iPixelSize, int iFace )
+	{
+		const CrossFace& oFace = s_pCrossFaces[ iFace ];
+
+		return extract( oFace.iRowMul * iFaceSize + oFace.iRowAdd, oFace.iColMul * iFaceSize + oFace.iColAdd,
+			iFaceSize, iFaceSize, 3 * iFaceSize, 4 * iFaceSize, iPixelSize, pCross, true, oFace.bPositive, oFace.bPositive );
+	}
+}
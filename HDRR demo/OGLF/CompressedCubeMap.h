@@ -0,0 +1,86 @@
+#ifndef COMPRESSEDCUBEMAP_H
+#define COMPRESSEDCUBEMAP_H
+
+#include <string>
+#include <vector>
+
+namespace Oglf
+{
+	const unsigned int BPTC_RGB_UNSIGNED_FLOAT = 0x8E8F; // GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT_ARB
+
+	/**
+	* @brief a compressed cube map as stored in the cache files: the 6 faces of the first mipmap level in
+	* GL_TEXTURE_CUBE_MAP_POSITIVE_X_ARB + i order, then the 6 faces of the next level and so on.
+	*/
+	struct CompressedCubeMapData
+	{
+		unsigned int iFormat;		// gl compressed internal format
+		unsigned int iFaceSize;		// width and height of the first mipmap level faces
+		unsigned int iMipCount;		// number of mipmap levels
+		std::vector< unsigned char > vData;
+
+		CompressedCubeMapData()
+			: iFormat( BPTC_RGB_UNSIGNED_FLOAT )
+			, iFaceSize( 0 )
+			, iMipCount( 0 )
+		{
+		}
+
+		/**
+		* @brief returns the faces size of a mipmap level
+		* @param iMip the mipmap level
+		* @return the faces width and height
+		*/
+		unsigned int getMipSize( unsigned int iMip ) const
+		{
+			unsigned int iSize = iFaceSize >> iMip;
+			return iSize > 0 ? iSize : 1;
+		}
+
+		/**
+		* @brief returns the compressed size of one face of a mipmap level
+		* @param iMip the mipmap level
+		* @return the size in bytes
+		*/
+		unsigned int getFaceDataSize( unsigned int iMip ) const;
+
+		/**
+		* @brief returns where a face of a mipmap level is stored in vData
+		* @param iFace the face index, in GL_TEXTURE_CUBE_MAP_POSITIVE_X_ARB + i order
+		* @param iMip the mipmap level
+		* @return the offset in bytes
+		*/
+		unsigned int getFaceDataOffset( unsigned int iFace, unsigned int iMip ) const;
+
+		/**
+		* @brief allocates vData for the current size and mipmap count
+		*/
+		void allocate();
+	};
+
+	/**
+	* @brief writes a compressed cube map cache file, throws an Error on failure
+	* @param sFilename the file name
+	* @param oCubeMap the compressed cube map
+	*/
+	void writeCompressedCubeMap( const std::string& sFilename, const CompressedCubeMapData& oCubeMap );
+
+	/**
+	* @brief reads a compressed cube map cache file, throws an Error on failure
+	* @param sFilename the file name
+	* @param oCubeMap the read compressed cube map
+	*/
+	void readCompressedCubeMap( const std::string& sFilename, CompressedCubeMapData& oCubeMap );
+
+	/**
+	* @brief extracts one face from a vertical cross cube map picture
+	* @param pCross the vertical cross picture data, 3 faces wide and 4 faces high
+	* @param iFaceSize the faces width and height (pixels)
+	* @param iPixelSize the pixel size (bytes)
+	* @param iFace the face index, in GL_TEXTURE_CUBE_MAP_POSITIVE_X_ARB + i order
+	* @return the face data, to be deleted with delete[]
+	*/
+	unsigned char* extractCubeMapFace( const unsigned char* pCross, int iFaceSize, int iPixelSize, int iFace );
+}
+
+#endif /* COMPRESSEDCUBEMAP_H */
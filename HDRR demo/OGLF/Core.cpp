@@ -1,9 +1,178 @@
+#include <cstdlib>
+#include <cstring>
 #include "Core.h"
-#include <map>
+
+#ifdef WIN32
+#include <Windows.h>
+#define OGLF_THREAD_LOCAL __declspec( thread )
+#else
+#define OGLF_THREAD_LOCAL __thread
+#endif
 
 
 namespace Oglf
 {
-	size_t Core::m_iAllocatedByteNb = 0;
-	std::map< char*, size_t > Core::m_oAllocatedSizeMap;
+	/**
+	* @brief the counters of one thread, only written by their thread
+	*/
+	struct ThreadMemoryCounters
+	{
+		volatile long			pAllocatedBytes[ MEMORY_CATEGORY_NB ];
+		volatile long			pAllocationNb[ MEMORY_CATEGORY_NB ];
+		volatile long			pTotalAllocationNb[ MEMORY_CATEGORY_NB ];
+		ThreadMemoryCounters*	pNext;
+	};
+
+	/**
+	* @brief header stored before each tracked allocation, 16 bytes so that the allocations keep the malloc alignment
+	*/
+	struct AllocationHeader
+	{
+		size_t	iSize;
+		int		iCategory;
+		char	pPadding[ 16 - sizeof( size_t ) - sizeof( int ) ];
+	};
+
+	// counters of every thread that has allocated tracked memory. Threads never unregister: the
+	// memory they allocated may be freed by other threads and their counters must stay in the sums.
+	static ThreadMemoryCounters* volatile	s_pCountersList = NULL;
+	static OGLF_THREAD_LOCAL ThreadMemoryCounters*	s_pThreadCounters = NULL;
+
+	static size_t	s_pPeakBytes[ MEMORY_CATEGORY_NB ];
+	static size_t	s_iPeakBytes = 0;
+
+	static const char* s_pCategoryNames[ MEMORY_CATEGORY_NB ] = { "other", "meshes", "textures", "FX", "scene" };
+
+	/**
+	* @brief atomically pushes thread counters on the counters list
+	* @param pCounters the thread counters
+	*/
+	static void pushCounters( ThreadMemoryCounters* pCounters )
+	{
+		ThreadMemoryCounters* pHead;
+
+		do
+		{
+			pHead = s_pCountersList;
+			pCounters->pNext = pHead;
+		}
+#ifdef WIN32
+		while( InterlockedCompareExchangePointer( ( PVOID volatile* )&s_pCountersList, pCounters, pHead ) != pHead );
+#else
+		while( !__sync_bool_compare_and_swap( &s_pCountersList, pHead, pCounters ) );
+#endif
+	}
+
+	/**
+	* @brief returns the calling thread counters, created on the first call
+	* @return the thread counters
+	*/
+	static ThreadMemoryCounters* getThreadCounters()
+	{
+		if( s_pThreadCounters == NULL )
+		{
+			// allocated with calloc to not be tracked themselves
+			s_pThreadCounters = ( ThreadMemoryCounters* )calloc( 1, sizeof( ThreadMemoryCounters ) );
+			if( s_pThreadCounters == NULL )
+				throw std::bad_alloc();
+
+			pushCounters( s_pThreadCounters );
+		}
+
+		return s_pThreadCounters;
+	}
+
+	/**
+	* @brief allocates tracked memory, throws std::bad_alloc on failure
+	* @param iSize the size in bytes
+	* @param eCategory the category the memory is accounted in
+	* @return the allocated memory, aligned as with malloc
+	*/
+	void* MemoryTracker::allocate( size_t iSize, MemoryCategory eCategory )
+	{
+		ThreadMemoryCounters* pCounters = getThreadCounters();
+
+		AllocationHeader* pHeader = ( AllocationHeader* )malloc( sizeof( AllocationHeader ) + iSize );
+		if( pHeader == NULL )
+			throw std::bad_alloc();
+
+		pHeader->iSize = iSize;
+		pHeader->iCategory = eCategory;
+
+		pCounters->pAllocatedBytes[ eCategory ] += ( long )iSize;
+		++pCounters->pAllocationNb[ eCategory ];
+		++pCounters->pTotalAllocationNb[ eCategory ];
+
+		return pHeader + 1;
+	}
+
+	/**
+	* @brief frees memory allocated by allocate()
+	* @param pData the memory, can be NULL
+	*/
+	void MemoryTracker::deallocate( void* pData )
+	{
+		if( pData == NULL )
+			return;
+
+		ThreadMemoryCounters* pCounters = getThreadCounters();
+		AllocationHeader* pHeader = ( AllocationHeader* )pData - 1;
+
+		pCounters->pAllocatedBytes[ pHeader->iCategory ] -= ( long )pHeader->iSize;
+		--pCounters->pAllocationNb[ pHeader->iCategory ];
+
+		free( pHeader );
+	}
+
+	/**
+	* @brief sums the counters of all the threads and updates the high-water marks, to be called
+	* from one thread at a time, for instance once per frame
+	* @param oStats the statistics
+	*/
+	void MemoryTracker::getStats( MemoryStats& oStats )
+	{
+		long pAllocatedBytes[ MEMORY_CATEGORY_NB ] = { 0 };
+		long pAllocationNb[ MEMORY_CATEGORY_NB ] = { 0 };
+		long pTotalAllocationNb[ MEMORY_CATEGORY_NB ] = { 0 };
+
+		oStats.iThreadNb = 0;
+		for( ThreadMemoryCounters* pCounters = s_pCountersList; pCounters != NULL; pCounters = pCounters->pNext )
+		{
+			for( int i = 0; i < MEMORY_CATEGORY_NB; ++i )
+			{
+				pAllocatedBytes[ i ] += pCounters->pAllocatedBytes[ i ];
+				pAllocationNb[ i ] += pCounters->pAllocationNb[ i ];
+				pTotalAllocationNb[ i ] += pCounters->pTotalAllocationNb[ i ];
+			}
+			++oStats.iThreadNb;
+		}
+
+		oStats.iAllocatedBytes = 0;
+		for( int i = 0; i < MEMORY_CATEGORY_NB; ++i )
+		{
+			// the sums can be briefly negative while another thread frees memory it did not allocate
+			oStats.pAllocatedBytes[ i ] = pAllocatedBytes[ i ] > 0 ? ( size_t )pAllocatedBytes[ i ] : 0;
+			oStats.pAllocationNb[ i ] = pAllocationNb[ i ] > 0 ? ( size_t )pAllocationNb[ i ] : 0;
+			oStats.pTotalAllocationNb[ i ] = ( size_t )pTotalAllocationNb[ i ];
+			oStats.iAllocatedBytes += oStats.pAllocatedBytes[ i ];
+
+			if( oStats.pAllocatedBytes[ i ] > s_pPeakBytes[ i ] )
+				s_pPeakBytes[ i ] = oStats.pAllocatedBytes[ i ];
+			oStats.pPeakBytes[ i ] = s_pPeakBytes[ i ];
+		}
+
+		if( oStats.iAllocatedBytes > s_iPeakBytes )
+			s_iPeakBytes = oStats.iAllocatedBytes;
+		oStats.iPeakBytes = s_iPeakBytes;
+	}
+
+	/**
+	* @brief returns a category name
+	* @param eCategory the category
+	* @return the category name
+	*/
+	const char* MemoryTracker::getCategoryName( MemoryCategory eCategory )
+	{
+		return s_pCategoryNames[ eCategory ];
+	}
 }
@@ -1,84 +1,197 @@
 #ifndef CORE_H
 #define CORE_H
 
-#include <map>
-#include <iostream>
+#include <cstddef>
+#include <new>
 
-#define LOG_MEMORY_ALLOCATIONS
 #define TRACE_MEMORY_ALLOCATIONS
 
 
 namespace Oglf
 {
-	class Core
+	/**
+	* @brief categories the allocations are accounted in
+	*/
+	enum MemoryCategory
 	{
-		static size_t m_iAllocatedByteNb;
-		static std::map<char*, size_t> m_oAllocatedSizeMap;
+		MEMORY_OTHER,
+		MEMORY_MESH,
+		MEMORY_TEXTURE,
+		MEMORY_FX,
+		MEMORY_SCENE,
 
-	public:
+		MEMORY_CATEGORY_NB
+	};
 
-#ifdef TRACE_MEMORY_ALLOCATIONS
+	/**
+	* @brief memory statistics of each category, aggregated from all the threads by MemoryTracker::getStats()
+	*/
+	struct MemoryStats
+	{
+		size_t pAllocatedBytes[ MEMORY_CATEGORY_NB ];	// bytes currently allocated
+		size_t pPeakBytes[ MEMORY_CATEGORY_NB ];		// high-water mark of the allocated bytes
+		size_t pAllocationNb[ MEMORY_CATEGORY_NB ];		// live allocations
+		size_t pTotalAllocationNb[ MEMORY_CATEGORY_NB ];	// allocations made since the start
+		size_t iAllocatedBytes;							// bytes currently allocated in all the categories
+		size_t iPeakBytes;								// high-water mark of iAllocatedBytes
+		int    iThreadNb;								// threads that have allocated tracked memory
+	};
 
-		void* operator new(size_t size)
-		{
-			m_iAllocatedByteNb += size;
-			char* data = ::new char[size];
-			m_oAllocatedSizeMap.insert( std::pair< char*, size_t >( data, size ) );
+	/**
+	* class MemoryTracker accounts the tracked allocations. The allocated size and category are stored in a
+	* header before each allocation and every thread updates its own counters, without any lock. The counters
+	* are only summed when the statistics are queried: memory freed by another thread than the one that allocated
+	* it is correctly accounted in the sums, and the high-water marks are sampled at each query.
+	*/
+	class MemoryTracker
+	{
+	public:
 
-#ifdef LOG_MEMORY_ALLOCATIONS
+		/**
+		* @brief allocates tracked memory, throws std::bad_alloc on failure
+		* @param iSize the size in bytes
+		* @param eCategory the category the memory is accounted in
+		* @return the allocated memory, aligned as with malloc
+		*/
+		static void* allocate( size_t iSize, MemoryCategory eCategory );
+
+		/**
+		* @brief frees memory allocated by allocate()
+		* @param pData the memory, can be NULL
+		*/
+		static void deallocate( void* pData );
+
+		/**
+		* @brief sums the counters of all the threads and updates the high-water marks, to be called
+		* from one thread at a time, for instance once per frame
+		* @param oStats the statistics
+		*/
+		static void getStats( MemoryStats& oStats );
+
+		/**
+		* @brief returns a category name
+		* @param eCategory the category
+		* @return the category name
+		*/
+		static const char* getCategoryName( MemoryCategory eCategory );
+	};
 
-			std::cout << "allocated memory: " << m_iAllocatedByteNb << " byte(s)" << std::endl;
+	/**
+	* class Core is the base class of the objects whose allocations are tracked
+	*/
+	template< MemoryCategory eCategory = MEMORY_OTHER >
+	class Core
+	{
+	public:
 
-#endif
+#ifdef TRACE_MEMORY_ALLOCATIONS
 
-			return data;
+		void* operator new( size_t size )
+		{
+			return MemoryTracker::allocate( size, eCategory );
 		}
 
-		void operator delete(void* data)
+		void operator delete( void* data )
 		{
-			m_iAllocatedByteNb -= m_oAllocatedSizeMap[ ( char* )data ];
-			m_oAllocatedSizeMap.erase( ( char* )data );
+			MemoryTracker::deallocate( data );
+		}
 
-#ifdef LOG_MEMORY_ALLOCATIONS
+		void* operator new[]( size_t size )
+		{
+			return MemoryTracker::allocate( size, eCategory );
+		}
 
-			std::cout << "allocated memory: " << m_iAllocatedByteNb << " byte(s)" << std::endl;
+		void operator delete[]( void* data )
+		{
+			MemoryTracker::deallocate( data );
+		}
 
 #endif
 
-			::operator delete( data );
-		}
+	};
 
-		void* operator new[](size_t size)
+	/**
+	* class CoreAllocator is a standard containers allocator whose allocations are tracked
+	*/
+	template< typename T, MemoryCategory eCategory >
+	class CoreAllocator
+	{
+	public:
+		typedef T			value_type;
+		typedef T*			pointer;
+		typedef const T*	const_pointer;
+		typedef T&			reference;
+		typedef const T&	const_reference;
+		typedef size_t		size_type;
+		typedef ptrdiff_t	difference_type;
+
+		template< typename U >
+		struct rebind
 		{
-			m_iAllocatedByteNb += size;
-			char* data = ::new char[size];
-			m_oAllocatedSizeMap.insert( std::pair<char*, size_t>( data, size ) );
+			typedef CoreAllocator< U, eCategory > other;
+		};
 
-#ifdef LOG_MEMORY_ALLOCATIONS
+		CoreAllocator()
+		{
+		}
 
-			std::cout << "allocated memory: " << m_iAllocatedByteNb << " byte(s)" << std::endl;
+		template< typename U >
+		CoreAllocator( const CoreAllocator< U, eCategory >& )
+		{
+		}
 
-#endif
+		pointer address( reference x ) const
+		{
+			return &x;
+		}
 
-			return data;
+		const_pointer address( const_reference x ) const
+		{
+			return &x;
 		}
 
-		void operator delete[](void* data)
+		pointer allocate( size_type n, const void* = 0 )
 		{
-			m_iAllocatedByteNb -= m_oAllocatedSizeMap[ ( char* )data];
-			m_oAllocatedSizeMap.erase( ( char* )data );
+#ifdef TRACE_MEMORY_ALLOCATIONS
+			return ( pointer )MemoryTracker::allocate( n * sizeof( T ), eCategory );
+#else
+			return ( pointer )::operator new( n * sizeof( T ) );
+#endif
+		}
 
-#ifdef LOG_MEMORY_ALLOCATIONS
+		void deallocate( pointer p, size_type )
+		{
+#ifdef TRACE_MEMORY_ALLOCATIONS
+			MemoryTracker::deallocate( p );
+#else
+			::operator delete( p );
+#endif
+		}
 
-			std::cout << "allocated memory: " << m_iAllocatedByteNb << " byte(s)" << std::endl;
+		size_type max_size() const
+		{
+			return ( size_type )-1 / sizeof( T );
+		}
 
-#endif
+		void construct( pointer p, const T& val )
+		{
+			::new( ( void* )p ) T( val );
+		}
 
-			::operator delete[]( data );
+		void destroy( pointer p )
+		{
+			p->~T();
 		}
 
-#endif
+		bool operator==( const CoreAllocator& ) const
+		{
+			return true;
+		}
 
+		bool operator!=( const CoreAllocator& ) const
+		{
+			return false;
+		}
 	};
 }
 
@@ -1,7 +1,11 @@
 #include <cstdlib>
+#include <vector>
 #include "CubeMap.h"
 #include "Texture.h"
 #include "Error.h"
+#include "CompressedCubeMap.h"
+#include "Profiler.h"
+#include "RenderStats.h"
 
 using namespace std;
 
@@ -9,194 +13,317 @@ namespace Oglf
 {
 	RenderingFX* CubeMap::s_oDiffuseTex2dFx = NULL;
 
+	// sky box texture index of each cube map face, in GL_TEXTURE_CUBE_MAP_POSITIVE_X_ARB + i order
+	static const int s_pSkyBoxFaces[ 6 ] = { 2, 3, 0, 1, 4, 5 };
+
 	/**
-	* @brief  extract a piece of data from from a picture data
-	* @param  i the vertical coordinate of the copy beginning in the picture data (pixels)
-	* @param  j the horizontal coordinate of the copy beginning in the picture data (pixels)
-	* @param  sizei the piece height (pixels)
-	* @param  sizej the piece width (pixels)
-	* @param  w the picture data area width (pixels)
-	* @param  h the picture data area height (pixels)
-	* @param  bulkSize the size of each copied elements (bytes)
-	* @param  data the picture data address
-	* @param  rowMajOrder true: the data is read in row major order, false: the data is read in column major order
-	* @param  direction true: data is from left to right or top to bottom, false: data is read from right to left or from bottom to top
-	* @return  bulk the extracted piece of data
+	* @brief  set the texture storage
+	* @param  formatInfo the picture format info
+	* @param  data a pointer to the picture data (picture data must be a vertical cross)
+	* @param  border border size : 0 or 1
 	*/
-	GLubyte* extract(int i, int j, int sizei, int sizej, int w, int h, int bulkSize, GLubyte* data, bool rowMajorOrder, bool iPositive, bool jPositive)
-	{	
-		if(i+sizei>h || j+sizej>w)
-		{
-			//throw Error("extract() Error: bad size", NULL, true);
-		}
+	void CubeMap::setData (PicFormatInfo& formatInfo, const GLvoid* data, GLuint border)
+	{
+		glBindTexture(GL_TEXTURE_CUBE_MAP_ARB, glID);
 
-		int endi, stepi, endj, stepj;
+		for( int iFace = 0; iFace < 6; ++iFace )
+		{
+			GLubyte* pData = extractCubeMapFace( (const GLubyte*)data, width, formatInfo.iPixelSize, iFace );
 
-		GLubyte* bulk=new GLubyte[sizei*sizej*bulkSize];
+			glBindTexture(GL_TEXTURE_CUBE_MAP_ARB, glID);
+			glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X_ARB + iFace, 0, formatInfo.eDataFormat, width, height, border, formatInfo.ePixelFormat, formatInfo.eDataType, pData );
 
-		if(iPositive && jPositive)
-		{
-			endi=i+sizei;
-			stepi=1;
+			if( m_bCreateSkyBox )
+			{
+				try
+				{
+					m_pSkyBoxTexArray[ s_pSkyBoxFaces[ iFace ] ].setSize( width, height );
+					m_pSkyBoxTexArray[ s_pSkyBoxFaces[ iFace ] ].setData( formatInfo, pData );
+				}
+				catch(Error e) { e.showError(); exit(1); }
+			}
 
-			endj=j+sizej;
-			stepj=1;
+			delete[] pData;
 		}
-		else if(iPositive && !jPositive)
-		{
-			endi=i+sizei;
-			stepi=1;
 
-			endj=j-sizej;
-			stepj=-1;
-		}
-		else if(!iPositive && jPositive)
-		{
-			endi=i-sizei;
-			stepi=-1;
+		glBindTexture(GL_TEXTURE_CUBE_MAP_ARB, glID);
+		if( m_bAutoGenerateMipmap )
+			glGenerateMipmapEXT( GL_TEXTURE_CUBE_MAP_ARB );
 
-			endj=j+sizej;
-			stepj=1;
-		}
-		else
-		{
-			endi=i-sizei;
-			stepi=-1;
+		m_oFormat = formatInfo;
+		m_iCompressedFormat = 0;
+		m_iMipCount = m_bAutoGenerateMipmap ? getMipChainLength( width, height ) : 1;
+		setMemorySize( 6 * getLevelsMemorySize( width, height, m_iMipCount ) );
 
-			endj=j-sizej;
-			stepj=-1;
-		}
+		Error::checkGLerror("CubeMap::setData");
+		m_bStorageDefined=true;
+	}
 
-		if(rowMajorOrder)
-		{
-			for(int k=i; k!=endi; k+=stepi)
-			{
-				for(int m=j; m!=endj; m+=stepj)
-				{
-					unsigned int iBulkOffset = ( ((k-i)*stepi)*sizej + (m-j)*stepj ) * bulkSize;
-					unsigned int iDataOffset = ( k*w + m ) * bulkSize;
+	/**
+	* @brief  loads a compressed cube map cache file written by the CubeMapCompressor tool
+	* and uploads its faces and mipmap levels as they are
+	* @param  sFilename the cache file name
+	*/
+	void CubeMap::loadCompressedFile( const string& sFilename )
+	{
+		if( !GLEW_ARB_texture_compression_bptc )
+			throw Error( "CubeMap::loadCompressedFile error: GL_ARB_texture_compression_bptc is not supported", sFilename );
 
-					memcpy(bulk + iBulkOffset, data + iDataOffset, bulkSize);
+		CompressedCubeMapData oCubeMap;
+		readCompressedCubeMap( sFilename, oCubeMap );
 
-					//std::cout<<"bulk="<<( (k-i)*sizej + m-j ) * bulkSize<<" data="<<( k*w + m ) * bulkSize<<std::endl;
-					//std::cout<<"  k-i"<<k-i<<std::endl;
-				}
-			}
-		}
-		else
+		width  = oCubeMap.iFaceSize;
+		height = oCubeMap.iFaceSize;
+
+		for( unsigned int iMip = 0; iMip < oCubeMap.iMipCount; ++iMip )
 		{
-			for(int k=j; k!=endj; k+=stepj)
+			GLuint iSize = oCubeMap.getMipSize( iMip );
+
+			for( int iFace = 0; iFace < 6; ++iFace )
 			{
-				for(int m=i; m!=endi; m+=stepi)
-				{
-					memcpy(bulk + ( ((k-j)*stepj)*sizei + (m-i)*stepi ) * bulkSize, data + ( m*w + k ) * bulkSize, bulkSize);
+				const GLubyte* pData = &oCubeMap.vData[ oCubeMap.getFaceDataOffset( iFace, iMip ) ];
 
-					//std::cout<<"bulk="<<( (k-j)*sizei + m-i ) * bulkSize<<" data="<<( m*w + k ) * bulkSize<<std::endl;
-					//std::cout<<"  k-j"<<k-j<<std::endl;
+				glBindTexture(GL_TEXTURE_CUBE_MAP_ARB, glID);
+				glCompressedTexImage2DARB( GL_TEXTURE_CUBE_MAP_POSITIVE_X_ARB + iFace, iMip, oCubeMap.iFormat, iSize, iSize, 0,
+					oCubeMap.getFaceDataSize( iMip ), pData );
+
+				if( m_bCreateSkyBox )
+				{
+					m_pSkyBoxTexArray[ s_pSkyBoxFaces[ iFace ] ].setSize( width, height );
+					m_pSkyBoxTexArray[ s_pSkyBoxFaces[ iFace ] ].setCompressedData( oCubeMap.iFormat, iMip, iSize, iSize,
+						oCubeMap.getFaceDataSize( iMip ), pData );
 				}
 			}
 		}
 
-		return bulk;
+		// mipmaps come from the file, they must not be regenerated from the compressed level 0
+		glBindTexture(GL_TEXTURE_CUBE_MAP_ARB, glID);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP_ARB, GL_TEXTURE_MAX_LEVEL, oCubeMap.iMipCount - 1);
+
+		m_iCompressedFormat = oCubeMap.iFormat;
+		m_iMipCount = oCubeMap.iMipCount;
+		setMemorySize( ( GLuint )oCubeMap.vData.size() );
+
+		Error::checkGLerror("CubeMap::loadCompressedFile");
+		m_bStorageDefined=true;
 	}
 
 	/**
-	* @brief  set the texture storage
+	* @brief  loads a picture in memory with the specified format
 	* @param  formatInfo the picture format info
-	* @param  data a pointer to the picture data (picture data must be a vertical cross)
-	* @param  border border size : 0 or 1
+	* @param  filename the picture filename
+	* @return GLubyte* the picture data 
 	*/
-	void CubeMap::setData (PicFormatInfo& formatInfo, const GLvoid* data, GLuint border)
+	void CubeMap::loadFile(PicFormatInfo& formatInfo, const string& sFilename )
+	{
+		GLubyte* data=Texture::loadFile(formatInfo, sFilename);
+
+		width=width/3;
+		height=width;
+
+
+		setData(formatInfo, data);
+
+		delete[] data;
+	}
+
+	/**
+	* @brief  disables mipmap generation and restricts sampling to the smallest of the allocated levels
+	* @param  iSize the faces width and height
+	* @param  iMipCount the number of allocated mipmap levels
+	*/
+	void CubeMap::setStreamedLevels( GLuint iSize, int iMipCount )
 	{
+		width  = iSize;
+		height = iSize;
+		m_iMipCount = iMipCount;
+		m_bAutoGenerateMipmap = false;
+		m_bStorageDefined = false;
+
 		glBindTexture(GL_TEXTURE_CUBE_MAP_ARB, glID);
-		GLubyte* pData = NULL;
+		glTexParameteri(GL_TEXTURE_CUBE_MAP_ARB, GL_TEXTURE_MAX_LEVEL, iMipCount - 1);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP_ARB, GL_TEXTURE_BASE_LEVEL, iMipCount - 1);
+	}
 
-		try
+	/**
+	* @brief  allocates every face and mipmap level of the texture storage without data, to be filled with
+	* setFaceSubData(). Only the smallest level is sampled until setResidentLevel() is called.
+	* @param  formatInfo the picture format info
+	* @param  iSize the faces width and height
+	* @param  iMipCount the number of mipmap levels
+	*/
+	void CubeMap::allocateStorage( PicFormatInfo& formatInfo, GLuint iSize, int iMipCount )
+	{
+		for( int iFace = 0; iFace < 6; ++iFace )
 		{
-			pData = extract(height-1, 2*width-1, height, width, 3*width, 4*height, formatInfo.iPixelSize, (GLubyte*)data, true, false, false);
-			glTexImage2D(GL_TEXTURE_CUBE_MAP_NEGATIVE_Y_ARB, 0, formatInfo.eDataFormat, width, height, border, formatInfo.ePixelFormat, formatInfo.eDataType, pData );
-			
+			glBindTexture(GL_TEXTURE_CUBE_MAP_ARB, glID);
+			for( int i = 0; i < iMipCount; ++i )
+				glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X_ARB + iFace, i, formatInfo.eDataFormat, maxT( iSize >> i, 1u ), maxT( iSize >> i, 1u ), 0,
+					formatInfo.ePixelFormat, formatInfo.eDataType, NULL);
+
 			if( m_bCreateSkyBox )
 			{
-				m_pSkyBoxTexArray[ 1 ].setSize( width, height );
-				m_pSkyBoxTexArray[ 1 ].setData( formatInfo, pData );
+				m_pSkyBoxTexArray[ s_pSkyBoxFaces[ iFace ] ].setSize( iSize, iSize );
+				m_pSkyBoxTexArray[ s_pSkyBoxFaces[ iFace ] ].allocateStorage( formatInfo, iMipCount );
 			}
+		}
 
-			pData = extract(2*height-1, width-1, height, width, 3*width, 4*height, formatInfo.iPixelSize, (GLubyte*)data, true, false, false);
-			glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X_ARB, 0, formatInfo.eDataFormat, width, height, border, formatInfo.ePixelFormat, formatInfo.eDataType, pData );
+		m_oFormat = formatInfo;
+		m_iCompressedFormat = 0;
+		setStreamedLevels( iSize, iMipCount );
+		setMemorySize( 6 * getLevelsMemorySize( iSize, iSize, iMipCount ) );
 
-			if( m_bCreateSkyBox )
-			{
-				m_pSkyBoxTexArray[ 2 ].setSize( width, height );
-				m_pSkyBoxTexArray[ 2 ].setData( formatInfo, pData );
-			}
+		Error::checkGLerror("CubeMap::allocateStorage");
+	}
 
-			pData = extract(2*height-1, 2*width-1, height, width, 3*width, 4*height, formatInfo.iPixelSize, (GLubyte*)data, true, false, false);
-			glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_Z_ARB, 0, formatInfo.eDataFormat, width, height, border, formatInfo.ePixelFormat, formatInfo.eDataType, pData );
+	/**
+	* @brief  allocates every face and mipmap level of a compressed texture storage without data, to be filled
+	* with setFaceSubData(). Only the smallest level is sampled until setResidentLevel() is called.
+	* @param  iFormat the gl compressed internal format
+	* @param  iSize the faces width and height
+	* @param  iMipCount the number of mipmap levels
+	* @param  pLevelSizes the compressed size of a face of each level in bytes
+	*/
+	void CubeMap::allocateCompressedStorage( GLenum iFormat, GLuint iSize, int iMipCount, const GLsizei* pLevelSizes )
+	{
+		for( int iFace = 0; iFace < 6; ++iFace )
+		{
+			glBindTexture(GL_TEXTURE_CUBE_MAP_ARB, glID);
+			for( int i = 0; i < iMipCount; ++i )
+				glCompressedTexImage2DARB(GL_TEXTURE_CUBE_MAP_POSITIVE_X_ARB + iFace, i, iFormat, maxT( iSize >> i, 1u ), maxT( iSize >> i, 1u ), 0,
+					pLevelSizes[ i ], NULL);
 
 			if( m_bCreateSkyBox )
 			{
-				m_pSkyBoxTexArray[ 4 ].setSize( width, height );
-				m_pSkyBoxTexArray[ 4 ].setData( formatInfo, pData );
+				m_pSkyBoxTexArray[ s_pSkyBoxFaces[ iFace ] ].setSize( iSize, iSize );
+				m_pSkyBoxTexArray[ s_pSkyBoxFaces[ iFace ] ].allocateCompressedStorage( iFormat, iMipCount, pLevelSizes );
 			}
+		}
 
-			pData = extract(2*height-1, 3*width-1, height, width, 3*width, 4*height, formatInfo.iPixelSize, (GLubyte*)data, true, false, false);
-			glTexImage2D(GL_TEXTURE_CUBE_MAP_NEGATIVE_X_ARB, 0, formatInfo.eDataFormat, width, height, border, formatInfo.ePixelFormat, formatInfo.eDataType, pData );
+		GLuint iMemorySize = 0;
+		for( int i = 0; i < iMipCount; ++i )
+			iMemorySize += 6 * pLevelSizes[ i ];
 
-			if( m_bCreateSkyBox )
-			{
-				m_pSkyBoxTexArray[ 3 ].setSize( width, height );
-				m_pSkyBoxTexArray[ 3 ].setData( formatInfo, pData );
-			}
+		m_iCompressedFormat = iFormat;
+		setStreamedLevels( iSize, iMipCount );
+		setMemorySize( iMemorySize );
 
-			pData = extract(3*height-1, 2*width-1, height, width, 3*width, 4*height, formatInfo.iPixelSize, (GLubyte*)data, true, false, false);
-			glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_Y_ARB, 0, formatInfo.eDataFormat, width, height, border, formatInfo.ePixelFormat, formatInfo.eDataType, pData);
+		Error::checkGLerror("CubeMap::allocateCompressedStorage");
+	}
 
-			if( m_bCreateSkyBox )
-			{
-				m_pSkyBoxTexArray[ 0 ].setSize( width, height );
-				m_pSkyBoxTexArray[ 0 ].setData( formatInfo, pData );
-			}
+	/**
+	* @brief  fills a face mipmap level allocated by allocateStorage() or allocateCompressedStorage()
+	* @param  iFace the face index, in GL_TEXTURE_CUBE_MAP_POSITIVE_X_ARB + i order
+	* @param  iLevel the mipmap level
+	* @param  data a pointer to the level data, or an offset in the bound pixel unpack buffer
+	* @param  iSize the data size in bytes
+	*/
+	void CubeMap::setFaceSubData( int iFace, int iLevel, const GLvoid* data, GLsizei iSize )
+	{
+		GLuint iLevelSize = maxT( width >> iLevel, 1u );
 
-			pData = extract(3*height, width, height, width, 3*width, 4*height, formatInfo.iPixelSize, (GLubyte*)data, true, true, true);
-			glTexImage2D(GL_TEXTURE_CUBE_MAP_NEGATIVE_Z_ARB, 0, formatInfo.eDataFormat, width, height, border, formatInfo.ePixelFormat, formatInfo.eDataType, pData);
+		glBindTexture(GL_TEXTURE_CUBE_MAP_ARB, glID);
+		if( m_iCompressedFormat != 0 )
+			glCompressedTexSubImage2DARB(GL_TEXTURE_CUBE_MAP_POSITIVE_X_ARB + iFace, iLevel, 0, 0, iLevelSize, iLevelSize, m_iCompressedFormat, iSize, data);
+		else
+			glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X_ARB + iFace, iLevel, 0, 0, iLevelSize, iLevelSize, m_oFormat.ePixelFormat, m_oFormat.eDataType, data);
 
-			if( m_bCreateSkyBox )
-			{
-				m_pSkyBoxTexArray[ 5 ].setSize( width, height );
-				m_pSkyBoxTexArray[ 5 ].setData( formatInfo, pData );
-			}
-		}
-		catch(Error e) { e.showError(); exit(1); }
+		if( m_bCreateSkyBox )
+			m_pSkyBoxTexArray[ s_pSkyBoxFaces[ iFace ] ].setSubData( iLevel, data, iSize );
+	}
 
-		if( m_bAutoGenerateMipmap )
-			glGenerateMipmapEXT( GL_TEXTURE_CUBE_MAP_ARB );
+	/**
+	* @brief  makes the cube map sample its levels from iLevel, once all their faces have been filled
+	* @param  iLevel the finest filled mipmap level
+	*/
+	void CubeMap::setResidentLevel( int iLevel )
+	{
+		setMipMapBaseLevel( iLevel );
 
-		Error::checkGLerror("CubeMap::setData");
+		if( m_bCreateSkyBox )
+			for( int i = 0; i < 6; ++i )
+				m_pSkyBoxTexArray[ i ].setResidentLevel( iLevel );
+
+		if( iLevel == 0 )
+			m_bStorageDefined = true;
+	}
+
+	/**
+	* @brief  releases the finest mipmap levels of every face: the texture is redefined from the level
+	* iFirstLevel, which becomes its first level
+	* @param  iFirstLevel the first kept level
+	*/
+	void CubeMap::evictLevels( int iFirstLevel )
+	{
+		if( iFirstLevel <= 0 || iFirstLevel >= m_iMipCount )
+			return;
+
+		vector< vector< GLubyte > > pFaceLevels[ 6 ];
+		unsigned int iLastBindFrame = m_iLastBindFrame;
+
+		glBindTexture(GL_TEXTURE_CUBE_MAP_ARB, glID);
+		for( int iFace = 0; iFace < 6; ++iFace )
+			readLevels( GL_TEXTURE_CUBE_MAP_POSITIVE_X_ARB + iFace, iFirstLevel, pFaceLevels[ iFace ] );
+
+		recreate();
+		width  = maxT( width >> iFirstLevel, 1u );
+		height = width;
+		m_iMipCount -= iFirstLevel;
+
+		glBindTexture(GL_TEXTURE_CUBE_MAP_ARB, glID);
+		for( int iFace = 0; iFace < 6; ++iFace )
+			writeLevels( GL_TEXTURE_CUBE_MAP_POSITIVE_X_ARB + iFace, width, height, pFaceLevels[ iFace ] );
+
+		glTexParameteri(GL_TEXTURE_CUBE_MAP_ARB, GL_TEXTURE_MAX_LEVEL, m_iMipCount - 1);
+		setWrapMode( wrapMode );
+		setFilters( minFilter, magFilter );
+		setMemorySize( 6 * getLevelsMemorySize( width, height, m_iMipCount ) );
+
+		if( m_bCreateSkyBox )
+			for( int i = 0; i < 6; ++i )
+				m_pSkyBoxTexArray[ i ].evictLevels( iFirstLevel );
+
+		// eviction is not a use of the texture
+		m_iLastBindFrame = iLastBindFrame;
+
+		Error::checkGLerror("CubeMap::evictLevels");
 		m_bStorageDefined=true;
 	}
 
 	/**
-	* @brief  loads a picture in memory with the specified format
-	* @param  formatInfo the picture format info
-	* @param  filename the picture filename
-	* @return GLubyte* the picture data 
+	* @brief returns the video memory used by the texture, including its sky box textures
+	* @return the memory size in bytes
 	*/
-	void CubeMap::loadFile(PicFormatInfo& formatInfo, const string& sFilename )
+	GLuint CubeMap::getMemorySize() const
 	{
-		GLubyte* data=Texture::loadFile(formatInfo, sFilename);
+		GLuint iSize = m_iMemorySize;
 
-		width=width/3;
-		height=width;
+		if( m_bCreateSkyBox )
+			for( int i = 0; i < 6; ++i )
+				iSize += m_pSkyBoxTexArray[ i ].getMemorySize();
 
+		return iSize;
+	}
 
-		setData(formatInfo, data);
+	/**
+	* @brief returns the frame the texture or its sky box textures have been bound for the last time
+	* @return the frame number, see nextFrame()
+	*/
+	unsigned int CubeMap::getLastBindFrame() const
+	{
+		unsigned int iFrame = m_iLastBindFrame;
 
-		delete[] data;
+		if( m_bCreateSkyBox )
+			for( int i = 0; i < 6; ++i )
+				iFrame = maxT( iFrame, m_pSkyBoxTexArray[ i ].getLastBindFrame() );
+
+		return iFrame;
 	}
 
 	void CubeMap::drawSkyBox()
 	{
+		OGLF_PROFILE_GPU_SCOPE( "CubeMap::drawSkyBox" );
+
 		GLfloat fSize = 20.f;
 
 		s_oDiffuseTex2dFx->updateTextureLocation( m_iSkyBoxTexParamID, m_pSkyBoxTexArray[ 2 ] );
@@ -210,6 +337,7 @@ namespace Oglf
 		glTexCoord2f(1.0, 0.0); glVertex3f(-fSize, -fSize, fSize);		
 
 		glEnd();
+		RenderStats::addDrawCall( 2 );
 
 		s_oDiffuseTex2dFx->updateTextureLocation( m_iSkyBoxTexParamID, m_pSkyBoxTexArray[ 3 ] );
 		s_oDiffuseTex2dFx->enable();
@@ -222,6 +350,7 @@ namespace Oglf
 		glTexCoord2f(1.0, 1.0); glVertex3f(fSize, fSize, -fSize);
 
 		glEnd();
+		RenderStats::addDrawCall( 2 );
 
 		s_oDiffuseTex2dFx->updateTextureLocation( m_iSkyBoxTexParamID, m_pSkyBoxTexArray[ 0 ] );
 		s_oDiffuseTex2dFx->enable();
@@ -234,6 +363,7 @@ namespace Oglf
 		glTexCoord2f(0.0, 1.0); glVertex3f(fSize, -fSize, -fSize);
 
 		glEnd();
+		RenderStats::addDrawCall( 2 );
 
 		s_oDiffuseTex2dFx->updateTextureLocation( m_iSkyBoxTexParamID, m_pSkyBoxTexArray[ 1 ] );
 		s_oDiffuseTex2dFx->enable();
@@ -246,6 +376,7 @@ namespace Oglf
 		glTexCoord2f(1.0, 1.0); glVertex3f(-fSize, fSize, fSize);
 
 		glEnd();
+		RenderStats::addDrawCall( 2 );
 
 		s_oDiffuseTex2dFx->updateTextureLocation( m_iSkyBoxTexParamID, m_pSkyBoxTexArray[ 4 ] );
 		s_oDiffuseTex2dFx->enable();
@@ -258,6 +389,7 @@ namespace Oglf
 		glTexCoord2f(1.0, 1.0); glVertex3f(-fSize, fSize, -fSize);
 
 		glEnd();
+		RenderStats::addDrawCall( 2 );
 
 		s_oDiffuseTex2dFx->updateTextureLocation( m_iSkyBoxTexParamID, m_pSkyBoxTexArray[ 5 ] );
 		s_oDiffuseTex2dFx->enable();
@@ -270,5 +402,6 @@ namespace Oglf
 		glTexCoord2f(1.0, 0.0); glVertex3f(fSize, -fSize, fSize);
 
 		glEnd();
+		RenderStats::addDrawCall( 2 );
 	}
 }
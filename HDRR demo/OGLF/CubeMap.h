@@ -7,22 +7,6 @@
 
 namespace Oglf
 {
-	/**
-	* @brief  extract a piece of data from from a picture data
-	* @param  i the vertical coordinate of the copy beginning in the picture data (pixels)
-	* @param  j the horizontal coordinate of the copy beginning in the picture data (pixels)
-	* @param  sizei the piece height (pixels)
-	* @param  sizej the piece width (pixels)
-	* @param  w the picture data area width (pixels)
-	* @param  h the picture data area height (pixels)
-	* @param  bulkSize the size of each copied elements (bytes)
-	* @param  data the picture data address
-	* @param  rowMajOrder true: the data is read in row major order, false: the data is read in column major order
-	* @param  direction true: data is from left to right or top to bottom, false: data is read from right to left or from bottom to top
-	* @return  bulk the extracted piece of data
-	*/
-	GLubyte* extract(int i, int j, int sizei, int sizej, int w, int h, int bulkSize, GLubyte* data, bool rowMajorOrder, bool direction);
-
 	/**
 	* class Cubemap manages cube mapping with openGL
 	*/
@@ -34,6 +18,8 @@ namespace Oglf
 		static RenderingFX*	s_oDiffuseTex2dFx;
 		int					m_iSkyBoxTexParamID;
 
+		void setStreamedLevels( GLuint iSize, int iMipCount );
+
 	public:
 
 		/**
@@ -80,6 +66,13 @@ namespace Oglf
 		*/
 		void loadFile(PicFormatInfo& formatInfo, const std::string& sFilename );
 
+		/**
+		* @brief  loads a compressed cube map cache file written by the CubeMapCompressor tool
+		* and uploads its faces and mipmap levels as they are
+		* @param  sFilename the cache file name
+		*/
+		void loadCompressedFile( const std::string& sFilename );
+
 		/**
 		* @brief  set the texture storage
 		* @param  formatInfo the picture format info
@@ -88,14 +81,69 @@ namespace Oglf
 		*/
 		void setData (PicFormatInfo& formatInfo, const GLvoid* data, GLuint border = 0);
 
+		/**
+		* @brief  allocates every face and mipmap level of the texture storage without data, to be filled with
+		* setFaceSubData(). Only the smallest level is sampled until setResidentLevel() is called.
+		* @param  formatInfo the picture format info
+		* @param  iSize the faces width and height
+		* @param  iMipCount the number of mipmap levels
+		*/
+		void allocateStorage( PicFormatInfo& formatInfo, GLuint iSize, int iMipCount );
+
+		/**
+		* @brief  allocates every face and mipmap level of a compressed texture storage without data, to be filled
+		* with setFaceSubData(). Only the smallest level is sampled until setResidentLevel() is called.
+		* @param  iFormat the gl compressed internal format
+		* @param  iSize the faces width and height
+		* @param  iMipCount the number of mipmap levels
+		* @param  pLevelSizes the compressed size of a face of each level in bytes
+		*/
+		void allocateCompressedStorage( GLenum iFormat, GLuint iSize, int iMipCount, const GLsizei* pLevelSizes );
+
+		/**
+		* @brief  fills a face mipmap level allocated by allocateStorage() or allocateCompressedStorage()
+		* @param  iFace the face index, in GL_TEXTURE_CUBE_MAP_POSITIVE_X_ARB + i order
+		* @param  iLevel the mipmap level
+		* @param  data a pointer to the level data, or an offset in the bound pixel unpack buffer
+		* @param  iSize the data size in bytes
+		*/
+		void setFaceSubData( int iFace, int iLevel, const GLvoid* data, GLsizei iSize );
+
+		/**
+		* @brief  makes the cube map sample its levels from iLevel, once all their faces have been filled
+		* @param  iLevel the finest filled mipmap level
+		*/
+		void setResidentLevel( int iLevel );
+
+		/**
+		* @brief  releases the finest mipmap levels of every face: the texture is redefined from the level
+		* iFirstLevel, which becomes its first level
+		* @param  iFirstLevel the first kept level
+		*/
+		void evictLevels( int iFirstLevel );
+
+		/**
+		* @brief returns the video memory used by the texture, including its sky box textures
+		* @return the memory size in bytes
+		*/
+		GLuint getMemorySize() const;
+
+		/**
+		* @brief returns the frame the texture or its sky box textures have been bound for the last time
+		* @return the frame number, see nextFrame()
+		*/
+		unsigned int getLastBindFrame() const;
+
 		/**
 		* @brief  binds or unbinds a gl texture
 		* @param  state true: texture is bound, false: texture is unbound
 		*/
 		void bind (bool state=true) const
 		{
+			RenderStats::addStateChange();
 			if(state)
 			{
+				m_iLastBindFrame = s_iFrame;
 				glBindTexture(GL_TEXTURE_CUBE_MAP_ARB, glID);
 			}
 			else
@@ -111,6 +159,7 @@ namespace Oglf
 		*/
 		void setFilters (TexFilter minType, TexFilter magType)
 		{
+			Texture::setFilters( minType, magType );
 			this->bind();
 			glTexParameteri(GL_TEXTURE_CUBE_MAP_ARB, GL_TEXTURE_MIN_FILTER, minType);
 			glTexParameteri(GL_TEXTURE_CUBE_MAP_ARB, GL_TEXTURE_MAG_FILTER, magType);
@@ -126,6 +175,7 @@ namespace Oglf
 		*/
 		virtual void setWrapMode(WrapMode wm)
 		{
+			Texture::setWrapMode( wm );
 			this->bind();
 			glTexParameteri(GL_TEXTURE_CUBE_MAP_ARB, GL_TEXTURE_WRAP_S, wm);
 			glTexParameteri(GL_TEXTURE_CUBE_MAP_ARB, GL_TEXTURE_WRAP_T, wm);
@@ -140,6 +190,8 @@ namespace Oglf
 			{
 				this->bind();
 				glGenerateMipmapEXT(GL_TEXTURE_CUBE_MAP_ARB);
+				m_iMipCount = getMipChainLength( width, height );
+				setMemorySize( 6 * getLevelsMemorySize( width, height, m_iMipCount ) );
 			}
 			else
 			{
@@ -0,0 +1,329 @@
+#include <cstring>
+#include "FrameCapture.h"
+#include "Error.h"
+
+using namespace std;
+
+namespace Oglf
+{
+	/**
+	* @brief constructor: creates the pixel buffers and starts the encoder threads, must be called with a current GL context
+	* @param iEncoderNb the number of encoder threads
+	* @param iMaxQueuedBytes the memory of the frames waiting for an encoder, the capture waits for the encoders beyond it
+	*/
+	FrameCapture::FrameCapture( int iEncoderNb, unsigned int iMaxQueuedBytes )
+		: m_iNextSlot( 0 )
+		, m_bAsync( false )
+		, m_iQueuedBytes( 0 )
+		, m_iMaxQueuedBytes( iMaxQueuedBytes )
+		, m_iBusyEncoderNb( 0 )
+		, m_iWrittenNb( 0 )
+		, m_bShutdown( false )
+	{
+		m_bAsync = GLEW_ARB_pixel_buffer_object && GLEW_ARB_sync;
+
+		for( int i = 0; i < FRAME_CAPTURE_PBO_NB; ++i )
+		{
+			CaptureSlot& oSlot = m_pSlots[ i ];
+			oSlot.iPBO = 0;
+			oSlot.iBufferSize = 0;
+			oSlot.oFence = 0;
+			oSlot.bPending = false;
+			oSlot.pFormat = NULL;
+			oSlot.iWidth = 0;
+			oSlot.iHeight = 0;
+			oSlot.iSize = 0;
+			oSlot.pData = NULL;
+
+			if( m_bAsync )
+				glGenBuffersARB( 1, &oSlot.iPBO );
+		}
+
+		Error::checkGLerror( "FrameCapture::FrameCapture" );
+
+		m_oLock = glfwCreateMutex();
+		m_oJobCond = glfwCreateCond();
+		m_oDoneCond = glfwCreateCond();
+
+		for( int i = 0; i < iEncoderNb; ++i )
+			m_vThreads.push_back( glfwCreateThread( encoderThread, this ) );
+	}
+
+	/**
+	* @brief destructor: writes the captured frames and stops the encoder threads, must be called with a current GL context
+	*/
+	FrameCapture::~FrameCapture()
+	{
+		flush();
+
+		glfwLockMutex( m_oLock );
+		m_bShutdown = true;
+		glfwBroadcastCond( m_oJobCond );
+		glfwUnlockMutex( m_oLock );
+
+		for( size_t i = 0; i < m_vThreads.size(); ++i )
+			glfwWaitThread( m_vThreads[ i ], GLFW_WAIT );
+
+		for( int i = 0; i < FRAME_CAPTURE_PBO_NB; ++i )
+		{
+			if( m_pSlots[ i ].iPBO != 0 )
+				glDeleteBuffersARB( 1, &m_pSlots[ i ].iPBO );
+		}
+
+		glfwDestroyCond( m_oDoneCond );
+		glfwDestroyCond( m_oJobCond );
+		glfwDestroyMutex( m_oLock );
+	}
+
+	/**
+	* @brief encoder thread: writes the queued frames until the capture is destroyed
+	* @param pData the frame capture
+	*/
+	void GLFWCALL FrameCapture::encoderThread( void* pData )
+	{
+		FrameCapture* pCapture = ( FrameCapture* )pData;
+
+		for( ;; )
+		{
+			glfwLockMutex( pCapture->m_oLock );
+			while( pCapture->m_dJobs.empty() && !pCapture->m_bShutdown )
+				glfwWaitCond( pCapture->m_oJobCond, pCapture->m_oLock, GLFW_INFINITY );
+
+			if( pCapture->m_dJobs.empty() )
+			{
+				glfwUnlockMutex( pCapture->m_oLock );
+				return;
+			}
+
+			EncodeJob oJob = pCapture->m_dJobs.front();
+			pCapture->m_dJobs.pop_front();
+			++pCapture->m_iBusyEncoderNb;
+			glfwUnlockMutex( pCapture->m_oLock );
+
+			try
+			{
+				Texture::writeFile( *oJob.pFormat, oJob.sFilename.c_str(), oJob.iWidth, oJob.iHeight, oJob.pData );
+			}
+			catch( Error e )
+			{
+				e.showError();
+			}
+			delete[] oJob.pData;
+
+			glfwLockMutex( pCapture->m_oLock );
+			--pCapture->m_iBusyEncoderNb;
+			++pCapture->m_iWrittenNb;
+			pCapture->m_iQueuedBytes -= oJob.iSize;
+			glfwBroadcastCond( pCapture->m_oDoneCond );
+			glfwUnlockMutex( pCapture->m_oLock );
+		}
+	}
+
+	/**
+	* @brief queues a frame for the encoder threads, waits for them when too many frames are queued
+	* @param oJob the frame, its data is deleted once written
+	*/
+	void FrameCapture::queueJob( const EncodeJob& oJob )
+	{
+		glfwLockMutex( m_oLock );
+		while( m_iQueuedBytes > 0 && m_iQueuedBytes + oJob.iSize > m_iMaxQueuedBytes )
+			glfwWaitCond( m_oDoneCond, m_oLock, GLFW_INFINITY );
+
+		m_dJobs.push_back( oJob );
+		m_iQueuedBytes += oJob.iSize;
+		glfwSignalCond( m_oJobCond );
+		glfwUnlockMutex( m_oLock );
+	}
+
+	/**
+	* @brief prepares the next slot of the ring to receive a frame
+	* @param sFilename the picture file name
+	* @param oFormat the picture format
+	* @param iWidth the frame width
+	* @param iHeight the frame height
+	* @param iSize the frame size in bytes
+	* @return where the frame is read back: an offset in the pixel buffer bound for packing, or client memory
+	*/
+	GLvoid* FrameCapture::beginCapture( const string& sFilename, PicFormatInfo& oFormat, GLuint iWidth, GLuint iHeight, GLuint iSize )
+	{
+		CaptureSlot& oSlot = m_pSlots[ m_iNextSlot ];
+
+		// the ring is full: the oldest frame must be read back first
+		if( oSlot.bPending )
+			retireSlot( oSlot, true );
+
+		oSlot.sFilename = sFilename;
+		oSlot.pFormat = &oFormat;
+		oSlot.iWidth = iWidth;
+		oSlot.iHeight = iHeight;
+		oSlot.iSize = iSize;
+
+		glPixelStorei( GL_PACK_ALIGNMENT, 1 );
+
+		if( !m_bAsync )
+		{
+			oSlot.pData = new GLubyte[ iSize ];
+			return oSlot.pData;
+		}
+
+		glBindBufferARB( GL_PIXEL_PACK_BUFFER_ARB, oSlot.iPBO );
+		if( oSlot.iBufferSize < iSize )
+		{
+			glBufferDataARB( GL_PIXEL_PACK_BUFFER_ARB, iSize, NULL, GL_STREAM_READ_ARB );
+			oSlot.iBufferSize = iSize;
+		}
+
+		return NULL;
+	}
+
+	/**
+	* @brief fences the read back of the frame prepared by beginCapture(), or queues it when it was read synchronously
+	*/
+	void FrameCapture::endCapture()
+	{
+		CaptureSlot& oSlot = m_pSlots[ m_iNextSlot ];
+
+		if( !m_bAsync )
+		{
+			EncodeJob oJob = { oSlot.sFilename, oSlot.pFormat, oSlot.iWidth, oSlot.iHeight, oSlot.iSize, oSlot.pData };
+			oSlot.pData = NULL;
+			queueJob( oJob );
+			return;
+		}
+
+		glBindBufferARB( GL_PIXEL_PACK_BUFFER_ARB, 0 );
+		oSlot.oFence = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+		oSlot.bPending = true;
+		m_iNextSlot = ( m_iNextSlot + 1 ) % FRAME_CAPTURE_PBO_NB;
+
+		Error::checkGLerror( "FrameCapture::endCapture" );
+	}
+
+	/**
+	* @brief copies a frame out of its pixel buffer and queues it for the encoder threads
+	* @param oSlot the slot
+	* @param bWait true: waits for the GL to write the frame, false: returns if it is not written yet
+	* @return true if the frame was queued
+	*/
+	bool FrameCapture::retireSlot( CaptureSlot& oSlot, bool bWait )
+	{
+		GLenum iStatus = glClientWaitSync( oSlot.oFence, bWait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, bWait ? GL_TIMEOUT_IGNORED : 0 );
+		if( iStatus != GL_ALREADY_SIGNALED && iStatus != GL_CONDITION_SATISFIED )
+			return false;
+
+		glDeleteSync( oSlot.oFence );
+		oSlot.oFence = 0;
+		oSlot.bPending = false;
+
+		// the frame is copied so that the buffer is unmapped at once, the GL cannot use a mapped buffer
+		glBindBufferARB( GL_PIXEL_PACK_BUFFER_ARB, oSlot.iPBO );
+		const GLubyte* pMapped = ( const GLubyte* )glMapBufferARB( GL_PIXEL_PACK_BUFFER_ARB, GL_READ_ONLY_ARB );
+		if( pMapped == NULL )
+		{
+			glBindBufferARB( GL_PIXEL_PACK_BUFFER_ARB, 0 );
+			throw Error( "FrameCapture::retireSlot error : Failed to map a pixel buffer", oSlot.sFilename );
+		}
+
+		EncodeJob oJob = { oSlot.sFilename, oSlot.pFormat, oSlot.iWidth, oSlot.iHeight, oSlot.iSize, new GLubyte[ oSlot.iSize ] };
+		memcpy( oJob.pData, pMapped, oSlot.iSize );
+
+		glUnmapBufferARB( GL_PIXEL_PACK_BUFFER_ARB );
+		glBindBufferARB( GL_PIXEL_PACK_BUFFER_ARB, 0 );
+
+		queueJob( oJob );
+		return true;
+	}
+
+	/**
+	* @brief captures the frame of the framebuffer bound for reading as a PNG picture
+	* @param sFilename the picture file name
+	* @param iWidth the frame width
+	* @param iHeight the frame height
+	*/
+	void FrameCapture::captureFramebuffer( const string& sFilename, GLuint iWidth, GLuint iHeight )
+	{
+		GLvoid* pDest = beginCapture( sFilename, PNG, iWidth, iHeight, PNG.iPixelSize * iWidth * iHeight );
+		glReadPixels( 0, 0, iWidth, iHeight, GL_RGB, GL_UNSIGNED_BYTE, pDest );
+		endCapture();
+	}
+
+	/**
+	* @brief captures the first level of a floating point texture as an EXR picture
+	* @param sFilename the picture file name
+	* @param oTexture the texture
+	*/
+	void FrameCapture::captureTexture( const string& sFilename, const Texture2D& oTexture )
+	{
+		GLuint iWidth = oTexture.getWidth();
+		GLuint iHeight = oTexture.getHeight();
+
+		GLvoid* pDest = beginCapture( sFilename, EXR, iWidth, iHeight, EXR.iPixelSize * iWidth * iHeight );
+		oTexture.bind();
+		glGetTexImage( GL_TEXTURE_2D, 0, GL_RGBA, GL_HALF_FLOAT_ARB, pDest );
+		oTexture.bind( false );
+		endCapture();
+	}
+
+	/**
+	* @brief hands the frames the GL is done reading back to the encoder threads, to be called once per frame
+	*/
+	void FrameCapture::update()
+	{
+		// the frames are retired in capture order, from the oldest one
+		for( int i = 0; i < FRAME_CAPTURE_PBO_NB; ++i )
+		{
+			CaptureSlot& oSlot = m_pSlots[ ( m_iNextSlot + i ) % FRAME_CAPTURE_PBO_NB ];
+			if( oSlot.bPending && !retireSlot( oSlot, false ) )
+				break;
+		}
+	}
+
+	/**
+	* @brief waits until every captured frame is written
+	*/
+	void FrameCapture::flush()
+	{
+		for( int i = 0; i < FRAME_CAPTURE_PBO_NB; ++i )
+		{
+			CaptureSlot& oSlot = m_pSlots[ ( m_iNextSlot + i ) % FRAME_CAPTURE_PBO_NB ];
+			if( oSlot.bPending )
+				retireSlot( oSlot, true );
+		}
+
+		glfwLockMutex( m_oLock );
+		while( !m_dJobs.empty() || m_iBusyEncoderNb > 0 )
+			glfwWaitCond( m_oDoneCond, m_oLock, GLFW_INFINITY );
+		glfwUnlockMutex( m_oLock );
+	}
+
+	/**
+	* @brief returns the number of frames captured and not written yet
+	* @return the number of frames
+	*/
+	int FrameCapture::getPendingNb()
+	{
+		int iPendingNb = 0;
+		for( int i = 0; i < FRAME_CAPTURE_PBO_NB; ++i )
+			if( m_pSlots[ i ].bPending )
+				++iPendingNb;
+
+		glfwLockMutex( m_oLock );
+		iPendingNb += ( int )m_dJobs.size() + m_iBusyEncoderNb;
+		glfwUnlockMutex( m_oLock );
+
+		return iPendingNb;
+	}
+
+	/**
+	* @brief returns the number of frames written
+	* @return the number of frames
+	*/
+	int FrameCapture::getWrittenNb()
+	{
+		glfwLockMutex( m_oLock );
+		int iWrittenNb = m_iWrittenNb;
+		glfwUnlockMutex( m_oLock );
+
+		return iWrittenNb;
+	}
+}
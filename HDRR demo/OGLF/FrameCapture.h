@@ -0,0 +1,135 @@
+#ifndef FRAMECAPTURE_H
+#define FRAMECAPTURE_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <GL/glew.h>
+
+#ifdef WIN32
+#include <Windows.h>
+#endif
+
+#include <GL/glfw.h>
+#include "Texture2D.h"
+
+namespace Oglf
+{
+	const int FRAME_CAPTURE_PBO_NB = 3;		// frames read back at the same time
+
+	/**
+	* class FrameCapture writes frames to disk without stalling the rendering: the frames are read back into a ring
+	* of pixel buffers, each one fenced, and are only mapped once the GL is done writing them, a few frames later.
+	* Encoder threads then write the pictures: PNG pictures of the framebuffer, or EXR pictures of a floating point
+	* texture such as the HDR render output. When pixel buffers or fences are not supported the frames are read
+	* back synchronously but still encoded by the threads. DevIL serializes the encoding, the threads keep it off
+	* the rendering thread.
+	*/
+	class FrameCapture
+	{
+		/**
+		* @brief a pixel buffer of the ring
+		*/
+		struct CaptureSlot
+		{
+			GLuint			iPBO;
+			GLuint			iBufferSize;	// allocated size in bytes
+			GLsync			oFence;			// signaled when the GL is done writing the buffer
+			bool			bPending;		// the buffer holds a frame not handed to the encoders yet
+			std::string		sFilename;
+			PicFormatInfo*	pFormat;
+			GLuint			iWidth;
+			GLuint			iHeight;
+			GLuint			iSize;			// frame size in bytes
+			GLubyte*		pData;			// the frame read back synchronously, without pixel buffers
+		};
+
+		/**
+		* @brief a frame waiting for an encoder thread
+		*/
+		struct EncodeJob
+		{
+			std::string		sFilename;
+			PicFormatInfo*	pFormat;
+			GLuint			iWidth;
+			GLuint			iHeight;
+			GLuint			iSize;
+			GLubyte*		pData;
+		};
+
+		CaptureSlot					m_pSlots[ FRAME_CAPTURE_PBO_NB ];
+		int							m_iNextSlot;		// slot of the next frame, the oldest pending one
+		bool						m_bAsync;			// pixel buffers and fences are supported
+
+		std::deque< EncodeJob >		m_dJobs;
+		unsigned int				m_iQueuedBytes;		// frames read back and not written yet
+		unsigned int				m_iMaxQueuedBytes;
+		int							m_iBusyEncoderNb;
+		int							m_iWrittenNb;
+
+		std::vector< GLFWthread >	m_vThreads;
+		GLFWmutex					m_oLock;
+		GLFWcond					m_oJobCond;			// signaled when a frame is queued
+		GLFWcond					m_oDoneCond;		// signaled when a frame is written
+		bool						m_bShutdown;
+
+		static void GLFWCALL encoderThread( void* pData );
+		GLvoid* beginCapture( const std::string& sFilename, PicFormatInfo& oFormat, GLuint iWidth, GLuint iHeight, GLuint iSize );
+		void endCapture();
+		bool retireSlot( CaptureSlot& oSlot, bool bWait );
+		void queueJob( const EncodeJob& oJob );
+
+	public:
+
+		/**
+		* @brief constructor: creates the pixel buffers and starts the encoder threads, must be called with a current GL context
+		* @param iEncoderNb the number of encoder threads
+		* @param iMaxQueuedBytes the memory of the frames waiting for an encoder, the capture waits for the encoders beyond it
+		*/
+		FrameCapture( int iEncoderNb = 2, unsigned int iMaxQueuedBytes = 256 << 20 );
+
+		/**
+		* @brief destructor: writes the captured frames and stops the encoder threads, must be called with a current GL context
+		*/
+		~FrameCapture();
+
+		/**
+		* @brief captures the frame of the framebuffer bound for reading as a PNG picture
+		* @param sFilename the picture file name
+		* @param iWidth the frame width
+		* @param iHeight the frame height
+		*/
+		void captureFramebuffer( const std::string& sFilename, GLuint iWidth, GLuint iHeight );
+
+		/**
+		* @brief captures the first level of a floating point texture as an EXR picture
+		* @param sFilename the picture file name
+		* @param oTexture the texture
+		*/
+		void captureTexture( const std::string& sFilename, const Texture2D& oTexture );
+
+		/**
+		* @brief hands the frames the GL is done reading back to the encoder threads, to be called once per frame
+		*/
+		void update();
+
+		/**
+		* @brief waits until every captured frame is written
+		*/
+		void flush();
+
+		/**
+		* @brief returns the number of frames captured and not written yet
+		* @return the number of frames
+		*/
+		int getPendingNb();
+
+		/**
+		* @brief returns the number of frames written
+		* @return the number of frames
+		*/
+		int getWrittenNb();
+	};
+}
+
+#endif /* FRAMECAPTURE_H */
@@ -0,0 +1,99 @@
+#include "FrameState.h"
+
+using namespace std;
+
+namespace Oglf
+{
+	/**
+	* @brief constructor: creates an empty state
+	*/
+	FrameState::FrameState()
+		: m_iWriteState( 0 )
+	{
+	}
+
+	/**
+	* @brief registers a block in both states, must be called before the pipeline starts
+	* @param iFloatNb the block size
+	* @param pfData the block initial data, NULL for zeros
+	* @return the block ID
+	*/
+	int FrameState::addBlock( int iFloatNb, const float* pfData )
+	{
+		int iBlock = ( int )m_vStates[ 0 ].size();
+
+		for( int i = 0; i < 2; ++i )
+		{
+			if( pfData != NULL )
+				m_vStates[ i ].insert( m_vStates[ i ].end(), pfData, pfData + iFloatNb );
+			else
+				m_vStates[ i ].resize( iBlock + iFloatNb, 0.f );
+		}
+
+		return iBlock;
+	}
+
+	/**
+	* @brief registers a vector block
+	* @param oVec the initial vector
+	* @return the block ID
+	*/
+	int FrameState::addVec3( const Vec3& oVec )
+	{
+		return addBlock( 3, oVec.v );
+	}
+
+	/**
+	* @brief registers a matrix block
+	* @param oMat the initial matrix
+	* @return the block ID
+	*/
+	int FrameState::addMatrix( const Matrix4x4& oMat )
+	{
+		return addBlock( 16, oMat.m );
+	}
+
+	/**
+	* @brief registers a block bound to an effect parameter, which is then refreshed by applyParameters()
+	* @param oFx the effect
+	* @param iParameterID the parameter id in the effect parameter list
+	* @param iFloatNb the parameter size
+	* @param pfData the parameter initial data, NULL for zeros
+	* @return the block ID
+	*/
+	int FrameState::addParameter( RenderingFX& oFx, unsigned int iParameterID, int iFloatNb, const float* pfData )
+	{
+		Parameter oParameter;
+		oParameter.pFx = &oFx;
+		oParameter.iParameterID = iParameterID;
+		oParameter.iBlock = addBlock( iFloatNb, pfData );
+		m_vParameters.push_back( oParameter );
+
+		return oParameter.iBlock;
+	}
+
+	/**
+	* @brief makes the write state the read one, the new write state starts as a copy of it so that the blocks
+	* the update stage does not write keep their value. Must be called while no stage runs.
+	*/
+	void FrameState::publish()
+	{
+		m_iWriteState = 1 - m_iWriteState;
+		m_vStates[ m_iWriteState ] = m_vStates[ 1 - m_iWriteState ];
+	}
+
+	/**
+	* @brief points the effect parameters bound to blocks at the read state and refreshes them, to be called by
+	* the render stage with the GL context current
+	*/
+	void FrameState::applyParameters()
+	{
+		for( size_t i = 0; i < m_vParameters.size(); ++i )
+		{
+			const Parameter& oParameter = m_vParameters[ i ];
+
+			oParameter.pFx->updateParameterLocation( oParameter.iParameterID, getReadBlock( oParameter.iBlock ) );
+			oParameter.pFx->refreshParameter( oParameter.iParameterID );
+		}
+	}
+}
@@ -0,0 +1,156 @@
+#ifndef FRAMESTATE_H
+#define FRAMESTATE_H
+
+#include <vector>
+#include "Vec.h"
+#include "Matrix.h"
+#include "RenderingFX.h"
+
+namespace Oglf
+{
+	/**
+	* class FrameState double-buffers the scene state shared by the update and the render stages of the frame pipeline:
+	* the update stage writes the transforms, the cameras and the effect parameters of a frame into the write state
+	* while the render stage reads those of the previous frame from the read state, so that both stages may run at
+	* once on different threads. The state is made of float blocks, registered before the pipeline starts. A block
+	* may be bound to an effect parameter, which the render stage points at the read state and refreshes.
+	* publish() makes the write state the read one, it must not overlap any stage.
+	*/
+	class FrameState
+	{
+		/**
+		* @brief a block bound to an effect parameter
+		*/
+		struct Parameter
+		{
+			RenderingFX*	pFx;
+			unsigned int	iParameterID;
+			int				iBlock;
+		};
+
+		std::vector< float >		m_vStates[ 2 ];
+		int							m_iWriteState;
+		std::vector< Parameter >	m_vParameters;
+
+	public:
+
+		/**
+		* @brief constructor: creates an empty state
+		*/
+		FrameState();
+
+		/**
+		* @brief registers a block in both states, must be called before the pipeline starts
+		* @param iFloatNb the block size
+		* @param pfData the block initial data, NULL for zeros
+		* @return the block ID
+		*/
+		int addBlock( int iFloatNb, const float* pfData = NULL );
+
+		/**
+		* @brief registers a vector block
+		* @param oVec the initial vector
+		* @return the block ID
+		*/
+		int addVec3( const Vec3& oVec );
+
+		/**
+		* @brief registers a matrix block
+		* @param oMat the initial matrix
+		* @return the block ID
+		*/
+		int addMatrix( const Matrix4x4& oMat );
+
+		/**
+		* @brief registers a block bound to an effect parameter, which is then refreshed by applyParameters()
+		* @param oFx the effect
+		* @param iParameterID the parameter id in the effect parameter list
+		* @param iFloatNb the parameter size
+		* @param pfData the parameter initial data, NULL for zeros
+		* @return the block ID
+		*/
+		int addParameter( RenderingFX& oFx, unsigned int iParameterID, int iFloatNb, const float* pfData = NULL );
+
+		/**
+		* @brief makes the write state the read one, the new write state starts as a copy of it so that the blocks
+		* the update stage does not write keep their value. Must be called while no stage runs.
+		*/
+		void publish();
+
+		/**
+		* @brief points the effect parameters bound to blocks at the read state and refreshes them, to be called by
+		* the render stage with the GL context current
+		*/
+		void applyParameters();
+
+		/**
+		* @brief returns a block of the write state, for the update stage
+		* @param iBlock the block ID
+		* @return the block data
+		*/
+		float* getWriteBlock( int iBlock )
+		{
+			return &m_vStates[ m_iWriteState ][ iBlock ];
+		}
+
+		/**
+		* @brief returns a block of the read state, for the render stage
+		* @param iBlock the block ID
+		* @return the block data
+		*/
+		const float* getReadBlock( int iBlock ) const
+		{
+			return &m_vStates[ 1 - m_iWriteState ][ iBlock ];
+		}
+
+		/**
+		* @brief writes a vector block
+		* @param iBlock the block ID
+		* @param oVec the vector
+		*/
+		void setVec3( int iBlock, const Vec3& oVec )
+		{
+			float* pfBlock = getWriteBlock( iBlock );
+			for( int i = 0; i < 3; ++i )
+				pfBlock[ i ] = oVec.v[ i ];
+		}
+
+		/**
+		* @brief writes a matrix block
+		* @param iBlock the block ID
+		* @param oMat the matrix
+		*/
+		void setMatrix( int iBlock, const Matrix4x4& oMat )
+		{
+			float* pfBlock = getWriteBlock( iBlock );
+			for( int i = 0; i < 16; ++i )
+				pfBlock[ i ] = oMat.m[ i ];
+		}
+
+		/**
+		* @brief reads a vector block
+		* @param iBlock the block ID
+		* @param oVec the vector read
+		*/
+		void getVec3( int iBlock, Vec3& oVec ) const
+		{
+			const float* pfBlock = getReadBlock( iBlock );
+			for( int i = 0; i < 3; ++i )
+				oVec.v[ i ] = pfBlock[ i ];
+		}
+
+		/**
+		* @brief reads a matrix block
+		* @param iBlock the block ID
+		* @param oMat the matrix read
+		*/
+		void getMatrix( int iBlock, Matrix4x4& oMat ) const
+		{
+			const float* pfBlock = getReadBlock( iBlock );
+			for( int i = 0; i < 16; ++i )
+				oMat.m[ i ] = pfBlock[ i ];
+		}
+	};
+}
+
+#endif /* FRAMESTATE_H */
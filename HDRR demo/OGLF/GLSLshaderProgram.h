@@ -4,6 +4,7 @@
 #include <GL/glew.h>
 #include "GLSLshader.h"
 #include "Error.h"
+#include "RenderStats.h"
 
 namespace Oglf
 {
@@ -75,6 +76,7 @@ namespace Oglf
 		*/
 		void use( bool state=true ) const
 		{
+			RenderStats::addStateChange();
 			if(state)
 			{
 				glUseProgram(m_handle);
@@ -109,6 +111,7 @@ namespace Oglf
 		*/
 		static void useFixedPipeline()
 		{
+			RenderStats::addStateChange();
 			glUseProgram(0);
 			m_inUse = 0;
 		}
@@ -0,0 +1,137 @@
+#ifdef WIN32
+#include <Windows.h>
+#endif
+#include <GL/gl.h>
+#include "GLtransformer3D.h"
+
+
+namespace Oglf
+{
+	/**
+	* @brief rebuilds the transform matrix and the transformed pivot from the translation, rotation and scale
+	*/
+	void GLtransformer3D::update() const
+	{
+		m_rotation.toMatrix(m_transformMat.m);
+
+		for(int c=0; c<3; c++)
+		{
+			for(int l=0; l<3; l++)
+				m_transformMat.m[c*4+l] *= m_fScale;
+			m_transformMat.m[c*4+3] = 0.0;
+		}
+
+		m_transformMat.m[12] = m_translation.v[0];
+		m_transformMat.m[13] = m_translation.v[1];
+		m_transformMat.m[14] = m_translation.v[2];
+		m_transformMat.m[15] = 1.0;
+
+		m_pivotPosition = m_transformMat * m_pivot;
+
+		m_bDirty = false;
+	}
+
+	/**
+	* @brief composes a rotation after the current one, the quaternion is normalized every s_iRenormalizePeriod rotations
+	* @param q the rotation
+	*/
+	void GLtransformer3D::applyRotation(const Quaternion& q)
+	{
+		m_rotation = m_rotation * q;
+
+		if(++m_iRotationNb >= s_iRenormalizePeriod)
+		{
+			m_rotation.normalize();
+			m_iRotationNb = 0;
+		}
+
+		m_bDirty = true;
+		++m_iVersion;
+	}
+
+	/**
+	* @brief resets the transformation to the identity to apply no transformations
+	*/
+	void GLtransformer3D::reset()
+	{
+		m_translation = Vec3();
+		m_rotation.identity();
+		m_fScale = 1.0;
+		m_iRotationNb = 0;
+		m_bDirty = true;
+		++m_iVersion;
+	}
+
+	/**
+	* @brief applies a rotation to the transformation
+	* @param ax rotation angle on X axis
+	* @param ay rotation angle on Y axis
+	* @param az rotation angle on Z axis
+	*/
+	void GLtransformer3D::rotate(float ax, float ay, float az)
+	{
+		// createRotation() takes degrees, the angles are in radians as with Matrix4x4::rotationX()
+		float toDegrees = 180.f / (float)M_PI;
+		Quaternion qx, qy, qz;
+
+		qx.createRotation(ax * toDegrees, 1.f, 0.f, 0.f);
+		qy.createRotation(ay * toDegrees, 0.f, 1.f, 0.f);
+		qz.createRotation(az * toDegrees, 0.f, 0.f, 1.f);
+
+		applyRotation(qx * qy * qz);
+	}
+
+	/**
+	* @briefs applies a rotation of a given angle around a given axis using quaternions
+	* @param angle the rotation angle
+	* @param x the rotation axis x coordinate
+	* @param y the rotation axis y coordinate
+	* @param z the rotation axis z coordinate
+	*/
+	void GLtransformer3D::rotate(float angle, float x, float y, float z)
+	{
+		Quaternion rotQ;
+		rotQ.createRotation(angle, x, y, z);
+
+		// the transformation used to be multiplied by the createRotationMatrix() matrix, the transpose of the
+		// quaternion one: composing the conjugate keeps the rotations in the same direction
+		applyRotation(rotQ.getConjugate());
+	}
+
+	/**
+	* @brief applies a translation on the transformation
+	* @param tx translation factor on X axis
+	* @param ty translation factor on Y axis
+	* @param tz translation factor on Z axis
+	*/
+	void GLtransformer3D::translate(float tx, float ty, float tz)
+	{
+		// the translation is applied in the object space: it is rotated and scaled by the current transformation
+		m_translation += m_fScale * m_rotation.rotateVector(Vec3(tx, ty, tz));
+		m_bDirty = true;
+		++m_iVersion;
+	}
+
+	/**
+	* @brief sets the transformation from a matrix made of a translation, a rotation and a uniform scale
+	* @param oMat the matrix, kept as the transform matrix
+	*/
+	void GLtransformer3D::setTransformMatrix(const Matrix4x4& oMat)
+	{
+		m_fScale = Vec3(oMat.m[0], oMat.m[1], oMat.m[2]).length();
+
+		Matrix4x4 rotMat(oMat);
+		for(int i=0; i<12; i++)
+			rotMat.m[i] /= m_fScale;
+		m_rotation.fromMatrix(rotMat.m);
+		m_iRotationNb = 0;
+
+		m_translation = Vec3(oMat.m[12], oMat.m[13], oMat.m[14]);
+
+		// the matrix is kept as is rather than rebuilt from its decomposition
+		m_transformMat = oMat;
+		m_pivotPosition = m_transformMat * m_pivot;
+		m_bDirty = false;
+		++m_iVersion;
+	}
+}
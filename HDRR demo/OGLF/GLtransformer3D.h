@@ -8,13 +8,32 @@
 
 namespace Oglf
 {
+	/**
+	* class GLtransformer3D holds the transform of an object as a translation, a rotation quaternion and a uniform
+	* scale, composed in this order: each transformation is applied in the object space, after the previous ones.
+	* Storing the decomposition instead of accumulating matrix products keeps the rotation orthogonal over long
+	* sessions. The transform matrix and the transformed pivot are only rebuilt when they are read after a change.
+	*/
 	class GLtransformer3D
 	{
-		Matrix4x4 m_transformMat;
+		static const int s_iRenormalizePeriod = 64; // rotations between two quaternion normalizations
+
+		Vec3 m_translation;
+		Quaternion m_rotation;
+		float m_fScale;
+		int m_iRotationNb; // rotations since the quaternion was normalized
 		Vec3 m_pivot; // a reference point to which the transformation matrix is applied
 
+		mutable Matrix4x4 m_transformMat; // translation * rotation * scale
+		mutable Vec3 m_pivotPosition; // the pivot transformed by m_transformMat
+		mutable bool m_bDirty; // m_transformMat and m_pivotPosition must be rebuilt
+		unsigned int m_iVersion; // incremented on each change of the transformation
+
+		void update() const;
+		void applyRotation(const Quaternion& q);
+
 	public:
-		GLtransformer3D()
+		GLtransformer3D() : m_iVersion(0)
 		{
 			reset();
 		}
@@ -25,32 +44,17 @@ namespace Oglf
 		}
 
 		/**
-		* @brief loads the transformation matrix with the identity matrix to apply no transformations
+		* @brief resets the transformation to the identity to apply no transformations
 		*/
-		void reset()
-		{
-			m_transformMat.identity();
-		}
-
-
+		void reset();
 
 		/**
-		* @brief applies a rotation to the transformation matrix
+		* @brief applies a rotation to the transformation
 		* @param ax rotation angle on X axis
 		* @param ay rotation angle on Y axis
 		* @param az rotation angle on Z axis
 		*/
-		void rotate(float ax, float ay, float az)
-		{
-			Matrix4x4 tmpMat;
-
-			tmpMat.rotationX(ax);
-			m_transformMat= m_transformMat * tmpMat;
-			tmpMat.rotationY(ay);
-			m_transformMat= m_transformMat * tmpMat;
-			tmpMat.rotationZ(az);
-			m_transformMat= m_transformMat * tmpMat;
-		}
+		void rotate(float ax, float ay, float az);
 
 		/**
 		* @briefs applies a rotation of a given angle around a given axis using quaternions
@@ -59,16 +63,7 @@ namespace Oglf
 		* @param y the rotation axis y coordinate
 		* @param z the rotation axis z coordinate
 		*/
-		void rotate(float angle, float x, float y, float z)
-		{
-			Quaternion rotQ;
-			rotQ.createRotation(angle, x, y, z);
-
-			Matrix4x4 rotMatrix;
-			rotQ.createRotationMatrix(rotMatrix.m);
-
-			m_transformMat= m_transformMat * rotMatrix;
-		}
+		void rotate(float angle, float x, float y, float z);
 
 		void rotate(float angle,Vec3 oAxis )
 		{
@@ -76,48 +71,76 @@ namespace Oglf
 		}
 
 		/**
-		* @brief applies a translation on the transformation matrix
+		* @brief applies a rotation to the transformation, in the object space
+		* @param q the rotation unit quaternion
+		*/
+		void rotate(const Quaternion& q)
+		{
+			applyRotation(q);
+		}
+
+		/**
+		* @brief applies a translation on the transformation
 		* @param tx translation factor on X axis
 		* @param ty translation factor on Y axis
 		* @param tz translation factor on Z axis
 		*/
-		void translate(float tx, float ty, float tz)
-		{
-			Matrix4x4 tmpMat;
-			Vec3 tVec(tx, ty, tz);
-			tmpMat.translate(tVec);
-
-			m_transformMat= m_transformMat * tmpMat;
-		}
+		void translate(float tx, float ty, float tz);
 
 		/**
-		* @brief applies a uniform scale on the transformation matrix
+		* @brief applies a uniform scale on the transformation
 		* @param s the scale factor
 		*/
 		void uniformScale(float s)
 		{
-			Matrix4x4 tmpMat;
-			tmpMat.scale(s);
-
-			m_transformMat= m_transformMat * tmpMat;
+			m_fScale *= s;
+			m_bDirty = true;
+			++m_iVersion;
 		}
 
 		/**
-		* @brief Returns a reference to the transform matrix to write to. The transform matrix is a
-		* Opengl compliant matrix store in the float[16] array in column major order
-		* @return a reference to the transfrom matrix
+		* @brief Returns the transform matrix, rebuilt if the transformation changed since it was last read. The
+		* transform matrix is a Opengl compliant matrix store in the float[16] array in column major order
+		* @return a reference to the transform matrix, valid until the transformation changes
 		*/
-		Matrix4x4& getTransformMatrix()
+		const Matrix4x4& getTransformMatrix() const
 		{
+			if( m_bDirty )
+				update();
+
 			return m_transformMat;
 		}
 
+		/**
+		* @brief sets the transformation from a matrix made of a translation, a rotation and a uniform scale
+		* @param oMat the matrix, kept as the transform matrix
+		*/
+		void setTransformMatrix(const Matrix4x4& oMat);
+
+		const Vec3& getTranslation() const { return m_translation; }
+		const Quaternion& getRotation() const { return m_rotation; }
+		float getScale() const { return m_fScale; }
+
+		void setTranslation(const Vec3& t) { m_translation = t; m_bDirty = true; ++m_iVersion; }
+		void setRotation(const Quaternion& q) { m_rotation = q; m_bDirty = true; ++m_iVersion; }
+		void setScale(float s) { m_fScale = s; m_bDirty = true; ++m_iVersion; }
+
+		/**
+		* @brief returns the transformation version, which changes each time the transformation does, so that
+		* the matrices derived from it may be rebuilt only when needed
+		* @return the transformation version
+		*/
+		unsigned int getVersion() const
+		{
+			return m_iVersion;
+		}
+
 		/**
 		* @brief applies all transformations to the object using the opengl modelview matrix
 		*/
 		void transform()
 		{
-			glMultMatrixf(m_transformMat.m);
+			glMultMatrixf(getTransformMatrix().m);
 		}
 
 		/**
@@ -129,15 +152,19 @@ namespace Oglf
 		void setPivotPosition(float x, float y, float z)
 		{
 			m_pivot= Vec3(x, y, z);
+			m_bDirty = true;
 		}
 
 		/**
 		* @brief returns the pivot position
-		* @return the pivot position after the matrix transformation
+		* @return the pivot position after the matrix transformation, valid until the transformation changes
 		*/
 		const float* getPivotPosition() const
 		{
-			return (m_transformMat + m_pivot).v;
+			if( m_bDirty )
+				update();
+
+			return m_pivotPosition.v;
 		}
 	};
 }
@@ -2,6 +2,7 @@
 #define HUD_H
 
 #include "Texture2D.h"
+#include "Profiler.h"
 
 
 namespace Oglf
@@ -40,6 +41,8 @@ namespace Oglf
 
 		void draw()
 		{
+			OGLF_PROFILE_GPU_SCOPE( "Hud::draw" );
+
 			glMatrixMode(GL_PROJECTION);
 			glPushMatrix();
 			glLoadIdentity();
@@ -75,6 +78,7 @@ namespace Oglf
 			glVertex2f( m_fWidth, m_fY );
 
 			glEnd();
+			RenderStats::addDrawCall( 2 );
 
 			m_pRfx->disable();
 
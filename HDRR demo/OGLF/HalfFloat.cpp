@@ -0,0 +1,251 @@
+#include <cstring>
+#include "HalfFloat.h"
+#include "Simd.h"
+
+
+namespace Oglf
+{
+	/**
+	* @brief reinterprets float bits as an integer and the other way around
+	*/
+	union FloatBits
+	{
+		unsigned int u;
+		float f;
+	};
+
+	/**
+	* @brief converts a float to a half float, rounding to nearest even
+	* @param fVal the float to convert
+	* @return the half float
+	*/
+	Half floatToHalf( float fVal )
+	{
+		const unsigned int iF32Infinity = 255 << 23;
+		const unsigned int iF16Max = ( 127 + 16 ) << 23;    // every float above rounds to infinity
+		const unsigned int iMinNormal = ( 127 - 14 ) << 23; // smallest float giving a normalized half
+		FloatBits oDenormMagic;
+		oDenormMagic.u = ( ( 127 - 15 ) + ( 23 - 10 ) + 1 ) << 23;
+
+		FloatBits oIn;
+		oIn.f = fVal;
+		unsigned int iSign = oIn.u & 0x80000000u;
+		oIn.u ^= iSign;
+
+		unsigned int iOut;
+		if( oIn.u >= iF16Max )
+		{
+			// infinity or NaN (all NaNs are made quiet)
+			iOut = ( oIn.u > iF32Infinity ) ? 0x7e00 : 0x7c00;
+		}
+		else if( oIn.u < iMinNormal )
+		{
+			// the float addition aligns the mantissa and rounds it to the denormalized half precision
+			oIn.f += oDenormMagic.f;
+			iOut = oIn.u - oDenormMagic.u;
+		}
+		else
+		{
+			unsigned int iMantissaOdd = ( oIn.u >> 13 ) & 1;
+
+			// rebias the exponent and round to nearest even
+			oIn.u += ( ( unsigned int )( 15 - 127 ) << 23 ) + 0xfff;
+			oIn.u += iMantissaOdd;
+			iOut = oIn.u >> 13;
+		}
+
+		return ( Half )( iOut | ( iSign >> 16 ) );
+	}
+
+	/**
+	* @brief converts a half float to a float
+	* @param hVal the half float to convert
+	* @return the float
+	*/
+	float halfToFloat( Half hVal )
+	{
+		const unsigned int iShiftedExp = 0x7c00 << 13;
+		FloatBits oMagic;
+		oMagic.u = 113 << 23;
+
+		FloatBits oOut;
+		oOut.u = ( hVal & 0x7fff ) << 13;
+		unsigned int iExp = iShiftedExp & oOut.u;
+		oOut.u += ( 127 - 15 ) << 23;
+
+		if( iExp == iShiftedExp )
+		{
+			// infinity or NaN
+			oOut.u += ( 128 - 16 ) << 23;
+		}
+		else if( iExp == 0 )
+		{
+			// zero or denormalized
+			oOut.u += 1 << 23;
+			oOut.f -= oMagic.f;
+		}
+
+		oOut.u |= ( hVal & 0x8000 ) << 16;
+		return oOut.f;
+	}
+
+#ifdef OGLF_SSE2
+
+	/**
+	* @brief SSE2 version of floatToHalf() working on 4 floats at once. The results are stored in the
+	* low 16 bits of each lane, sign extended so that they can be packed with _mm_packs_epi32.
+	*/
+	static inline __m128i floatToHalfSSE2( __m128 oVal )
+	{
+		const __m128  oSignMask      = _mm_set1_ps( -0.f );
+		const __m128i oF16Max        = _mm_set1_epi32( ( 127 + 16 ) << 23 );
+		const __m128i oF32Infinity   = _mm_set1_epi32( 255 << 23 );
+		const __m128i oNaNbit        = _mm_set1_epi32( 0x200 );
+		const __m128i oF16Infinity   = _mm_set1_epi32( 0x7c00 );
+		const __m128i oMinNormal     = _mm_set1_epi32( ( 127 - 14 ) << 23 );
+		const __m128i oDenormMagic   = _mm_set1_epi32( ( ( 127 - 15 ) + ( 23 - 10 ) + 1 ) << 23 );
+		const __m128i oNormalBias    = _mm_set1_epi32( 0xfff - ( ( 127 - 15 ) << 23 ) );
+
+		__m128  oSign     = _mm_and_ps( oSignMask, oVal );
+		__m128  oAbs      = _mm_xor_ps( oVal, oSign );
+		__m128i oAbsInt   = _mm_castps_si128( oAbs );
+
+		// infinity and NaN
+		__m128i oIsNaN     = _mm_cmpgt_epi32( oAbsInt, oF32Infinity );
+		__m128i oIsRegular = _mm_cmpgt_epi32( oF16Max, oAbsInt );
+		__m128i oSpecial   = _mm_or_si128( _mm_and_si128( oIsNaN, oNaNbit ), oF16Infinity );
+
+		// denormalized results
+		__m128i oIsDenorm  = _mm_cmpgt_epi32( oMinNormal, oAbsInt );
+		__m128  oDenorm1   = _mm_add_ps( oAbs, _mm_castsi128_ps( oDenormMagic ) );
+		__m128i oDenorm2   = _mm_sub_epi32( _mm_castps_si128( oDenorm1 ), oDenormMagic );
+
+		// normalized results, rounded to nearest even
+		__m128i oMantOdd   = _mm_srai_epi32( _mm_slli_epi32( oAbsInt, 31 - 13 ), 31 );
+		__m128i oRounded   = _mm_sub_epi32( _mm_add_epi32( oAbsInt, oNormalBias ), oMantOdd );
+		__m128i oNormal    = _mm_srli_epi32( oRounded, 13 );
+
+		__m128i oFinite    = _mm_or_si128( _mm_and_si128( oIsDenorm, oDenorm2 ), _mm_andnot_si128( oIsDenorm, oNormal ) );
+		__m128i oJoined    = _mm_or_si128( _mm_and_si128( oIsRegular, oFinite ), _mm_andnot_si128( oIsRegular, oSpecial ) );
+
+		return _mm_or_si128( oJoined, _mm_srai_epi32( _mm_castps_si128( oSign ), 16 ) );
+	}
+
+	static void floatToHalfSSE2( const float* pSrc, Half* pDst, size_t iCount )
+	{
+		size_t i = 0;
+		for( ; i + 8 <= iCount; i += 8 )
+		{
+			__m128i oLow  = floatToHalfSSE2( _mm_loadu_ps( pSrc + i ) );
+			__m128i oHigh = floatToHalfSSE2( _mm_loadu_ps( pSrc + i + 4 ) );
+			_mm_storeu_si128( ( __m128i* )( pDst + i ), _mm_packs_epi32( oLow, oHigh ) );
+		}
+		for( ; i < iCount; ++i )
+			pDst[ i ] = floatToHalf( pSrc[ i ] );
+	}
+
+	OGLF_TARGET( "f16c" )
+	static void floatToHalfF16C( const float* pSrc, Half* pDst, size_t iCount )
+	{
+		size_t i = 0;
+		for( ; i + 8 <= iCount; i += 8 )
+		{
+			// rounding mode 0: round to nearest even
+			__m128i oLow  = _mm_cvtps_ph( _mm_loadu_ps( pSrc + i ), 0 );
+			__m128i oHigh = _mm_cvtps_ph( _mm_loadu_ps( pSrc + i + 4 ), 0 );
+			_mm_storeu_si128( ( __m128i* )( pDst + i ), _mm_unpacklo_epi64( oLow, oHigh ) );
+		}
+		for( ; i < iCount; ++i )
+			pDst[ i ] = floatToHalf( pSrc[ i ] );
+	}
+
+	OGLF_TARGET( "f16c" )
+	static void halfToFloatF16C( const Half* pSrc, float* pDst, size_t iCount )
+	{
+		size_t i = 0;
+		for( ; i + 4 <= iCount; i += 4 )
+		{
+			_mm_storeu_ps( pDst + i, _mm_cvtph_ps( _mm_loadl_epi64( ( const __m128i* )( pSrc + i ) ) ) );
+		}
+		for( ; i < iCount; ++i )
+			pDst[ i ] = halfToFloat( pSrc[ i ] );
+	}
+
+#endif
+
+	/**
+	* @brief converts an array of floats to half floats, using F16C instructions when the CPU supports them
+	* and an SSE2 bit-trick otherwise. Source and destination may not overlap.
+	* @param pSrc the floats to convert
+	* @param pDst the converted half floats
+	* @param iCount the number of values to convert
+	*/
+	void floatToHalf( const float* pSrc, Half* pDst, size_t iCount )
+	{
+#ifdef OGLF_SSE2
+		if( CpuFeatures::get().bF16C )
+		{
+			floatToHalfF16C( pSrc, pDst, iCount );
+			return;
+		}
+		if( CpuFeatures::get().bSSE2 )
+		{
+			floatToHalfSSE2( pSrc, pDst, iCount );
+			return;
+		}
+#endif
+		for( size_t i = 0; i < iCount; ++i )
+			pDst[ i ] = floatToHalf( pSrc[ i ] );
+	}
+
+	/**
+	* @brief converts an array of half floats to floats
+	* @param pSrc the half floats to convert
+	* @param pDst the converted floats
+	* @param iCount the number of values to convert
+	*/
+	void halfToFloat( const Half* pSrc, float* pDst, size_t iCount )
+	{
+#ifdef OGLF_SSE2
+		if( CpuFeatures::get().bF16C )
+		{
+			halfToFloatF16C( pSrc, pDst, iCount );
+			return;
+		}
+#endif
+		for( size_t i = 0; i < iCount; ++i )
+			pDst[ i ] = halfToFloat( pSrc[ i ] );
+	}
+
+	/**
+	* @brief computes the next mipmap level of a RGBA half float picture with a 2x2 box filter
+	* @param pSrc the source picture
+	* @param iSrcWidth the source picture width
+	* @param iSrcHeight the source picture height
+	* @param pDst the downsampled picture, max( iSrcWidth / 2, 1 ) x max( iSrcHeight / 2, 1 ) texels
+	*/
+	void downsampleHalfRGBA( const Half* pSrc, unsigned int iSrcWidth, unsigned int iSrcHeight, Half* pDst )
+	{
+		unsigned int iDstWidth  = iSrcWidth > 1 ? iSrcWidth / 2 : 1;
+		unsigned int iDstHeight = iSrcHeight > 1 ? iSrcHeight / 2 : 1;
+
+		for( unsigned int y = 0; y < iDstHeight; ++y )
+		{
+			unsigned int y0 = 2 * y;
+			unsigned int y1 = y0 + 1 < iSrcHeight ? y0 + 1 : y0;
+
+			for( unsigned int x = 0; x < iDstWidth; ++x )
+			{
+				unsigned int x0 = 2 * x;
+				unsigned int x1 = x0 + 1 < iSrcWidth ? x0 + 1 : x0;
+
+				for( int c = 0; c < 4; ++c )
+				{
+					float fSum = halfToFloat( pSrc[ 4 * ( y0 * iSrcWidth + x0 ) + c ] ) + halfToFloat( pSrc[ 4 * ( y0 * iSrcWidth + x1 ) + c ] )
+							   + halfToFloat( pSrc[ 4 * ( y1 * iSrcWidth + x0 ) + c ] ) + halfToFloat( pSrc[ 4 * ( y1 * iSrcWidth + x1 ) + c ] );
+					pDst[ 4 * ( y * iDstWidth + x ) + c ] = floatToHalf( fSum * 0.25f );
+				}
+			}
+		}
+	}
+}
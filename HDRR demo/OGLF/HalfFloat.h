@@ -0,0 +1,54 @@
+#ifndef HALFFLOAT_H
+#define HALFFLOAT_H
+
+#include <cstddef>
+
+namespace Oglf
+{
+	/**
+	* @brief IEEE 754 binary16 value as uploaded with GL_HALF_FLOAT
+	*/
+	typedef unsigned short Half;
+
+	/**
+	* @brief converts a float to a half float, rounding to nearest even
+	* @param fVal the float to convert
+	* @return the half float
+	*/
+	Half floatToHalf( float fVal );
+
+	/**
+	* @brief converts a half float to a float
+	* @param hVal the half float to convert
+	* @return the float
+	*/
+	float halfToFloat( Half hVal );
+
+	/**
+	* @brief converts an array of floats to half floats, using F16C instructions when the CPU supports them
+	* and an SSE2 bit-trick otherwise. Source and destination may not overlap.
+	* @param pSrc the floats to convert
+	* @param pDst the converted half floats
+	* @param iCount the number of values to convert
+	*/
+	void floatToHalf( const float* pSrc, Half* pDst, size_t iCount );
+
+	/**
+	* @brief converts an array of half floats to floats
+	* @param pSrc the half floats to convert
+	* @param pDst the converted floats
+	* @param iCount the number of values to convert
+	*/
+	void halfToFloat( const Half* pSrc, float* pDst, size_t iCount );
+
+	/**
+	* @brief computes the next mipmap level of a RGBA half float picture with a 2x2 box filter
+	* @param pSrc the source picture
+	* @param iSrcWidth the source picture width
+	* @param iSrcHeight the source picture height
+	* @param pDst the downsampled picture, max( iSrcWidth / 2, 1 ) x max( iSrcHeight / 2, 1 ) texels
+	*/
+	void downsampleHalfRGBA( const Half* pSrc, unsigned int iSrcWidth, unsigned int iSrcHeight, Half* pDst );
+}
+
+#endif /* HALFFLOAT_H */
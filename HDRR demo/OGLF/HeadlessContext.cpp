@@ -0,0 +1,170 @@
+#include <cstring>
+#include "HeadlessContext.h"
+#include "Error.h"
+
+#if defined( OGLF_OSMESA )
+#include <GL/osmesa.h>
+#elif !defined( WIN32 )
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+namespace Oglf
+{
+	/**
+	* @brief constructor: creates the context and makes it current
+	* @param iWidth the frames width
+	* @param iHeight the frames height
+	*/
+	HeadlessContext::HeadlessContext( int iWidth, int iHeight )
+		: m_pDisplay( NULL )
+		, m_pSurface( NULL )
+		, m_pContext( NULL )
+		, m_pBuffer( NULL )
+		, m_iWidth( iWidth )
+		, m_iHeight( iHeight )
+		, m_pTargetTex( NULL )
+		, m_pTarget( NULL )
+	{
+#if defined( OGLF_OSMESA )
+		OSMesaContext pContext = OSMesaCreateContextExt( OSMESA_RGBA, 24, 0, 0, NULL );
+		if( pContext == NULL )
+			throw Error( "HeadlessContext::HeadlessContext error : Failed to create an OSMesa context" );
+		m_pContext = pContext;
+
+		// the frames are drawn to the render target, the OSMesa buffer is only needed to make the context current
+		m_pBuffer = new GLubyte[ 4 * iWidth * iHeight ];
+		if( !OSMesaMakeCurrent( pContext, m_pBuffer, GL_UNSIGNED_BYTE, iWidth, iHeight ) )
+			throw Error( "HeadlessContext::HeadlessContext error : Failed to make the OSMesa context current" );
+
+#elif !defined( WIN32 )
+		// a surfaceless display needs neither a window system nor a GPU, the default display is used otherwise
+		EGLDisplay pDisplay = EGL_NO_DISPLAY;
+		const char* sClientExtensions = eglQueryString( EGL_NO_DISPLAY, EGL_EXTENSIONS );
+		if( sClientExtensions != NULL && strstr( sClientExtensions, "EGL_MESA_platform_surfaceless" ) != NULL )
+		{
+			PFNEGLGETPLATFORMDISPLAYEXTPROC pGetPlatformDisplay = ( PFNEGLGETPLATFORMDISPLAYEXTPROC )eglGetProcAddress( "eglGetPlatformDisplayEXT" );
+			if( pGetPlatformDisplay != NULL )
+				pDisplay = pGetPlatformDisplay( EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL );
+		}
+		if( pDisplay == EGL_NO_DISPLAY )
+			pDisplay = eglGetDisplay( EGL_DEFAULT_DISPLAY );
+
+		if( pDisplay == EGL_NO_DISPLAY || !eglInitialize( pDisplay, NULL, NULL ) )
+			throw Error( "HeadlessContext::HeadlessContext error : Failed to initialize an EGL display" );
+		m_pDisplay = pDisplay;
+
+		if( !eglBindAPI( EGL_OPENGL_API ) )
+			throw Error( "HeadlessContext::HeadlessContext error : EGL does not support desktop OpenGL" );
+
+		// a pbuffer is only created when the display does not support contexts without surface
+		const char* sExtensions = eglQueryString( pDisplay, EGL_EXTENSIONS );
+		bool bSurfaceless = sExtensions != NULL && strstr( sExtensions, "EGL_KHR_surfaceless_context" ) != NULL;
+
+		EGLint pConfigAttributes[] =
+		{
+			EGL_RENDERABLE_TYPE,	EGL_OPENGL_BIT,
+			EGL_SURFACE_TYPE,		bSurfaceless ? 0 : EGL_PBUFFER_BIT,
+			EGL_NONE
+		};
+		EGLConfig pConfig;
+		EGLint iConfigNb = 0;
+		if( !eglChooseConfig( pDisplay, pConfigAttributes, &pConfig, 1, &iConfigNb ) || iConfigNb == 0 )
+			throw Error( "HeadlessContext::HeadlessContext error : No EGL config supports desktop OpenGL" );
+
+		EGLSurface pSurface = EGL_NO_SURFACE;
+		if( !bSurfaceless )
+		{
+			EGLint pSurfaceAttributes[] = { EGL_WIDTH, iWidth, EGL_HEIGHT, iHeight, EGL_NONE };
+			pSurface = eglCreatePbufferSurface( pDisplay, pConfig, pSurfaceAttributes );
+			if( pSurface == EGL_NO_SURFACE )
+				throw Error( "HeadlessContext::HeadlessContext error : Failed to create an EGL pbuffer" );
+		}
+		m_pSurface = pSurface;
+
+		EGLContext pContext = eglCreateContext( pDisplay, pConfig, EGL_NO_CONTEXT, NULL );
+		if( pContext == EGL_NO_CONTEXT )
+			throw Error( "HeadlessContext::HeadlessContext error : Failed to create an EGL context" );
+		m_pContext = pContext;
+
+		if( !eglMakeCurrent( pDisplay, pSurface, pSurface, pContext ) )
+			throw Error( "HeadlessContext::HeadlessContext error : Failed to make the EGL context current" );
+
+#else
+		throw Error( "HeadlessContext::HeadlessContext error : Headless rendering is not supported on Windows" );
+#endif
+	}
+
+	/**
+	* @brief destructor: deletes the render target and the context
+	*/
+	HeadlessContext::~HeadlessContext()
+	{
+		if( m_pTarget != NULL )
+			RenderTexture::setDefaultFramebuffer( 0 );
+
+		delete m_pTarget;
+		delete m_pTargetTex;
+
+#if defined( OGLF_OSMESA )
+		if( m_pContext != NULL )
+			OSMesaDestroyContext( ( OSMesaContext )m_pContext );
+		delete[] m_pBuffer;
+
+#elif !defined( WIN32 )
+		if( m_pDisplay != NULL )
+		{
+			eglMakeCurrent( m_pDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT );
+			if( m_pContext != NULL )
+				eglDestroyContext( m_pDisplay, m_pContext );
+			if( m_pSurface != EGL_NO_SURFACE )
+				eglDestroySurface( m_pDisplay, m_pSurface );
+			eglTerminate( m_pDisplay );
+		}
+#endif
+	}
+
+	/**
+	* @brief creates the render target the frames are drawn to, to be called once the OpenGL extensions are loaded
+	*/
+	void HeadlessContext::initRenderTarget()
+	{
+		m_pTargetTex = new Texture2D( m_iWidth, m_iHeight );
+		m_pTargetTex->setFilters( NEAREST, NEAREST );
+		m_pTargetTex->setWrapMode( CLAMP_TO_EDGE );
+		m_pTargetTex->setData( TGA, NULL );
+
+		m_pTarget = new RenderTexture;
+		m_pTarget->setTexture( *m_pTargetTex );
+
+		// the target replaces the window framebuffer
+		RenderTexture::setDefaultFramebuffer( m_pTarget->getFramebufferID() );
+		m_pTarget->bind( false );
+		glViewport( 0, 0, m_iWidth, m_iHeight );
+
+		Error::checkGLerror( "HeadlessContext::initRenderTarget" );
+	}
+
+	/**
+	* @brief ends a frame: waits for its rendering to complete as there is no buffer swap to pace the frames
+	*/
+	void HeadlessContext::swapBuffers()
+	{
+		glFinish();
+	}
+
+	/**
+	* @brief reads the last frame back
+	* @param pData the RGBA pixels, iWidth * iHeight * 4 bytes, from the bottom row to the top one
+	*/
+	void HeadlessContext::readPixels( GLubyte* pData )
+	{
+		GLint iFramebuffer;
+		glGetIntegerv( GL_FRAMEBUFFER_BINDING_EXT, &iFramebuffer );
+
+		m_pTarget->bind();
+		glPixelStorei( GL_PACK_ALIGNMENT, 1 );
+		glReadPixels( 0, 0, m_iWidth, m_iHeight, GL_RGBA, GL_UNSIGNED_BYTE, pData );
+		glBindFramebufferEXT( GL_FRAMEBUFFER_EXT, iFramebuffer );
+	}
+}
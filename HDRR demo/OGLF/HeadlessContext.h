@@ -0,0 +1,78 @@
+#ifndef HEADLESSCONTEXT_H
+#define HEADLESSCONTEXT_H
+
+#include <GL/glew.h>
+#include "Texture2D.h"
+#include "RenderTexture.h"
+
+namespace Oglf
+{
+	/**
+	* class HeadlessContext creates an OpenGL context without any window, to render on machines without a display
+	* or a GPU, with Mesa llvmpipe for instance. The context is created through EGL with a surfaceless display or a
+	* pbuffer, or through OSMesa when OGLF_OSMESA is defined. The frames are rendered into a RenderTexture target
+	* which replaces the window framebuffer in RenderTexture::bind( false ). Headless contexts are not supported on
+	* Windows.
+	*/
+	class HeadlessContext
+	{
+		void*			m_pDisplay;		// EGLDisplay
+		void*			m_pSurface;		// EGLSurface, EGL_NO_SURFACE on a surfaceless display
+		void*			m_pContext;		// EGLContext or OSMesaContext
+		GLubyte*		m_pBuffer;		// OSMesa color buffer
+		int				m_iWidth;
+		int				m_iHeight;
+		Texture2D*		m_pTargetTex;
+		RenderTexture*	m_pTarget;
+
+	public:
+
+		/**
+		* @brief constructor: creates the context and makes it current
+		* @param iWidth the frames width
+		* @param iHeight the frames height
+		*/
+		HeadlessContext( int iWidth, int iHeight );
+
+		/**
+		* @brief destructor: deletes the render target and the context
+		*/
+		~HeadlessContext();
+
+		/**
+		* @brief creates the render target the frames are drawn to, to be called once the OpenGL extensions are loaded
+		*/
+		void initRenderTarget();
+
+		/**
+		* @brief ends a frame: waits for its rendering to complete as there is no buffer swap to pace the frames
+		*/
+		void swapBuffers();
+
+		/**
+		* @brief reads the last frame back
+		* @param pData the RGBA pixels, iWidth * iHeight * 4 bytes, from the bottom row to the top one
+		*/
+		void readPixels( GLubyte* pData );
+
+		/**
+		* @brief returns the frames width
+		* @return the width in pixels
+		*/
+		int getWidth() const
+		{
+			return m_iWidth;
+		}
+
+		/**
+		* @brief returns the frames height
+		* @return the height in pixels
+		*/
+		int getHeight() const
+		{
+			return m_iHeight;
+		}
+	};
+}
+
+#endif /* HEADLESSCONTEXT_H */
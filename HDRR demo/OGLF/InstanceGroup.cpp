@@ -0,0 +1,288 @@
+#include <math.h>
+#include "InstanceGroup.h"
+#include "RenderStats.h"
+#include "Error.h"
+
+using namespace std;
+
+
+namespace Oglf
+{
+	/**
+	* @brief constructor: creates a group without instances
+	* @param oMesh the mesh drawn by the instances, its bounding box must be built
+	*/
+	InstanceGroup::InstanceGroup( Mesh& oMesh )
+		: m_pMesh( &oMesh )
+		, m_iInstanceBuffer( 0 )
+		, m_iBufferCapacity( 0 )
+		, m_iMatrixAttribute( -1 )
+		, m_iParameterAttribute( -1 )
+		, m_bCulling( true )
+	{
+		m_pMesh->getBoundingBox().buildSphere();
+	}
+
+	/**
+	* @brief destructor, the instance buffer is deleted
+	*/
+	InstanceGroup::~InstanceGroup()
+	{
+		if( m_iInstanceBuffer != 0 )
+			glDeleteBuffersARB( 1, &m_iInstanceBuffer );
+	}
+
+	/**
+	* @brief adds an instance
+	* @param oWorld the instance world matrix
+	* @return the instance index
+	*/
+	int InstanceGroup::addInstance( const Matrix4x4& oWorld )
+	{
+		m_vMatrices.push_back( oWorld );
+		if( !m_vParameters.empty() )
+			m_vParameters.resize( 4 * m_vMatrices.size(), 0.f );
+
+		return ( int )m_vMatrices.size() - 1;
+	}
+
+	/**
+	* @brief adds an instance with a parameter
+	* @param oWorld the instance world matrix
+	* @param pfParameter the 4 floats of the instance parameter
+	* @return the instance index
+	*/
+	int InstanceGroup::addInstance( const Matrix4x4& oWorld, const float* pfParameter )
+	{
+		int iInstance = addInstance( oWorld );
+		setInstanceParameter( iInstance, pfParameter );
+
+		return iInstance;
+	}
+
+	/**
+	* @brief moves an instance
+	* @param iInstance the instance index
+	* @param oWorld the instance world matrix
+	*/
+	void InstanceGroup::setInstance( int iInstance, const Matrix4x4& oWorld )
+	{
+		if( iInstance < 0 || iInstance >= ( int )m_vMatrices.size() )
+			throw Error( "InstanceGroup::setInstance error : invalid instance index" );
+
+		m_vMatrices[ iInstance ] = oWorld;
+	}
+
+	/**
+	* @brief sets the parameter of an instance, the other instances get zeros if they had none
+	* @param iInstance the instance index
+	* @param pfParameter the 4 floats of the instance parameter
+	*/
+	void InstanceGroup::setInstanceParameter( int iInstance, const float* pfParameter )
+	{
+		if( iInstance < 0 || iInstance >= ( int )m_vMatrices.size() )
+			throw Error( "InstanceGroup::setInstanceParameter error : invalid instance index" );
+
+		m_vParameters.resize( 4 * m_vMatrices.size(), 0.f );
+		for( int i = 0; i < 4; ++i )
+			m_vParameters[ 4 * iInstance + i ] = pfParameter[ i ];
+	}
+
+	/**
+	* @brief removes every instance
+	*/
+	void InstanceGroup::clear()
+	{
+		m_vMatrices.clear();
+		m_vParameters.clear();
+		m_vVisibleInstances.clear();
+	}
+
+	/**
+	* @brief looks up the instance attributes in the effect program, to be called once the shaders are linked
+	* @param pFx the effect drawing the group, NULL for the fixed pipeline
+	*/
+	void InstanceGroup::bindAttributes( const RenderingFX* pFx )
+	{
+		m_iMatrixAttribute = -1;
+		m_iParameterAttribute = -1;
+
+		if( pFx == NULL || !GLEW_ARB_draw_instanced || !GLEW_ARB_instanced_arrays || !GLEW_ARB_vertex_buffer_object )
+			return;
+
+		m_iMatrixAttribute = pFx->getAttributeLocation( "a_mInstanceMatrix" );
+		if( m_iMatrixAttribute >= 0 )
+			m_iParameterAttribute = pFx->getAttributeLocation( "a_vInstanceParameter" );
+	}
+
+	/**
+	* @brief keeps the instances whose bounding sphere intersects the view frustum
+	* @param oViewProjection the projection matrix times the view matrix
+	*/
+	void InstanceGroup::cull( const Matrix4x4& oViewProjection )
+	{
+		int iNb = ( int )m_vMatrices.size();
+		m_vVisibleInstances.clear();
+
+		if( !m_bCulling )
+		{
+			for( int i = 0; i < iNb; ++i )
+				m_vVisibleInstances.push_back( i );
+			return;
+		}
+
+		// the frustum planes, in world space, from the rows of the view projection matrix
+		const float* m = oViewProjection.m;
+		float pPlanes[ 6 ][ 4 ];
+		for( int iPlane = 0; iPlane < 6; ++iPlane )
+		{
+			int iRow = iPlane / 2;
+			float fSign = ( iPlane % 2 ) ? -1.f : 1.f;
+
+			float fLength = 0.f;
+			for( int c = 0; c < 4; ++c )
+			{
+				pPlanes[ iPlane ][ c ] = m[ 4 * c + 3 ] + fSign * m[ 4 * c + iRow ];
+				if( c < 3 )
+					fLength += pPlanes[ iPlane ][ c ] * pPlanes[ iPlane ][ c ];
+			}
+
+			fLength = fLength > 0.f ? 1.f / sqrt( fLength ) : 0.f;
+			for( int c = 0; c < 4; ++c )
+				pPlanes[ iPlane ][ c ] *= fLength;
+		}
+
+		const BoundingBox& oBox = m_pMesh->getBoundingBox();
+		for( int i = 0; i < iNb; ++i )
+		{
+			const float* w = m_vMatrices[ i ].m;
+
+			// the sphere is scaled by the largest scale of the instance
+			float fScale2 = 0.f;
+			for( int c = 0; c < 3; ++c )
+				fScale2 = maxT( fScale2, w[ 4 * c ] * w[ 4 * c ] + w[ 4 * c + 1 ] * w[ 4 * c + 1 ] + w[ 4 * c + 2 ] * w[ 4 * c + 2 ] );
+			float fRadius = oBox.sphereRadius * sqrt( fScale2 );
+			Vec3 oCenter = m_vMatrices[ i ] + oBox.sphereCenter;
+
+			bool bVisible = true;
+			for( int iPlane = 0; iPlane < 6 && bVisible; ++iPlane )
+			{
+				const float* p = pPlanes[ iPlane ];
+				bVisible = p[ 0 ] * oCenter.v[ 0 ] + p[ 1 ] * oCenter.v[ 1 ] + p[ 2 ] * oCenter.v[ 2 ] + p[ 3 ] >= -fRadius;
+			}
+
+			if( bVisible )
+				m_vVisibleInstances.push_back( i );
+		}
+	}
+
+	/**
+	* @brief draws the instances which passed the last cull(), with the GL context current and the effect enabled
+	* @param pFx the effect drawing the group, NULL for the fixed pipeline
+	* @param iWorldMatrixParameter the u_mWorldMatrix parameter id of the effect, for the one by one draws
+	*/
+	void InstanceGroup::draw( RenderingFX* pFx, int iWorldMatrixParameter )
+	{
+		if( m_vVisibleInstances.empty() )
+			return;
+
+		if( m_iMatrixAttribute >= 0 && pFx != NULL )
+			drawInstanced();
+		else
+			drawOneByOne( pFx, iWorldMatrixParameter );
+	}
+
+	/**
+	* @brief draws the visible instances with their matrices, the effect world matrix is refreshed for each
+	*/
+	void InstanceGroup::drawOneByOne( RenderingFX* pFx, int iWorldMatrixParameter )
+	{
+		for( size_t i = 0; i < m_vVisibleInstances.size(); ++i )
+		{
+			const Matrix4x4& oWorld = m_vMatrices[ m_vVisibleInstances[ i ] ];
+
+			if( pFx != NULL && iWorldMatrixParameter >= 0 )
+			{
+				pFx->updateParameterLocation( iWorldMatrixParameter, &oWorld );
+				pFx->refreshParameter< FR_FLOAT_MAT4 >( iWorldMatrixParameter );
+			}
+
+			glPushMatrix();
+			glMultMatrixf( oWorld.m );
+			m_pMesh->draw();
+			glPopMatrix();
+		}
+	}
+
+	/**
+	* @brief packs the visible instances in the instance buffer and draws them at once from the mesh buffers
+	*/
+	void InstanceGroup::drawInstanced()
+	{
+		if( !m_pMesh->hasBuffers() )
+			m_pMesh->compileBuffers();
+
+		int iVisibleNb = ( int )m_vVisibleInstances.size();
+		bool bParameters = m_iParameterAttribute >= 0 && !m_vParameters.empty();
+
+		// the matrices then the parameters
+		m_vInstanceData.resize( ( bParameters ? 20 : 16 ) * iVisibleNb );
+		for( int i = 0; i < iVisibleNb; ++i )
+		{
+			int iInstance = m_vVisibleInstances[ i ];
+			for( int j = 0; j < 16; ++j )
+				m_vInstanceData[ 16 * i + j ] = m_vMatrices[ iInstance ].m[ j ];
+			if( bParameters )
+			{
+				for( int j = 0; j < 4; ++j )
+					m_vInstanceData[ 16 * iVisibleNb + 4 * i + j ] = m_vParameters[ 4 * iInstance + j ];
+			}
+		}
+
+		if( m_iInstanceBuffer == 0 )
+			glGenBuffersARB( 1, &m_iInstanceBuffer );
+		glBindBufferARB( GL_ARRAY_BUFFER_ARB, m_iInstanceBuffer );
+
+		// the storage is only created again when the data outgrows it
+		int iDataNb = ( int )m_vInstanceData.size();
+		if( iDataNb > m_iBufferCapacity )
+		{
+			m_iBufferCapacity = iDataNb;
+			glBufferDataARB( GL_ARRAY_BUFFER_ARB, m_iBufferCapacity * sizeof( float ), NULL, GL_STREAM_DRAW_ARB );
+		}
+		glBufferSubDataARB( GL_ARRAY_BUFFER_ARB, 0, iDataNb * sizeof( float ), &m_vInstanceData[ 0 ] );
+
+		m_pMesh->bindBuffers();
+		glBindBufferARB( GL_ARRAY_BUFFER_ARB, m_iInstanceBuffer );
+
+		// a mat4 attribute takes 4 consecutive locations, one per column
+		for( int c = 0; c < 4; ++c )
+		{
+			glEnableVertexAttribArrayARB( m_iMatrixAttribute + c );
+			glVertexAttribPointerARB( m_iMatrixAttribute + c, 4, GL_FLOAT, GL_FALSE, 16 * sizeof( float ), ( const GLvoid* )( 4 * c * sizeof( float ) ) );
+			glVertexAttribDivisorARB( m_iMatrixAttribute + c, 1 );
+		}
+		if( bParameters )
+		{
+			glEnableVertexAttribArrayARB( m_iParameterAttribute );
+			glVertexAttribPointerARB( m_iParameterAttribute, 4, GL_FLOAT, GL_FALSE, 4 * sizeof( float ), ( const GLvoid* )( 16 * iVisibleNb * sizeof( float ) ) );
+			glVertexAttribDivisorARB( m_iParameterAttribute, 1 );
+		}
+
+		glDrawElementsInstancedARB( GL_TRIANGLES, m_pMesh->getIndexNb(), GL_UNSIGNED_INT, ( const GLvoid* )0, iVisibleNb );
+		RenderStats::addDrawCall( ( unsigned int )( m_pMesh->getIndexNb() / 3 * iVisibleNb ) );
+
+		for( int c = 0; c < 4; ++c )
+		{
+			glVertexAttribDivisorARB( m_iMatrixAttribute + c, 0 );
+			glDisableVertexAttribArrayARB( m_iMatrixAttribute + c );
+		}
+		if( bParameters )
+		{
+			glVertexAttribDivisorARB( m_iParameterAttribute, 0 );
+			glDisableVertexAttribArrayARB( m_iParameterAttribute );
+		}
+
+		m_pMesh->unbindBuffers();
+	}
+}
@@ -0,0 +1,156 @@
+#ifndef INSTANCEGROUP_H
+#define INSTANCEGROUP_H
+
+#include <vector>
+#include "Mesh.h"
+#include "Matrix.h"
+#include "RenderingFX.h"
+#include "Core.h"
+
+
+namespace Oglf
+{
+	/**
+	* class InstanceGroup draws a mesh many times, each instance placed by its own world matrix and optionally given
+	* a 4 floats parameter. Before each draw the instances are culled against the view frustum with the mesh bounding
+	* sphere, the matrices and parameters of the visible ones are packed in a buffer read as per-instance attributes
+	* and all of them are drawn by a single glDrawElementsInstancedARB() call from the mesh buffers. The effect
+	* shaders read the world matrix from the mat4 attribute a_mInstanceMatrix and the parameter from the vec4
+	* attribute a_vInstanceParameter, in place of the u_mWorldMatrix uniform. Without instancing support, for the
+	* fixed pipeline or for effects without the matrix attribute, the visible instances are drawn one by one with
+	* the mesh display list, as the scene meshes are.
+	*/
+	class InstanceGroup : public Core< MEMORY_SCENE >
+	{
+		typedef std::vector< Matrix4x4, CoreAllocator< Matrix4x4, MEMORY_SCENE > >	MatrixArray;
+		typedef std::vector< float, CoreAllocator< float, MEMORY_SCENE > >			FloatArray;
+
+		Mesh*			m_pMesh;
+		MatrixArray		m_vMatrices;			// the instances world matrices
+		FloatArray		m_vParameters;			// 4 floats per instance, empty if no instance has a parameter
+		std::vector< int >	m_vVisibleInstances;	// the instances which passed the last cull()
+		FloatArray		m_vInstanceData;		// the visible instances matrices, then their parameters, as uploaded
+		GLuint			m_iInstanceBuffer;
+		int				m_iBufferCapacity;		// the number of floats the buffer holds
+		GLint			m_iMatrixAttribute;		// -1 if the instances are drawn one by one
+		GLint			m_iParameterAttribute;	// -1 if the shaders read no parameter
+		bool			m_bCulling;
+
+		void drawInstanced();
+		void drawOneByOne( RenderingFX* pFx, int iWorldMatrixParameter );
+
+	public:
+
+		/**
+		* @brief constructor: creates a group without instances
+		* @param oMesh the mesh drawn by the instances, its bounding box must be built
+		*/
+		InstanceGroup( Mesh& oMesh );
+
+		/**
+		* @brief destructor, the instance buffer is deleted
+		*/
+		~InstanceGroup();
+
+		/**
+		* @brief adds an instance
+		* @param oWorld the instance world matrix
+		* @return the instance index
+		*/
+		int addInstance( const Matrix4x4& oWorld );
+
+		/**
+		* @brief adds an instance with a parameter
+		* @param oWorld the instance world matrix
+		* @param pfParameter the 4 floats of the instance parameter
+		* @return the instance index
+		*/
+		int addInstance( const Matrix4x4& oWorld, const float* pfParameter );
+
+		/**
+		* @brief moves an instance
+		* @param iInstance the instance index
+		* @param oWorld the instance world matrix
+		*/
+		void setInstance( int iInstance, const Matrix4x4& oWorld );
+
+		/**
+		* @brief sets the parameter of an instance, the other instances get zeros if they had none
+		* @param iInstance the instance index
+		* @param pfParameter the 4 floats of the instance parameter
+		*/
+		void setInstanceParameter( int iInstance, const float* pfParameter );
+
+		/**
+		* @brief removes every instance
+		*/
+		void clear();
+
+		/**
+		* @brief looks up the instance attributes in the effect program, to be called once the shaders are linked
+		* @param pFx the effect drawing the group, NULL for the fixed pipeline
+		*/
+		void bindAttributes( const RenderingFX* pFx );
+
+		/**
+		* @brief keeps the instances whose bounding sphere intersects the view frustum
+		* @param oViewProjection the projection matrix times the view matrix
+		*/
+		void cull( const Matrix4x4& oViewProjection );
+
+		/**
+		* @brief draws the instances which passed the last cull(), with the GL context current and the effect enabled
+		* @param pFx the effect drawing the group, NULL for the fixed pipeline
+		* @param iWorldMatrixParameter the u_mWorldMatrix parameter id of the effect, for the one by one draws
+		*/
+		void draw( RenderingFX* pFx, int iWorldMatrixParameter );
+
+		/**
+		* @brief enables the frustum culling, all the instances are drawn when disabled
+		* @param bCulling true to cull the instances
+		*/
+		void setCulling( bool bCulling )
+		{
+			m_bCulling = bCulling;
+		}
+
+		/**
+		* @brief returns the world matrix of an instance
+		* @param iInstance the instance index
+		* @return the world matrix
+		*/
+		const Matrix4x4& getInstance( int iInstance ) const
+		{
+			return m_vMatrices[ iInstance ];
+		}
+
+		/**
+		* @brief returns the number of instances
+		* @return the number of instances
+		*/
+		int getInstanceNb() const
+		{
+			return ( int )m_vMatrices.size();
+		}
+
+		/**
+		* @brief returns the number of instances which passed the last cull()
+		* @return the number of visible instances
+		*/
+		int getVisibleNb() const
+		{
+			return ( int )m_vVisibleInstances.size();
+		}
+
+		/**
+		* @brief returns the mesh drawn by the instances
+		* @return the mesh
+		*/
+		Mesh& getMesh() const
+		{
+			return *m_pMesh;
+		}
+	};
+}
+
+#endif /* INSTANCEGROUP_H */
@@ -0,0 +1,535 @@
+#include "JobSystem.h"
+#include "utils.h"
+
+#ifdef WIN32
+	#include <Windows.h>
+#else
+	#include <pthread.h>
+	#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace Oglf
+{
+#ifdef WIN32
+	typedef HANDLE				NativeThread;
+	typedef DWORD				NativeThreadID;
+	typedef CRITICAL_SECTION	NativeMutex;
+	typedef CONDITION_VARIABLE	NativeCond;
+#else
+	typedef pthread_t			NativeThread;
+	typedef pthread_t			NativeThreadID;
+	typedef pthread_mutex_t		NativeMutex;
+	typedef pthread_cond_t		NativeCond;
+#endif
+
+	static inline void createMutex( NativeMutex& oMutex )
+	{
+#ifdef WIN32
+		InitializeCriticalSection( &oMutex );
+#else
+		pthread_mutex_init( &oMutex, NULL );
+#endif
+	}
+
+	static inline void destroyMutex( NativeMutex& oMutex )
+	{
+#ifdef WIN32
+		DeleteCriticalSection( &oMutex );
+#else
+		pthread_mutex_destroy( &oMutex );
+#endif
+	}
+
+	static inline void lockMutex( NativeMutex& oMutex )
+	{
+#ifdef WIN32
+		EnterCriticalSection( &oMutex );
+#else
+		pthread_mutex_lock( &oMutex );
+#endif
+	}
+
+	static inline void unlockMutex( NativeMutex& oMutex )
+	{
+#ifdef WIN32
+		LeaveCriticalSection( &oMutex );
+#else
+		pthread_mutex_unlock( &oMutex );
+#endif
+	}
+
+	static inline void createCond( NativeCond& oCond )
+	{
+#ifdef WIN32
+		InitializeConditionVariable( &oCond );
+#else
+		pthread_cond_init( &oCond, NULL );
+#endif
+	}
+
+	static inline void destroyCond( NativeCond& oCond )
+	{
+#ifdef WIN32
+		// a Windows condition variable holds no resource
+		( void )oCond;
+#else
+		pthread_cond_destroy( &oCond );
+#endif
+	}
+
+	static inline void waitCond( NativeCond& oCond, NativeMutex& oMutex )
+	{
+#ifdef WIN32
+		SleepConditionVariableCS( &oCond, &oMutex, INFINITE );
+#else
+		pthread_cond_wait( &oCond, &oMutex );
+#endif
+	}
+
+	static inline void signalCond( NativeCond& oCond )
+	{
+#ifdef WIN32
+		WakeConditionVariable( &oCond );
+#else
+		pthread_cond_signal( &oCond );
+#endif
+	}
+
+	static inline void broadcastCond( NativeCond& oCond )
+	{
+#ifdef WIN32
+		WakeAllConditionVariable( &oCond );
+#else
+		pthread_cond_broadcast( &oCond );
+#endif
+	}
+
+	static inline NativeThreadID getThreadID()
+	{
+#ifdef WIN32
+		return GetCurrentThreadId();
+#else
+		return pthread_self();
+#endif
+	}
+
+	static inline bool isSameThread( NativeThreadID iThread1, NativeThreadID iThread2 )
+	{
+#ifdef WIN32
+		return iThread1 == iThread2;
+#else
+		return pthread_equal( iThread1, iThread2 ) != 0;
+#endif
+	}
+
+	/**
+	* @brief returns the number of processors
+	* @return the number of processors, at least 1
+	*/
+	static int getProcessorNb()
+	{
+#ifdef WIN32
+		SYSTEM_INFO oInfo;
+		GetSystemInfo( &oInfo );
+		return maxT( ( int )oInfo.dwNumberOfProcessors, 1 );
+#else
+		return maxT( ( int )sysconf( _SC_NPROCESSORS_ONLN ), 1 );
+#endif
+	}
+
+	/**
+	* @brief a worker deque
+	*/
+	struct WorkerQueue
+	{
+		deque< Job >	dJobs;
+		NativeMutex		oLock;
+	};
+
+	/**
+	* @brief the data passed to a worker thread
+	*/
+	struct WorkerData
+	{
+		JobSystem*	pJobSystem;
+		int			iWorker;
+	};
+
+	/**
+	* @brief the worker threads and the locks, they must not move once created
+	*/
+	struct JobSystem::Threads
+	{
+		vector< NativeThread >		vThreads;
+		vector< NativeThreadID >	vThreadIDs;
+		vector< WorkerQueue >		vQueues;
+		vector< WorkerData >		vWorkerData;
+		NativeThreadID				iMainThreadID;
+
+		NativeMutex					oLock;			// guards the counters, the main thread jobs and the job system members
+		NativeCond					oWorkCond;		// signaled when a job is queued
+		NativeCond					oDoneCond;		// signaled when a counter falls to zero or a main thread job is queued
+
+		/**
+		* @brief worker thread entry point
+		* @param pData the worker data
+		*/
+#ifdef WIN32
+		static DWORD WINAPI workerThread( LPVOID pData )
+#else
+		static void* workerThread( void* pData )
+#endif
+		{
+			WorkerData* pWorker = ( WorkerData* )pData;
+			pWorker->pJobSystem->runWorker( pWorker->iWorker );
+
+			return 0;
+		}
+	};
+
+	/**
+	* @brief constructor: starts the worker threads, must be called by the main thread
+	* @param iWorkerNb the number of worker threads, 0 for one per processor but the main thread one
+	*/
+	JobSystem::JobSystem( int iWorkerNb )
+		: m_pThreads( new Threads )
+		, m_iWorkerNb( 0 )
+		, m_iQueuedJobNb( 0 )
+		, m_iNextQueue( 0 )
+		, m_bShutdown( false )
+	{
+		if( iWorkerNb <= 0 )
+			iWorkerNb = maxT( getProcessorNb() - 1, 1 );
+
+		m_pThreads->iMainThreadID = getThreadID();
+		createMutex( m_pThreads->oLock );
+		createCond( m_pThreads->oWorkCond );
+		createCond( m_pThreads->oDoneCond );
+
+		// the workers keep pointers to their data, which must not move
+		m_pThreads->vQueues.resize( iWorkerNb );
+		m_pThreads->vWorkerData.resize( iWorkerNb );
+		for( int i = 0; i < iWorkerNb; ++i )
+		{
+			createMutex( m_pThreads->vQueues[ i ].oLock );
+			m_pThreads->vWorkerData[ i ].pJobSystem = this;
+			m_pThreads->vWorkerData[ i ].iWorker = i;
+		}
+
+		m_pThreads->vThreads.resize( iWorkerNb );
+		m_pThreads->vThreadIDs.resize( iWorkerNb );
+		for( int i = 0; i < iWorkerNb; ++i )
+		{
+#ifdef WIN32
+			m_pThreads->vThreads[ i ] = CreateThread( NULL, 0, Threads::workerThread, &m_pThreads->vWorkerData[ i ], 0, &m_pThreads->vThreadIDs[ i ] );
+#else
+			pthread_create( &m_pThreads->vThreads[ i ], NULL, Threads::workerThread, &m_pThreads->vWorkerData[ i ] );
+			m_pThreads->vThreadIDs[ i ] = m_pThreads->vThreads[ i ];
+#endif
+		}
+		m_iWorkerNb = iWorkerNb;
+	}
+
+	/**
+	* @brief destructor: waits for the queued jobs and stops the worker threads, the main thread jobs not run yet
+	* and the jobs depending on counters that are not done are dropped
+	*/
+	JobSystem::~JobSystem()
+	{
+		lockMutex( m_pThreads->oLock );
+		m_bShutdown = true;
+		broadcastCond( m_pThreads->oWorkCond );
+		unlockMutex( m_pThreads->oLock );
+
+		for( size_t i = 0; i < m_pThreads->vThreads.size(); ++i )
+		{
+#ifdef WIN32
+			WaitForSingleObject( m_pThreads->vThreads[ i ], INFINITE );
+			CloseHandle( m_pThreads->vThreads[ i ] );
+#else
+			pthread_join( m_pThreads->vThreads[ i ], NULL );
+#endif
+		}
+
+		for( size_t i = 0; i < m_pThreads->vQueues.size(); ++i )
+			destroyMutex( m_pThreads->vQueues[ i ].oLock );
+
+		destroyCond( m_pThreads->oDoneCond );
+		destroyCond( m_pThreads->oWorkCond );
+		destroyMutex( m_pThreads->oLock );
+
+		delete m_pThreads;
+	}
+
+	/**
+	* @brief worker thread: runs the queued jobs until the job system is destroyed and every job is run
+	* @param iWorker the worker index
+	*/
+	void JobSystem::runWorker( int iWorker )
+	{
+		for( ;; )
+		{
+			lockMutex( m_pThreads->oLock );
+			while( m_iQueuedJobNb == 0 && !m_bShutdown )
+				waitCond( m_pThreads->oWorkCond, m_pThreads->oLock );
+
+			if( m_iQueuedJobNb == 0 )
+			{
+				unlockMutex( m_pThreads->oLock );
+				return;
+			}
+			unlockMutex( m_pThreads->oLock );
+
+			Job oJob;
+			if( popJob( iWorker, oJob ) )
+				runJob( oJob );
+		}
+	}
+
+	/**
+	* @brief returns the worker running the calling thread
+	* @return the worker index, -1 when called by another thread
+	*/
+	int JobSystem::getWorkerIndex() const
+	{
+		NativeThreadID iThreadID = getThreadID();
+
+		for( size_t i = 0; i < m_pThreads->vThreadIDs.size(); ++i )
+		{
+			if( isSameThread( m_pThreads->vThreadIDs[ i ], iThreadID ) )
+				return ( int )i;
+		}
+
+		return -1;
+	}
+
+	/**
+	* @brief queues a job whose dependency is done, must be called with the job system lock
+	* @param oJob the job
+	*/
+	void JobSystem::queueJob( const Job& oJob )
+	{
+		if( oJob.bMainThread )
+		{
+			m_dMainThreadJobs.push_back( oJob );
+			broadcastCond( m_pThreads->oDoneCond );
+			return;
+		}
+
+		// a worker queues its jobs on its own deque, the other threads spread them over the deques
+		int iWorker = getWorkerIndex();
+		if( iWorker < 0 )
+		{
+			iWorker = m_iNextQueue;
+			m_iNextQueue = ( m_iNextQueue + 1 ) % ( int )m_pThreads->vQueues.size();
+		}
+
+		WorkerQueue& oQueue = m_pThreads->vQueues[ iWorker ];
+		lockMutex( oQueue.oLock );
+		oQueue.dJobs.push_back( oJob );
+		unlockMutex( oQueue.oLock );
+
+		++m_iQueuedJobNb;
+		signalCond( m_pThreads->oWorkCond );
+	}
+
+	/**
+	* @brief takes a job from the back of a worker deque, or steals one from the front of the other deques
+	* @param iWorker the worker, -1 for another thread which only steals jobs
+	* @param oJob the job taken
+	* @return false when every deque is empty
+	*/
+	bool JobSystem::popJob( int iWorker, Job& oJob )
+	{
+		bool bFound = false;
+		int iQueueNb = ( int )m_pThreads->vQueues.size();
+
+		if( iWorker >= 0 )
+		{
+			WorkerQueue& oQueue = m_pThreads->vQueues[ iWorker ];
+			lockMutex( oQueue.oLock );
+			if( !oQueue.dJobs.empty() )
+			{
+				oJob = oQueue.dJobs.back();
+				oQueue.dJobs.pop_back();
+				bFound = true;
+			}
+			unlockMutex( oQueue.oLock );
+		}
+
+		for( int i = 1; i <= iQueueNb && !bFound; ++i )
+		{
+			WorkerQueue& oQueue = m_pThreads->vQueues[ ( iWorker + i + iQueueNb ) % iQueueNb ];
+			lockMutex( oQueue.oLock );
+			if( !oQueue.dJobs.empty() )
+			{
+				oJob = oQueue.dJobs.front();
+				oQueue.dJobs.pop_front();
+				bFound = true;
+			}
+			unlockMutex( oQueue.oLock );
+		}
+
+		if( bFound )
+		{
+			lockMutex( m_pThreads->oLock );
+			--m_iQueuedJobNb;
+			unlockMutex( m_pThreads->oLock );
+		}
+
+		return bFound;
+	}
+
+	/**
+	* @brief runs a job then decrements its counter, the jobs depending on the counter are queued when it falls to zero
+	* @param oJob the job
+	*/
+	void JobSystem::runJob( const Job& oJob )
+	{
+		oJob.pFunction( oJob.pData );
+
+		if( oJob.pCounter == NULL )
+			return;
+
+		lockMutex( m_pThreads->oLock );
+		if( --oJob.pCounter->m_iJobNb == 0 )
+		{
+			vector< Job >& vDependentJobs = oJob.pCounter->m_vDependentJobs;
+			for( size_t i = 0; i < vDependentJobs.size(); ++i )
+				queueJob( vDependentJobs[ i ] );
+			vDependentJobs.clear();
+
+			broadcastCond( m_pThreads->oDoneCond );
+		}
+		unlockMutex( m_pThreads->oLock );
+	}
+
+	/**
+	* @brief counts a job and queues it, or parks it on its dependency
+	* @param pFunction the job function
+	* @param pData the job data
+	* @param pCounter counts the job until it is done, may be NULL
+	* @param pDependency the job is queued once this counter falls to zero, may be NULL
+	* @param bMainThread true: the job is run by the main thread
+	*/
+	void JobSystem::addJob( JobFunction pFunction, void* pData, JobCounter* pCounter, JobCounter* pDependency, bool bMainThread )
+	{
+		Job oJob;
+		oJob.pFunction = pFunction;
+		oJob.pData = pData;
+		oJob.pCounter = pCounter;
+		oJob.bMainThread = bMainThread;
+
+		lockMutex( m_pThreads->oLock );
+		if( pCounter != NULL )
+			++pCounter->m_iJobNb;
+
+		if( pDependency != NULL && pDependency->m_iJobNb > 0 )
+			pDependency->m_vDependentJobs.push_back( oJob );
+		else
+			queueJob( oJob );
+		unlockMutex( m_pThreads->oLock );
+	}
+
+	/**
+	* @brief queues a job on the worker threads
+	* @param pFunction the job function
+	* @param pData the job data
+	* @param pCounter counts the job until it is done, may be NULL
+	* @param pDependency the job is queued once this counter falls to zero, may be NULL
+	*/
+	void JobSystem::run( JobFunction pFunction, void* pData, JobCounter* pCounter, JobCounter* pDependency )
+	{
+		addJob( pFunction, pData, pCounter, pDependency, false );
+	}
+
+	/**
+	* @brief queues a job on the main thread, for work touching the GL context
+	* @param pFunction the job function
+	* @param pData the job data
+	* @param pCounter counts the job until it is done, may be NULL
+	* @param pDependency the job is queued once this counter falls to zero, may be NULL
+	*/
+	void JobSystem::runOnMainThread( JobFunction pFunction, void* pData, JobCounter* pCounter, JobCounter* pDependency )
+	{
+		addJob( pFunction, pData, pCounter, pDependency, true );
+	}
+
+	/**
+	* @brief returns whether the jobs of a counter are done
+	* @param oCounter the counter
+	* @return true when the counter is zero
+	*/
+	bool JobSystem::isDone( const JobCounter& oCounter )
+	{
+		lockMutex( m_pThreads->oLock );
+		bool bDone = oCounter.m_iJobNb == 0;
+		unlockMutex( m_pThreads->oLock );
+
+		return bDone;
+	}
+
+	/**
+	* @brief waits for the jobs of a counter, the calling thread runs queued jobs meanwhile and the main thread
+	* also runs its own jobs
+	* @param oCounter the counter
+	*/
+	void JobSystem::wait( const JobCounter& oCounter )
+	{
+		bool bMainThread = isSameThread( getThreadID(), m_pThreads->iMainThreadID );
+		int iWorker = getWorkerIndex();
+
+		for( ;; )
+		{
+			lockMutex( m_pThreads->oLock );
+			if( oCounter.m_iJobNb == 0 )
+			{
+				unlockMutex( m_pThreads->oLock );
+				return;
+			}
+
+			if( bMainThread && !m_dMainThreadJobs.empty() )
+			{
+				Job oJob = m_dMainThreadJobs.front();
+				m_dMainThreadJobs.pop_front();
+				unlockMutex( m_pThreads->oLock );
+
+				runJob( oJob );
+				continue;
+			}
+
+			// sleeps until a counter falls to zero when there is nothing to help with
+			bool bQueued = m_iQueuedJobNb > 0;
+			if( !bQueued )
+				waitCond( m_pThreads->oDoneCond, m_pThreads->oLock );
+			unlockMutex( m_pThreads->oLock );
+
+			Job oJob;
+			if( bQueued && popJob( iWorker, oJob ) )
+				runJob( oJob );
+		}
+	}
+
+	/**
+	* @brief runs the jobs queued on the main thread, to be called once per frame by the main thread
+	*/
+	void JobSystem::processMainThreadJobs()
+	{
+		// the jobs queued meanwhile are run by the next call
+		lockMutex( m_pThreads->oLock );
+		size_t iJobNb = m_dMainThreadJobs.size();
+		unlockMutex( m_pThreads->oLock );
+
+		for( size_t i = 0; i < iJobNb; ++i )
+		{
+			lockMutex( m_pThreads->oLock );
+			Job oJob = m_dMainThreadJobs.front();
+			m_dMainThreadJobs.pop_front();
+			unlockMutex( m_pThreads->oLock );
+
+			runJob( oJob );
+		}
+	}
+}
@@ -0,0 +1,182 @@
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include <cstddef>
+#include <vector>
+#include <deque>
+#include "utils.h"
+
+namespace Oglf
+{
+	typedef void ( *JobFunction )( void* pData );
+
+	class JobCounter;
+
+	/**
+	* @brief a function to run with its data
+	*/
+	struct Job
+	{
+		JobFunction		pFunction;
+		void*			pData;
+		JobCounter*		pCounter;		// decremented once the job is done, may be NULL
+		bool			bMainThread;	// the job is run by JobSystem::processMainThreadJobs()
+	};
+
+	/**
+	* class JobCounter counts the jobs of a group that are not done yet, it is the future of the group. Jobs may
+	* depend on a counter: they are only queued once it falls to zero. A counter must outlive its jobs.
+	*/
+	class JobCounter
+	{
+		friend class JobSystem;
+
+		int					m_iJobNb;			// guarded by the job system lock
+		std::vector< Job >	m_vDependentJobs;	// queued when m_iJobNb falls to zero
+
+	public:
+		JobCounter()
+			: m_iJobNb( 0 )
+		{
+		}
+	};
+
+	/**
+	* class JobSystem runs jobs on a fixed pool of worker threads. Each worker owns a deque: the jobs a worker queues
+	* go to its own deque, which it runs from the back while idle workers steal from the front of the others, and the
+	* jobs queued by other threads are spread over the deques. Jobs are counted by JobCounter objects, which other
+	* jobs can depend on and threads can wait for. The jobs that must touch the GL context are queued on the main
+	* thread instead, which runs them once per frame in processMainThreadJobs(). The threads are created with the
+	* native thread API and need no window library.
+	*/
+	class JobSystem
+	{
+		struct Threads;
+
+		Threads*			m_pThreads;			// the worker threads, their deques and the locks, on the native thread API
+		std::deque< Job >	m_dMainThreadJobs;
+		int					m_iWorkerNb;
+		int					m_iQueuedJobNb;		// jobs in the worker deques, never less than their actual number
+		int					m_iNextQueue;		// deque of the next job queued by another thread than a worker
+		bool				m_bShutdown;
+
+		void runWorker( int iWorker );
+		int getWorkerIndex() const;
+		void queueJob( const Job& oJob );
+		bool popJob( int iWorker, Job& oJob );
+		void runJob( const Job& oJob );
+		void addJob( JobFunction pFunction, void* pData, JobCounter* pCounter, JobCounter* pDependency, bool bMainThread );
+
+		JobSystem( const JobSystem& );
+		JobSystem& operator=( const JobSystem& );
+
+	public:
+
+		/**
+		* @brief constructor: starts the worker threads, must be called by the main thread
+		* @param iWorkerNb the number of worker threads, 0 for one per processor but the main thread one
+		*/
+		JobSystem( int iWorkerNb = 0 );
+
+		/**
+		* @brief destructor: waits for the queued jobs and stops the worker threads, the main thread jobs not run yet
+		* and the jobs depending on counters that are not done are dropped
+		*/
+		~JobSystem();
+
+		/**
+		* @brief queues a job on the worker threads
+		* @param pFunction the job function
+		* @param pData the job data
+		* @param pCounter counts the job until it is done, may be NULL
+		* @param pDependency the job is queued once this counter falls to zero, may be NULL
+		*/
+		void run( JobFunction pFunction, void* pData, JobCounter* pCounter = NULL, JobCounter* pDependency = NULL );
+
+		/**
+		* @brief queues a job on the main thread, for work touching the GL context
+		* @param pFunction the job function
+		* @param pData the job data
+		* @param pCounter counts the job until it is done, may be NULL
+		* @param pDependency the job is queued once this counter falls to zero, may be NULL
+		*/
+		void runOnMainThread( JobFunction pFunction, void* pData, JobCounter* pCounter = NULL, JobCounter* pDependency = NULL );
+
+		/**
+		* @brief returns whether the jobs of a counter are done
+		* @param oCounter the counter
+		* @return true when the counter is zero
+		*/
+		bool isDone( const JobCounter& oCounter );
+
+		/**
+		* @brief waits for the jobs of a counter, the calling thread runs queued jobs meanwhile and the main thread
+		* also runs its own jobs
+		* @param oCounter the counter
+		*/
+		void wait( const JobCounter& oCounter );
+
+		/**
+		* @brief runs the jobs queued on the main thread, to be called once per frame by the main thread
+		*/
+		void processMainThreadJobs();
+
+		/**
+		* @brief returns the number of worker threads
+		* @return the number of workers
+		*/
+		int getWorkerNb() const
+		{
+			return m_iWorkerNb;
+		}
+	};
+
+	/**
+	* @brief runs a job over the elements [0,iNb), split in ranges run by the workers of a job system when they are
+	* enough, else in one range run by the calling thread, and waits for them. A range is a copy of the job data
+	* whose iStart and iEnd members are set to its elements, the job function is called with a pointer to it.
+	* @param pJobSystem the job system, may be NULL
+	* @param pFunction the job function
+	* @param oJob the job data
+	* @param iNb the number of elements
+	* @param iJobSize the number of elements under which a range would cost more to schedule than to run
+	* @param iAlignment the ranges start on a multiple of this power of two, for the SIMD packets
+	* @param vRanges an empty array, receives the ranges run by the workers, done when the function returns. It is not
+	* used when the job runs in one range.
+	* @return the first range: the whole job when it runs in one range, else a copy of vRanges[ 0 ]
+	*/
+	template< typename R >
+	R runRanges( JobSystem* pJobSystem, JobFunction pFunction, const R& oJob, int iNb, int iJobSize, int iAlignment, std::vector< R >& vRanges )
+	{
+		// small batches and calls without job system run on the calling thread, without allocation
+		if( pJobSystem == NULL || pJobSystem->getWorkerNb() == 0 || iNb < 2 * iJobSize )
+		{
+			R oRange = oJob;
+			oRange.iStart = 0;
+			oRange.iEnd = iNb;
+			if( iNb > 0 )
+				pFunction( &oRange );
+			return oRange;
+		}
+
+		// a few jobs per thread balance the load
+		int iJobNb = minT( ( iNb + iJobSize - 1 ) / iJobSize, 4 * ( pJobSystem->getWorkerNb() + 1 ) );
+		int iRangeSize = ( ( iNb + iJobNb - 1 ) / iJobNb + iAlignment - 1 ) & ~( iAlignment - 1 );
+
+		for( int iStart = 0; iStart < iNb; iStart += iRangeSize )
+		{
+			vRanges.push_back( oJob );
+			vRanges.back().iStart = iStart;
+			vRanges.back().iEnd = minT( iStart + iRangeSize, iNb );
+		}
+
+		JobCounter oDone;
+		for( size_t i = 0; i < vRanges.size(); ++i )
+			pJobSystem->run( pFunction, &vRanges[ i ], &oDone );
+		pJobSystem->wait( oDone );
+
+		return vRanges[ 0 ];
+	}
+}
+
+#endif /* JOBSYSTEM_H */
@@ -1,5 +1,10 @@
 #include "Matrix.h"
 #include <cstring>
+#include <vector>
+#include "JobSystem.h"
+#include "utils.h"
+
+using namespace std;
 
 
 namespace Oglf
@@ -67,85 +72,315 @@ namespace Oglf
 		(*this)(3,3) = 1.0;
 	}
 
-	void Matrix4x4::transpose()
+#ifdef OGLF_SSE2
+
+	/**
+	* @brief multiplies two column-major matrices with SSE: each column of the product is a combination of the
+	* columns of a weighted by the coefficients of the column of b
+	* @param pA the left matrix
+	* @param pB the right matrix
+	* @param pR the product, must not overlap the operands
+	*/
+	static inline void multiplySSE( const float* pA, const float* pB, float* pR )
+	{
+		__m128 oA0 = _mm_loadu_ps( pA );
+		__m128 oA1 = _mm_loadu_ps( pA + 4 );
+		__m128 oA2 = _mm_loadu_ps( pA + 8 );
+		__m128 oA3 = _mm_loadu_ps( pA + 12 );
+
+		for( int c = 0; c < 4; c++ )
+		{
+			__m128 oB = _mm_loadu_ps( pB + 4 * c );
+			__m128 oR = _mm_mul_ps( oA0, _mm_shuffle_ps( oB, oB, _MM_SHUFFLE( 0, 0, 0, 0 ) ) );
+			oR = _mm_add_ps( oR, _mm_mul_ps( oA1, _mm_shuffle_ps( oB, oB, _MM_SHUFFLE( 1, 1, 1, 1 ) ) ) );
+			oR = _mm_add_ps( oR, _mm_mul_ps( oA2, _mm_shuffle_ps( oB, oB, _MM_SHUFFLE( 2, 2, 2, 2 ) ) ) );
+			oR = _mm_add_ps( oR, _mm_mul_ps( oA3, _mm_shuffle_ps( oB, oB, _MM_SHUFFLE( 3, 3, 3, 3 ) ) ) );
+			_mm_storeu_ps( pR + 4 * c, oR );
+		}
+	}
+
+	/**
+	* @brief AVX version of multiplySSE() computing two columns of the product at once: the columns of a are
+	* broadcast to both 128 bits lanes and the shuffles broadcast the coefficients of a column of b within its lane
+	* @param pA the left matrix
+	* @param pB the right matrix
+	* @param pR the product, must not overlap the operands
+	*/
+	OGLF_TARGET( "avx" )
+	static void multiplyAVX( const float* pA, const float* pB, float* pR )
+	{
+		__m256 oA0 = _mm256_broadcast_ps( ( const __m128* )pA );
+		__m256 oA1 = _mm256_broadcast_ps( ( const __m128* )( pA + 4 ) );
+		__m256 oA2 = _mm256_broadcast_ps( ( const __m128* )( pA + 8 ) );
+		__m256 oA3 = _mm256_broadcast_ps( ( const __m128* )( pA + 12 ) );
+
+		for( int c = 0; c < 4; c += 2 )
+		{
+			__m256 oB = _mm256_loadu_ps( pB + 4 * c );
+			__m256 oR = _mm256_mul_ps( oA0, _mm256_shuffle_ps( oB, oB, _MM_SHUFFLE( 0, 0, 0, 0 ) ) );
+			oR = _mm256_add_ps( oR, _mm256_mul_ps( oA1, _mm256_shuffle_ps( oB, oB, _MM_SHUFFLE( 1, 1, 1, 1 ) ) ) );
+			oR = _mm256_add_ps( oR, _mm256_mul_ps( oA2, _mm256_shuffle_ps( oB, oB, _MM_SHUFFLE( 2, 2, 2, 2 ) ) ) );
+			oR = _mm256_add_ps( oR, _mm256_mul_ps( oA3, _mm256_shuffle_ps( oB, oB, _MM_SHUFFLE( 3, 3, 3, 3 ) ) ) );
+			_mm256_storeu_ps( pR + 4 * c, oR );
+		}
+	}
+
+	/**
+	* @brief 2x2 matrices packed in a vector: product a * b
+	*/
+	static inline __m128 mat2Mul( __m128 oA, __m128 oB )
+	{
+		return _mm_add_ps( _mm_mul_ps( oA, _mm_shuffle_ps( oB, oB, _MM_SHUFFLE( 3, 0, 3, 0 ) ) ),
+			_mm_mul_ps( _mm_shuffle_ps( oA, oA, _MM_SHUFFLE( 2, 3, 0, 1 ) ), _mm_shuffle_ps( oB, oB, _MM_SHUFFLE( 1, 2, 1, 2 ) ) ) );
+	}
+
+	/**
+	* @brief 2x2 matrices packed in a vector: product adjugate( a ) * b
+	*/
+	static inline __m128 mat2AdjMul( __m128 oA, __m128 oB )
 	{
-		Matrix4x4 sav = (*this);
+		return _mm_sub_ps( _mm_mul_ps( _mm_shuffle_ps( oA, oA, _MM_SHUFFLE( 0, 0, 3, 3 ) ), oB ),
+			_mm_mul_ps( _mm_shuffle_ps( oA, oA, _MM_SHUFFLE( 2, 2, 1, 1 ) ), _mm_shuffle_ps( oB, oB, _MM_SHUFFLE( 1, 0, 3, 2 ) ) ) );
+	}
+
+	/**
+	* @brief 2x2 matrices packed in a vector: product a * adjugate( b )
+	*/
+	static inline __m128 mat2MulAdj( __m128 oA, __m128 oB )
+	{
+		return _mm_sub_ps( _mm_mul_ps( oA, _mm_shuffle_ps( oB, oB, _MM_SHUFFLE( 0, 3, 0, 3 ) ) ),
+			_mm_mul_ps( _mm_shuffle_ps( oA, oA, _MM_SHUFFLE( 2, 3, 0, 1 ) ), _mm_shuffle_ps( oB, oB, _MM_SHUFFLE( 1, 2, 1, 2 ) ) ) );
+	}
 
+	/**
+	* @brief inverts a matrix with SSE from the cofactors of its 2x2 blocks: with the blocks A B / C D, the
+	* inverse blocks are built from the adjugates of A and D and the determinant from the 2x2 determinants.
+	* The transpose of the inverse is the inverse of the transpose, so the column-major storage is read as is.
+	* @param pM the matrix to invert, overwritten by its inverse
+	*/
+	static void invertSSE( float* pM )
+	{
+		__m128 oRow0 = _mm_loadu_ps( pM );
+		__m128 oRow1 = _mm_loadu_ps( pM + 4 );
+		__m128 oRow2 = _mm_loadu_ps( pM + 8 );
+		__m128 oRow3 = _mm_loadu_ps( pM + 12 );
+
+		// the 2x2 blocks, each packed in a vector in row order
+		__m128 oA = _mm_movelh_ps( oRow0, oRow1 );
+		__m128 oB = _mm_movehl_ps( oRow1, oRow0 );
+		__m128 oC = _mm_movelh_ps( oRow2, oRow3 );
+		__m128 oD = _mm_movehl_ps( oRow3, oRow2 );
+
+		// the block determinants |A| |B| |C| |D|
+		__m128 oDetSub = _mm_sub_ps(
+			_mm_mul_ps( _mm_shuffle_ps( oRow0, oRow2, _MM_SHUFFLE( 2, 0, 2, 0 ) ), _mm_shuffle_ps( oRow1, oRow3, _MM_SHUFFLE( 3, 1, 3, 1 ) ) ),
+			_mm_mul_ps( _mm_shuffle_ps( oRow0, oRow2, _MM_SHUFFLE( 3, 1, 3, 1 ) ), _mm_shuffle_ps( oRow1, oRow3, _MM_SHUFFLE( 2, 0, 2, 0 ) ) ) );
+		__m128 oDetA = _mm_shuffle_ps( oDetSub, oDetSub, _MM_SHUFFLE( 0, 0, 0, 0 ) );
+		__m128 oDetB = _mm_shuffle_ps( oDetSub, oDetSub, _MM_SHUFFLE( 1, 1, 1, 1 ) );
+		__m128 oDetC = _mm_shuffle_ps( oDetSub, oDetSub, _MM_SHUFFLE( 2, 2, 2, 2 ) );
+		__m128 oDetD = _mm_shuffle_ps( oDetSub, oDetSub, _MM_SHUFFLE( 3, 3, 3, 3 ) );
+
+		__m128 oDC = mat2AdjMul( oD, oC );
+		__m128 oAB = mat2AdjMul( oA, oB );
+		__m128 oX = _mm_sub_ps( _mm_mul_ps( oDetD, oA ), mat2Mul( oB, oDC ) );
+		__m128 oW = _mm_sub_ps( _mm_mul_ps( oDetA, oD ), mat2Mul( oC, oAB ) );
+		__m128 oY = _mm_sub_ps( _mm_mul_ps( oDetB, oC ), mat2MulAdj( oD, oAB ) );
+		__m128 oZ = _mm_sub_ps( _mm_mul_ps( oDetC, oB ), mat2MulAdj( oA, oDC ) );
+
+		// |M| = |A||D| + |B||C| - tr( adj( A ) B adj( D ) C )
+		__m128 oDet = _mm_add_ps( _mm_mul_ps( oDetA, oDetD ), _mm_mul_ps( oDetB, oDetC ) );
+		__m128 oTrace = _mm_mul_ps( oAB, _mm_shuffle_ps( oDC, oDC, _MM_SHUFFLE( 3, 1, 2, 0 ) ) );
+		oTrace = _mm_add_ps( oTrace, _mm_shuffle_ps( oTrace, oTrace, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+		oTrace = _mm_add_ps( oTrace, _mm_shuffle_ps( oTrace, oTrace, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+		oDet = _mm_sub_ps( oDet, oTrace );
+
+		__m128 oInvDet = _mm_div_ps( _mm_setr_ps( 1.f, -1.f, -1.f, 1.f ), oDet );
+		oX = _mm_mul_ps( oX, oInvDet );
+		oY = _mm_mul_ps( oY, oInvDet );
+		oZ = _mm_mul_ps( oZ, oInvDet );
+		oW = _mm_mul_ps( oW, oInvDet );
+
+		_mm_storeu_ps( pM, _mm_shuffle_ps( oX, oY, _MM_SHUFFLE( 1, 3, 1, 3 ) ) );
+		_mm_storeu_ps( pM + 4, _mm_shuffle_ps( oX, oY, _MM_SHUFFLE( 0, 2, 0, 2 ) ) );
+		_mm_storeu_ps( pM + 8, _mm_shuffle_ps( oZ, oW, _MM_SHUFFLE( 1, 3, 1, 3 ) ) );
+		_mm_storeu_ps( pM + 12, _mm_shuffle_ps( oZ, oW, _MM_SHUFFLE( 0, 2, 0, 2 ) ) );
+	}
+
+#endif
+
+	void Matrix4x4::transpose()
+	{
+#ifdef OGLF_SSE2
+		__m128 oCol0 = _mm_loadu_ps( m );
+		__m128 oCol1 = _mm_loadu_ps( m + 4 );
+		__m128 oCol2 = _mm_loadu_ps( m + 8 );
+		__m128 oCol3 = _mm_loadu_ps( m + 12 );
+		_MM_TRANSPOSE4_PS( oCol0, oCol1, oCol2, oCol3 );
+		_mm_storeu_ps( m, oCol0 );
+		_mm_storeu_ps( m + 4, oCol1 );
+		_mm_storeu_ps( m + 8, oCol2 );
+		_mm_storeu_ps( m + 12, oCol3 );
+#else
 		for( int l = 0; l < 4; l++ )
-			for( int c = 0; c < 4; c++ )
-				(*this)(l,c) = sav(c,l);
+		{
+			for( int c = l + 1; c < 4; c++ )
+			{
+				float fTemp = m[ c * 4 + l ];
+				m[ c * 4 + l ] = m[ l * 4 + c ];
+				m[ l * 4 + c ] = fTemp;
+			}
+		}
+#endif
 	}
 
 	Matrix4x4 Matrix4x4::operator * ( const Matrix4x4 &b ) const
 	{
-		Matrix4x4 m;
+		Matrix4x4 r;
 
-		for( int l = 0; l < 4; l++ )
-			for( int c = 0; c < 4; c++ )
-				m(l,c) = (*this)(l,0) * b(0,c) + (*this)(l,1) * b(1,c) + (*this)(l,2) * b(2,c) + (*this)(l,3) * b(3, c);
+#ifdef OGLF_SSE2
+		if( CpuFeatures::get().bAVX )
+		{
+			multiplyAVX( m, b.m, r.m );
+			return r;
+		}
+		if( CpuFeatures::get().bSSE2 )
+		{
+			multiplySSE( m, b.m, r.m );
+			return r;
+		}
+#endif
+		// column c of the product combines the columns of this matrix
+		for( int c = 0; c < 4; c++ )
+			for( int l = 0; l < 4; l++ )
+				r.m[ c * 4 + l ] = m[ l ] * b.m[ c * 4 ] + m[ 4 + l ] * b.m[ c * 4 + 1 ] + m[ 8 + l ] * b.m[ c * 4 + 2 ] + m[ 12 + l ] * b.m[ c * 4 + 3 ];
 
-		return m;
+		return r;
 	}
 
-	// Gauss-Jordan elimination with partial pivoting
+	/**
+	* @brief inverts the matrix: affine matrices through invertAffine(), the other ones from their cofactors.
+	* A singular matrix gives infinite or NaN coefficients.
+	*/
 	void Matrix4x4::invert()
 	{
-		Matrix4x4 a(*this),          // a evolves from original to identity
-			b;                 // b evolves from indentity to inverse(a)
+		if( isAffine() )
+		{
+			invertAffine();
+			return;
+		}
 
-		int   i, j, i1, i2;
-		float temp, pivot;
-		float factor=0.0;
+#ifdef OGLF_SSE2
+		if( CpuFeatures::get().bSSE2 )
+		{
+			invertSSE( m );
+			return;
+		}
+#endif
+		// the 2x2 determinants of the first two and the last two rows, the transpose of the inverse being the
+		// inverse of the transpose, the column-major storage is read as is
+		const float* a = m;
+		float s0 = a[0] * a[5] - a[4] * a[1];
+		float s1 = a[0] * a[6] - a[4] * a[2];
+		float s2 = a[0] * a[7] - a[4] * a[3];
+		float s3 = a[1] * a[6] - a[5] * a[2];
+		float s4 = a[1] * a[7] - a[5] * a[3];
+		float s5 = a[2] * a[7] - a[6] * a[3];
+
+		float c5 = a[10] * a[15] - a[14] * a[11];
+		float c4 = a[9] * a[15] - a[13] * a[11];
+		float c3 = a[9] * a[14] - a[13] * a[10];
+		float c2 = a[8] * a[15] - a[12] * a[11];
+		float c1 = a[8] * a[14] - a[12] * a[10];
+		float c0 = a[8] * a[13] - a[12] * a[9];
+
+		float fInvDet = 1.f / ( s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0 );
+
+		float b[16];
+		b[0] = ( a[5] * c5 - a[6] * c4 + a[7] * c3 ) * fInvDet;
+		b[1] = ( -a[1] * c5 + a[2] * c4 - a[3] * c3 ) * fInvDet;
+		b[2] = ( a[13] * s5 - a[14] * s4 + a[15] * s3 ) * fInvDet;
+		b[3] = ( -a[9] * s5 + a[10] * s4 - a[11] * s3 ) * fInvDet;
+
+		b[4] = ( -a[4] * c5 + a[6] * c2 - a[7] * c1 ) * fInvDet;
+		b[5] = ( a[0] * c5 - a[2] * c2 + a[3] * c1 ) * fInvDet;
+		b[6] = ( -a[12] * s5 + a[14] * s2 - a[15] * s1 ) * fInvDet;
+		b[7] = ( a[8] * s5 - a[10] * s2 + a[11] * s1 ) * fInvDet;
+
+		b[8] = ( a[4] * c4 - a[5] * c2 + a[7] * c0 ) * fInvDet;
+		b[9] = ( -a[0] * c4 + a[1] * c2 - a[3] * c0 ) * fInvDet;
+		b[10] = ( a[12] * s4 - a[13] * s2 + a[15] * s0 ) * fInvDet;
+		b[11] = ( -a[8] * s4 + a[9] * s2 - a[11] * s0 ) * fInvDet;
+
+		b[12] = ( -a[4] * c3 + a[5] * c1 - a[6] * c0 ) * fInvDet;
+		b[13] = ( a[0] * c3 - a[1] * c1 + a[2] * c0 ) * fInvDet;
+		b[14] = ( -a[12] * s3 + a[13] * s1 - a[14] * s0 ) * fInvDet;
+		b[15] = ( a[8] * s3 - a[9] * s1 + a[10] * s0 ) * fInvDet;
+
+		memcpy( m, b, sizeof( m ) );
+	}
 
-		b.identity();           // b : identity
+	/**
+	* @brief inverts a matrix whose last row is 0 0 0 1: inverts its 3x3 part and transforms the opposite
+	* of its translation
+	*/
+	void Matrix4x4::invertAffine()
+	{
+		Matrix4x4 &a = *this;
 
-		for( j=0; j<4; j++ )    // Loop over cols eliminating above and below diag
-		{                       // Find largest pivot in col j
-			i1 = j;
-			for( i=j; i<4; i++ ) // Row with possible largest pivot
-				if( fabs(a(i,j)) > fabs(a(i1,j) ) ) i1 = i;
-			if (i1!=j)
-			{
-				for (i2=0; i2<4; i2++)
-				{
-					temp = b(i1,i2);
-					b(i1,i2) = b(j,i2);
-					b(j,i2) = temp;
-					if (i2>=j)
-					{
-						temp = a(i1,i2);
-						a(i1,i2) = a(j,i2);
-						a(j,i2) = temp;
-					}
-				}
-			}
-			pivot = a(j,j);
-			for (i2=0; i2<4; i2++)
-			{
-				b(j,i2) = b(j,i2) / pivot;                   // Scale row j to have a unit diag
-				if (i2>=j) a(j,i2) = a(j,i2) / pivot;
-			}
+		// cofactors of the 3x3 part, transposed
+		float r00 = a(1,1) * a(2,2) - a(1,2) * a(2,1);
+		float r01 = a(0,2) * a(2,1) - a(0,1) * a(2,2);
+		float r02 = a(0,1) * a(1,2) - a(0,2) * a(1,1);
+		float r10 = a(1,2) * a(2,0) - a(1,0) * a(2,2);
+		float r11 = a(0,0) * a(2,2) - a(0,2) * a(2,0);
+		float r12 = a(0,2) * a(1,0) - a(0,0) * a(1,2);
+		float r20 = a(1,0) * a(2,1) - a(1,1) * a(2,0);
+		float r21 = a(0,1) * a(2,0) - a(0,0) * a(2,1);
+		float r22 = a(0,0) * a(1,1) - a(0,1) * a(1,0);
 
-			for( i=0; i<4; i++)           // Eliminate off-diag elems in col j (a) and (b)
-			{
-				if (i!=j) factor = a(i,j);
-				for (i2=0; i2<4; i2++)
-				{
-					if (i!=j)
-					{
-						b(i,i2) = b(i,i2) - factor * b(j,i2);
-						a(i,i2) = a(i,i2) - factor * a(j,i2);
-					}
-				}
-			}                       // Inversion done
-		}
+		float fInvDet = 1.f / ( a(0,0) * r00 + a(0,1) * r10 + a(0,2) * r20 );
+
+		float tx = a(0,3), ty = a(1,3), tz = a(2,3);
+
+		a(0,0) = r00 * fInvDet; a(0,1) = r01 * fInvDet; a(0,2) = r02 * fInvDet;
+		a(1,0) = r10 * fInvDet; a(1,1) = r11 * fInvDet; a(1,2) = r12 * fInvDet;
+		a(2,0) = r20 * fInvDet; a(2,1) = r21 * fInvDet; a(2,2) = r22 * fInvDet;
+
+		a(0,3) = -( a(0,0) * tx + a(0,1) * ty + a(0,2) * tz );
+		a(1,3) = -( a(1,0) * tx + a(1,1) * ty + a(1,2) * tz );
+		a(2,3) = -( a(2,0) * tx + a(2,1) * ty + a(2,2) * tz );
+
+		a(3,0) = 0.0; a(3,1) = 0.0; a(3,2) = 0.0; a(3,3) = 1.0;
+	}
+
+	/**
+	* @brief inverts a rotation and translation matrix: transposes its rotation and transforms the opposite
+	* of its translation. The matrix must not scale.
+	*/
+	void Matrix4x4::invertRigid()
+	{
+		Matrix4x4 &a = *this;
+		float fTemp;
 
-		(*this)(0,0) = b(0,0) ; (*this)(0,1) = b(0,1) ; (*this)(0,2) = b(0,2) ; (*this)(0,3) = b(0,3) ;
-		(*this)(1,0) = b(1,0) ; (*this)(1,1) = b(1,1) ; (*this)(1,2) = b(1,2) ; (*this)(1,3) = b(1,3) ;
-		(*this)(2,0) = b(2,0) ; (*this)(2,1) = b(2,1) ; (*this)(2,2) = b(2,2) ; (*this)(2,3) = b(2,3) ;
-		(*this)(3,0) = b(3,0) ; (*this)(3,1) = b(3,1) ; (*this)(3,2) = b(3,2) ; (*this)(3,3) = b(3,3) ;
+		fTemp = a(0,1); a(0,1) = a(1,0); a(1,0) = fTemp;
+		fTemp = a(0,2); a(0,2) = a(2,0); a(2,0) = fTemp;
+		fTemp = a(1,2); a(1,2) = a(2,1); a(2,1) = fTemp;
 
+		float tx = a(0,3), ty = a(1,3), tz = a(2,3);
+		a(0,3) = -( a(0,0) * tx + a(0,1) * ty + a(0,2) * tz );
+		a(1,3) = -( a(1,0) * tx + a(1,1) * ty + a(1,2) * tz );
+		a(2,3) = -( a(2,0) * tx + a(2,1) * ty + a(2,2) * tz );
 
+		a(3,0) = 0.0; a(3,1) = 0.0; a(3,2) = 0.0; a(3,3) = 1.0;
+	}
+
+	/**
+	* @brief returns whether the last row of the matrix is 0 0 0 1
+	* @return true if invertAffine() can invert the matrix
+	*/
+	bool Matrix4x4::isAffine() const
+	{
+		return m[3] == 0.f && m[7] == 0.f && m[11] == 0.f && m[15] == 1.f;
 	}
 
 	/*void blMatrix::print( char *nom )
@@ -190,6 +425,423 @@ namespace Oglf
 	}
 
 
+	/**
+	* @brief how the batch transforms treat their elements
+	*/
+	enum TransformMode
+	{
+		TRANSFORM_POINT,	// v[x,y,z,1]
+		TRANSFORM_VECTOR,	// v[x,y,z,0]
+		TRANSFORM_PROJECT	// v[x,y,z,1] and w-divide
+	};
+
+	/**
+	* @brief a range of a batch transform, the elements are either an array of Vec3 or x, y and z streams
+	*/
+	struct TransformBatch
+	{
+		const float*	pMatrix;
+		TransformMode	eMode;
+		const Vec3*		pElements;		// NULL for streams
+		Vec3*			pResults;
+		const float*	ppElements[ 3 ];
+		float*			ppResults[ 3 ];
+		int				iStart;
+		int				iEnd;
+	};
+
+	const int g_iTransformJobSize = 16384;	// elements per job, smaller jobs would cost more to schedule than to run
+
+	/**
+	* @brief transforms an element with the FPU, in the order of the SIMD code so that both give the same results
+	* @param pM the matrix
+	* @param eMode the transform mode
+	* @param x, y, z the element, overwritten by the result
+	*/
+	static inline void transformScalar( const float* pM, TransformMode eMode, float& x, float& y, float& z )
+	{
+		float rx = pM[ 0 ] * x + pM[ 4 ] * y + pM[ 8 ] * z;
+		float ry = pM[ 1 ] * x + pM[ 5 ] * y + pM[ 9 ] * z;
+		float rz = pM[ 2 ] * x + pM[ 6 ] * y + pM[ 10 ] * z;
+
+		if( eMode != TRANSFORM_VECTOR )
+		{
+			rx += pM[ 12 ];
+			ry += pM[ 13 ];
+			rz += pM[ 14 ];
+		}
+		if( eMode == TRANSFORM_PROJECT )
+		{
+			float w = pM[ 3 ] * x + pM[ 7 ] * y + pM[ 11 ] * z + pM[ 15 ];
+			rx /= w;
+			ry /= w;
+			rz /= w;
+		}
+
+		x = rx;
+		y = ry;
+		z = rz;
+	}
+
+	/**
+	* @brief transforms the elements of a range with the FPU
+	* @param oBatch the range
+	*/
+	static void transformBatchScalar( const TransformBatch& oBatch )
+	{
+		if( oBatch.pElements != NULL )
+		{
+			for( int i = oBatch.iStart; i < oBatch.iEnd; ++i )
+			{
+				Vec3 oVec = oBatch.pElements[ i ];
+				transformScalar( oBatch.pMatrix, oBatch.eMode, oVec.v[ 0 ], oVec.v[ 1 ], oVec.v[ 2 ] );
+				oBatch.pResults[ i ] = oVec;
+			}
+		}
+		else
+		{
+			for( int i = oBatch.iStart; i < oBatch.iEnd; ++i )
+			{
+				float x = oBatch.ppElements[ 0 ][ i ], y = oBatch.ppElements[ 1 ][ i ], z = oBatch.ppElements[ 2 ][ i ];
+				transformScalar( oBatch.pMatrix, oBatch.eMode, x, y, z );
+				oBatch.ppResults[ 0 ][ i ] = x;
+				oBatch.ppResults[ 1 ][ i ] = y;
+				oBatch.ppResults[ 2 ][ i ] = z;
+			}
+		}
+	}
+
+#ifdef OGLF_SSE2
+
+	/**
+	* @brief transforms 4 elements stored as x, y and z vectors with SSE
+	* @param pM the matrix coefficients, each broadcast to a vector
+	* @param eMode the transform mode
+	* @param oX, oY, oZ the elements, overwritten by the results
+	*/
+	static inline void transformSSE( const __m128* pM, TransformMode eMode, __m128& oX, __m128& oY, __m128& oZ )
+	{
+		__m128 oRx = _mm_add_ps( _mm_add_ps( _mm_mul_ps( pM[ 0 ], oX ), _mm_mul_ps( pM[ 4 ], oY ) ), _mm_mul_ps( pM[ 8 ], oZ ) );
+		__m128 oRy = _mm_add_ps( _mm_add_ps( _mm_mul_ps( pM[ 1 ], oX ), _mm_mul_ps( pM[ 5 ], oY ) ), _mm_mul_ps( pM[ 9 ], oZ ) );
+		__m128 oRz = _mm_add_ps( _mm_add_ps( _mm_mul_ps( pM[ 2 ], oX ), _mm_mul_ps( pM[ 6 ], oY ) ), _mm_mul_ps( pM[ 10 ], oZ ) );
+
+		if( eMode != TRANSFORM_VECTOR )
+		{
+			oRx = _mm_add_ps( oRx, pM[ 12 ] );
+			oRy = _mm_add_ps( oRy, pM[ 13 ] );
+			oRz = _mm_add_ps( oRz, pM[ 14 ] );
+		}
+		if( eMode == TRANSFORM_PROJECT )
+		{
+			__m128 oW = _mm_add_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( pM[ 3 ], oX ), _mm_mul_ps( pM[ 7 ], oY ) ), _mm_mul_ps( pM[ 11 ], oZ ) ), pM[ 15 ] );
+			oRx = _mm_div_ps( oRx, oW );
+			oRy = _mm_div_ps( oRy, oW );
+			oRz = _mm_div_ps( oRz, oW );
+		}
+
+		oX = oRx;
+		oY = oRy;
+		oZ = oRz;
+	}
+
+	/**
+	* @brief transforms the elements of a range with SSE, 4 at once, and the remaining ones with the FPU. 4 Vec3 are
+	* loaded as 3 vectors x0y0z0x1 y1z1x2y2 z2x3y3z3 and shuffled to x, y and z vectors, and back to store them.
+	* @param oBatch the range
+	*/
+	static void transformBatchSSE( const TransformBatch& oBatch )
+	{
+		__m128 pM[ 16 ];
+		for( int i = 0; i < 16; ++i )
+			pM[ i ] = _mm_set1_ps( oBatch.pMatrix[ i ] );
+
+		int i = oBatch.iStart;
+		if( oBatch.pElements != NULL )
+		{
+			for( ; i + 4 <= oBatch.iEnd; i += 4 )
+			{
+				const float* pSrc = oBatch.pElements[ i ].v;
+				__m128 oA = _mm_loadu_ps( pSrc );
+				__m128 oB = _mm_loadu_ps( pSrc + 4 );
+				__m128 oC = _mm_loadu_ps( pSrc + 8 );
+
+				__m128 oXY = _mm_shuffle_ps( oB, oC, _MM_SHUFFLE( 2, 1, 3, 2 ) );	// x2 y2 x3 y3
+				__m128 oYZ = _mm_shuffle_ps( oA, oB, _MM_SHUFFLE( 1, 0, 2, 1 ) );	// y0 z0 y1 z1
+				__m128 oX = _mm_shuffle_ps( oA, oXY, _MM_SHUFFLE( 2, 0, 3, 0 ) );
+				__m128 oY = _mm_shuffle_ps( oYZ, oXY, _MM_SHUFFLE( 3, 1, 2, 0 ) );
+				__m128 oZ = _mm_shuffle_ps( oYZ, oC, _MM_SHUFFLE( 3, 0, 3, 1 ) );
+
+				transformSSE( pM, oBatch.eMode, oX, oY, oZ );
+
+				float* pDst = oBatch.pResults[ i ].v;
+				_mm_storeu_ps( pDst, _mm_shuffle_ps( _mm_shuffle_ps( oX, oY, _MM_SHUFFLE( 0, 0, 0, 0 ) ), _mm_shuffle_ps( oZ, oX, _MM_SHUFFLE( 1, 1, 0, 0 ) ), _MM_SHUFFLE( 2, 0, 2, 0 ) ) );
+				_mm_storeu_ps( pDst + 4, _mm_shuffle_ps( _mm_shuffle_ps( oY, oZ, _MM_SHUFFLE( 1, 1, 1, 1 ) ), _mm_shuffle_ps( oX, oY, _MM_SHUFFLE( 2, 2, 2, 2 ) ), _MM_SHUFFLE( 2, 0, 2, 0 ) ) );
+				_mm_storeu_ps( pDst + 8, _mm_shuffle_ps( _mm_shuffle_ps( oZ, oX, _MM_SHUFFLE( 3, 3, 2, 2 ) ), _mm_shuffle_ps( oY, oZ, _MM_SHUFFLE( 3, 3, 3, 3 ) ), _MM_SHUFFLE( 2, 0, 2, 0 ) ) );
+			}
+		}
+		else
+		{
+			for( ; i + 4 <= oBatch.iEnd; i += 4 )
+			{
+				__m128 oX = _mm_loadu_ps( oBatch.ppElements[ 0 ] + i );
+				__m128 oY = _mm_loadu_ps( oBatch.ppElements[ 1 ] + i );
+				__m128 oZ = _mm_loadu_ps( oBatch.ppElements[ 2 ] + i );
+
+				transformSSE( pM, oBatch.eMode, oX, oY, oZ );
+
+				_mm_storeu_ps( oBatch.ppResults[ 0 ] + i, oX );
+				_mm_storeu_ps( oBatch.ppResults[ 1 ] + i, oY );
+				_mm_storeu_ps( oBatch.ppResults[ 2 ] + i, oZ );
+			}
+		}
+
+		TransformBatch oRemaining = oBatch;
+		oRemaining.iStart = i;
+		transformBatchScalar( oRemaining );
+	}
+
+	/**
+	* @brief AVX version of transformSSE(), on 8 elements
+	*/
+	OGLF_TARGET( "avx" )
+	static inline void transformAVX( const __m256* pM, TransformMode eMode, __m256& oX, __m256& oY, __m256& oZ )
+	{
+		__m256 oRx = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( pM[ 0 ], oX ), _mm256_mul_ps( pM[ 4 ], oY ) ), _mm256_mul_ps( pM[ 8 ], oZ ) );
+		__m256 oRy = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( pM[ 1 ], oX ), _mm256_mul_ps( pM[ 5 ], oY ) ), _mm256_mul_ps( pM[ 9 ], oZ ) );
+		__m256 oRz = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( pM[ 2 ], oX ), _mm256_mul_ps( pM[ 6 ], oY ) ), _mm256_mul_ps( pM[ 10 ], oZ ) );
+
+		if( eMode != TRANSFORM_VECTOR )
+		{
+			oRx = _mm256_add_ps( oRx, pM[ 12 ] );
+			oRy = _mm256_add_ps( oRy, pM[ 13 ] );
+			oRz = _mm256_add_ps( oRz, pM[ 14 ] );
+		}
+		if( eMode == TRANSFORM_PROJECT )
+		{
+			__m256 oW = _mm256_add_ps( _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( pM[ 3 ], oX ), _mm256_mul_ps( pM[ 7 ], oY ) ), _mm256_mul_ps( pM[ 11 ], oZ ) ), pM[ 15 ] );
+			oRx = _mm256_div_ps( oRx, oW );
+			oRy = _mm256_div_ps( oRy, oW );
+			oRz = _mm256_div_ps( oRz, oW );
+		}
+
+		oX = oRx;
+		oY = oRy;
+		oZ = oRz;
+	}
+
+	/**
+	* @brief AVX version of transformBatchSSE(), on 8 elements at once: the low 128 bits lanes hold the first 4
+	* Vec3 and the high ones the next 4, so that the in-lane shuffles of the SSE version still apply
+	* @param oBatch the range
+	*/
+	OGLF_TARGET( "avx" )
+	static void transformBatchAVX( const TransformBatch& oBatch )
+	{
+		__m256 pM[ 16 ];
+		for( int i = 0; i < 16; ++i )
+			pM[ i ] = _mm256_set1_ps( oBatch.pMatrix[ i ] );
+
+		int i = oBatch.iStart;
+		if( oBatch.pElements != NULL )
+		{
+			for( ; i + 8 <= oBatch.iEnd; i += 8 )
+			{
+				const float* pSrc = oBatch.pElements[ i ].v;
+				__m256 oA = _mm256_insertf128_ps( _mm256_castps128_ps256( _mm_loadu_ps( pSrc ) ), _mm_loadu_ps( pSrc + 12 ), 1 );
+				__m256 oB = _mm256_insertf128_ps( _mm256_castps128_ps256( _mm_loadu_ps( pSrc + 4 ) ), _mm_loadu_ps( pSrc + 16 ), 1 );
+				__m256 oC = _mm256_insertf128_ps( _mm256_castps128_ps256( _mm_loadu_ps( pSrc + 8 ) ), _mm_loadu_ps( pSrc + 20 ), 1 );
+
+				__m256 oXY = _mm256_shuffle_ps( oB, oC, _MM_SHUFFLE( 2, 1, 3, 2 ) );
+				__m256 oYZ = _mm256_shuffle_ps( oA, oB, _MM_SHUFFLE( 1, 0, 2, 1 ) );
+				__m256 oX = _mm256_shuffle_ps( oA, oXY, _MM_SHUFFLE( 2, 0, 3, 0 ) );
+				__m256 oY = _mm256_shuffle_ps( oYZ, oXY, _MM_SHUFFLE( 3, 1, 2, 0 ) );
+				__m256 oZ = _mm256_shuffle_ps( oYZ, oC, _MM_SHUFFLE( 3, 0, 3, 1 ) );
+
+				transformAVX( pM, oBatch.eMode, oX, oY, oZ );
+
+				oA = _mm256_shuffle_ps( _mm256_shuffle_ps( oX, oY, _MM_SHUFFLE( 0, 0, 0, 0 ) ), _mm256_shuffle_ps( oZ, oX, _MM_SHUFFLE( 1, 1, 0, 0 ) ), _MM_SHUFFLE( 2, 0, 2, 0 ) );
+				oB = _mm256_shuffle_ps( _mm256_shuffle_ps( oY, oZ, _MM_SHUFFLE( 1, 1, 1, 1 ) ), _mm256_shuffle_ps( oX, oY, _MM_SHUFFLE( 2, 2, 2, 2 ) ), _MM_SHUFFLE( 2, 0, 2, 0 ) );
+				oC = _mm256_shuffle_ps( _mm256_shuffle_ps( oZ, oX, _MM_SHUFFLE( 3, 3, 2, 2 ) ), _mm256_shuffle_ps( oY, oZ, _MM_SHUFFLE( 3, 3, 3, 3 ) ), _MM_SHUFFLE( 2, 0, 2, 0 ) );
+
+				float* pDst = oBatch.pResults[ i ].v;
+				_mm_storeu_ps( pDst, _mm256_castps256_ps128( oA ) );
+				_mm_storeu_ps( pDst + 4, _mm256_castps256_ps128( oB ) );
+				_mm_storeu_ps( pDst + 8, _mm256_castps256_ps128( oC ) );
+				_mm_storeu_ps( pDst + 12, _mm256_extractf128_ps( oA, 1 ) );
+				_mm_storeu_ps( pDst + 16, _mm256_extractf128_ps( oB, 1 ) );
+				_mm_storeu_ps( pDst + 20, _mm256_extractf128_ps( oC, 1 ) );
+			}
+		}
+		else
+		{
+			for( ; i + 8 <= oBatch.iEnd; i += 8 )
+			{
+				__m256 oX = _mm256_loadu_ps( oBatch.ppElements[ 0 ] + i );
+				__m256 oY = _mm256_loadu_ps( oBatch.ppElements[ 1 ] + i );
+				__m256 oZ = _mm256_loadu_ps( oBatch.ppElements[ 2 ] + i );
+
+				transformAVX( pM, oBatch.eMode, oX, oY, oZ );
+
+				_mm256_storeu_ps( oBatch.ppResults[ 0 ] + i, oX );
+				_mm256_storeu_ps( oBatch.ppResults[ 1 ] + i, oY );
+				_mm256_storeu_ps( oBatch.ppResults[ 2 ] + i, oZ );
+			}
+		}
+
+		// avoids the AVX to SSE transition penalty before the remaining elements
+		_mm256_zeroupper();
+		TransformBatch oRemaining = oBatch;
+		oRemaining.iStart = i;
+		transformBatchSSE( oRemaining );
+	}
+
+#endif
+
+	/**
+	* @brief job transforming the elements of a range, with AVX, SSE or the FPU
+	* @param pData the range
+	*/
+	static void transformBatchJob( void* pData )
+	{
+		const TransformBatch& oBatch = *( const TransformBatch* )pData;
+
+#ifdef OGLF_SSE2
+		if( CpuFeatures::get().bAVX )
+		{
+			transformBatchAVX( oBatch );
+			return;
+		}
+		if( CpuFeatures::get().bSSE2 )
+		{
+			transformBatchSSE( oBatch );
+			return;
+		}
+#endif
+		transformBatchScalar( oBatch );
+	}
+
+	/**
+	* @brief runs a batch transform, split in ranges run by the job system workers when it is large enough
+	* @param oBatch the batch
+	* @param iNb the number of elements
+	* @param pJobSystem the job system, may be NULL
+	*/
+	static void runTransformBatch( const TransformBatch& oBatch, int iNb, JobSystem* pJobSystem )
+	{
+		// the ranges start on a multiple of 8 elements, for the AVX packets
+		vector< TransformBatch > vRanges;
+		runRanges( pJobSystem, transformBatchJob, oBatch, iNb, g_iTransformJobSize, 8, vRanges );
+	}
+
+	/**
+	* @brief builds a batch transform of an array of Vec3
+	*/
+	static TransformBatch makeTransformBatch( const float* pMatrix, TransformMode eMode, const Vec3* pElements, Vec3* pResults )
+	{
+		TransformBatch oBatch;
+		memset( &oBatch, 0, sizeof( oBatch ) );
+		oBatch.pMatrix = pMatrix;
+		oBatch.eMode = eMode;
+		oBatch.pElements = pElements;
+		oBatch.pResults = pResults;
+		return oBatch;
+	}
+
+	/**
+	* @brief builds a batch transform of x, y and z streams
+	*/
+	static TransformBatch makeTransformBatch( const float* pMatrix, TransformMode eMode, const float* const ppElements[ 3 ], float* const ppResults[ 3 ] )
+	{
+		TransformBatch oBatch;
+		memset( &oBatch, 0, sizeof( oBatch ) );
+		oBatch.pMatrix = pMatrix;
+		oBatch.eMode = eMode;
+		for( int i = 0; i < 3; ++i )
+		{
+			oBatch.ppElements[ i ] = ppElements[ i ];
+			oBatch.ppResults[ i ] = ppResults[ i ];
+		}
+		return oBatch;
+	}
+
+	/**
+	* @brief transforms points v[x,y,z,1] without w-divide, as the product with a Vec3 does
+	* @param pPoints the points
+	* @param pResults the transformed points, may be pPoints
+	* @param iNb the number of points
+	* @param pJobSystem spreads large batches over its workers, may be NULL
+	*/
+	void Matrix4x4::transformPoints( const Vec3* pPoints, Vec3* pResults, int iNb, JobSystem* pJobSystem ) const
+	{
+		TransformBatch oBatch = makeTransformBatch( m, TRANSFORM_POINT, pPoints, pResults );
+		runTransformBatch( oBatch, iNb, pJobSystem );
+	}
+
+	/**
+	* @brief transforms vectors v[x,y,z,0]: the translation is ignored
+	* @param pVectors the vectors
+	* @param pResults the transformed vectors, may be pVectors
+	* @param iNb the number of vectors
+	* @param pJobSystem spreads large batches over its workers, may be NULL
+	*/
+	void Matrix4x4::transformVectors( const Vec3* pVectors, Vec3* pResults, int iNb, JobSystem* pJobSystem ) const
+	{
+		TransformBatch oBatch = makeTransformBatch( m, TRANSFORM_VECTOR, pVectors, pResults );
+		runTransformBatch( oBatch, iNb, pJobSystem );
+	}
+
+	/**
+	* @brief transforms points v[x,y,z,1] and w-divides them, as the + operator does
+	* @param pPoints the points
+	* @param pResults the projected points, may be pPoints
+	* @param iNb the number of points
+	* @param pJobSystem spreads large batches over its workers, may be NULL
+	*/
+	void Matrix4x4::projectPoints( const Vec3* pPoints, Vec3* pResults, int iNb, JobSystem* pJobSystem ) const
+	{
+		TransformBatch oBatch = makeTransformBatch( m, TRANSFORM_PROJECT, pPoints, pResults );
+		runTransformBatch( oBatch, iNb, pJobSystem );
+	}
+
+	/**
+	* @brief transformPoints() on points stored as x, y and z streams
+	* @param ppPoints the x, y and z streams of the points
+	* @param ppResults the x, y and z streams of the transformed points, may be ppPoints
+	* @param iNb the number of points
+	* @param pJobSystem spreads large batches over its workers, may be NULL
+	*/
+	void Matrix4x4::transformPoints( const float* const ppPoints[ 3 ], float* const ppResults[ 3 ], int iNb, JobSystem* pJobSystem ) const
+	{
+		TransformBatch oBatch = makeTransformBatch( m, TRANSFORM_POINT, ppPoints, ppResults );
+		runTransformBatch( oBatch, iNb, pJobSystem );
+	}
+
+	/**
+	* @brief transformVectors() on vectors stored as x, y and z streams
+	* @param ppVectors the x, y and z streams of the vectors
+	* @param ppResults the x, y and z streams of the transformed vectors, may be ppVectors
+	* @param iNb the number of vectors
+	* @param pJobSystem spreads large batches over its workers, may be NULL
+	*/
+	void Matrix4x4::transformVectors( const float* const ppVectors[ 3 ], float* const ppResults[ 3 ], int iNb, JobSystem* pJobSystem ) const
+	{
+		TransformBatch oBatch = makeTransformBatch( m, TRANSFORM_VECTOR, ppVectors, ppResults );
+		runTransformBatch( oBatch, iNb, pJobSystem );
+	}
+
+	/**
+	* @brief projectPoints() on points stored as x, y and z streams
+	* @param ppPoints the x, y and z streams of the points
+	* @param ppResults the x, y and z streams of the projected points, may be ppPoints
+	* @param iNb the number of points
+	* @param pJobSystem spreads large batches over its workers, may be NULL
+	*/
+	void Matrix4x4::projectPoints( const float* const ppPoints[ 3 ], float* const ppResults[ 3 ], int iNb, JobSystem* pJobSystem ) const
+	{
+		TransformBatch oBatch = makeTransformBatch( m, TRANSFORM_PROJECT, ppPoints, ppResults );
+		runTransformBatch( oBatch, iNb, pJobSystem );
+	}
+
 	void Matrix4x4::rotationX( float radians )
 	{
 		float _cos = cos( radians ),
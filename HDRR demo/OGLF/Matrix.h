@@ -5,14 +5,22 @@
 #include <string>
 
 #include "Vec.h"
+#include "Simd.h"
 
 namespace Oglf
 {
+	class JobSystem;
+
+	/**
+	* class Matrix4x4 is a 4x4 float matrix. The products and the general inverse run on SSE, or AVX when the CPU
+	* supports it, on x86 targets, as do the batch transforms of point and vector arrays. The coefficients are 16 bytes aligned but the matrices allocated with operator new
+	* may only be 8 bytes aligned on 32 bits targets, so the SIMD code uses unaligned loads, as fast when aligned.
+	*/
 	class Matrix4x4
 	{
 	public:
 
-		float m[16]; // Opengl compliant matrix that is internally stored in gl
+		OGLF_ALIGN( 16 ) float m[16]; // Opengl compliant matrix that is internally stored in gl
 		// column-major order. (16 consecutive floats)
 		// Nevertheless, the overloded (,) operator accesses the coefficients
 		// in the mathematical style row-major order.
@@ -39,6 +47,79 @@ namespace Oglf
 		void resetScaleAndRotation();
 		void resetTranslation();
 		void invert();
+
+		/**
+		* @brief inverts a matrix whose last row is 0 0 0 1: inverts its 3x3 part and transforms the opposite
+		* of its translation
+		*/
+		void invertAffine();
+
+		/**
+		* @brief inverts a rotation and translation matrix: transposes its rotation and transforms the opposite
+		* of its translation. The matrix must not scale.
+		*/
+		void invertRigid();
+
+		/**
+		* @brief returns whether the last row of the matrix is 0 0 0 1
+		* @return true if invertAffine() can invert the matrix
+		*/
+		bool isAffine() const;
+
+		/**
+		* @brief transforms points v[x,y,z,1] without w-divide, as the product with a Vec3 does
+		* @param pPoints the points
+		* @param pResults the transformed points, may be pPoints
+		* @param iNb the number of points
+		* @param pJobSystem spreads large batches over its workers, may be NULL
+		*/
+		void transformPoints( const Vec3* pPoints, Vec3* pResults, int iNb, JobSystem* pJobSystem = NULL ) const;
+
+		/**
+		* @brief transforms vectors v[x,y,z,0]: the translation is ignored
+		* @param pVectors the vectors
+		* @param pResults the transformed vectors, may be pVectors
+		* @param iNb the number of vectors
+		* @param pJobSystem spreads large batches over its workers, may be NULL
+		*/
+		void transformVectors( const Vec3* pVectors, Vec3* pResults, int iNb, JobSystem* pJobSystem = NULL ) const;
+
+		/**
+		* @brief transforms points v[x,y,z,1] and w-divides them, as the + operator does
+		* @param pPoints the points
+		* @param pResults the projected points, may be pPoints
+		* @param iNb the number of points
+		* @param pJobSystem spreads large batches over its workers, may be NULL
+		*/
+		void projectPoints( const Vec3* pPoints, Vec3* pResults, int iNb, JobSystem* pJobSystem = NULL ) const;
+
+		/**
+		* @brief transformPoints() on points stored as x, y and z streams
+		* @param ppPoints the x, y and z streams of the points
+		* @param ppResults the x, y and z streams of the transformed points, may be ppPoints
+		* @param iNb the number of points
+		* @param pJobSystem spreads large batches over its workers, may be NULL
+		*/
+		void transformPoints( const float* const ppPoints[ 3 ], float* const ppResults[ 3 ], int iNb, JobSystem* pJobSystem = NULL ) const;
+
+		/**
+		* @brief transformVectors() on vectors stored as x, y and z streams
+		* @param ppVectors the x, y and z streams of the vectors
+		* @param ppResults the x, y and z streams of the transformed vectors, may be ppVectors
+		* @param iNb the number of vectors
+		* @param pJobSystem spreads large batches over its workers, may be NULL
+		*/
+		void transformVectors( const float* const ppVectors[ 3 ], float* const ppResults[ 3 ], int iNb, JobSystem* pJobSystem = NULL ) const;
+
+		/**
+		* @brief projectPoints() on points stored as x, y and z streams
+		* @param ppPoints the x, y and z streams of the points
+		* @param ppResults the x, y and z streams of the projected points, may be ppPoints
+		* @param iNb the number of points
+		* @param pJobSystem spreads large batches over its workers, may be NULL
+		*/
+		void projectPoints( const float* const ppPoints[ 3 ], float* const ppResults[ 3 ], int iNb, JobSystem* pJobSystem = NULL ) const;
+
 		void rotationX( float radians );
 		void rotationY( float radians );
 		void rotationZ( float radians );
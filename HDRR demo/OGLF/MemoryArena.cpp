@@ -0,0 +1,97 @@
+#include "MemoryArena.h"
+
+namespace Oglf
+{
+	/**
+	* @brief constructor, no memory is allocated until the first allocation or reservation
+	* @param iChunkSize the default size of the chunks in bytes
+	* @param eCategory the category the chunks are accounted in
+	*/
+	MemoryArena::MemoryArena( size_t iChunkSize, MemoryCategory eCategory )
+		: m_pChunk( NULL )
+		, m_iChunkSize( iChunkSize )
+		, m_eCategory( eCategory )
+		, m_iUsedSize( 0 )
+		, m_iReservedSize( 0 )
+		, m_iPeakSize( 0 )
+		, m_iChunkNb( 0 )
+	{
+	}
+
+	/**
+	* @brief destructor, frees all the chunks
+	*/
+	MemoryArena::~MemoryArena()
+	{
+		release();
+	}
+
+	/**
+	* @brief allocates a new chunk allocations are taken from
+	* @param iSize the minimum chunk size in bytes
+	*/
+	void MemoryArena::addChunk( size_t iSize )
+	{
+		if( iSize < m_iChunkSize )
+			iSize = m_iChunkSize;
+
+		Chunk* pChunk = ( Chunk* )MemoryTracker::allocate( sizeof( Chunk ) + iSize, m_eCategory );
+		pChunk->pPrevious = m_pChunk;
+		pChunk->iSize = iSize;
+		pChunk->iUsed = 0;
+		m_pChunk = pChunk;
+
+		m_iReservedSize += pChunk->iSize;
+		if( m_iReservedSize > m_iPeakSize )
+			m_iPeakSize = m_iReservedSize;
+		++m_iChunkNb;
+	}
+
+	/**
+	* @brief makes sure that the next allocations of at most iSize bytes in total fit in the current chunk
+	* @param iSize the size in bytes
+	*/
+	void MemoryArena::reserve( size_t iSize )
+	{
+		if( m_pChunk == NULL || m_pChunk->iSize - m_pChunk->iUsed < iSize )
+			addChunk( iSize );
+	}
+
+	/**
+	* @brief allocates memory, throws std::bad_alloc on failure
+	* @param iSize the size in bytes
+	* @param iAlignment the alignment, a power of 2 not larger than 16
+	* @return the allocated memory
+	*/
+	void* MemoryArena::allocate( size_t iSize, size_t iAlignment )
+	{
+		// the chunks memory alignment depends on the header size, the worst case padding is reserved
+		reserve( iSize + iAlignment - 1 );
+
+		char* pMemory = ( char* )( m_pChunk + 1 );
+		size_t iOffset = ( size_t )( pMemory + m_pChunk->iUsed );
+		size_t iPadding = ( iAlignment - ( iOffset & ( iAlignment - 1 ) ) ) & ( iAlignment - 1 );
+
+		void* pData = pMemory + m_pChunk->iUsed + iPadding;
+		m_pChunk->iUsed += iPadding + iSize;
+		m_iUsedSize += iPadding + iSize;
+
+		return pData;
+	}
+
+	/**
+	* @brief frees all the chunks at once, the memory allocated from the arena must not be used anymore
+	*/
+	void MemoryArena::release()
+	{
+		while( m_pChunk != NULL )
+		{
+			Chunk* pPrevious = m_pChunk->pPrevious;
+			MemoryTracker::deallocate( m_pChunk );
+			m_pChunk = pPrevious;
+		}
+
+		m_iUsedSize = 0;
+		m_iReservedSize = 0;
+	}
+}
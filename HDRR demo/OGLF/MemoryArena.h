@@ -0,0 +1,128 @@
+#ifndef MEMORYARENA_H
+#define MEMORYARENA_H
+
+#include <cstddef>
+#include <new>
+#include "Core.h"
+
+namespace Oglf
+{
+	/**
+	* class MemoryArena is a linear allocator for temporary data: allocations are taken one after the other
+	* from large chunks and are never freed individually, all the chunks are freed at once by release() or
+	* by the destructor. Only objects with trivial destructors should be allocated in an arena.
+	*/
+	class MemoryArena
+	{
+		/**
+		* @brief header of a chunk, followed by its memory
+		*/
+		struct Chunk
+		{
+			Chunk*	pPrevious;
+			size_t	iSize;		// chunk memory size, header excluded
+			size_t	iUsed;
+		};
+
+		Chunk*			m_pChunk;		// the chunk allocations are taken from, the other ones are linked from it
+		size_t			m_iChunkSize;
+		MemoryCategory	m_eCategory;
+		size_t			m_iUsedSize;
+		size_t			m_iReservedSize;
+		size_t			m_iPeakSize;
+		unsigned int	m_iChunkNb;
+
+		void addChunk( size_t iSize );
+
+		// not copyable, the chunks are owned by the arena
+		MemoryArena( const MemoryArena& );
+		MemoryArena& operator=( const MemoryArena& );
+
+	public:
+
+		/**
+		* @brief constructor, no memory is allocated until the first allocation or reservation
+		* @param iChunkSize the default size of the chunks in bytes
+		* @param eCategory the category the chunks are accounted in
+		*/
+		MemoryArena( size_t iChunkSize = 1 << 20, MemoryCategory eCategory = MEMORY_OTHER );
+
+		/**
+		* @brief destructor, frees all the chunks
+		*/
+		~MemoryArena();
+
+		/**
+		* @brief makes sure that the next allocations of at most iSize bytes in total fit in the current chunk
+		* @param iSize the size in bytes
+		*/
+		void reserve( size_t iSize );
+
+		/**
+		* @brief allocates memory, throws std::bad_alloc on failure
+		* @param iSize the size in bytes
+		* @param iAlignment the alignment, a power of 2 not larger than 16
+		* @return the allocated memory
+		*/
+		void* allocate( size_t iSize, size_t iAlignment = 16 );
+
+		/**
+		* @brief allocates and default constructs an array
+		* @param iCount the number of elements
+		* @return the array
+		*/
+		template< typename T >
+		T* allocateArray( size_t iCount )
+		{
+			T* pArray = ( T* )allocate( iCount * sizeof( T ) );
+
+			for( size_t i = 0; i < iCount; ++i )
+				new( pArray + i ) T();
+
+			return pArray;
+		}
+
+		/**
+		* @brief frees all the chunks at once, the memory allocated from the arena must not be used anymore
+		*/
+		void release();
+
+		/**
+		* @brief returns the memory allocated from the arena since the last release
+		* @return the size in bytes
+		*/
+		size_t getUsedSize() const
+		{
+			return m_iUsedSize;
+		}
+
+		/**
+		* @brief returns the memory of all the chunks
+		* @return the size in bytes
+		*/
+		size_t getReservedSize() const
+		{
+			return m_iReservedSize;
+		}
+
+		/**
+		* @brief returns the highest memory the chunks have used at once
+		* @return the size in bytes
+		*/
+		size_t getPeakSize() const
+		{
+			return m_iPeakSize;
+		}
+
+		/**
+		* @brief returns the number of chunks allocated since the arena creation
+		* @return the number of chunks
+		*/
+		unsigned int getChunkCount() const
+		{
+			return m_iChunkNb;
+		}
+	};
+}
+
+#endif /* MEMORYARENA_H */
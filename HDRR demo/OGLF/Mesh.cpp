@@ -3,7 +3,9 @@
 #include <string>
 #include <vector>
 #include <set>
+#include <map>
 #include <cstdlib>
+#include <cstring>
 #include "Error.h"
 #include "utils.h"
 
@@ -13,9 +15,13 @@ namespace Oglf
 {
 	/**
 	* @brief center the pivot to the object center
+	* @param pJobSystem spreads the translation of large meshes over its workers, may be NULL
 	*/
-	void Mesh::centerPivotToObjectCenter()
+	void Mesh::centerPivotToObjectCenter( JobSystem* pJobSystem )
 	{
+		if( vertices.empty() )
+			return;
+
 		Vec3 pivot;
 
 		for(int i=0; i<(int)vertices.size(); i++)
@@ -24,83 +30,106 @@ namespace Oglf
 		}
 		pivot= pivot/(float)vertices.size();
 
-		for(int i=0; i<(int)vertices.size(); i++)
-		{
-			vertices[i] -= pivot;
-		}
+		Vec3 oOffset = -pivot;
+		Matrix4x4 oTranslation;
+		oTranslation.translate( oOffset );
+		oTranslation.transformPoints( &vertices[0], &vertices[0], (int)vertices.size(), pJobSystem );
+
+		bBox->build( pJobSystem );
 	}
 
 	/**
 	* @brief scales the x,y and z vertices position components between -limit and +limit
 	* @param limit x, y and z components will stuck in the range [-limit +limit]
+	* @param pJobSystem spreads the scale of large meshes over its workers, may be NULL
 	*/
-	void Mesh::boundSize(float limit)
+	void Mesh::boundSize(float limit, JobSystem* pJobSystem)
 	{
+		if( vertices.empty() )
+			return;
+
 		float ScaleFactor= limit / maxT(maxT(bBox->maxX, bBox->maxY), bBox->maxZ);
 
-		for(int i=0; i<(int)vertices.size(); i++)
-		{
-			vertices[i] *= ScaleFactor;
-		}
+		Matrix4x4 oScale;
+		oScale.scale( ScaleFactor );
+		oScale.transformPoints( &vertices[0], &vertices[0], (int)vertices.size(), pJobSystem );
 
-		bBox->build();
+		bBox->build( pJobSystem );
 	}
 
 	/**
 	* @brief create all faces tangent spaces
+	* @param oArena the arena the faces tangent spaces are allocated from
+	* @param oFaces the faces tangent spaces
 	*/
-	void Mesh::createFacesTangentSpaces()
+	void Mesh::createFacesTangentSpaces( MemoryArena& oArena, FacesTangentSpaces& oFaces )
 	{
-		Vec3 v0, v1, v2; // a 3D vector that stores each face (triangles) vertices
-		Vec3 edge1, edge2; // two edges of a face
-		float dS1, dS2; // variation along edge 1 and 2  of the S texture coordinates component
-		float dT1, dT2; // variation along edge 1 and 2  of the T texture coordinates component
-		float detInv;
-		Vec3  normal, tangent, binormal; // to store each face normal, tangent and binormal
+		const int iPacketSize = Vec3x4::SIZE; // faces processed at once
+		Vec3 pV0[ iPacketSize ], pV1[ iPacketSize ], pV2[ iPacketSize ]; // each face vertices
+		float pDS1[ iPacketSize ], pDS2[ iPacketSize ]; // variation along edge 1 and 2  of the S texture coordinates component
+		float pDT1[ iPacketSize ], pDT2[ iPacketSize ]; // variation along edge 1 and 2  of the T texture coordinates component
 		int progress; // computation progress (percent)
+		int iFaceNb = (int)vertIndices.size() / 3;
 
-		// run through each face and find its tangent space
+		oFaces.pNormals = oArena.allocateArray< Vec3 >( iFaceNb );
+		oFaces.pTangents = oArena.allocateArray< Vec3 >( iFaceNb );
+		oFaces.pBinormals = oArena.allocateArray< Vec3 >( iFaceNb );
+
+		// run through the faces by packets and find their tangent spaces
 		//
-		for(int i=0; i<(int)vertIndices.size(); i+=3)
+		for(int iFirstFace=0; iFirstFace<iFaceNb; iFirstFace+=iPacketSize)
 		{
+			int iNb = minT( iPacketSize, iFaceNb - iFirstFace );
+
 			// show progress in console
-			if (i%100==0)
+			if ((iFirstFace & 0xFFFF)==0)
 			{
-				progress=(int)(100.0*(float)i/(float)vertices.size());
+				progress=(int)(100.0*(float)iFirstFace/(float)iFaceNb);
 				cout<<"Computing tangent spaces..."<<progress<<"% \r"<<flush;
 			}
 
-			// storing each face vertices
-			v0 = vertices[vertIndices[i]];
-			v1 = vertices[vertIndices[i+1]];
-			v2 = vertices[vertIndices[i+2]];
+			// gathering each face vertices and texture coordinates variations, the lanes past the last face are zeros
+			for(int j=0; j<iPacketSize; j++)
+			{
+				pDS1[j] = pDS2[j] = pDT1[j] = pDT2[j] = 0.f;
+				if(j >= iNb)
+					continue;
+
+				int i = 3 * (iFirstFace + j);
+				pV0[j] = vertices[vertIndices[i]];
+				pV1[j] = vertices[vertIndices[i+1]];
+				pV2[j] = vertices[vertIndices[i+2]];
+
+				pDS1[j]= uv[2*uvIndices[i+1]] - uv[2*uvIndices[i]];
+				pDS2[j]= uv[2*uvIndices[i+2]] - uv[2*uvIndices[i]];
+
+				pDT1[j]= uv[2*uvIndices[i+1]+1] - uv[2*uvIndices[i]+1];
+				pDT2[j]= uv[2*uvIndices[i+2]+1] - uv[2*uvIndices[i]+1];
+			}
+
+			Vec3x4 v0 = Vec3x4::load( pV0, iNb );
 
 			// calculate 2 edges in order to compute their cross product which is the face normal
-			edge1= v1-v0;
-			edge2= v2-v0;
-			normal= edge1^edge2; // cross product gives face normal
+			Vec3x4 edge1 = Vec3x4::load( pV1, iNb ) - v0;
+			Vec3x4 edge2 = Vec3x4::load( pV2, iNb ) - v0;
+			Vec3x4 normal = edge1 ^ edge2; // cross product gives face normal
 			normal.normalize();
 
 			// storing all normals in an array
-			facesNormals.push_back(normal);
+			normal.store( oFaces.pNormals + iFirstFace, iNb );
 
 			// computing tangent spaces at each face
-			dS1= uv[2*uvIndices[i+1]] - uv[2*uvIndices[i]];
-			dS2= uv[2*uvIndices[i+2]] - uv[2*uvIndices[i]];
+			Float4 dS1 = Float4::load( pDS1 ), dS2 = Float4::load( pDS2 );
+			Float4 dT1 = Float4::load( pDT1 ), dT2 = Float4::load( pDT2 );
 
-			dT1= uv[2*uvIndices[i+1]+1] - uv[2*uvIndices[i]+1];
-			dT2= uv[2*uvIndices[i+2]+1] - uv[2*uvIndices[i]+1];
-
-			detInv= 1.f/(dS1 * dT2 - dS2 * dT1);
-
-			tangent= (dT2 * edge1 - dT1 * edge2);
-			binormal= (dS1 * edge2 - dS2 * edge1);
+			Vec3x4 tangent = dT2 * edge1 - dT1 * edge2;
+			Vec3x4 binormal = dS1 * edge2 - dS2 * edge1;
 
 			tangent.normalize();
 			binormal.normalize();
 
-			facesTangents.push_back(tangent);
-			facesBinormals.push_back(binormal);
+			tangent.store( oFaces.pTangents + iFirstFace, iNb );
+			binormal.store( oFaces.pBinormals + iFirstFace, iNb );
 		}
 
 		cout<<"Computing tangent spaces...100%"<<endl;
@@ -109,36 +138,59 @@ namespace Oglf
 	/**
 	* @brief Computes vertices normals interpolating the face normals of each face that uses one vertex.
 	* Then computes the tangent and the binormal using the normal
+	* @param oArena the arena temporary data are allocated from
+	* @param oFaces the faces tangent spaces
 	*/
-	void Mesh::createVerticesTangentSpace()
+	void Mesh::createVerticesTangentSpace( MemoryArena& oArena, const FacesTangentSpaces& oFaces )
 	{
-		// an array of vector that stores the faces indices that use a vertex for each vertex
-		vector<int>* facesCreated= new vector<int>[vertices.size()];
+		int iVertexNb = (int)vertices.size();
+		int iIndexNb = (int)vertIndices.size();
 		Vec3 normal, tangent, binormal;
 		int progress; // computation progress (percent)
 
-		for (int i=0; i<(int)vertIndices.size(); i++)
+		// the faces that use each vertex, stored one vertex after the other: the faces of vertex i
+		// are pFaces[pFirstFace[i]] to pFaces[pFirstFace[i+1]-1], in the order they are declared
+		int* pFirstFace = oArena.allocateArray< int >( iVertexNb + 1 );
+		int* pNextFace = oArena.allocateArray< int >( iVertexNb );
+		int* pFaces = oArena.allocateArray< int >( iIndexNb );
+
+		for (int i=0; i<iIndexNb; i++)
 		{
-			facesCreated[vertIndices[i]].push_back(i/3);
+			pFirstFace[vertIndices[i]+1]++;
 		}
 
-		for (int i=0; i<(int)vertices.size(); i++)
+		for (int i=0; i<iVertexNb; i++)
 		{
-			if (i%100==0)
+			pFirstFace[i+1] += pFirstFace[i];
+			pNextFace[i] = pFirstFace[i];
+		}
+
+		for (int i=0; i<iIndexNb; i++)
+		{
+			pFaces[pNextFace[vertIndices[i]]++] = i/3;
+		}
+
+		vertNormals.resize(iVertexNb);
+		vertTangents.resize(iVertexNb);
+		vertBinormals.resize(iVertexNb);
+
+		for (int i=0; i<iVertexNb; i++)
+		{
+			if ((i & 0xFFFF)==0)
 			{
-				progress=(int)(100.0*(float)i/(float)vertices.size());
+				progress=(int)(100.0*(float)i/(float)iVertexNb);
 				cout<<"Computing vertices tangents spaces..."<<progress<<"% \r"<<flush;
 			}
 
 			normal = tangent = binormal = Vec3();
 
-			for (int j=0; j<(int)facesCreated[i].size(); j++)
+			for (int j=pFirstFace[i]; j<pFirstFace[i+1]; j++)
 			{
-				normal   = normal   + facesNormals[facesCreated[i][j]];
+				normal   = normal   + oFaces.pNormals[pFaces[j]];
 
-				tangent  = tangent  + facesTangents[facesCreated[i][j]];
+				tangent  = tangent  + oFaces.pTangents[pFaces[j]];
 
-				binormal = binormal + facesBinormals[facesCreated[i][j]];
+				binormal = binormal + oFaces.pBinormals[pFaces[j]];
 			}
 			normal.normalize();
 			tangent.normalize();
@@ -151,31 +203,129 @@ namespace Oglf
 			binormal = Vec3();
 			/*		}*/
 
-			vertNormals.push_back(normal);
-			vertTangents.push_back(tangent);
-			vertBinormals.push_back(binormal);
+			vertNormals[i] = normal;
+			vertTangents[i] = tangent;
+			vertBinormals[i] = binormal;
 		}
 
 		cout<<"Computing vertices tangents spaces...100%"<<endl;
 	}
 
-	//find slash slash == //
-	bool findSS(char*s, int length)
+	/**
+	* @brief skips the spaces of a line
+	* @param pChar the first character
+	* @return the first character that is not a space or the line end
+	*/
+	static char* skipSpaces( char* pChar )
+	{
+		while( *pChar == ' ' || *pChar == '\t' || *pChar == '\r' )
+			++pChar;
+
+		return pChar;
+	}
+
+	/**
+	* @brief skips a word
+	* @param pChar the first character of the word
+	* @return the character following the word
+	*/
+	static char* skipWord( char* pChar )
+	{
+		while( *pChar != '\0' && *pChar != ' ' && *pChar != '\t' && *pChar != '\r' )
+			++pChar;
+
+		return pChar;
+	}
+
+	/**
+	* @brief compares a word to an obj command
+	* @param pWord the word
+	* @param iLength the word length
+	* @param sCommand the command
+	* @return true if the word is the command
+	*/
+	static bool isCommand( const char* pWord, size_t iLength, const char* sCommand )
 	{
-		char* c=s;
-		int i=0;
+		return iLength == strlen( sCommand ) && strncmp( pWord, sCommand, iLength ) == 0;
+	}
+
+	/**
+	* class ObjLineReader reads a file line by line through a buffer allocated from an arena
+	*/
+	class ObjLineReader
+	{
+		ifstream&	m_oFile;
+		string		m_sFilename;
+		char*		m_pBuffer;
+		size_t		m_iBufferSize;
+		char*		m_pLine;	// the next line
+		char*		m_pEnd;		// the end of the data read in the buffer
+
+	public:
+
+		/**
+		* @brief constructor
+		* @param oFile the file
+		* @param sFilename the file name
+		* @param oArena the arena the buffer is allocated from
+		* @param iBufferSize the buffer size, the longest line must fit in it
+		*/
+		ObjLineReader( ifstream& oFile, const string& sFilename, MemoryArena& oArena, size_t iBufferSize )
+			: m_oFile( oFile )
+			, m_sFilename( sFilename )
+			, m_pBuffer( ( char* )oArena.allocate( iBufferSize + 1 ) )
+			, m_iBufferSize( iBufferSize )
+		{
+			rewind();
+		}
+
+		/**
+		* @brief goes back to the beginning of the file
+		*/
+		void rewind()
+		{
+			m_oFile.clear();
+			m_oFile.seekg( 0, ios::beg );
+			m_pLine = m_pEnd = m_pBuffer;
+		}
 
-		while (i<length)
+		/**
+		* @brief returns the next line
+		* @return the line without its end of line character, NULL at the end of the file
+		*/
+		char* nextLine()
 		{
-			//cout<<*(c+i)<<"-";
-			if (*(c+i)=='/')
+			for( ;; )
 			{
-				return true;
+				char* pLineEnd = ( char* )memchr( m_pLine, '\n', m_pEnd - m_pLine );
+
+				if( pLineEnd != NULL || ( !m_oFile && m_pLine < m_pEnd ) )
+				{
+					char* pLine = m_pLine;
+
+					if( pLineEnd == NULL )
+						pLineEnd = m_pEnd;
+
+					*pLineEnd = '\0';
+					m_pLine = pLineEnd < m_pEnd ? pLineEnd + 1 : m_pEnd;
+					return pLine;
+				}
+
+				if( !m_oFile )
+					return NULL;
+
+				// moves the incomplete line to the beginning of the buffer and fills the rest
+				size_t iLineLength = m_pEnd - m_pLine;
+				if( iLineLength == m_iBufferSize )
+					throw Error( "Mesh::importOBJ error : Line too long", m_sFilename );
+
+				memmove( m_pBuffer, m_pLine, iLineLength );
+				m_oFile.read( m_pBuffer + iLineLength, m_iBufferSize - iLineLength );
+				m_pLine = m_pBuffer;
+				m_pEnd = m_pBuffer + iLineLength + m_oFile.gcount();
 			}
-			i++;
 		}
-		return false;
-	}
+	};
 
 	/**
 	* @brief Loads a obj file
@@ -183,123 +333,135 @@ namespace Oglf
 	*/
 	void Mesh::importOBJ( const string& sFilename )
 	{
-		ifstream oObjFile( sFilename.c_str(), ios::in );
+		ifstream oObjFile( sFilename.c_str(), ios::in | ios::binary );
 		if ( !oObjFile )
 		{
 			throw Error( "Mesh::importOBJ error : Failed to open the obj file", sFilename );
 		}
 		cout << "Importing OBJ file: " << sFilename << endl;
 
-		string sCom;
-		float fVal;
+		oObjFile.seekg( 0, ios::end );
+		size_t iFileSize = (size_t)oObjFile.tellg();
+
+		// all the import temporary data are allocated from an arena freed at once when the mesh is finalized.
+		// An obj triangle with its share of vertices and texture coordinates takes about 60 bytes in the file
+		// and the tangent spaces computation needs 3 face vectors and about 4 indices per triangle: the first
+		// chunk is reserved from the file size for the read buffer and these data, it grows when the file is denser.
+		const size_t iBufferSize = minT< size_t >( iFileSize + 1, 1 << 20 );
+		size_t iEstimatedFaceNb = iFileSize / 60;
+		MemoryArena oArena( 1 << 20, MEMORY_MESH );
+		oArena.reserve( iBufferSize + 1 + iEstimatedFaceNb * ( 3 * sizeof( Vec3 ) + 4 * sizeof( int ) ) + 256 );
+
+		ObjLineReader oReader( oObjFile, sFilename, oArena, iBufferSize );
+		char* pLine;
+
+		// counts the elements first, so that the mesh arrays are allocated once
+		size_t iVertexNb = 0, iUvNb = 0, iFaceNb = 0;
+
+		while ( ( pLine = oReader.nextLine() ) != NULL )
+		{
+			char* pCom = skipSpaces( pLine );
+			size_t iComLength = skipWord( pCom ) - pCom;
+
+			if ( isCommand( pCom, iComLength, "v" ) )
+				++iVertexNb;
+			else if ( isCommand( pCom, iComLength, "vt" ) )
+				++iUvNb;
+			else if ( isCommand( pCom, iComLength, "f" ) )
+				++iFaceNb;
+		}
+
+		vertices.reserve( vertices.size() + iVertexNb );
+		uv.reserve( uv.size() + 2 * iUvNb );
+		vertIndices.reserve( vertIndices.size() + 3 * iFaceNb );
+		uvIndices.reserve( uvIndices.size() + 3 * iFaceNb );
+
+		oReader.rewind();
 
-		while ( !oObjFile.eof() )
+		while ( ( pLine = oReader.nextLine() ) != NULL )
 		{
-			oObjFile >> sCom;
-			//cout<<com;
+			char* pCom = skipSpaces( pLine );
+			char* pChar = skipWord( pCom );
+			size_t iComLength = pChar - pCom;
 
-			if ( !oObjFile.eof() && sCom !="v" && sCom != "vn" && sCom != "vt" && sCom != "f"
-				&& sCom != "g" && sCom != "s" && sCom != "#" && sCom != "usemtl"
-				&& sCom != "mtllib" )
+			if ( iComLength == 0 || *pCom == '#' || isCommand( pCom, iComLength, "vn" ) || isCommand( pCom, iComLength, "g" )
+				|| isCommand( pCom, iComLength, "s" ) || isCommand( pCom, iComLength, "usemtl" ) || isCommand( pCom, iComLength, "mtllib" ) )
 			{
-				//cout << "com: " << sCom << endl;
-				throw Error( "Mesh::importOBJ error : Bad format", sFilename );
+				// ignored
 			}
-
-			if ( sCom == "v" )
+			else if ( isCommand( pCom, iComLength, "v" ) )
 			{
-				//cout<<"v"<<endl;
 				Vec3 oVec;
-				oObjFile >> oVec.v[0]; oObjFile >> oVec.v[1]; oObjFile >> oVec.v[2];
+				oVec.v[0] = (float)strtod( pChar, &pChar );
+				oVec.v[1] = (float)strtod( pChar, &pChar );
+				oVec.v[2] = (float)strtod( pChar, &pChar );
 
 				vertices.push_back( oVec );
 			}
-			if (sCom=="vt")
+			else if ( isCommand( pCom, iComLength, "vt" ) )
 			{
-				//cout<<"vt"<<endl;
-				oObjFile>>fVal;
-				uv.push_back(fVal);
-				oObjFile>>fVal;
-				uv.push_back(fVal);
-
-				getline(oObjFile, sCom);
-				sCom.clear();
+				uv.push_back( (float)strtod( pChar, &pChar ) );
+				uv.push_back( (float)strtod( pChar, &pChar ) );
 			}
-			if (sCom=="f")
+			else if ( isCommand( pCom, iComLength, "f" ) )
 			{
-				//cout<<"f"<<endl;
-				string s;
-
-				for (int i=0; i<3; i++)
+				// v, v/vt, v//vn or v/vt/vn
+				for ( int i = 0; i < 3; i++ )
 				{
-					oObjFile>>s;
-
-					if (!s.empty())
-					{
-						char* index=(char*)s.c_str();
-						char* word;
+					pChar = skipSpaces( pChar );
+					if ( *pChar == '\0' )
+						throw Error( "Mesh::importOBJ error : Bad format", sFilename );
 
-						//cout<<"chaine "<<index<<endl;
-						word = strtok(index, "/");
-						vertIndices.push_back(atoi(word)-1);
+					vertIndices.push_back( strtol( pChar, &pChar, 10 ) - 1 );
 
-						word = strtok(NULL, "/");
-
-						if (!findSS(index, s.size()))
-						{
-							//cout<<"coord de tex"<<endl;
-							uvIndices.push_back(atoi(word)-1);
-
-							word = strtok(NULL, "/");
-						}
+					if ( *pChar == '/' )
+					{
+						++pChar;
+						if ( *pChar != '/' )
+							uvIndices.push_back( strtol( pChar, &pChar, 10 ) - 1 );
 					}
+					pChar = skipWord( pChar );
 				}
-			}
 
-			if (sCom=="vn")
-			{
-				//cout<<"vn"<<endl;
-				getline(oObjFile, sCom);
-				sCom.clear();
-			}
-			if (sCom=="g")
-			{
-				//cout<<"g"<<endl;
-				getline(oObjFile, sCom);
-				sCom.clear();
-			}
-			if (sCom=="s")
-			{
-				//cout<<"s"<<endl;
-				getline(oObjFile, sCom);
-				sCom.clear();
+				if ( *skipSpaces( pChar ) != '\0' )
+					throw Error( "Mesh::importOBJ error : Only triangle faces are supported", sFilename );
 			}
-			if (sCom=="#")
+			else
 			{
-				//cout<<"#"<<endl;
-				getline(oObjFile, sCom);
-				sCom.clear();
+				throw Error( "Mesh::importOBJ error : Bad format", sFilename );
 			}
-			if (sCom=="usemtl" || sCom=="mtllib")
-			{
+		}
 
-				//cout<<"usemtl"<<endl;
-				getline(oObjFile, sCom);
-				sCom.clear();
-			}
+		oObjFile.close();
+
+		if ( uvIndices.size() != vertIndices.size() )
+		{
+			throw Error( "Mesh::importOBJ error : Faces without texture coordinates are not supported", sFilename );
 		}
 
+		FacesTangentSpaces oFaces;
+
 		this->bBox->build();
-		this->createFacesTangentSpaces();
-		this->createVerticesTangentSpace();
+		this->createFacesTangentSpaces( oArena, oFaces );
+		this->createVerticesTangentSpace( oArena, oFaces );
 
-		oObjFile.close();
+		cout << "Imported " << vertices.size() << " vertices and " << vertIndices.size() / 3 << " faces, "
+			<< oArena.getPeakSize() / 1024 << " KB of temporary data in " << oArena.getChunkCount() << " chunks" << endl;
 	}
 
 	void Mesh::prepareRenderableBatch()
 	{
-		m_iDlID = glGenLists( 1 );
-		glNewList( m_iDlID, GL_COMPILE );
+		setRenderableBatch( compileRenderableBatch() );
+	}
+
+	/**
+	* @brief compiles the mesh data in a display list, may be called with the shared context of an upload context
+	* @return the display list ID, to be set with setRenderableBatch() once the GL is done compiling it
+	*/
+	GLuint Mesh::compileRenderableBatch() const
+	{
+		GLuint iDlID = glGenLists( 1 );
+		glNewList( iDlID, GL_COMPILE );
 
 		glEnable( GL_NORMALIZE );
 
@@ -311,16 +473,106 @@ namespace Oglf
 
 			// smooth shading
 			glNormal3fv(vertNormals[vertIndices[i]].v);
-			//flat shading
-			//glNormal3fv(facesNormals[i/3].v);
 
 			glVertex3fv(vertices[vertIndices[i]].v);
 		}
 		glEnd();
 
-		glEnd();
-
 		glEndList();
+
+		return iDlID;
+	}
+
+	/**
+	* @brief destructor, the buffers of compileBuffers() are deleted
+	*/
+	Mesh::~Mesh()
+	{
+		delete bBox;
+
+		if( m_iVertexBuffer != 0 )
+		{
+			glDeleteBuffersARB( 1, &m_iVertexBuffer );
+			glDeleteBuffersARB( 1, &m_iIndexBuffer );
+		}
+	}
+
+	/**
+	* @brief uploads the mesh data to a vertex and an index buffer, drawn by the instanced draws. The vertices
+	* sharing a position and texture coordinates are merged. Must be called with the GL context current.
+	*/
+	void Mesh::compileBuffers()
+	{
+		map< pair< int, int >, unsigned int > oVertexIDs;
+		vector< float > vVertexData;
+		vector< unsigned int > vIndices( vertIndices.size() );
+
+		for( size_t i = 0; i < vertIndices.size(); ++i )
+		{
+			pair< int, int > oKey( vertIndices[ i ], uvIndices[ i ] );
+			map< pair< int, int >, unsigned int >::iterator oIt = oVertexIDs.find( oKey );
+
+			if( oIt == oVertexIDs.end() )
+			{
+				unsigned int iID = ( unsigned int )oVertexIDs.size();
+				oIt = oVertexIDs.insert( make_pair( oKey, iID ) ).first;
+
+				const Vec3& oPosition = vertices[ oKey.first ];
+				const Vec3& oNormal = vertNormals[ oKey.first ];
+				vVertexData.insert( vVertexData.end(), oPosition.v, oPosition.v + 3 );
+				vVertexData.insert( vVertexData.end(), oNormal.v, oNormal.v + 3 );
+				vVertexData.push_back( uv[ 2 * oKey.second ] );
+				vVertexData.push_back( uv[ 2 * oKey.second + 1 ] );
+			}
+			vIndices[ i ] = oIt->second;
+		}
+
+		if( m_iVertexBuffer == 0 )
+		{
+			glGenBuffersARB( 1, &m_iVertexBuffer );
+			glGenBuffersARB( 1, &m_iIndexBuffer );
+		}
+		m_iIndexNb = ( int )vIndices.size();
+
+		glBindBufferARB( GL_ARRAY_BUFFER_ARB, m_iVertexBuffer );
+		glBufferDataARB( GL_ARRAY_BUFFER_ARB, vVertexData.size() * sizeof( float ), vVertexData.empty() ? NULL : &vVertexData[ 0 ], GL_STATIC_DRAW_ARB );
+		glBindBufferARB( GL_ARRAY_BUFFER_ARB, 0 );
+
+		glBindBufferARB( GL_ELEMENT_ARRAY_BUFFER_ARB, m_iIndexBuffer );
+		glBufferDataARB( GL_ELEMENT_ARRAY_BUFFER_ARB, vIndices.size() * sizeof( unsigned int ), vIndices.empty() ? NULL : &vIndices[ 0 ], GL_STATIC_DRAW_ARB );
+		glBindBufferARB( GL_ELEMENT_ARRAY_BUFFER_ARB, 0 );
+	}
+
+	/**
+	* @brief binds the buffers of compileBuffers() as the vertex, normal and texture coordinates arrays and the
+	* element array
+	*/
+	void Mesh::bindBuffers() const
+	{
+		const GLsizei iStride = 8 * sizeof( float ); // position, normal, texture coordinates
+
+		glBindBufferARB( GL_ARRAY_BUFFER_ARB, m_iVertexBuffer );
+		glBindBufferARB( GL_ELEMENT_ARRAY_BUFFER_ARB, m_iIndexBuffer );
+
+		glEnableClientState( GL_VERTEX_ARRAY );
+		glEnableClientState( GL_NORMAL_ARRAY );
+		glEnableClientState( GL_TEXTURE_COORD_ARRAY );
+		glVertexPointer( 3, GL_FLOAT, iStride, ( const GLvoid* )0 );
+		glNormalPointer( GL_FLOAT, iStride, ( const GLvoid* )( 3 * sizeof( float ) ) );
+		glTexCoordPointer( 2, GL_FLOAT, iStride, ( const GLvoid* )( 6 * sizeof( float ) ) );
+	}
+
+	/**
+	* @brief unbinds the buffers and disables the arrays bound by bindBuffers()
+	*/
+	void Mesh::unbindBuffers() const
+	{
+		glDisableClientState( GL_VERTEX_ARRAY );
+		glDisableClientState( GL_NORMAL_ARRAY );
+		glDisableClientState( GL_TEXTURE_COORD_ARRAY );
+
+		glBindBufferARB( GL_ARRAY_BUFFER_ARB, 0 );
+		glBindBufferARB( GL_ELEMENT_ARRAY_BUFFER_ARB, 0 );
 	}
+}
 
-}
\ No newline at end of file
@@ -4,102 +4,57 @@
 #include <vector>
 #include <fstream>
 #include <math.h>
+#include <GL/glew.h>
 #include "Vec.h"
+#include "Matrix.h"
 #include "utils.h"
 #include "Object3D.h"
 #include "Namable.h"
+#include "Core.h"
+#include "MemoryArena.h"
+#include "RenderStats.h"
+#include "BoundingBox.h"
 
 
 namespace Oglf
 {
-	struct BoundingBox
-	{
-		float left, right; // planes parallel to Oyz
-		float front, back; // planes parallel to Oxy
-		float top, bottom; // planes parallel to Oxz
-		float maxX; // max absolute x value
-		float maxY; // max absolute y value
-		float maxZ; // max absolute z value
-		std::vector<Vec3>* vertices;
-
-		BoundingBox(std::vector<Vec3>& vertices)
-		{
-			this->vertices=&vertices;
-		}
-
-		void clear()
-		{
-			left  = (*vertices)[0].v[0]; right  = (*vertices)[0].v[0];
-			front = (*vertices)[0].v[2]; back   = (*vertices)[0].v[2];
-			top   = (*vertices)[0].v[1]; bottom = (*vertices)[0].v[1];
-		}
-
-		void build()
-		{
-			this->clear();
-			for (int i=0; i<(int)(*vertices).size(); i++)
-			{
-				if((*vertices)[i].v[0] <= left) {
-					left=(*vertices)[i].v[0];
-				}
-				else if((*vertices)[i].v[0] > right) {
-					right=(*vertices)[i].v[0];
-				}
-
-				if((*vertices)[i].v[2] <= back) {
-					back=(*vertices)[i].v[2];
-				}
-				else if((*vertices)[i].v[2] > front) {
-					front=(*vertices)[i].v[2];
-				}
-
-				if((*vertices)[i].v[1] <= bottom) {
-					bottom=(*vertices)[i].v[1];
-				}
-				else if((*vertices)[i].v[1] > top) {
-					top=(*vertices)[i].v[1];
-				}
-			}
-
-			maxX= Oglf::maxT<float>( fabs( left ),	fabs( right ) );
-			maxY= Oglf::maxT<float>( fabs( top ),	fabs( bottom ) );
-			maxZ= Oglf::maxT<float>( fabs( front ),	fabs( back ) );
-		}
-	};
+	typedef std::vector< float, CoreAllocator< float, MEMORY_MESH > >	MeshFloatArray;
+	typedef std::vector< int, CoreAllocator< int, MEMORY_MESH > >		MeshIntArray;
 
 	/**
 	* class Mesh
 	*/
-	class Mesh : public Object3D, public Namable
+	class Mesh : public Object3D, public Namable, public Core< MEMORY_MESH >
 	{
 	protected:
-		std::vector<Vec3> vertices; // vertices coordinates
-		std::vector<float> uv; // 2D texture coordinates
-		std::vector<Vec3> vertNormals;   // vertices normals
-		std::vector<Vec3> vertTangents;  // vertices tangents
-		std::vector<Vec3> vertBinormals; // vertices binormals
-		std::vector<Vec3> facesNormals; // face normals for flat shading
-		std::vector<Vec3> facesTangents; // tangents computed at each index
-		std::vector<Vec3> facesBinormals; // binormals computed at each index
-
-		std::vector<int> vertIndices; // vertices indices to build each face (triangles)
-		std::vector<int> uvIndices; // texture coordinates indices for each vertices index
+		MeshVec3Array vertices; // vertices coordinates
+		MeshFloatArray uv; // 2D texture coordinates
+		MeshVec3Array vertNormals;   // vertices normals
+		MeshVec3Array vertTangents;  // vertices tangents
+		MeshVec3Array vertBinormals; // vertices binormals
+
+		MeshIntArray vertIndices; // vertices indices to build each face (triangles)
+		MeshIntArray uvIndices; // texture coordinates indices for each vertices index
 		BoundingBox* bBox; // the mesh bounding box;
 
 		GLuint m_iDlID;
+		GLuint m_iVertexBuffer; // interleaved positions, normals and texture coordinates, for the instanced draws
+		GLuint m_iIndexBuffer;
+		int m_iIndexNb;
 
 	public:
 
 		Mesh( const std::string& sName )
 			: Namable( sName )
+			, m_iDlID( 0 )
+			, m_iVertexBuffer( 0 )
+			, m_iIndexBuffer( 0 )
+			, m_iIndexNb( 0 )
 		{
 			bBox= new BoundingBox(this->vertices);
 		}
 
-		virtual ~Mesh()
-		{
-			delete bBox;
-		}
+		virtual ~Mesh();
 
 		/**
 		* @brief Loads a obj file
@@ -110,39 +65,119 @@ namespace Oglf
 		/**
 		* @brief scales the x,y and z vertices position components between -limit and +limit
 		* @param limit x, y and z components will stuck in the range [-limit +limit]
+		* @param pJobSystem spreads the scale of large meshes over its workers, may be NULL
 		*/
-		void boundSize(float limit);
+		void boundSize(float limit, JobSystem* pJobSystem = NULL);
 
 		/**
 		* @brief Prepare mesh data for rendering
 		*/
 		void prepareRenderableBatch();
 
+		/**
+		* @brief compiles the mesh data in a display list, may be called with the shared context of an upload context
+		* @return the display list ID, to be set with setRenderableBatch() once the GL is done compiling it
+		*/
+		GLuint compileRenderableBatch() const;
+
+		/**
+		* @brief sets the display list drawing the mesh, nothing is drawn until it is set
+		* @param iDlID the display list ID returned by compileRenderableBatch()
+		*/
+		void setRenderableBatch( GLuint iDlID )
+		{
+			m_iDlID = iDlID;
+		}
+
+		/**
+		* @brief uploads the mesh data to a vertex and an index buffer, drawn by the instanced draws. The vertices
+		* sharing a position and texture coordinates are merged. Must be called with the GL context current.
+		*/
+		void compileBuffers();
+
+		/**
+		* @brief returns whether compileBuffers() was called
+		* @return true if the buffers exist
+		*/
+		bool hasBuffers() const
+		{
+			return m_iVertexBuffer != 0;
+		}
+
+		/**
+		* @brief binds the buffers of compileBuffers() as the vertex, normal and texture coordinates arrays and the
+		* element array
+		*/
+		void bindBuffers() const;
+
+		/**
+		* @brief unbinds the buffers and disables the arrays bound by bindBuffers()
+		*/
+		void unbindBuffers() const;
+
+		/**
+		* @brief returns the number of indices in the index buffer
+		* @return the number of indices, 3 per triangle
+		*/
+		int getIndexNb() const
+		{
+			return m_iIndexNb;
+		}
+
 		/**
 		* @brief draws the object
 		*/
 		virtual void draw()
 		{
+			if( m_iDlID == 0 )
+				return;
+
 			glCallList( m_iDlID );
+			RenderStats::addDrawCall( ( unsigned int )vertIndices.size() / 3 );
 		}
 
 		/**
 		* @brief center the pivot to the object center
+		* @param pJobSystem spreads the translation of large meshes over its workers, may be NULL
+		*/
+		virtual void centerPivotToObjectCenter( JobSystem* pJobSystem = NULL );
+
+		/**
+		* @brief returns the mesh bounding volumes, the box is kept up to date by the import, boundSize() and
+		* centerPivotToObjectCenter(), the sphere and the oriented box are built on demand
+		* @return the bounding volumes
 		*/
-		virtual void centerPivotToObjectCenter();
+		BoundingBox& getBoundingBox()
+		{
+			return *bBox;
+		}
 
 	private:
 
+		/**
+		* @brief the faces tangent spaces, only needed during the import
+		*/
+		struct FacesTangentSpaces
+		{
+			Vec3* pNormals;
+			Vec3* pTangents;
+			Vec3* pBinormals;
+		};
+
 		/**
 		* @brief create all faces tangent spaces
+		* @param oArena the arena the faces tangent spaces are allocated from
+		* @param oFaces the faces tangent spaces
 		*/
-		void createFacesTangentSpaces();
+		void createFacesTangentSpaces( MemoryArena& oArena, FacesTangentSpaces& oFaces );
 
 		/**
 		* @brief Computes vertices normals interpolating the face normals of each face that uses one vertex.
 		* Then computes the tangent and the binormal using the normal
+		* @param oArena the arena temporary data are allocated from
+		* @param oFaces the faces tangent spaces
 		*/
-		void createVerticesTangentSpace();
+		void createVerticesTangentSpace( MemoryArena& oArena, const FacesTangentSpaces& oFaces );
 
 	};
 }
@@ -21,7 +21,23 @@
 #include "Texture.h"
 #include "CubeMap.h"
 #include "utils.h"
+#include "HalfFloat.h"
+#include "BC6H.h"
+#include "CompressedCubeMap.h"
+#include "TextureStreamer.h"
+#include "TextureResidencyManager.h"
+#include "MemoryArena.h"
+#include "Profiler.h"
 #include "TextureCopier.h"
 #include "HUD.h"
+#include "RenderStats.h"
+#include "PerformanceHud.h"
+#include "HeadlessContext.h"
+#include "CameraPath.h"
+#include "BenchmarkReport.h"
+#include "FrameCapture.h"
+#include "JobSystem.h"
+#include "UploadContext.h"
+#include "FrameState.h"
 
 #endif
@@ -11,9 +11,10 @@ namespace Oglf
 	{
 		bool m_transformable; // is the object transformable? default: false
 		GLtransformer3D m_transformer;
+		int m_iSceneNode; // the scene graph node bound to the object, -1 if none
 
 	public:
-		Object3D() : m_transformable(false)
+		Object3D() : m_transformable(false), m_iSceneNode(-1)
 		{
 
 		}
@@ -45,6 +46,24 @@ namespace Oglf
 			return m_transformer;
 		}
 
+		/**
+		* @brief returns the scene graph node bound to the object, whose world matrix places the object in the scene
+		* @return the node handle, -1 if the object is in no scene graph
+		*/
+		int getSceneNode() const
+		{
+			return m_iSceneNode;
+		}
+
+		/**
+		* @brief sets the scene graph node bound to the object
+		* @param iNode the node handle, -1 if the object is in no scene graph
+		*/
+		void setSceneNode(int iNode)
+		{
+			m_iSceneNode = iNode;
+		}
+
 		virtual void transform()
 		{
 			m_transformer.transform();
@@ -0,0 +1,463 @@
+#include <cstdio>
+#include <cstring>
+#include "PerformanceHud.h"
+#include "GLSLshaderProgram.h"
+#include "utils.h"
+
+namespace Oglf
+{
+	const int FONT_FIRST_CHAR = 32;		// the font covers the printable ASCII characters
+	const int FONT_CHAR_NB = 95;
+	const int FONT_WIDTH = 5;
+	const int FONT_HEIGHT = 7;
+	const int ATLAS_CELL_SIZE = 8;		// a glyph per cell, the cell after the last glyph is opaque for the rectangles
+	const int ATLAS_COLUMN_NB = 16;
+	const int ATLAS_WIDTH = 128;
+	const int ATLAS_HEIGHT = 64;
+	const int SOLID_CELL = FONT_CHAR_NB;
+
+	const int GRAPH_BAR_WIDTH = 2;			// in screen pixels
+	const int GRAPH_HEIGHT = 60;
+	const float GRAPH_MAX_TIME = 1000.f / 30.f;	// frame time at the top of the graph in ms
+	const float GRAPH_TARGET_TIME = 1000.f / 60.f;
+
+	// 5x7 glyphs of the characters 32 to 126, one byte per row from the top, the leftmost pixel is the 5th bit
+	static const unsigned char s_pFontGlyphs[ FONT_CHAR_NB ][ FONT_HEIGHT ] =
+	{
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// ' '
+		{ 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04 },	// '!'
+		{ 0x0A, 0x0A, 0x0A, 0x00, 0x00, 0x00, 0x00 },	// '"'
+		{ 0x0A, 0x0A, 0x1F, 0x0A, 0x1F, 0x0A, 0x0A },	// '#'
+		{ 0x04, 0x0F, 0x14, 0x0E, 0x05, 0x1E, 0x04 },	// '$'
+		{ 0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03 },	// '%'
+		{ 0x0C, 0x12, 0x14, 0x08, 0x15, 0x12, 0x0D },	// '&'
+		{ 0x04, 0x04, 0x08, 0x00, 0x00, 0x00, 0x00 },	// '''
+		{ 0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02 },	// '('
+		{ 0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08 },	// ')'
+		{ 0x00, 0x04, 0x15, 0x0E, 0x15, 0x04, 0x00 },	// '*'
+		{ 0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00 },	// '+'
+		{ 0x00, 0x00, 0x00, 0x00, 0x0C, 0x04, 0x08 },	// ','
+		{ 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00 },	// '-'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C },	// '.'
+		{ 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00 },	// '/'
+		{ 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E },	// '0'
+		{ 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E },	// '1'
+		{ 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F },	// '2'
+		{ 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E },	// '3'
+		{ 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 },	// '4'
+		{ 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E },	// '5'
+		{ 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E },	// '6'
+		{ 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 },	// '7'
+		{ 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E },	// '8'
+		{ 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C },	// '9'
+		{ 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00 },	// ':'
+		{ 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x04, 0x08 },	// ';'
+		{ 0x02, 0x04, 0x08, 0x10, 0x08, 0x04, 0x02 },	// '<'
+		{ 0x00, 0x00, 0x1F, 0x00, 0x1F, 0x00, 0x00 },	// '='
+		{ 0x08, 0x04, 0x02, 0x01, 0x02, 0x04, 0x08 },	// '>'
+		{ 0x0E, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04 },	// '?'
+		{ 0x0E, 0x11, 0x01, 0x0D, 0x15, 0x15, 0x0E },	// '@'
+		{ 0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 },	// 'A'
+		{ 0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E },	// 'B'
+		{ 0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E },	// 'C'
+		{ 0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C },	// 'D'
+		{ 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F },	// 'E'
+		{ 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10 },	// 'F'
+		{ 0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F },	// 'G'
+		{ 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 },	// 'H'
+		{ 0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E },	// 'I'
+		{ 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C },	// 'J'
+		{ 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 },	// 'K'
+		{ 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F },	// 'L'
+		{ 0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11 },	// 'M'
+		{ 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11 },	// 'N'
+		{ 0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E },	// 'O'
+		{ 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10 },	// 'P'
+		{ 0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D },	// 'Q'
+		{ 0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11 },	// 'R'
+		{ 0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E },	// 'S'
+		{ 0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 },	// 'T'
+		{ 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E },	// 'U'
+		{ 0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04 },	// 'V'
+		{ 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A },	// 'W'
+		{ 0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11 },	// 'X'
+		{ 0x11, 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04 },	// 'Y'
+		{ 0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F },	// 'Z'
+		{ 0x0E, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0E },	// '['
+		{ 0x00, 0x10, 0x08, 0x04, 0x02, 0x01, 0x00 },	// backslash
+		{ 0x0E, 0x02, 0x02, 0x02, 0x02, 0x02, 0x0E },	// ']'
+		{ 0x04, 0x0A, 0x11, 0x00, 0x00, 0x00, 0x00 },	// '^'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F },	// '_'
+		{ 0x08, 0x04, 0x02, 0x00, 0x00, 0x00, 0x00 },	// '`'
+		{ 0x00, 0x00, 0x0E, 0x01, 0x0F, 0x11, 0x0F },	// 'a'
+		{ 0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x1E },	// 'b'
+		{ 0x00, 0x00, 0x0E, 0x10, 0x10, 0x11, 0x0E },	// 'c'
+		{ 0x01, 0x01, 0x0D, 0x13, 0x11, 0x11, 0x0F },	// 'd'
+		{ 0x00, 0x00, 0x0E, 0x11, 0x1F, 0x10, 0x0E },	// 'e'
+		{ 0x06, 0x09, 0x08, 0x1C, 0x08, 0x08, 0x08 },	// 'f'
+		{ 0x00, 0x0F, 0x11, 0x11, 0x0F, 0x01, 0x0E },	// 'g'
+		{ 0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x11 },	// 'h'
+		{ 0x04, 0x00, 0x0C, 0x04, 0x04, 0x04, 0x0E },	// 'i'
+		{ 0x02, 0x00, 0x06, 0x02, 0x02, 0x12, 0x0C },	// 'j'
+		{ 0x10, 0x10, 0x12, 0x14, 0x18, 0x14, 0x12 },	// 'k'
+		{ 0x0C, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E },	// 'l'
+		{ 0x00, 0x00, 0x1A, 0x15, 0x15, 0x11, 0x11 },	// 'm'
+		{ 0x00, 0x00, 0x16, 0x19, 0x11, 0x11, 0x11 },	// 'n'
+		{ 0x00, 0x00, 0x0E, 0x11, 0x11, 0x11, 0x0E },	// 'o'
+		{ 0x00, 0x00, 0x1E, 0x11, 0x1E, 0x10, 0x10 },	// 'p'
+		{ 0x00, 0x00, 0x0D, 0x13, 0x0F, 0x01, 0x01 },	// 'q'
+		{ 0x00, 0x00, 0x16, 0x19, 0x10, 0x10, 0x10 },	// 'r'
+		{ 0x00, 0x00, 0x0E, 0x10, 0x0E, 0x01, 0x1E },	// 's'
+		{ 0x08, 0x08, 0x1C, 0x08, 0x08, 0x09, 0x06 },	// 't'
+		{ 0x00, 0x00, 0x11, 0x11, 0x11, 0x13, 0x0D },	// 'u'
+		{ 0x00, 0x00, 0x11, 0x11, 0x11, 0x0A, 0x04 },	// 'v'
+		{ 0x00, 0x00, 0x11, 0x11, 0x15, 0x15, 0x0A },	// 'w'
+		{ 0x00, 0x00, 0x11, 0x0A, 0x04, 0x0A, 0x11 },	// 'x'
+		{ 0x00, 0x00, 0x11, 0x11, 0x0F, 0x01, 0x0E },	// 'y'
+		{ 0x00, 0x00, 0x1F, 0x02, 0x04, 0x08, 0x1F },	// 'z'
+		{ 0x02, 0x04, 0x04, 0x08, 0x04, 0x04, 0x02 },	// '{'
+		{ 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 },	// '|'
+		{ 0x08, 0x04, 0x04, 0x02, 0x04, 0x04, 0x08 },	// '}'
+		{ 0x00, 0x00, 0x08, 0x15, 0x02, 0x00, 0x00 },	// '~'
+	};
+
+	static const GLubyte s_pBackgroundColor[ 4 ]	= { 0, 0, 0, 160 };
+	static const GLubyte s_pTextColor[ 4 ]			= { 255, 255, 255, 255 };
+	static const GLubyte s_pTitleColor[ 4 ]			= { 255, 200, 64, 255 };
+	static const GLubyte s_pFastColor[ 4 ]			= { 64, 224, 64, 255 };
+	static const GLubyte s_pSlowColor[ 4 ]			= { 240, 200, 32, 255 };
+	static const GLubyte s_pTooSlowColor[ 4 ]		= { 240, 48, 32, 255 };
+	static const GLubyte s_pTargetColor[ 4 ]		= { 255, 255, 255, 96 };
+
+
+	/**
+	* @brief constructor: creates the glyph atlas, must be called with a current GL context
+	* @param pStreamer the texture streamer whose queues are shown, NULL to hide them
+	* @param fX the overlay left position in pixels
+	* @param fY the overlay top position in pixels
+	* @param fScale the size of a font pixel in screen pixels
+	*/
+	PerformanceHud::PerformanceHud( TextureStreamer* pStreamer, float fX, float fY, float fScale )
+		: m_pStreamer( pStreamer )
+		, m_fX( fX )
+		, m_fY( fY )
+		, m_fScale( fScale )
+		, m_bVisible( false )
+		, m_iFramePosition( 0 )
+		, m_iFrameNb( 0 )
+		, m_dLastFrame( getTime() )
+		, m_fDrawTime( 0.f )
+	{
+		// white texels whose alpha is the glyph coverage, modulated by the vertices color
+		GLubyte* pTexels = new GLubyte[ 4 * ATLAS_WIDTH * ATLAS_HEIGHT ];
+		memset( pTexels, 0, 4 * ATLAS_WIDTH * ATLAS_HEIGHT );
+
+		for( int iCell = 0; iCell <= SOLID_CELL; ++iCell )
+		{
+			int iCellX = ( iCell % ATLAS_COLUMN_NB ) * ATLAS_CELL_SIZE;
+			int iCellY = ( iCell / ATLAS_COLUMN_NB ) * ATLAS_CELL_SIZE;
+
+			for( int y = 0; y < ATLAS_CELL_SIZE; ++y )
+			{
+				for( int x = 0; x < ATLAS_CELL_SIZE; ++x )
+				{
+					bool bSet = iCell == SOLID_CELL ||
+						( x < FONT_WIDTH && y < FONT_HEIGHT && ( s_pFontGlyphs[ iCell ][ y ] & ( 1 << ( FONT_WIDTH - 1 - x ) ) ) != 0 );
+
+					GLubyte* pTexel = pTexels + 4 * ( ( iCellY + y ) * ATLAS_WIDTH + iCellX + x );
+					pTexel[ 0 ] = 255;
+					pTexel[ 1 ] = 255;
+					pTexel[ 2 ] = 255;
+					pTexel[ 3 ] = bSet ? 255 : 0;
+				}
+			}
+		}
+
+		m_pAtlas = new Texture2D( ATLAS_WIDTH, ATLAS_HEIGHT );
+		m_pAtlas->setFilters( NEAREST, NEAREST );
+		m_pAtlas->setWrapMode( CLAMP_TO_EDGE );
+		m_pAtlas->setData( TGA, pTexels );
+		m_pAtlas->bind( false );
+
+		delete[] pTexels;
+
+		for( int i = 0; i < PERFORMANCE_HUD_HISTORY_LENGTH; ++i )
+			m_pFrameTimes[ i ] = 0.f;
+
+		// room for a full overlay, the vertex array is never reallocated afterwards
+		m_vVertices.reserve( 4 * 4096 );
+	}
+
+	PerformanceHud::~PerformanceHud()
+	{
+		setVisible( false );
+		delete m_pAtlas;
+	}
+
+	/**
+	* @brief adds a textured quad to the overlay
+	* @param fX0 the left position in pixels
+	* @param fY0 the top position in pixels
+	* @param fX1 the right position in pixels
+	* @param fY1 the bottom position in pixels
+	* @param fU0 the left texture coordinate
+	* @param fV0 the top texture coordinate
+	* @param fU1 the right texture coordinate
+	* @param fV1 the bottom texture coordinate
+	* @param pColor the RGBA color
+	*/
+	void PerformanceHud::addQuad( float fX0, float fY0, float fX1, float fY1, float fU0, float fV0, float fU1, float fV1, const GLubyte* pColor )
+	{
+		HudVertex oVertex;
+		memcpy( oVertex.pColor, pColor, 4 );
+
+		oVertex.fX = fX0; oVertex.fY = fY0; oVertex.fU = fU0; oVertex.fV = fV0;
+		m_vVertices.push_back( oVertex );
+		oVertex.fX = fX0; oVertex.fY = fY1; oVertex.fU = fU0; oVertex.fV = fV1;
+		m_vVertices.push_back( oVertex );
+		oVertex.fX = fX1; oVertex.fY = fY1; oVertex.fU = fU1; oVertex.fV = fV1;
+		m_vVertices.push_back( oVertex );
+		oVertex.fX = fX1; oVertex.fY = fY0; oVertex.fU = fU1; oVertex.fV = fV0;
+		m_vVertices.push_back( oVertex );
+	}
+
+	/**
+	* @brief adds a plain rectangle to the overlay
+	* @param fX the left position in pixels
+	* @param fY the top position in pixels
+	* @param fWidth the width in pixels
+	* @param fHeight the height in pixels
+	* @param pColor the RGBA color
+	*/
+	void PerformanceHud::addRect( float fX, float fY, float fWidth, float fHeight, const GLubyte* pColor )
+	{
+		// samples the middle of the opaque cell
+		float fU = ( ( SOLID_CELL % ATLAS_COLUMN_NB ) * ATLAS_CELL_SIZE + ATLAS_CELL_SIZE * 0.5f ) / ATLAS_WIDTH;
+		float fV = ( ( SOLID_CELL / ATLAS_COLUMN_NB ) * ATLAS_CELL_SIZE + ATLAS_CELL_SIZE * 0.5f ) / ATLAS_HEIGHT;
+
+		addQuad( fX, fY, fX + fWidth, fY + fHeight, fU, fV, fU, fV, pColor );
+	}
+
+	/**
+	* @brief adds a line of text to the overlay
+	* @param fX the left position in pixels
+	* @param fY the top position in pixels
+	* @param sText the text, the characters out of the font are skipped
+	* @param pColor the RGBA color
+	* @return the right position of the text in pixels
+	*/
+	float PerformanceHud::addText( float fX, float fY, const char* sText, const GLubyte* pColor )
+	{
+		float fAdvance = ( FONT_WIDTH + 1 ) * m_fScale;
+
+		for( ; *sText != '\0'; ++sText, fX += fAdvance )
+		{
+			int iCell = ( unsigned char )*sText - FONT_FIRST_CHAR;
+			if( iCell <= 0 || iCell >= FONT_CHAR_NB )
+				continue;
+
+			float fU = ( float )( ( iCell % ATLAS_COLUMN_NB ) * ATLAS_CELL_SIZE ) / ATLAS_WIDTH;
+			float fV = ( float )( ( iCell / ATLAS_COLUMN_NB ) * ATLAS_CELL_SIZE ) / ATLAS_HEIGHT;
+
+			addQuad( fX, fY, fX + FONT_WIDTH * m_fScale, fY + FONT_HEIGHT * m_fScale,
+				fU, fV, fU + ( float )FONT_WIDTH / ATLAS_WIDTH, fV + ( float )FONT_HEIGHT / ATLAS_HEIGHT, pColor );
+		}
+
+		return fX;
+	}
+
+	/**
+	* @brief records the duration of the frame that just ended, to be called once per frame after the buffers swap
+	*/
+	void PerformanceHud::nextFrame()
+	{
+		double dTime = getTime();
+
+		m_pFrameTimes[ m_iFramePosition ] = ( float )( ( dTime - m_dLastFrame ) * 1000.0 );
+		m_iFramePosition = ( m_iFramePosition + 1 ) % PERFORMANCE_HUD_HISTORY_LENGTH;
+		if( m_iFrameNb < PERFORMANCE_HUD_HISTORY_LENGTH )
+			++m_iFrameNb;
+
+		m_dLastFrame = dTime;
+	}
+
+	/**
+	* @brief shows or hides the overlay, the culled triangles are only counted while it is visible
+	* @param bVisible true to show the overlay
+	*/
+	void PerformanceHud::setVisible( bool bVisible )
+	{
+		m_bVisible = bVisible;
+		RenderStats::setPipelineStatistics( bVisible );
+	}
+
+	/**
+	* @brief draws the overlay when it is visible
+	* @param iWidth the window width
+	* @param iHeight the window height
+	*/
+	void PerformanceHud::draw( int iWidth, int iHeight )
+	{
+		if( !m_bVisible )
+			return;
+
+		OGLF_PROFILE_GPU_SCOPE( "PerformanceHud::draw" );
+
+		double dStart = getTime();
+
+		float fLineHeight = ( FONT_HEIGHT + 3 ) * m_fScale;
+		float fPadding = 2 * m_fScale;
+		float fX = m_fX + fPadding;
+		float fY = m_fY + fPadding;
+		float fRight = fX + GRAPH_BAR_WIDTH * PERFORMANCE_HUD_HISTORY_LENGTH;
+		char sLine[ 128 ];
+
+		m_vVertices.clear();
+
+		// the background is resized once the overlay height is known
+		addRect( m_fX, m_fY, 0.f, 0.f, s_pBackgroundColor );
+
+		// frame time
+		float fLastFrameTime = 0.f;
+		float fAverageFrameTime = 0.f;
+		float fMaxFrameTime = 0.f;
+		if( m_iFrameNb > 0 )
+		{
+			for( int i = 0; i < m_iFrameNb; ++i )
+			{
+				fAverageFrameTime += m_pFrameTimes[ i ];
+				fMaxFrameTime = maxT( fMaxFrameTime, m_pFrameTimes[ i ] );
+			}
+			fAverageFrameTime /= m_iFrameNb;
+			fLastFrameTime = m_pFrameTimes[ ( m_iFramePosition + PERFORMANCE_HUD_HISTORY_LENGTH - 1 ) % PERFORMANCE_HUD_HISTORY_LENGTH ];
+		}
+
+		sprintf( sLine, "Frame %.2f ms (%.1f fps)", fLastFrameTime, fAverageFrameTime > 0.f ? 1000.f / fAverageFrameTime : 0.f );
+		fRight = maxT( fRight, addText( fX, fY, sLine, s_pTitleColor ) );
+		fY += fLineHeight;
+		sprintf( sLine, "avg %.2f ms, max %.2f ms", fAverageFrameTime, fMaxFrameTime );
+		fRight = maxT( fRight, addText( fX, fY, sLine, s_pTextColor ) );
+		fY += fLineHeight;
+
+		// frame time graph, from the oldest frame on the left to the last one on the right
+		float fGraphBottom = fY + GRAPH_HEIGHT;
+		for( int i = 0; i < m_iFrameNb; ++i )
+		{
+			int iFrame = ( m_iFramePosition + PERFORMANCE_HUD_HISTORY_LENGTH - m_iFrameNb + i ) % PERFORMANCE_HUD_HISTORY_LENGTH;
+			float fTime = m_pFrameTimes[ iFrame ];
+			float fHeight = minT( fTime / GRAPH_MAX_TIME, 1.f ) * GRAPH_HEIGHT;
+			const GLubyte* pColor = fTime <= GRAPH_TARGET_TIME * 1.05f ? s_pFastColor : ( fTime <= GRAPH_MAX_TIME ? s_pSlowColor : s_pTooSlowColor );
+
+			addRect( fX + ( PERFORMANCE_HUD_HISTORY_LENGTH - m_iFrameNb + i ) * GRAPH_BAR_WIDTH, fGraphBottom - fHeight,
+				GRAPH_BAR_WIDTH - 1.f, fHeight, pColor );
+		}
+		addRect( fX, fGraphBottom - GRAPH_TARGET_TIME / GRAPH_MAX_TIME * GRAPH_HEIGHT, ( float )( GRAPH_BAR_WIDTH * PERFORMANCE_HUD_HISTORY_LENGTH ),
+			1.f, s_pTargetColor );
+		fY = fGraphBottom + fPadding * 2;
+
+		// rendering statistics of the last frame
+		sprintf( sLine, "Draw calls %u, state changes %u", RenderStats::getDrawCallNb(), RenderStats::getStateChangeNb() );
+		fRight = maxT( fRight, addText( fX, fY, sLine, s_pTextColor ) );
+		fY += fLineHeight;
+		if( RenderStats::getCulledTriangleNb() >= 0 )
+			sprintf( sLine, "Triangles %u, culled %d", RenderStats::getTriangleNb(), RenderStats::getCulledTriangleNb() );
+		else
+			sprintf( sLine, "Triangles %u, culled n/a", RenderStats::getTriangleNb() );
+		fRight = maxT( fRight, addText( fX, fY, sLine, s_pTextColor ) );
+		fY += fLineHeight;
+		sprintf( sLine, "Textures %.1f MB, peak %.1f MB", Texture::getTotalMemorySize() / 1048576.f, Texture::getPeakMemorySize() / 1048576.f );
+		fRight = maxT( fRight, addText( fX, fY, sLine, s_pTextColor ) );
+		fY += fLineHeight;
+		if( m_pStreamer != NULL )
+		{
+			int iRequestNb, iUploadNb;
+			m_pStreamer->getQueueDepth( iRequestNb, iUploadNb );
+			sprintf( sLine, "Streaming %d textures, %d uploads", iRequestNb, iUploadNb );
+			fRight = maxT( fRight, addText( fX, fY, sLine, s_pTextColor ) );
+			fY += fLineHeight;
+		}
+		sprintf( sLine, "Overlay %.3f ms", m_fDrawTime );
+		fRight = maxT( fRight, addText( fX, fY, sLine, s_pTextColor ) );
+		fY += fLineHeight;
+
+#ifdef OGLF_PROFILING
+		// CPU and GPU time of the profiled scopes, averaged over the profiler history
+		float fColumn = 22 * ( FONT_WIDTH + 1 ) * m_fScale;
+		fY += fPadding * 2;
+		addText( fX, fY, "Scope", s_pTitleColor );
+		addText( fX + fColumn, fY, "CPU ms", s_pTitleColor );
+		fRight = maxT( fRight, addText( fX + fColumn + 8 * ( FONT_WIDTH + 1 ) * m_fScale, fY, "GPU ms", s_pTitleColor ) );
+		fY += fLineHeight;
+
+		for( int i = 0; i < Profiler::getScopeNb(); ++i )
+		{
+			const ProfileScopeStats& oScope = Profiler::getScopeStats( i );
+
+			// the names are indented by the scopes depth and cut to fit in the first column
+			int iIndent = minT( oScope.iDepth, 4 );
+			sprintf( sLine, "%*s%.*s", iIndent, "", 21 - iIndent, oScope.sName );
+			addText( fX, fY, sLine, s_pTextColor );
+
+			if( oScope.fGpuAverage >= 0.f )
+				sprintf( sLine, "%6.3f  %6.3f", oScope.fCpuAverage, oScope.fGpuAverage );
+			else
+				sprintf( sLine, "%6.3f       -", oScope.fCpuAverage );
+			fRight = maxT( fRight, addText( fX + fColumn, fY, sLine, s_pTextColor ) );
+			fY += fLineHeight;
+		}
+#endif
+
+		// resizes the background behind the overlay content
+		m_vVertices[ 1 ].fY = fY;
+		m_vVertices[ 2 ].fX = fRight + fPadding;
+		m_vVertices[ 2 ].fY = fY;
+		m_vVertices[ 3 ].fX = fRight + fPadding;
+
+		// single draw of the overlay with the fixed pipeline
+		glMatrixMode( GL_PROJECTION );
+		glPushMatrix();
+		glLoadIdentity();
+		glOrtho( 0, iWidth, iHeight, 0, -1, 1 );
+		glMatrixMode( GL_MODELVIEW );
+		glPushMatrix();
+		glLoadIdentity();
+
+		glPushAttrib( GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_TEXTURE_BIT );
+		glDisable( GL_DEPTH_TEST );
+		glDisable( GL_CULL_FACE );
+		glDisable( GL_LIGHTING );
+		glEnable( GL_BLEND );
+		glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+
+		if( GLSLshaderProgram::currentShaderProgramInUse() != 0 )
+			GLSLshaderProgram::useFixedPipeline();
+
+		glActiveTexture( GL_TEXTURE0 );
+		glEnable( GL_TEXTURE_2D );
+		glTexEnvi( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE );
+		m_pAtlas->bind();
+
+		glPushClientAttrib( GL_CLIENT_VERTEX_ARRAY_BIT );
+		glEnableClientState( GL_VERTEX_ARRAY );
+		glEnableClientState( GL_TEXTURE_COORD_ARRAY );
+		glEnableClientState( GL_COLOR_ARRAY );
+		glVertexPointer( 2, GL_FLOAT, sizeof( HudVertex ), &m_vVertices[ 0 ].fX );
+		glTexCoordPointer( 2, GL_FLOAT, sizeof( HudVertex ), &m_vVertices[ 0 ].fU );
+		glColorPointer( 4, GL_UNSIGNED_BYTE, sizeof( HudVertex ), m_vVertices[ 0 ].pColor );
+
+		glDrawArrays( GL_QUADS, 0, ( GLsizei )m_vVertices.size() );
+		RenderStats::addDrawCall( ( unsigned int )m_vVertices.size() / 2 );
+
+		glPopClientAttrib();
+
+		m_pAtlas->bind( false );
+		glPopAttrib();
+
+		glMatrixMode( GL_PROJECTION );
+		glPopMatrix();
+		glMatrixMode( GL_MODELVIEW );
+		glPopMatrix();
+
+		m_fDrawTime = ( float )( ( getTime() - dStart ) * 1000.0 );
+	}
+}
@@ -0,0 +1,105 @@
+#ifndef PERFORMANCEHUD_H
+#define PERFORMANCEHUD_H
+
+#include <vector>
+#include <GL/glew.h>
+#include "Texture2D.h"
+#include "TextureStreamer.h"
+#include "RenderStats.h"
+#include "Profiler.h"
+
+
+namespace Oglf
+{
+	const int PERFORMANCE_HUD_HISTORY_LENGTH = 128;	// frames shown in the frame time graph
+
+	/**
+	* class PerformanceHud draws a performance overlay over the frame: the frame time and its rolling graph, the draw
+	* calls, state changes and triangles of the last frame from RenderStats, the texture memory, the texture streaming
+	* queues and, when OGLF_PROFILING is defined, the CPU and GPU times of the profiled scopes. The text is drawn with
+	* a glyph atlas created once from an embedded 5x7 font, the whole overlay is a single draw call.
+	*/
+	class PerformanceHud
+	{
+		/**
+		* @brief an overlay vertex, in pixels from the top left corner of the window
+		*/
+		struct HudVertex
+		{
+			GLfloat	fX;
+			GLfloat	fY;
+			GLfloat	fU;
+			GLfloat	fV;
+			GLubyte	pColor[ 4 ];
+		};
+
+		Texture2D*					m_pAtlas;
+		std::vector< HudVertex >	m_vVertices;		// rebuilt every frame, its capacity is kept
+		TextureStreamer*			m_pStreamer;
+		float						m_fX;
+		float						m_fY;
+		float						m_fScale;			// size of a font pixel in screen pixels
+		bool						m_bVisible;
+
+		float						m_pFrameTimes[ PERFORMANCE_HUD_HISTORY_LENGTH ];	// in ms
+		int							m_iFramePosition;	// slot of the next frame time
+		int							m_iFrameNb;
+		double						m_dLastFrame;
+		float						m_fDrawTime;		// CPU time of the last draw() in ms
+
+		void addQuad( float fX0, float fY0, float fX1, float fY1, float fU0, float fV0, float fU1, float fV1, const GLubyte* pColor );
+		void addRect( float fX, float fY, float fWidth, float fHeight, const GLubyte* pColor );
+		float addText( float fX, float fY, const char* sText, const GLubyte* pColor );
+
+	public:
+
+		/**
+		* @brief constructor: creates the glyph atlas, must be called with a current GL context
+		* @param pStreamer the texture streamer whose queues are shown, NULL to hide them
+		* @param fX the overlay left position in pixels
+		* @param fY the overlay top position in pixels
+		* @param fScale the size of a font pixel in screen pixels
+		*/
+		PerformanceHud( TextureStreamer* pStreamer = NULL, float fX = 10.f, float fY = 10.f, float fScale = 2.f );
+
+		~PerformanceHud();
+
+		/**
+		* @brief records the duration of the frame that just ended, to be called once per frame after the buffers swap
+		*/
+		void nextFrame();
+
+		/**
+		* @brief draws the overlay when it is visible
+		* @param iWidth the window width
+		* @param iHeight the window height
+		*/
+		void draw( int iWidth, int iHeight );
+
+		/**
+		* @brief shows or hides the overlay, the culled triangles are only counted while it is visible
+		* @param bVisible true to show the overlay
+		*/
+		void setVisible( bool bVisible );
+
+		/**
+		* @brief returns whether the overlay is visible
+		* @return true if it is drawn by draw()
+		*/
+		bool isVisible() const
+		{
+			return m_bVisible;
+		}
+
+		/**
+		* @brief returns the CPU time spent in the last draw()
+		* @return the time in ms
+		*/
+		float getDrawTime() const
+		{
+			return m_fDrawTime;
+		}
+	};
+}
+
+#endif /* PERFORMANCEHUD_H */
@@ -1,6 +1,8 @@
 #include <string>
 #include "PostProcessingFX.h"
 #include "Renderer.h"
+#include "Profiler.h"
+#include "RenderStats.h"
 
 using namespace std;
 
@@ -44,6 +46,8 @@ namespace Oglf
 
 	void PostProcessingFX::compute()
 	{
+		OGLF_PROFILE_GPU_SCOPE( getName().c_str() );
+
 		vector< PassFx* >::iterator oPassIt = m_vPasses.begin();
 
 		// Set the projection matrix to 2D projection
@@ -70,6 +74,8 @@ namespace Oglf
 
 		for( oPassIt; oPassIt != m_vPasses.end(); ++oPassIt )
 		{
+			OGLF_PROFILE_GPU_SCOPE( ( *oPassIt )->getName().c_str() );
+
 			pRfx	   = ( *oPassIt )->m_pRfx;
 			pOutputTex = ( *oPassIt )->m_pOutputTex;
 
@@ -102,6 +108,7 @@ namespace Oglf
 			glVertex2f(0.0, 1.0);
 
 			glEnd();
+			RenderStats::addDrawCall( 2 );
 
 			if( pOutputTex!= NULL && pOutputTex->isMipmapped() )
 			{
@@ -0,0 +1,415 @@
+#include "Profiler.h"
+
+#ifdef OGLF_PROFILING
+
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include "Error.h"
+#include "utils.h"
+
+using namespace std;
+
+namespace Oglf
+{
+	vector< ProfileScopeStats >		Profiler::s_vScopes;
+	vector< float >					Profiler::s_vCpuHistory;
+	vector< float >					Profiler::s_vGpuHistory;
+	float							Profiler::s_pFrameHistory[ PROFILER_HISTORY_LENGTH ];
+	int								Profiler::s_iHistoryPosition = 0;
+	int								Profiler::s_iHistoryLength = 0;
+	Profiler::FrameData				Profiler::s_pFrames[ PROFILER_FRAME_LATENCY ];
+	int								Profiler::s_iCurrentFrame = 0;
+	unsigned int					Profiler::s_iFrameNb = 0;
+	vector< int >					Profiler::s_vOpenEvents;
+	deque< Profiler::TraceEvent >	Profiler::s_dTraceEvents;
+	bool							Profiler::s_bGpuTiming = false;
+	bool							Profiler::s_bInitialized = false;
+
+	/**
+	* @brief starts recording the first frame, the OpenGL context must be current
+	*/
+	void Profiler::initialize()
+	{
+		s_bGpuTiming = GLEW_ARB_timer_query != 0;
+
+		for( int i = 0; i < PROFILER_FRAME_LATENCY; ++i )
+		{
+			s_pFrames[ i ].iQueryNb = 0;
+			s_pFrames[ i ].bRecorded = false;
+		}
+
+		s_pFrames[ s_iCurrentFrame ].dStart = getTime();
+		s_bInitialized = true;
+	}
+
+	/**
+	* @brief returns a scope, it is created the first time it is entered
+	* @param sName the scope name
+	* @param bGpu true: the scope GPU execution is timed
+	* @return the scope
+	*/
+	int Profiler::findScope( const char* sName, bool bGpu )
+	{
+		// the names are usually string literals, compared by address first
+		for( size_t i = 0; i < s_vScopes.size(); ++i )
+			if( s_vScopes[ i ].sName == sName || strcmp( s_vScopes[ i ].sName, sName ) == 0 )
+				return ( int )i;
+
+		ProfileScopeStats oScope;
+		oScope.sName = sName;
+		oScope.iDepth = ( int )s_vOpenEvents.size();
+		oScope.bGpu = bGpu && s_bGpuTiming;
+		oScope.fCpuAverage = oScope.fCpuMax = 0.f;
+		oScope.fGpuAverage = oScope.fGpuMax = -1.f;
+		oScope.iCallNb = 0;
+		s_vScopes.push_back( oScope );
+
+		s_vCpuHistory.resize( s_vScopes.size() * PROFILER_HISTORY_LENGTH, 0.f );
+		s_vGpuHistory.resize( s_vScopes.size() * PROFILER_HISTORY_LENGTH, -1.f );
+
+		return ( int )s_vScopes.size() - 1;
+	}
+
+	/**
+	* @brief returns a free timestamp query of a frame, queries are created when the frame needs more
+	* @param oFrame the frame
+	* @param iQuery the query index in the frame queries
+	* @return the query
+	*/
+	GLuint Profiler::getQuery( FrameData& oFrame, int& iQuery )
+	{
+		if( oFrame.iQueryNb == oFrame.vQueries.size() )
+		{
+			GLuint iQueryID;
+			glGenQueries( 1, &iQueryID );
+			oFrame.vQueries.push_back( iQueryID );
+		}
+
+		iQuery = ( int )oFrame.iQueryNb;
+		return oFrame.vQueries[ oFrame.iQueryNb++ ];
+	}
+
+	/**
+	* @brief enters a scope, called by ProfileScope
+	* @param sName the scope name, it must stay valid while the profiler is used
+	* @param bGpu true: the scope GPU execution is timed
+	* @return the scope event
+	*/
+	int Profiler::beginScope( const char* sName, bool bGpu )
+	{
+		if( !s_bInitialized )
+			initialize();
+
+		FrameData& oFrame = s_pFrames[ s_iCurrentFrame ];
+
+		ProfileEvent oEvent;
+		oEvent.iScope = findScope( sName, bGpu );
+		oEvent.iDepth = ( int )s_vOpenEvents.size();
+		oEvent.iBeginQuery = oEvent.iEndQuery = -1;
+		oEvent.dGpuStart = oEvent.dGpuEnd = -1.0;
+		oEvent.dCpuStart = getTime();
+		oEvent.dCpuEnd = oEvent.dCpuStart;
+
+		if( s_vScopes[ oEvent.iScope ].bGpu )
+			glQueryCounter( getQuery( oFrame, oEvent.iBeginQuery ), GL_TIMESTAMP );
+
+		oFrame.vEvents.push_back( oEvent );
+		s_vOpenEvents.push_back( ( int )oFrame.vEvents.size() - 1 );
+
+		return s_vOpenEvents.back();
+	}
+
+	/**
+	* @brief leaves a scope, called by ProfileScope
+	* @param iEvent the scope event
+	*/
+	void Profiler::endScope( int iEvent )
+	{
+		// the scopes still entered when a frame ends are dropped
+		if( s_vOpenEvents.empty() || s_vOpenEvents.back() != iEvent )
+			return;
+
+		FrameData& oFrame = s_pFrames[ s_iCurrentFrame ];
+		ProfileEvent& oEvent = oFrame.vEvents[ iEvent ];
+
+		if( oEvent.iBeginQuery >= 0 )
+			glQueryCounter( getQuery( oFrame, oEvent.iEndQuery ), GL_TIMESTAMP );
+
+		oEvent.dCpuEnd = getTime();
+		s_vOpenEvents.pop_back();
+	}
+
+	/**
+	* @brief ends the current frame and reads back the frame recorded PROFILER_FRAME_LATENCY frames ago
+	*/
+	void Profiler::nextFrame()
+	{
+		if( !s_bInitialized )
+			initialize();
+
+		FrameData& oFrame = s_pFrames[ s_iCurrentFrame ];
+		oFrame.dEnd = getTime();
+		oFrame.bRecorded = true;
+
+		// drops the events of the scopes still entered
+		for( size_t i = 0; i < s_vOpenEvents.size(); ++i )
+		{
+			oFrame.vEvents[ s_vOpenEvents[ i ] ].dCpuEnd = oFrame.dEnd;
+			oFrame.vEvents[ s_vOpenEvents[ i ] ].iBeginQuery = -1;
+		}
+		s_vOpenEvents.clear();
+
+		++s_iFrameNb;
+		s_iCurrentFrame = ( s_iCurrentFrame + 1 ) % PROFILER_FRAME_LATENCY;
+
+		FrameData& oNextFrame = s_pFrames[ s_iCurrentFrame ];
+		if( oNextFrame.bRecorded )
+			readBack( oNextFrame );
+
+		oNextFrame.vEvents.clear();
+		oNextFrame.iQueryNb = 0;
+		oNextFrame.dStart = oFrame.dEnd;
+		oNextFrame.bRecorded = false;
+	}
+
+	/**
+	* @brief reads back the timings of a recorded frame and adds them to the history
+	* @param oFrame the frame
+	*/
+	void Profiler::readBack( FrameData& oFrame )
+	{
+		// the queries complete in order: the GPU timings are known when the last query is available. With
+		// PROFILER_FRAME_LATENCY frames in flight they nearly always are, they are dropped otherwise
+		bool bGpuTimings = false;
+		if( oFrame.iQueryNb > 0 )
+		{
+			GLint iAvailable = 0;
+			glGetQueryObjectiv( oFrame.vQueries[ oFrame.iQueryNb - 1 ], GL_QUERY_RESULT_AVAILABLE, &iAvailable );
+			bGpuTimings = iAvailable != 0;
+		}
+
+		size_t iScopeNb = s_vScopes.size();
+		vector< float > vCpuTimes( iScopeNb, 0.f );
+		vector< float > vGpuTimes( iScopeNb, 0.f );
+		vector< int > vCallNb( iScopeNb, 0 );
+
+		for( size_t i = 0; i < oFrame.vEvents.size(); ++i )
+		{
+			ProfileEvent& oEvent = oFrame.vEvents[ i ];
+
+			vCpuTimes[ oEvent.iScope ] += ( float )( ( oEvent.dCpuEnd - oEvent.dCpuStart ) * 1000.0 );
+			++vCallNb[ oEvent.iScope ];
+
+			if( oEvent.iBeginQuery >= 0 && oEvent.iEndQuery >= 0 && bGpuTimings )
+			{
+				GLuint64 iStart, iEnd;
+				glGetQueryObjectui64v( oFrame.vQueries[ oEvent.iBeginQuery ], GL_QUERY_RESULT, &iStart );
+				glGetQueryObjectui64v( oFrame.vQueries[ oEvent.iEndQuery ], GL_QUERY_RESULT, &iEnd );
+
+				oEvent.dGpuStart = ( double )iStart * 1e-9;
+				oEvent.dGpuEnd = ( double )iEnd * 1e-9;
+				vGpuTimes[ oEvent.iScope ] += ( float )( ( oEvent.dGpuEnd - oEvent.dGpuStart ) * 1000.0 );
+			}
+			else if( s_vScopes[ oEvent.iScope ].bGpu )
+			{
+				vGpuTimes[ oEvent.iScope ] = -1.f;
+			}
+		}
+
+		for( size_t i = 0; i < iScopeNb; ++i )
+		{
+			ProfileScopeStats& oScope = s_vScopes[ i ];
+
+			if( !oScope.bGpu || ( vCallNb[ i ] > 0 && !bGpuTimings ) )
+				vGpuTimes[ i ] = -1.f;
+
+			s_vCpuHistory[ i * PROFILER_HISTORY_LENGTH + s_iHistoryPosition ] = vCpuTimes[ i ];
+			s_vGpuHistory[ i * PROFILER_HISTORY_LENGTH + s_iHistoryPosition ] = vGpuTimes[ i ];
+			oScope.iCallNb = vCallNb[ i ];
+		}
+
+		s_pFrameHistory[ s_iHistoryPosition ] = ( float )( ( oFrame.dEnd - oFrame.dStart ) * 1000.0 );
+		s_iHistoryPosition = ( s_iHistoryPosition + 1 ) % PROFILER_HISTORY_LENGTH;
+		if( s_iHistoryLength < PROFILER_HISTORY_LENGTH )
+			++s_iHistoryLength;
+
+		for( size_t i = 0; i < iScopeNb; ++i )
+		{
+			ProfileScopeStats& oScope = s_vScopes[ i ];
+			float fCpuSum = 0.f, fGpuSum = 0.f;
+			int iGpuNb = 0;
+
+			oScope.fCpuMax = 0.f;
+			oScope.fGpuMax = -1.f;
+
+			for( int iFrame = 0; iFrame < s_iHistoryLength; ++iFrame )
+			{
+				float fCpuTime = getCpuTime( ( int )i, iFrame );
+				float fGpuTime = getGpuTime( ( int )i, iFrame );
+
+				fCpuSum += fCpuTime;
+				oScope.fCpuMax = maxT( oScope.fCpuMax, fCpuTime );
+
+				if( fGpuTime >= 0.f )
+				{
+					fGpuSum += fGpuTime;
+					oScope.fGpuMax = maxT( oScope.fGpuMax, fGpuTime );
+					++iGpuNb;
+				}
+			}
+
+			oScope.fCpuAverage = fCpuSum / s_iHistoryLength;
+			oScope.fGpuAverage = iGpuNb > 0 ? fGpuSum / iGpuNb : -1.f;
+		}
+
+		// keeps the events of the history frames for the trace export
+		unsigned int iFrame = s_iFrameNb - PROFILER_FRAME_LATENCY;
+		for( size_t i = 0; i < oFrame.vEvents.size(); ++i )
+		{
+			TraceEvent oTraceEvent;
+			oTraceEvent.oEvent = oFrame.vEvents[ i ];
+			oTraceEvent.iFrame = iFrame;
+			s_dTraceEvents.push_back( oTraceEvent );
+		}
+
+		while( !s_dTraceEvents.empty() && s_dTraceEvents.front().iFrame + PROFILER_HISTORY_LENGTH <= iFrame )
+			s_dTraceEvents.pop_front();
+	}
+
+	/**
+	* @brief returns the CPU time of a scope during a history frame
+	* @param iScope the scope
+	* @param iFrame the frame, from 0 for the oldest to getHistoryLength() - 1 for the last one read back
+	* @return the time in ms
+	*/
+	float Profiler::getCpuTime( int iScope, int iFrame )
+	{
+		int iSlot = ( s_iHistoryPosition - s_iHistoryLength + iFrame + PROFILER_HISTORY_LENGTH ) % PROFILER_HISTORY_LENGTH;
+		return s_vCpuHistory[ iScope * PROFILER_HISTORY_LENGTH + iSlot ];
+	}
+
+	/**
+	* @brief returns the GPU time of a scope during a history frame
+	* @param iScope the scope
+	* @param iFrame the frame, from 0 for the oldest to getHistoryLength() - 1 for the last one read back
+	* @return the time in ms, negative when unknown
+	*/
+	float Profiler::getGpuTime( int iScope, int iFrame )
+	{
+		int iSlot = ( s_iHistoryPosition - s_iHistoryLength + iFrame + PROFILER_HISTORY_LENGTH ) % PROFILER_HISTORY_LENGTH;
+		return s_vGpuHistory[ iScope * PROFILER_HISTORY_LENGTH + iSlot ];
+	}
+
+	/**
+	* @brief returns the duration of a history frame, from one nextFrame() call to the next
+	* @param iFrame the frame, from 0 for the oldest to getHistoryLength() - 1 for the last one read back
+	* @return the time in ms
+	*/
+	float Profiler::getFrameTime( int iFrame )
+	{
+		int iSlot = ( s_iHistoryPosition - s_iHistoryLength + iFrame + PROFILER_HISTORY_LENGTH ) % PROFILER_HISTORY_LENGTH;
+		return s_pFrameHistory[ iSlot ];
+	}
+
+	/**
+	* @brief writes a string in a JSON file
+	* @param oFile the file
+	* @param sString the string
+	*/
+	static void writeJSONstring( ofstream& oFile, const char* sString )
+	{
+		oFile << '"';
+		for( const char* pChar = sString; *pChar != '\0'; ++pChar )
+		{
+			if( *pChar == '"' || *pChar == '\\' )
+				oFile << '\\';
+			oFile << *pChar;
+		}
+		oFile << '"';
+	}
+
+	/**
+	* @brief writes the scopes of the history frames to a Chrome trace_event JSON file
+	* @param sFilename the file name
+	*/
+	void Profiler::exportChromeTrace( const string& sFilename )
+	{
+		ofstream oFile( sFilename.c_str() );
+		if( !oFile )
+			throw Error( "Profiler::exportChromeTrace error : Failed to create the trace file", sFilename );
+
+		oFile << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" << endl;
+		oFile << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}}," << endl;
+		oFile << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}";
+		oFile << fixed << setprecision( 3 );
+
+		double dOrigin = s_dTraceEvents.empty() ? 0.0 : s_dTraceEvents.front().oEvent.dCpuStart;
+		double dGpuOffset = 0.0;
+		unsigned int iGpuOffsetFrame = 0;
+		bool bGpuOffset = false;
+
+		for( size_t i = 0; i < s_dTraceEvents.size(); ++i )
+		{
+			const TraceEvent& oTraceEvent = s_dTraceEvents[ i ];
+			const ProfileEvent& oEvent = oTraceEvent.oEvent;
+			const char* sName = s_vScopes[ oEvent.iScope ].sName;
+
+			oFile << "," << endl << "{\"name\":";
+			writeJSONstring( oFile, sName );
+			oFile << ",\"cat\":\"CPU\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":" << ( oEvent.dCpuStart - dOrigin ) * 1e6
+				<< ",\"dur\":" << ( oEvent.dCpuEnd - oEvent.dCpuStart ) * 1e6 << ",\"args\":{\"frame\":" << oTraceEvent.iFrame << "}}";
+
+			if( oEvent.dGpuStart >= 0.0 )
+			{
+				// the GPU clock is aligned on the CPU clock at the first GPU scope of each frame
+				if( !bGpuOffset || iGpuOffsetFrame != oTraceEvent.iFrame )
+				{
+					dGpuOffset = oEvent.dCpuStart - oEvent.dGpuStart;
+					iGpuOffsetFrame = oTraceEvent.iFrame;
+					bGpuOffset = true;
+				}
+
+				oFile << "," << endl << "{\"name\":";
+				writeJSONstring( oFile, sName );
+				oFile << ",\"cat\":\"GPU\",\"ph\":\"X\",\"pid\":1,\"tid\":2,\"ts\":" << ( oEvent.dGpuStart + dGpuOffset - dOrigin ) * 1e6
+					<< ",\"dur\":" << ( oEvent.dGpuEnd - oEvent.dGpuStart ) * 1e6 << ",\"args\":{\"frame\":" << oTraceEvent.iFrame << "}}";
+			}
+		}
+
+		oFile << endl << "]}" << endl;
+	}
+
+	/**
+	* @brief deletes the timestamp queries and clears the recorded data, to be called while the OpenGL
+	* context still exists
+	*/
+	void Profiler::release()
+	{
+		for( int i = 0; i < PROFILER_FRAME_LATENCY; ++i )
+		{
+			FrameData& oFrame = s_pFrames[ i ];
+
+			if( !oFrame.vQueries.empty() )
+				glDeleteQueries( ( GLsizei )oFrame.vQueries.size(), &oFrame.vQueries[ 0 ] );
+
+			oFrame.vQueries.clear();
+			oFrame.vEvents.clear();
+			oFrame.iQueryNb = 0;
+			oFrame.bRecorded = false;
+		}
+
+		s_vScopes.clear();
+		s_vCpuHistory.clear();
+		s_vGpuHistory.clear();
+		s_vOpenEvents.clear();
+		s_dTraceEvents.clear();
+		s_iHistoryPosition = 0;
+		s_iHistoryLength = 0;
+		s_iCurrentFrame = 0;
+		s_iFrameNb = 0;
+		s_bInitialized = false;
+	}
+}
+
+#endif /* OGLF_PROFILING */
@@ -0,0 +1,226 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+// the profiler is only compiled when OGLF_PROFILING is defined, by the Debug and release debug configurations:
+// the profiling macros expand to nothing otherwise
+#ifdef OGLF_PROFILING
+
+#include <GL/glew.h>
+#include <string>
+#include <vector>
+#include <deque>
+
+#define OGLF_PROFILE_CONCAT2( a, b )		a##b
+#define OGLF_PROFILE_CONCAT( a, b )		OGLF_PROFILE_CONCAT2( a, b )
+
+// times the CPU execution of the enclosing block
+#define OGLF_PROFILE_SCOPE( sName )		Oglf::ProfileScope OGLF_PROFILE_CONCAT( oProfileScope, __LINE__ )( sName, false )
+// times the CPU execution and the GPU execution of the OpenGL commands of the enclosing block
+#define OGLF_PROFILE_GPU_SCOPE( sName )	Oglf::ProfileScope OGLF_PROFILE_CONCAT( oProfileScope, __LINE__ )( sName, true )
+// ends a frame, to be called once per frame after the buffers swap
+#define OGLF_PROFILE_NEXT_FRAME()		Oglf::Profiler::nextFrame()
+
+#else
+
+#define OGLF_PROFILE_SCOPE( sName )
+#define OGLF_PROFILE_GPU_SCOPE( sName )
+#define OGLF_PROFILE_NEXT_FRAME()
+
+#endif
+
+#ifdef OGLF_PROFILING
+
+namespace Oglf
+{
+	const int PROFILER_HISTORY_LENGTH = 128;	// frames kept in the scopes history and in the exported traces
+	const int PROFILER_FRAME_LATENCY = 3;		// frames recorded before their GPU timings are read back
+
+	/**
+	* @brief the statistics of a profiled scope over the history frames
+	*/
+	struct ProfileScopeStats
+	{
+		const char*	sName;
+		int			iDepth;			// nesting depth of the scope, 0 for the outermost scopes
+		bool		bGpu;			// the scope GPU execution is timed
+		float		fCpuAverage;	// average CPU time per frame in ms
+		float		fCpuMax;
+		float		fGpuAverage;	// average GPU time per frame in ms, negative when unknown
+		float		fGpuMax;
+		int			iCallNb;		// times the scope was entered during the last frame read back
+	};
+
+	/**
+	* class Profiler records the profiled scopes of the rendering thread. The scopes of a frame are timed on the
+	* CPU and, for the GPU scopes, with OpenGL timestamp queries that are only read back PROFILER_FRAME_LATENCY
+	* frames later so that the CPU never waits for the GPU. The times of the last PROFILER_HISTORY_LENGTH frames
+	* are kept for each scope and can be exported to the Chrome trace_event JSON format (chrome://tracing).
+	* The scopes must only be used from the thread owning the OpenGL context.
+	*/
+	class Profiler
+	{
+		/**
+		* @brief a scope execution
+		*/
+		struct ProfileEvent
+		{
+			int		iScope;
+			int		iDepth;
+			double	dCpuStart;		// in seconds, see getTime()
+			double	dCpuEnd;
+			int		iBeginQuery;	// timestamp queries index in the frame queries, -1 for CPU scopes
+			int		iEndQuery;
+			double	dGpuStart;		// in seconds on the GPU clock, negative when unknown
+			double	dGpuEnd;
+		};
+
+		/**
+		* @brief a frame being recorded or waiting for its GPU timings
+		*/
+		struct FrameData
+		{
+			std::vector< ProfileEvent >	vEvents;
+			std::vector< GLuint >		vQueries;
+			size_t						iQueryNb;	// queries used by the frame
+			double						dStart;
+			double						dEnd;
+			bool						bRecorded;
+		};
+
+		/**
+		* @brief an event of a frame that has been read back, kept for the trace export
+		*/
+		struct TraceEvent
+		{
+			ProfileEvent	oEvent;
+			unsigned int	iFrame;
+		};
+
+		static std::vector< ProfileScopeStats >	s_vScopes;
+		static std::vector< float >				s_vCpuHistory;		// PROFILER_HISTORY_LENGTH values per scope
+		static std::vector< float >				s_vGpuHistory;
+		static float							s_pFrameHistory[ PROFILER_HISTORY_LENGTH ];
+		static int								s_iHistoryPosition;	// slot of the next frame read back
+		static int								s_iHistoryLength;
+		static FrameData						s_pFrames[ PROFILER_FRAME_LATENCY ];
+		static int								s_iCurrentFrame;
+		static unsigned int						s_iFrameNb;
+		static std::vector< int >				s_vOpenEvents;		// the events of the scopes currently entered
+		static std::deque< TraceEvent >			s_dTraceEvents;
+		static bool								s_bGpuTiming;
+		static bool								s_bInitialized;
+
+		static void initialize();
+		static int findScope( const char* sName, bool bGpu );
+		static GLuint getQuery( FrameData& oFrame, int& iQuery );
+		static void readBack( FrameData& oFrame );
+
+	public:
+
+		/**
+		* @brief enters a scope, called by ProfileScope
+		* @param sName the scope name, it must stay valid while the profiler is used
+		* @param bGpu true: the scope GPU execution is timed
+		* @return the scope event
+		*/
+		static int beginScope( const char* sName, bool bGpu );
+
+		/**
+		* @brief leaves a scope, called by ProfileScope
+		* @param iEvent the scope event
+		*/
+		static void endScope( int iEvent );
+
+		/**
+		* @brief ends the current frame and reads back the frame recorded PROFILER_FRAME_LATENCY frames ago
+		*/
+		static void nextFrame();
+
+		/**
+		* @brief returns the number of scopes profiled so far
+		* @return the number of scopes
+		*/
+		static int getScopeNb()
+		{
+			return ( int )s_vScopes.size();
+		}
+
+		/**
+		* @brief returns the statistics of a scope
+		* @param iScope the scope, in the order they were first entered
+		* @return the scope statistics
+		*/
+		static const ProfileScopeStats& getScopeStats( int iScope )
+		{
+			return s_vScopes[ iScope ];
+		}
+
+		/**
+		* @brief returns the number of frames in the history
+		* @return the number of frames read back, at most PROFILER_HISTORY_LENGTH
+		*/
+		static int getHistoryLength()
+		{
+			return s_iHistoryLength;
+		}
+
+		/**
+		* @brief returns the CPU time of a scope during a history frame
+		* @param iScope the scope
+		* @param iFrame the frame, from 0 for the oldest to getHistoryLength() - 1 for the last one read back
+		* @return the time in ms
+		*/
+		static float getCpuTime( int iScope, int iFrame );
+
+		/**
+		* @brief returns the GPU time of a scope during a history frame
+		* @param iScope the scope
+		* @param iFrame the frame, from 0 for the oldest to getHistoryLength() - 1 for the last one read back
+		* @return the time in ms, negative when unknown
+		*/
+		static float getGpuTime( int iScope, int iFrame );
+
+		/**
+		* @brief returns the duration of a history frame, from one nextFrame() call to the next
+		* @param iFrame the frame, from 0 for the oldest to getHistoryLength() - 1 for the last one read back
+		* @return the time in ms
+		*/
+		static float getFrameTime( int iFrame );
+
+		/**
+		* @brief writes the scopes of the history frames to a Chrome trace_event JSON file
+		* @param sFilename the file name
+		*/
+		static void exportChromeTrace( const std::string& sFilename );
+
+		/**
+		* @brief deletes the timestamp queries and clears the recorded data, to be called while the OpenGL
+		* context still exists
+		*/
+		static void release();
+	};
+
+	/**
+	* class ProfileScope times its lifetime, see OGLF_PROFILE_SCOPE and OGLF_PROFILE_GPU_SCOPE
+	*/
+	class ProfileScope
+	{
+		int m_iEvent;
+
+	public:
+
+		ProfileScope( const char* sName, bool bGpu )
+			: m_iEvent( Profiler::beginScope( sName, bGpu ) )
+		{
+		}
+
+		~ProfileScope()
+		{
+			Profiler::endScope( m_iEvent );
+		}
+	};
+}
+
+#endif /* OGLF_PROFILING */
+
+#endif /* PROFILER_H */
@@ -1,6 +1,7 @@
 #include "Quaternion.h"
 #include <math.h>
 #include "Vec.h"
+#include "Matrix.h"
 
 
 namespace Oglf
@@ -71,5 +72,296 @@ namespace Oglf
 
 		// Now matrix[] is a 4x4 homogeneous matrix that can be applied to an OpenGL Matrix
 	}
-}
 
+	/**
+	* @brief scales the quaternion to a unit one, products of unit quaternions drift away from it with rounding
+	*/
+	void Quaternion::normalize()
+	{
+		float invLength = 1.f / sqrt( length2() );
+
+		m_w *= invLength;
+		m_x *= invLength;
+		m_y *= invLength;
+		m_z *= invLength;
+	}
+
+	/**
+	* @brief rotates a vector by the unit quaternion
+	* @param v the vector
+	* @return the rotated vector
+	*/
+	Vec3 Quaternion::rotateVector(const Vec3& v) const
+	{
+		// v' = v + 2w (u x v) + 2 u x (u x v), u being the vector part of the quaternion
+		Vec3 u(m_x, m_y, m_z);
+		Vec3 t = 2.f * (u ^ v);
+
+		return v + m_w * t + (u ^ t);
+	}
+
+	/**
+	* @brief writes the rotation matrix of the quaternion, the transpose of the createRotationMatrix() one: this is
+	* the matrix that rotates the column vectors by the quaternion. The quaternion does not need to be a unit one.
+	* @param matrix the 3x3 part of an OpenGL compliant 4x4 matrix, its other coefficients are not written
+	*/
+	void Quaternion::toMatrix(float* matrix) const
+	{
+		// dividing by the squared norm keeps the matrix orthogonal while the quaternion drifts from a unit one
+		float s = 2.f / length2();
+
+		// First column
+		matrix[0]  = 1.0f - s * ( m_y * m_y + m_z * m_z );
+		matrix[1]  = s * ( m_x * m_y + m_z * m_w );
+		matrix[2]  = s * ( m_x * m_z - m_y * m_w );
+
+		// Second column
+		matrix[4]  = s * ( m_x * m_y - m_z * m_w );
+		matrix[5]  = 1.0f - s * ( m_x * m_x + m_z * m_z );
+		matrix[6]  = s * ( m_y * m_z + m_x * m_w );
+
+		// Third column
+		matrix[8]  = s * ( m_x * m_z + m_y * m_w );
+		matrix[9]  = s * ( m_y * m_z - m_x * m_w );
+		matrix[10] = 1.0f - s * ( m_x * m_x + m_y * m_y );
+	}
+
+	/**
+	* @brief sets the unit quaternion of a rotation matrix, the inverse of toMatrix()
+	* @param matrix an OpenGL compliant 4x4 matrix whose 3x3 part is a rotation
+	*/
+	void Quaternion::fromMatrix(const float* matrix)
+	{
+		// (row,column) coefficients of the column major matrix
+		float m00 = matrix[0], m10 = matrix[1], m20 = matrix[2];
+		float m01 = matrix[4], m11 = matrix[5], m21 = matrix[6];
+		float m02 = matrix[8], m12 = matrix[9], m22 = matrix[10];
+		float trace = m00 + m11 + m22;
+
+		// the square root is taken of the largest of the 4 candidates, which keeps the division accurate
+		if( trace > 0.f )
+		{
+			float s = 2.f * sqrt( trace + 1.f );
+			m_w = 0.25f * s;
+			m_x = ( m21 - m12 ) / s;
+			m_y = ( m02 - m20 ) / s;
+			m_z = ( m10 - m01 ) / s;
+		}
+		else if( m00 > m11 && m00 > m22 )
+		{
+			float s = 2.f * sqrt( 1.f + m00 - m11 - m22 );
+			m_w = ( m21 - m12 ) / s;
+			m_x = 0.25f * s;
+			m_y = ( m01 + m10 ) / s;
+			m_z = ( m02 + m20 ) / s;
+		}
+		else if( m11 > m22 )
+		{
+			float s = 2.f * sqrt( 1.f + m11 - m00 - m22 );
+			m_w = ( m02 - m20 ) / s;
+			m_x = ( m01 + m10 ) / s;
+			m_y = 0.25f * s;
+			m_z = ( m12 + m21 ) / s;
+		}
+		else
+		{
+			float s = 2.f * sqrt( 1.f + m22 - m00 - m11 );
+			m_w = ( m10 - m01 ) / s;
+			m_x = ( m02 + m20 ) / s;
+			m_y = ( m12 + m21 ) / s;
+			m_z = 0.25f * s;
+		}
+
+		normalize();
+	}
+	/**
+	* @brief returns the rotation of the unit quaternion as an angle and an axis
+	* @param angle the rotation angle in degrees, in [0, 360]
+	* @param axis the unit rotation axis, the X axis for the identity
+	*/
+	void Quaternion::toAxisAngle(float& angle, Vec3& axis) const
+	{
+		float w = m_w < -1.f ? -1.f : (m_w > 1.f ? 1.f : m_w);
+		float sinHalfAngle = sqrt(1.f - w * w);
+
+		angle = 2.f * acos(w) * (180.f / (float)M_PI);
+
+		if(sinHalfAngle > 1e-6f)
+			axis = Vec3(m_x / sinHalfAngle, m_y / sinHalfAngle, m_z / sinHalfAngle);
+		else
+			axis = Vec3(1.f, 0.f, 0.f);
+	}
+
+	/**
+	* @brief sets the rotation that maps the X, Y and Z axes onto three orthonormal axes
+	* @param xAxis the X axis image
+	* @param yAxis the Y axis image
+	* @param zAxis the Z axis image
+	*/
+	void Quaternion::fromAxes(const Vec3& xAxis, const Vec3& yAxis, const Vec3& zAxis)
+	{
+		// the axes are the columns of the rotation matrix
+		float matrix[16];
+		for(int i=0; i<3; i++)
+		{
+			matrix[i] = xAxis.v[i];
+			matrix[4+i] = yAxis.v[i];
+			matrix[8+i] = zAxis.v[i];
+		}
+
+		fromMatrix(matrix);
+	}
+
+	/**
+	* @brief interpolates two unit quaternions linearly and normalizes the result, along the shortest arc. The
+	* angular speed is not constant but it is much cheaper than slerp() and close to it for small angles.
+	* @param a the rotation at t = 0
+	* @param b the rotation at t = 1
+	* @param t the interpolation factor
+	* @return the interpolated unit quaternion
+	*/
+	Quaternion Quaternion::nlerp(const Quaternion& a, const Quaternion& b, float t)
+	{
+		// q and -q stand for the same rotation, the one closest to a gives the shortest arc
+		float tb = a.dot(b) < 0.f ? -t : t;
+
+		return (a * (1.f - t) + b * tb).getNormalized();
+	}
+
+	/**
+	* @brief interpolates two unit quaternions at a constant angular speed along the shortest arc
+	* @param a the rotation at t = 0
+	* @param b the rotation at t = 1
+	* @param t the interpolation factor
+	* @return the interpolated unit quaternion
+	*/
+	Quaternion Quaternion::slerp(const Quaternion& a, const Quaternion& b, float t)
+	{
+		float cosAngle = a.dot(b);
+		float sign = 1.f;
+
+		if(cosAngle < 0.f)
+		{
+			cosAngle = -cosAngle;
+			sign = -1.f;
+		}
+
+		// the sine of nearly aligned quaternions is too small to divide by, they are close enough for nlerp
+		if(cosAngle > 0.9995f)
+			return nlerp(a, b, t);
+
+		float angle = acos(cosAngle);
+		float invSin = 1.f / sin(angle);
+		float wa = sin((1.f - t) * angle) * invSin;
+		float wb = sin(t * angle) * invSin * sign;
+
+		return a * wa + b * wb;
+	}
+
+	/**
+	* @brief writes the rotation matrix of a quaternion and the zero translation of its 4x4 matrix
+	* @param q the quaternion
+	* @param matrix the matrix coefficients
+	*/
+	static inline void toMatrixScalar(const Quaternion& q, float* matrix)
+	{
+		q.toMatrix(matrix);
+
+		matrix[3] = matrix[7] = matrix[11] = 0.f;
+		matrix[12] = matrix[13] = matrix[14] = 0.f;
+		matrix[15] = 1.f;
+	}
+
+#ifdef OGLF_SSE2
+
+	/**
+	* @brief converts the quaternions with SSE, 4 at once: the 4 quaternions are transposed to w, x, y and z vectors,
+	* from which 4 values of each matrix coefficient are computed, then each column of the 4 matrices is transposed back
+	* @param pQuaternions the quaternions coefficients
+	* @param pMatrices the matrices coefficients
+	* @param iNb the number of quaternions
+	* @return the number of quaternions converted, a multiple of 4
+	*/
+	static int toMatricesSSE(const float* pQuaternions, float* pMatrices, int iNb)
+	{
+		const __m128 oOne = _mm_set1_ps(1.f);
+		const __m128 oTwo = _mm_set1_ps(2.f);
+		const __m128 oZero = _mm_setzero_ps();
+		const __m128 oLastColumn = _mm_setr_ps(0.f, 0.f, 0.f, 1.f);
+
+		int i = 0;
+		for(; i + 4 <= iNb; i += 4)
+		{
+			const float* pQ = pQuaternions + 4 * i;
+			float* pM = pMatrices + 16 * i;
+
+			__m128 w = _mm_loadu_ps(pQ);
+			__m128 x = _mm_loadu_ps(pQ + 4);
+			__m128 y = _mm_loadu_ps(pQ + 8);
+			__m128 z = _mm_loadu_ps(pQ + 12);
+			_MM_TRANSPOSE4_PS(w, x, y, z);
+
+			// as in toMatrix(), dividing by the squared norm keeps the matrices orthogonal
+			__m128 s = _mm_div_ps(oTwo, _mm_add_ps(_mm_add_ps(_mm_mul_ps(w, w), _mm_mul_ps(x, x)), _mm_add_ps(_mm_mul_ps(y, y), _mm_mul_ps(z, z))));
+			__m128 xs = _mm_mul_ps(x, s);
+			__m128 ys = _mm_mul_ps(y, s);
+			__m128 zs = _mm_mul_ps(z, s);
+
+			__m128 wx = _mm_mul_ps(w, xs), wy = _mm_mul_ps(w, ys), wz = _mm_mul_ps(w, zs);
+			__m128 xx = _mm_mul_ps(x, xs), xy = _mm_mul_ps(x, ys), xz = _mm_mul_ps(x, zs);
+			__m128 yy = _mm_mul_ps(y, ys), yz = _mm_mul_ps(y, zs), zz = _mm_mul_ps(z, zs);
+
+			// each column is computed for the 4 matrices, then transposed to the 4 matrices columns
+			__m128 c0 = _mm_sub_ps(oOne, _mm_add_ps(yy, zz)), c1 = _mm_add_ps(xy, wz), c2 = _mm_sub_ps(xz, wy), c3 = oZero;
+			_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+			_mm_storeu_ps(pM, c0);
+			_mm_storeu_ps(pM + 16, c1);
+			_mm_storeu_ps(pM + 32, c2);
+			_mm_storeu_ps(pM + 48, c3);
+
+			c0 = _mm_sub_ps(xy, wz); c1 = _mm_sub_ps(oOne, _mm_add_ps(xx, zz)); c2 = _mm_add_ps(yz, wx); c3 = oZero;
+			_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+			_mm_storeu_ps(pM + 4, c0);
+			_mm_storeu_ps(pM + 20, c1);
+			_mm_storeu_ps(pM + 36, c2);
+			_mm_storeu_ps(pM + 52, c3);
+
+			c0 = _mm_add_ps(xz, wy); c1 = _mm_sub_ps(yz, wx); c2 = _mm_sub_ps(oOne, _mm_add_ps(xx, yy)); c3 = oZero;
+			_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+			_mm_storeu_ps(pM + 8, c0);
+			_mm_storeu_ps(pM + 24, c1);
+			_mm_storeu_ps(pM + 40, c2);
+			_mm_storeu_ps(pM + 56, c3);
+
+			_mm_storeu_ps(pM + 12, oLastColumn);
+			_mm_storeu_ps(pM + 28, oLastColumn);
+			_mm_storeu_ps(pM + 44, oLastColumn);
+			_mm_storeu_ps(pM + 60, oLastColumn);
+		}
+
+		return i;
+	}
+
+#endif
+
+	/**
+	* @brief writes the rotation matrices of an array of quaternions, with a zero translation. The quaternions
+	* are converted 4 at once with SSE on the x86 CPUs supporting it.
+	* @param pQuaternions the quaternions, which do not need to be unit ones
+	* @param pMatrices the matrices
+	* @param iNb the number of quaternions
+	*/
+	void Quaternion::toMatrices(const Quaternion* pQuaternions, Matrix4x4* pMatrices, int iNb)
+	{
+		int i = 0;
+
+#ifdef OGLF_SSE2
+		// a Matrix4x4 is made of its 16 coefficients only, the array is a contiguous coefficients array
+		if(iNb > 0 && CpuFeatures::get().bSSE2)
+			i = toMatricesSSE(&pQuaternions[0].m_w, pMatrices[0].m, iNb);
+#endif
+
+		for(; i < iNb; i++)
+			toMatrixScalar(pQuaternions[i], pMatrices[i].m);
+	}
+}
@@ -2,14 +2,18 @@
 #define QUATERNION_H
 
 #include "Error.h"
+#include "Vec.h"
 
 
 namespace Oglf
 {
+	class Matrix4x4;
+
 	/**
 	* @class Quaternion used to handle 3D rotations using quaternions totally inspired from the Vic Hollis
 	* NeHe quaternion camera tutorial.
 	* http://nehe.gamedev.net/data/lessons/lesson.asp?lesson=Quaternion_Camera_Class
+	* The coefficients are stored as 4 consecutive floats w, x, y, z, which the batch conversions rely on.
 	*/
 	class Quaternion
 	{
@@ -28,6 +32,97 @@ namespace Oglf
 			m_z = 0.0;
 		}
 
+		Quaternion(float w, float x, float y, float z)
+		{
+			m_w = w;
+			m_x = x;
+			m_y = y;
+			m_z = z;
+		}
+
+		float getW() const { return m_w; }
+		float getX() const { return m_x; }
+		float getY() const { return m_y; }
+		float getZ() const { return m_z; }
+
+		/**
+		* @brief sets the quaternion to the identity rotation
+		*/
+		void identity()
+		{
+			m_w = 1.0;
+			m_x = m_y = m_z = 0.0;
+		}
+
+		/**
+		* @brief returns the conjugate quaternion, the inverse rotation of a unit quaternion
+		* @return the conjugate
+		*/
+		Quaternion getConjugate() const
+		{
+			return Quaternion(m_w, -m_x, -m_y, -m_z);
+		}
+
+		/**
+		* @brief returns the inverse quaternion, the conjugate divided by the squared norm
+		* @return the inverse
+		*/
+		Quaternion getInverse() const
+		{
+			return getConjugate() * (1.f / length2());
+		}
+
+		/**
+		* @brief returns the dot product of two quaternions, the cosine of half the angle between two unit ones
+		* @param q another quaternion
+		* @return the dot product
+		*/
+		float dot(const Quaternion& q) const
+		{
+			return m_w*q.m_w + m_x*q.m_x + m_y*q.m_y + m_z*q.m_z;
+		}
+
+		/**
+		* @brief returns the squared norm of the quaternion
+		* @return the squared norm
+		*/
+		float length2() const
+		{
+			return m_w*m_w + m_x*m_x + m_y*m_y + m_z*m_z;
+		}
+
+		/**
+		* @brief returns the norm of the quaternion
+		* @return the norm
+		*/
+		float length() const
+		{
+			return sqrt(length2());
+		}
+
+		/**
+		* @brief scales the quaternion to a unit one, products of unit quaternions drift away from it with rounding
+		*/
+		void normalize();
+
+		/**
+		* @brief returns the unit quaternion of the same rotation
+		* @return the normalized quaternion
+		*/
+		Quaternion getNormalized() const
+		{
+			Quaternion q(*this);
+			q.normalize();
+			return q;
+		}
+
+		/**
+		* @brief rotates a vector by the unit quaternion
+		* @param v the vector
+		* @return the rotated vector
+		*/
+		Vec3 rotateVector(const Vec3& v) const;
+
 		/**
 		* @brief creates a quaternion to build then a rotation matrix
 		* @param angle the rotation angle in degrees
@@ -37,6 +132,21 @@ namespace Oglf
 		*/
 		void createRotation(float angle, float x, float y, float z);
 
+		/**
+		* @brief returns the rotation of the unit quaternion as an angle and an axis
+		* @param angle the rotation angle in degrees, in [0, 360]
+		* @param axis the unit rotation axis, the X axis for the identity
+		*/
+		void toAxisAngle(float& angle, Vec3& axis) const;
+
+		/**
+		* @brief sets the rotation that maps the X, Y and Z axes onto three orthonormal axes
+		* @param xAxis the X axis image
+		* @param yAxis the Y axis image
+		* @param zAxis the Z axis image
+		*/
+		void fromAxes(const Vec3& xAxis, const Vec3& yAxis, const Vec3& zAxis);
+
 		/**
 		* @brief creates a rotation matrix from the current set up quaternion
 		* @param matrix a 4x4 homogeneous matrix (this matrix is supposed OpenGL compliant, i.e it is
@@ -44,12 +154,82 @@ namespace Oglf
 		*/
 		void createRotationMatrix(float* matrix);
 
+		/**
+		* @brief writes the rotation matrix of the quaternion, the transpose of the createRotationMatrix() one: this is
+		* the matrix that rotates the column vectors by the quaternion. The quaternion does not need to be a unit one.
+		* @param matrix the 3x3 part of an OpenGL compliant 4x4 matrix, its other coefficients are not written
+		*/
+		void toMatrix(float* matrix) const;
+
+		/**
+		* @brief sets the unit quaternion of a rotation matrix, the inverse of toMatrix()
+		* @param matrix an OpenGL compliant 4x4 matrix whose 3x3 part is a rotation
+		*/
+		void fromMatrix(const float* matrix);
+
+		/**
+		* @brief writes the rotation matrices of an array of quaternions, with a zero translation. The quaternions
+		* are converted 4 at once with SSE on x86 targets.
+		* @param pQuaternions the quaternions, which do not need to be unit ones
+		* @param pMatrices the matrices
+		* @param iNb the number of quaternions
+		*/
+		static void toMatrices(const Quaternion* pQuaternions, Matrix4x4* pMatrices, int iNb);
+
+		/**
+		* @brief interpolates two unit quaternions linearly and normalizes the result, along the shortest arc. The
+		* angular speed is not constant but it is much cheaper than slerp() and close to it for small angles.
+		* @param a the rotation at t = 0
+		* @param b the rotation at t = 1
+		* @param t the interpolation factor
+		* @return the interpolated unit quaternion
+		*/
+		static Quaternion nlerp(const Quaternion& a, const Quaternion& b, float t);
+
+		/**
+		* @brief interpolates two unit quaternions at a constant angular speed along the shortest arc
+		* @param a the rotation at t = 0
+		* @param b the rotation at t = 1
+		* @param t the interpolation factor
+		* @return the interpolated unit quaternion
+		*/
+		static Quaternion slerp(const Quaternion& a, const Quaternion& b, float t);
+
+		/**
+		* @brief operator + to sum quaternions
+		* @param q another quaternion
+		* @return the sum
+		*/
+		Quaternion operator+(const Quaternion& q) const
+		{
+			return Quaternion(m_w + q.m_w, m_x + q.m_x, m_y + q.m_y, m_z + q.m_z);
+		}
+
+		/**
+		* @brief operator - to negate a quaternion, the opposite quaternion stands for the same rotation
+		* @return the opposite quaternion
+		*/
+		Quaternion operator-() const
+		{
+			return Quaternion(-m_w, -m_x, -m_y, -m_z);
+		}
+
+		/**
+		* @brief operator * to scale a quaternion
+		* @param s the scale factor
+		* @return the scaled quaternion
+		*/
+		Quaternion operator*(float s) const
+		{
+			return Quaternion(m_w * s, m_x * s, m_y * s, m_z * s);
+		}
+
 		/**
 		* @brief operator * to allow quaternions multiplications
 		* @param q another quaternion
 		* @return the result of the quaternions multiplication
 		*/
-		Quaternion operator*(Quaternion q)
+		Quaternion operator*(const Quaternion& q) const
 		{
 			Quaternion r;
 
@@ -0,0 +1,131 @@
+#include "RenderStats.h"
+
+namespace Oglf
+{
+	unsigned int	RenderStats::s_iDrawCallNb = 0;
+	unsigned int	RenderStats::s_iStateChangeNb = 0;
+	unsigned int	RenderStats::s_iTriangleNb = 0;
+
+	unsigned int	RenderStats::s_iLastDrawCallNb = 0;
+	unsigned int	RenderStats::s_iLastStateChangeNb = 0;
+	unsigned int	RenderStats::s_iLastTriangleNb = 0;
+	int				RenderStats::s_iLastCulledTriangleNb = -1;
+
+	GLuint			RenderStats::s_pInputQueries[ RENDER_STATS_QUERY_LATENCY ];
+	GLuint			RenderStats::s_pOutputQueries[ RENDER_STATS_QUERY_LATENCY ];
+	bool			RenderStats::s_pQueryIssued[ RENDER_STATS_QUERY_LATENCY ];
+	int				RenderStats::s_iCurrentQuery = 0;
+	bool			RenderStats::s_bQueryActive = false;
+	bool			RenderStats::s_bPipelineStatistics = false;
+
+	/**
+	* @brief starts counting the culled triangles, called once per frame before the scene meshes are drawn
+	*/
+	void RenderStats::beginCullingQueries()
+	{
+		if( !s_bPipelineStatistics || s_bQueryActive )
+			return;
+
+		glBeginQuery( GL_CLIPPING_INPUT_PRIMITIVES_ARB, s_pInputQueries[ s_iCurrentQuery ] );
+		glBeginQuery( GL_CLIPPING_OUTPUT_PRIMITIVES_ARB, s_pOutputQueries[ s_iCurrentQuery ] );
+		s_bQueryActive = true;
+	}
+
+	/**
+	* @brief stops counting the culled triangles, called once the scene meshes are drawn
+	*/
+	void RenderStats::endCullingQueries()
+	{
+		if( !s_bQueryActive )
+			return;
+
+		glEndQuery( GL_CLIPPING_INPUT_PRIMITIVES_ARB );
+		glEndQuery( GL_CLIPPING_OUTPUT_PRIMITIVES_ARB );
+		s_pQueryIssued[ s_iCurrentQuery ] = true;
+		s_bQueryActive = false;
+	}
+
+	/**
+	* @brief ends the current frame, to be called once per frame after the buffers swap
+	*/
+	void RenderStats::nextFrame()
+	{
+		s_iLastDrawCallNb = s_iDrawCallNb;
+		s_iLastStateChangeNb = s_iStateChangeNb;
+		s_iLastTriangleNb = s_iTriangleNb;
+		s_iDrawCallNb = 0;
+		s_iStateChangeNb = 0;
+		s_iTriangleNb = 0;
+
+		if( !s_bPipelineStatistics )
+			return;
+
+		endCullingQueries();
+
+		// the oldest queries are read back before being reused by the next frame
+		s_iCurrentQuery = ( s_iCurrentQuery + 1 ) % RENDER_STATS_QUERY_LATENCY;
+		if( s_pQueryIssued[ s_iCurrentQuery ] )
+		{
+			GLuint iAvailable = GL_FALSE;
+			glGetQueryObjectuiv( s_pOutputQueries[ s_iCurrentQuery ], GL_QUERY_RESULT_AVAILABLE, &iAvailable );
+			if( iAvailable == GL_TRUE )
+			{
+				GLuint iInputNb = 0;
+				GLuint iOutputNb = 0;
+				glGetQueryObjectuiv( s_pInputQueries[ s_iCurrentQuery ], GL_QUERY_RESULT, &iInputNb );
+				glGetQueryObjectuiv( s_pOutputQueries[ s_iCurrentQuery ], GL_QUERY_RESULT, &iOutputNb );
+
+				// the clipping stage may split a primitive into several ones
+				s_iLastCulledTriangleNb = iInputNb > iOutputNb ? ( int )( iInputNb - iOutputNb ) : 0;
+			}
+			s_pQueryIssued[ s_iCurrentQuery ] = false;
+		}
+	}
+
+	/**
+	* @brief enables the pipeline statistics queries counting the culled triangles
+	* @param bEnable true: the queries are issued every frame, false: the culled triangles are unknown
+	*/
+	void RenderStats::setPipelineStatistics( bool bEnable )
+	{
+		if( bEnable && !GLEW_ARB_pipeline_statistics_query )
+			bEnable = false;
+
+		if( bEnable == s_bPipelineStatistics )
+			return;
+
+		if( bEnable )
+		{
+			if( s_pInputQueries[ 0 ] == 0 )
+			{
+				glGenQueries( RENDER_STATS_QUERY_LATENCY, s_pInputQueries );
+				glGenQueries( RENDER_STATS_QUERY_LATENCY, s_pOutputQueries );
+			}
+
+			for( int i = 0; i < RENDER_STATS_QUERY_LATENCY; ++i )
+				s_pQueryIssued[ i ] = false;
+		}
+		else
+		{
+			endCullingQueries();
+		}
+
+		s_bPipelineStatistics = bEnable;
+		s_iLastCulledTriangleNb = -1;
+	}
+
+	/**
+	* @brief deletes the queries, to be called while the OpenGL context still exists
+	*/
+	void RenderStats::release()
+	{
+		setPipelineStatistics( false );
+
+		if( s_pInputQueries[ 0 ] != 0 )
+		{
+			glDeleteQueries( RENDER_STATS_QUERY_LATENCY, s_pInputQueries );
+			glDeleteQueries( RENDER_STATS_QUERY_LATENCY, s_pOutputQueries );
+			s_pInputQueries[ 0 ] = 0;
+		}
+	}
+}
@@ -0,0 +1,122 @@
+#ifndef RENDERSTATS_H
+#define RENDERSTATS_H
+
+#include <GL/glew.h>
+
+
+namespace Oglf
+{
+	const int RENDER_STATS_QUERY_LATENCY = 3;	// frames recorded before their pipeline statistics are read back
+
+	/**
+	* class RenderStats counts the draw calls, the state changes and the triangles submitted by the rendering thread
+	* during a frame. The counters are incremented by the framework draw and bind calls and are cheap enough to be
+	* always enabled. The scene triangles culled by the clipping stage are counted with pipeline statistics queries
+	* when they are enabled and ARB_pipeline_statistics_query is supported, their results are only read back
+	* RENDER_STATS_QUERY_LATENCY frames later so that the CPU never waits for the GPU. The queries only bracket the
+	* scene meshes: the quads of the sky box and of the screen passes are split by the clipping stage and would be
+	* counted twice in its output.
+	*/
+	class RenderStats
+	{
+		static unsigned int	s_iDrawCallNb;
+		static unsigned int	s_iStateChangeNb;
+		static unsigned int	s_iTriangleNb;
+
+		static unsigned int	s_iLastDrawCallNb;
+		static unsigned int	s_iLastStateChangeNb;
+		static unsigned int	s_iLastTriangleNb;
+		static int			s_iLastCulledTriangleNb;	// negative when unknown
+
+		static GLuint		s_pInputQueries[ RENDER_STATS_QUERY_LATENCY ];	// primitives entering the clipping stage
+		static GLuint		s_pOutputQueries[ RENDER_STATS_QUERY_LATENCY ];	// primitives leaving the clipping stage
+		static bool			s_pQueryIssued[ RENDER_STATS_QUERY_LATENCY ];
+		static int			s_iCurrentQuery;
+		static bool			s_bQueryActive;
+		static bool			s_bPipelineStatistics;
+
+	public:
+
+		/**
+		* @brief counts a draw call
+		* @param iTriangleNb the number of triangles it submits
+		*/
+		static void addDrawCall( unsigned int iTriangleNb )
+		{
+			++s_iDrawCallNb;
+			s_iTriangleNb += iTriangleNb;
+		}
+
+		/**
+		* @brief counts a state change: a shader program, texture or framebuffer bind
+		*/
+		static void addStateChange()
+		{
+			++s_iStateChangeNb;
+		}
+
+		/**
+		* @brief starts counting the culled triangles, called once per frame before the scene meshes are drawn
+		*/
+		static void beginCullingQueries();
+
+		/**
+		* @brief stops counting the culled triangles, called once the scene meshes are drawn
+		*/
+		static void endCullingQueries();
+
+		/**
+		* @brief ends the current frame, to be called once per frame after the buffers swap
+		*/
+		static void nextFrame();
+
+		/**
+		* @brief enables the pipeline statistics queries counting the culled triangles
+		* @param bEnable true: the queries are issued every frame, false: the culled triangles are unknown
+		*/
+		static void setPipelineStatistics( bool bEnable );
+
+		/**
+		* @brief returns the number of draw calls of the last frame
+		* @return the number of draw calls
+		*/
+		static unsigned int getDrawCallNb()
+		{
+			return s_iLastDrawCallNb;
+		}
+
+		/**
+		* @brief returns the number of state changes of the last frame
+		* @return the number of state changes
+		*/
+		static unsigned int getStateChangeNb()
+		{
+			return s_iLastStateChangeNb;
+		}
+
+		/**
+		* @brief returns the number of triangles submitted during the last frame
+		* @return the number of triangles
+		*/
+		static unsigned int getTriangleNb()
+		{
+			return s_iLastTriangleNb;
+		}
+
+		/**
+		* @brief returns the number of scene triangles culled by the clipping stage during the last frame read back
+		* @return the number of triangles, negative when unknown
+		*/
+		static int getCulledTriangleNb()
+		{
+			return s_iLastCulledTriangleNb;
+		}
+
+		/**
+		* @brief deletes the queries, to be called while the OpenGL context still exists
+		*/
+		static void release();
+	};
+}
+
+#endif /* RENDERSTATS_H */
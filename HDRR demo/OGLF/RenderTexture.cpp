@@ -3,6 +3,8 @@
 
 namespace Oglf
 {
+	GLuint RenderTexture::s_iDefaultFramebufferID = 0;
+
 	/**
 	* @brief  set the texture to render to, which is set up in a Texture2D object
 	* @param  tex the texture to render to
@@ -16,6 +16,8 @@ namespace Oglf
 		Texture2D*	m_pTexture;
 		bool		m_bDepthTest;
 
+		static GLuint s_iDefaultFramebufferID;
+
 	public:
 
 	    /**
@@ -55,14 +57,32 @@ namespace Oglf
 
 		/**
 		* @brief  binds or unbinds the fbo
-		* @param  state true: fbo is bound, false: framebuffer is bound
+		* @param  state true: fbo is bound, false: the default framebuffer is bound
 		*/
 		void bind( bool state = true ) const
 		{
+			RenderStats::addStateChange();
 			if(state)
 				glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, m_iFramebufferID);
 			else
-				glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, 0);
+				glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, s_iDefaultFramebufferID);
+		}
+
+		/**
+		* @return the fbo handle
+		*/
+		GLuint getFramebufferID() const
+		{
+			return m_iFramebufferID;
+		}
+
+		/**
+		* @brief  sets the framebuffer bound when the fbos are unbound, the window framebuffer by default
+		* @param  iFramebufferID the framebuffer handle, 0 for the window framebuffer
+		*/
+		static void setDefaultFramebuffer( GLuint iFramebufferID )
+		{
+			s_iDefaultFramebufferID = iFramebufferID;
 		}
 	};
 }
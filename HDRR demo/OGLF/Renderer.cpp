@@ -3,6 +3,8 @@
 #include "CubeMap.h"
 #include "PostProcessingFX.h"
 #include "RenderTexture.h"
+#include "Profiler.h"
+#include "RenderStats.h"
 
 using namespace std;
 
@@ -12,6 +14,8 @@ namespace Oglf
 	*/
 	void Renderer::render ( )
 	{
+		OGLF_PROFILE_GPU_SCOPE( "Renderer::render" );
+
 		//static float a=0.01;
 		//a+=0.0001;
 
@@ -35,7 +39,9 @@ namespace Oglf
 				// clear frame buffer and depth buffer
 				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+				RenderStats::beginCullingQueries();
 				m_vScenes[m_iActiveScene]->drawElements();
+				RenderStats::endCullingQueries();
 				//Error::checkGLerror("Renderer::render");
 
 // 				glDisable( GL_LIGHTING );
@@ -61,6 +67,8 @@ namespace Oglf
 
 				if( m_bEnablePostProcessings )
 				{
+					OGLF_PROFILE_GPU_SCOPE( "Post-processing" );
+
 					m_pRenderOutputRTex->bind( false );
 					vector< PostProcessingFX* >::iterator oPPit;
 
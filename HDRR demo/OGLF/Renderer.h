@@ -34,7 +34,7 @@ namespace Oglf
 	};
 
 
-	class Renderer : public Core
+	class Renderer : public Core< MEMORY_SCENE >
 	{
 		std::vector< Scene* >					m_vScenes;
 		int									m_iActiveScene;
@@ -248,31 +248,28 @@ namespace Oglf
 		}
 
 		/**
-		* @brief  write a screenshot on the hard disk in the specified format
-		* @param  format the picture format: PNG format is the only format supported at the present time
-		* @param  filename the picture filename
+		* @brief  write a screenshot of the current framebuffer on the hard disk, the frame is read back synchronously:
+		* frame sequences are captured with FrameCapture
+		* @param  filename the PNG picture filename
 		*/
-		void screenshot(char* filename)
+		void screenshot(const char* filename)
 		{
 			GLubyte* data = new GLubyte[3* m_iScreenWidth * m_iScreenHeight];
 
-			glFinish();
-			glReadPixels(m_vScenes[m_iActiveScene]->getCamera().getViewportX(),
-				m_vScenes[m_iActiveScene]->getCamera().getViewportY(),
-				m_vScenes[m_iActiveScene]->getCamera().getViewportWidth(),
-				m_vScenes[m_iActiveScene]->getCamera().getViewportHeight(),
-				GL_RGB, GL_UNSIGNED_BYTE, data);
+			glPixelStorei(GL_PACK_ALIGNMENT, 1);
+			glReadPixels(0, 0, m_iScreenWidth, m_iScreenHeight, GL_RGB, GL_UNSIGNED_BYTE, data);
 
 			Error::checkGLerror("Renderer::screenshot");
 
-			std::cout<<"screenshot "<<m_vScenes[m_iActiveScene]->getCamera().getViewportX()<<" "
-				<<m_vScenes[m_iActiveScene]->getCamera().getViewportY()<<" "
-				<<m_vScenes[m_iActiveScene]->getCamera().getViewportWidth()<<" "
-				<<m_vScenes[m_iActiveScene]->getCamera().getViewportHeight()<<std::endl
-				<<"screen: "<<m_iScreenWidth<<" "<<m_iScreenHeight<<std::endl;
-
-
-			Texture::writeFile(PNG, filename, m_iScreenWidth, m_iScreenHeight, data);
+			try
+			{
+				Texture::writeFile(PNG, filename, m_iScreenWidth, m_iScreenHeight, data);
+			}
+			catch(Error e)
+			{
+				delete[] data;
+				throw;
+			}
 
 			delete[] data;
 		}
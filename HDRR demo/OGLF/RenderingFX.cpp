@@ -8,6 +8,25 @@ using namespace Oglf;
 
 unsigned short RFXtexture::texturesUnitMax = MAX(GL_MAX_TEXTURE_COORDS, GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS);
 
+// the upload functions by type, the samplers are bound by addTexture()
+static const RFXparameter::UploadFunction s_pfUploads[] =
+{
+	&RFXuniform< FR_INT >::upload,
+	&RFXuniform< FR_INT_VEC2 >::upload,
+	&RFXuniform< FR_INT_VEC3 >::upload,
+	&RFXuniform< FR_INT_VEC4 >::upload,
+	&RFXuniform< FR_FLOAT >::upload,
+	&RFXuniform< FR_FLOAT_VEC2 >::upload,
+	&RFXuniform< FR_FLOAT_VEC3 >::upload,
+	&RFXuniform< FR_FLOAT_VEC4 >::upload,
+	&RFXuniform< FR_FLOAT_MAT2 >::upload,
+	&RFXuniform< FR_FLOAT_MAT3 >::upload,
+	&RFXuniform< FR_FLOAT_MAT4 >::upload
+};
+
+// fails to compile when a uniform type has no upload function
+typedef char RFXuploadTableCheck[ sizeof( s_pfUploads ) / sizeof( s_pfUploads[ 0 ] ) == FR_SAMPLER1D ? 1 : -1 ];
+
 
 /**
  * @brief destructor, all clean up is done here
@@ -19,12 +38,6 @@ RenderingFX::~RenderingFX()
 
 	delete m_vertShader;
 	delete m_fragShader;
-
-	for(unsigned int i=0; i<m_parametersList.size(); i++)
-	{
-		delete m_parametersList[i];
-	}
-	m_parametersList.clear();
 }
 
 /**
@@ -53,76 +66,32 @@ void RenderingFX::setShaders(const char* vsName, const char* fsName)
  */
 unsigned int RenderingFX::addParameter(const void* param, RFXparamType type, const short size, const char* name)
 {
-	GLint location = glGetUniformLocation(m_program.getHandle(), name);
-
-	if(type == FR_FLOAT)
-	{
-		RFXfloat* p = new RFXfloat((float*)param, size, location);
-		m_parametersList.push_back(p);
-		return m_parametersList.size()-1;
-	}
-	else if(type == FR_FLOAT_VEC2)
-	{
-		RFXfloatVec2* p = new RFXfloatVec2((float*)param, size, location);
-		m_parametersList.push_back(p);
-		return m_parametersList.size()-1;
-	}
-	else if(type == FR_FLOAT_VEC3)
-	{
-		RFXfloatVec3* p = new RFXfloatVec3((float*)param, size, location);
-		m_parametersList.push_back(p);
-		return m_parametersList.size()-1;
-	}
-	else if(type == FR_FLOAT_VEC4)
-	{
-		RFXfloatVec4* p = new RFXfloatVec4((float*)param, size, location);
-		m_parametersList.push_back(p);
-		return m_parametersList.size()-1;
-	}
-	else if(type == FR_FLOAT_MAT2)
-	{
-		RFXfloatMat2* p = new RFXfloatMat2((float*)param, size, location);
-		m_parametersList.push_back(p);
-		return m_parametersList.size()-1;
-	}
-	else if(type == FR_FLOAT_MAT3)
+	if( type < 0 || type >= FR_SAMPLER1D )
 	{
-		RFXfloatMat3* p = new RFXfloatMat3((float*)param, size, location);
-		m_parametersList.push_back(p);
-		return m_parametersList.size()-1;
-	}
-	else if(type == FR_FLOAT_MAT4)
-	{
-		RFXfloatMat4* p = new RFXfloatMat4((float*)param, size, location);
-		m_parametersList.push_back(p);
-		return m_parametersList.size()-1;
-	}
-	else if(type == FR_INT)
-	{
-		RFXint* p = new RFXint((int*)param, size, location);
-		m_parametersList.push_back(p);
-		return m_parametersList.size()-1;
-	}
-	else if(type == FR_INT_VEC2)
-	{
-		RFXintVec2* p = new RFXintVec2((int*)param, size, location);
-		m_parametersList.push_back(p);
-		return m_parametersList.size()-1;
-	}
-	else if(type == FR_INT_VEC3)
-	{
-		RFXintVec3* p = new RFXintVec3((int*)param, size, location);
-		m_parametersList.push_back(p);
-		return m_parametersList.size()-1;
-	}
-	else if(type == FR_INT_VEC4)
-	{
-		RFXintVec4* p = new RFXintVec4((int*)param, size, location);
-		m_parametersList.push_back(p);
-		return m_parametersList.size()-1;
+		throw Error("RenderingFX::addParameter error: the samplers are added with addTexture");
 	}
 
-	return -1;
+	return addUniform( param, s_pfUploads[ type ], size, name );
+}
+
+/**
+ * @brief adds a parameter uploaded by a given function
+ * @param param the parameter data
+ * @param pfUpload the RFXuniform upload function of the parameter type
+ * @param size if the parameter is an array, say its size
+ * @param name the name of the uniform in the associated shader program
+ * @return the id of the added parameter in the parameter list
+ */
+unsigned int RenderingFX::addUniform( const void* param, RFXparameter::UploadFunction pfUpload, const short size, const char* name )
+{
+	RFXparameter oParameter;
+	oParameter.m_data = param;
+	oParameter.m_size = size;
+	oParameter.location = glGetUniformLocation(m_program.getHandle(), name);
+	oParameter.m_pfUpload = pfUpload;
+
+	m_parametersList.push_back( oParameter );
+	return m_parametersList.size()-1;
 }
 
 /**
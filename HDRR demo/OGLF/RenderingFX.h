@@ -9,6 +9,7 @@
 #include "GLSLshaderProgram.h"
 #include "Error.h"
 #include "Texture.h"
+#include "Core.h"
 
 
 namespace Oglf
@@ -35,181 +36,45 @@ namespace Oglf
 	};
 
 	/**
-	* @brief stores a parameter and manages assignment to a uniform variable in a shader program
+	* @brief uploads the uniforms of a parameter type: each type specializes it with the matching glUniform call, so
+	* that the call is chosen at compile time. Adding a type takes an RFXparamType value, its specialization and its
+	* entry in the table of RenderingFX::addParameter().
+	*/
+	template< RFXparamType T >
+	struct RFXuniform;
+
+	template<> struct RFXuniform< FR_INT >			{ static void upload( GLint iLocation, GLsizei iSize, const void* pData ) { glUniform1iv( iLocation, iSize, ( const GLint* )pData ); } };
+	template<> struct RFXuniform< FR_INT_VEC2 >		{ static void upload( GLint iLocation, GLsizei iSize, const void* pData ) { glUniform2iv( iLocation, iSize, ( const GLint* )pData ); } };
+	template<> struct RFXuniform< FR_INT_VEC3 >		{ static void upload( GLint iLocation, GLsizei iSize, const void* pData ) { glUniform3iv( iLocation, iSize, ( const GLint* )pData ); } };
+	template<> struct RFXuniform< FR_INT_VEC4 >		{ static void upload( GLint iLocation, GLsizei iSize, const void* pData ) { glUniform4iv( iLocation, iSize, ( const GLint* )pData ); } };
+	template<> struct RFXuniform< FR_FLOAT >			{ static void upload( GLint iLocation, GLsizei iSize, const void* pData ) { glUniform1fv( iLocation, iSize, ( const GLfloat* )pData ); } };
+	template<> struct RFXuniform< FR_FLOAT_VEC2 >	{ static void upload( GLint iLocation, GLsizei iSize, const void* pData ) { glUniform2fv( iLocation, iSize, ( const GLfloat* )pData ); } };
+	template<> struct RFXuniform< FR_FLOAT_VEC3 >	{ static void upload( GLint iLocation, GLsizei iSize, const void* pData ) { glUniform3fv( iLocation, iSize, ( const GLfloat* )pData ); } };
+	template<> struct RFXuniform< FR_FLOAT_VEC4 >	{ static void upload( GLint iLocation, GLsizei iSize, const void* pData ) { glUniform4fv( iLocation, iSize, ( const GLfloat* )pData ); } };
+	template<> struct RFXuniform< FR_FLOAT_MAT2 >	{ static void upload( GLint iLocation, GLsizei iSize, const void* pData ) { glUniformMatrix2fv( iLocation, iSize, GL_FALSE, ( const GLfloat* )pData ); } };
+	template<> struct RFXuniform< FR_FLOAT_MAT3 >	{ static void upload( GLint iLocation, GLsizei iSize, const void* pData ) { glUniformMatrix3fv( iLocation, iSize, GL_FALSE, ( const GLfloat* )pData ); } };
+	template<> struct RFXuniform< FR_FLOAT_MAT4 >	{ static void upload( GLint iLocation, GLsizei iSize, const void* pData ) { glUniformMatrix4fv( iLocation, iSize, GL_FALSE, ( const GLfloat* )pData ); } };
+
+	/**
+	* @brief stores a parameter and manages assignment to a uniform variable in a shader program. The parameters are
+	* stored by value, their type is only kept as the RFXuniform upload function of their type.
 	*/
 	struct RFXparameter
 	{
+		typedef void ( *UploadFunction )( GLint iLocation, GLsizei iSize, const void* pData );
+
 		const void* m_data;   // parameter data
 		short m_size;   // parameter element number if this one an array
 		GLint location; // associated uniform location in the shader program object
+		UploadFunction m_pfUpload; // RFXuniform< type >::upload
 
-
-		RFXparameter(void* data, short size, GLint location) : m_data(data), m_size(size), location(location)
-		{
-			refresh();
-		}
-
-		virtual void refresh()
-		{
-
-		}
-	};
-
-	class RFXfloat : public RFXparameter
-	{
-	public:
-
-		RFXfloat(float* data, short size, GLint location) : RFXparameter((void*)data, size, location)
-		{
-		}
-
-		void refresh()
-		{
-			glUniform1fv(location, m_size, (GLfloat*)m_data);
-		}
-	};
-
-	class RFXfloatVec2 : public RFXparameter
-	{
-	public:
-
-		RFXfloatVec2(float* data, short size, GLint location) : RFXparameter((void*)data, size, location)
-		{
-		}
-
-		void refresh()
-		{
-			glUniform2fv(location, m_size, (GLfloat*)m_data);
-		}
-	};
-
-	class RFXfloatVec3 : public RFXparameter
-	{
-	public:
-
-		RFXfloatVec3(float* data, short size, GLint location) : RFXparameter((void*)data, size, location)
-		{
-		}
-
-		void refresh()
-		{
-			glUniform3fv(location, m_size, (GLfloat*)m_data);
-		}
-	};
-
-	class RFXfloatVec4 : public RFXparameter
-	{
-	public:
-
-		RFXfloatVec4(float* data, short size, GLint location) : RFXparameter((void*)data, size, location)
-		{
-		}
-
-		void refresh()
-		{
-			glUniform4fv(location, m_size, (GLfloat*)m_data);
-		}
-	};
-
-	class RFXfloatMat2 : public RFXparameter
-	{
-	public:
-
-		RFXfloatMat2(float* data, short size, GLint location) : RFXparameter((void*)data, size, location)
-		{
-		}
-
-		void refresh()
-		{
-			glUniformMatrix2fv(location, m_size, 0, (GLfloat*)m_data);
-		}
-	};
-
-	class RFXfloatMat3 : public RFXparameter
-	{
-	public:
-
-		RFXfloatMat3(float* data, short size, GLint location) : RFXparameter((void*)data, size, location)
-		{
-		}
-
-		void refresh()
-		{
-			glUniformMatrix3fv(location, m_size, 0, (GLfloat*)m_data);
-		}
-	};
-
-	class RFXfloatMat4 : public RFXparameter
-	{
-	public:
-
-		RFXfloatMat4(float* data, short size, GLint location) : RFXparameter((void*)data, size, location)
-		{
-		}
-
-		void refresh()
-		{
-			glUniformMatrix4fv(location, m_size, 0, (GLfloat*)m_data);
-		}
-	};
-
-	class RFXint : public RFXparameter
-	{
-	public:
-
-		RFXint(int* data, short size, GLint location) : RFXparameter((void*)data, size, location)
-		{
-		}
-
-		void refresh()
+		void refresh() const
 		{
-			glUniform1iv(location, m_size, (GLint*)m_data);
+			m_pfUpload( location, m_size, m_data );
 		}
 	};
 
-	class RFXintVec2 : public RFXparameter
-	{
-	public:
-
-		RFXintVec2(int* data, short size, GLint location) : RFXparameter((void*)data, size, location)
-		{
-		}
-
-		void refresh()
-		{
-			glUniform2iv(location, m_size, (GLint*)m_data);
-		}
-	};
-
-	class RFXintVec3 : public RFXparameter
-	{
-	public:
-
-		RFXintVec3(int* data, short size, GLint location) : RFXparameter((void*)data, size, location)
-		{
-		}
-
-		void refresh()
-		{
-			glUniform3iv(location, m_size, (GLint*)m_data);
-		}
-	};
-
-	class RFXintVec4 : public RFXparameter
-	{
-	public:
-
-		RFXintVec4(int* data, short size, GLint location) : RFXparameter((void*)data, size, location)
-		{
-		}
-
-		void refresh()
-		{
-			glUniform4iv(location, m_size, (GLint*)m_data);
-		}
-	};
-
-	class RFXtexture
+	class RFXtexture : public Core< MEMORY_FX >
 	{
 		static unsigned short texturesUnitMax;
 
@@ -234,14 +99,16 @@ namespace Oglf
 	/**
 	* @brief Interface to a rendering FX
 	*/
-	class RenderingFX
+	class RenderingFX : public Core< MEMORY_FX >
 	{
 		GLSLshader* m_vertShader;
 		GLSLshader* m_fragShader;
 
-		std::vector<RFXparameter*> m_parametersList;
+		std::vector< RFXparameter, CoreAllocator< RFXparameter, MEMORY_FX > > m_parametersList;
 		std::vector<RFXtexture*> m_texturesList;
 
+		unsigned int addUniform( const void* param, RFXparameter::UploadFunction pfUpload, const short size, const char* name );
+
 	protected:
 
 		GLSLshaderProgram m_program; // shader program that computes a rendering effect
@@ -287,6 +154,29 @@ namespace Oglf
 		*/
 		unsigned int addParameter(const void* param, RFXparamType type, const short size, const char* name);
 
+		/**
+		* @brief adds a parameter whose type is known at compile time, its uniform call is chosen by RFXuniform
+		* @param param the parameter data
+		* @param size if the parameter is an array, say its size
+		* @param name the name of the uniform in the associated shader program
+		* @return the id of the added parameter in the parameter list (used to refresh its value next)
+		*/
+		template< RFXparamType T >
+		unsigned int addParameter( const void* param, const short size, const char* name )
+		{
+			return addUniform( param, &RFXuniform< T >::upload, size, name );
+		}
+
+		/**
+		* @brief returns the location of a vertex attribute in the shader program, once the shaders are linked
+		* @param name the name of the attribute in the vertex shader
+		* @return the attribute location, -1 if the shader has no such attribute
+		*/
+		GLint getAttributeLocation( const char* name ) const
+		{
+			return glGetAttribLocation( m_program.getHandle(), name );
+		}
+
 		/**
 		* @brief adds a parameter to the rendering FX that will be used as a uniform in associated program shader
 		* @param tex a texture object
@@ -315,6 +205,23 @@ namespace Oglf
 		*/
 		inline void refreshParameter(const unsigned int id) const;
 
+		/**
+		* @brief Refreshes a parameter whose type is known at compile time, the uniform call is inlined.
+		* T must be the type the parameter was added with, no error handling either.
+		* @param id the parameter id in the parameter list returned when adding the parameter
+		*/
+		template< RFXparamType T >
+		void refreshParameter( const unsigned int id ) const
+		{
+			if(GLSLshaderProgram::currentShaderProgramInUse() != m_program.getHandle())
+			{
+				m_program.use();
+			}
+
+			const RFXparameter& oParameter = m_parametersList[ id ];
+			RFXuniform< T >::upload( oParameter.location, oParameter.m_size, oParameter.m_data );
+		}
+
 		/**
 		* @brief Update a parameter data location
 		* @param id the parameter id in the parameter list returned when adding the parameter
@@ -367,7 +274,7 @@ namespace Oglf
 		{
 			m_program.use();
 		}
-		m_parametersList[id]->refresh();
+		m_parametersList[id].refresh();
 
 	}
 
@@ -378,7 +285,7 @@ namespace Oglf
 	*/
 	inline void RenderingFX::updateParameterLocation( const int id, const void* data )
 	{
-		m_parametersList[ id ]->m_data  = data;
+		m_parametersList[ id ].m_data  = data;
 	}
 
 
@@ -1,4 +1,5 @@
 #include "Scene.h"
+#include "Profiler.h"
 
 using namespace std;
 
@@ -9,15 +10,36 @@ namespace Oglf
 	*/
 	void Scene::drawElements()
 	{
+		OGLF_PROFILE_GPU_SCOPE( "Scene::drawElements" );
+
+		// only the world matrices of the moved subtrees are recomputed
+		m_oGraph.update();
+
+		// the instance groups are culled against the frustum of the current view, the matrices are only read back
+		// from the GL state when there are some
+		Matrix4x4 oViewProjection;
+		if( m_iInstanceGroupNb > 0 )
+		{
+			Matrix4x4 oProjection;
+			glGetFloatv( GL_PROJECTION_MATRIX, oProjection.m );
+			glGetFloatv( GL_MODELVIEW_MATRIX, oViewProjection.m );
+			oViewProjection = oProjection * oViewProjection;
+		}
+
 		// drawing these meshes with the fixed pipeline
 		GLSLshaderProgram::useFixedPipeline();
 		for (mIt = m_defaultShadingMeshList.begin(); mIt != m_defaultShadingMeshList.end(); mIt++)
 		{
 			glPushMatrix();
-			(*mIt)->transform();
+			glMultMatrixf( m_oGraph.getWorldMatrix( ( *mIt )->getSceneNode() ).m );
 			(*mIt)->draw();
 			glPopMatrix();
 		}
+		for( size_t i = 0; i < m_defaultShadingInstanceGroupList.size(); ++i )
+		{
+			m_defaultShadingInstanceGroupList[ i ]->cull( oViewProjection );
+			m_defaultShadingInstanceGroupList[ i ]->draw( NULL, -1 );
+		}
 
 		for (lIt = m_lights.begin(); lIt != m_lights.end(); lIt++)
 		{
@@ -39,15 +61,20 @@ namespace Oglf
 			rIt->rFX->enable(); // drawing these meshes with the rendering effect they have been attached to
 			for (mIt = (*rIt).attachedMeshes.begin(); mIt != (*rIt).attachedMeshes.end(); mIt++)
 			{
-				m_pWorldMat = &( ( *mIt )->getTransformer().getTransformMatrix() );
+				m_pWorldMat = &m_oGraph.getWorldMatrix( ( *mIt )->getSceneNode() );
 				rIt->rFX->updateParameterLocation( m_iMatID, m_pWorldMat );
-				rIt->rFX->refreshParameter( m_iMatID );
+				rIt->rFX->refreshParameter< FR_FLOAT_MAT4 >( m_iMatID );
 
 				glPushMatrix();
-				(*mIt)->transform();
+				glMultMatrixf( m_pWorldMat->m );
 				(*mIt)->draw();
 				glPopMatrix();
 			}
+			for( size_t i = 0; i < rIt->attachedInstanceGroups.size(); ++i )
+			{
+				rIt->attachedInstanceGroups[ i ]->cull( oViewProjection );
+				rIt->attachedInstanceGroups[ i ]->draw( rIt->rFX, m_iMatID );
+			}
 			(*rIt).rFX->disable();
 		}
 	}
@@ -66,11 +93,12 @@ namespace Oglf
 	}
 
 	/**
-	* @brief adds a mesh in the scene
+	* @brief adds a mesh in the scene and binds it to a new scene graph node, whose local transform is the mesh transformer
 	* @param  m a mesh
 	* @param rFXid the rendering effect id to attach to.
+	* @param iParentNode the parent node handle in the scene graph, -1 to place the mesh in the world space
 	*/
-	void Scene::addMesh ( Mesh& m, int rFXid )
+	void Scene::addMesh ( Mesh& m, int rFXid, int iParentNode )
 	{
 		if(rFXid >= 0 && rFXid < (int)m_renderingFXmeshAttachmentList.size()) {
 			m_renderingFXmeshAttachmentList[rFXid].attachedMeshes.push_back(&m);
@@ -81,8 +109,41 @@ namespace Oglf
 		else {
 			throw Error("Scene::addMesh error: can not attach a mesh to an inexistant rendering effect");
 		}
+
+		m.setSceneNode( m_oGraph.addNode( iParentNode, &m ) );
+	}
+
+	/**
+	* @brief adds an instance group in the scene, its instances are culled and drawn at once. They are placed in
+	* the world space, outside of the scene graph.
+	* @param oGroup an instance group
+	* @param rFXid the rendering effect id to attach to, -1 for the fixed pipeline
+	*/
+	void Scene::addInstanceGroup( InstanceGroup& oGroup, int rFXid )
+	{
+		if( rFXid >= 0 && rFXid < ( int )m_renderingFXmeshAttachmentList.size() )
+		{
+			m_renderingFXmeshAttachmentList[ rFXid ].attachedInstanceGroups.push_back( &oGroup );
+			oGroup.bindAttributes( m_renderingFXmeshAttachmentList[ rFXid ].rFX );
+		}
+		else if( rFXid == -1 )
+		{
+			m_defaultShadingInstanceGroupList.push_back( &oGroup );
+			oGroup.bindAttributes( NULL );
+		}
+		else
+		{
+			throw Error( "Scene::addInstanceGroup error: can not attach an instance group to an inexistant rendering effect" );
+		}
+
+		++m_iInstanceGroupNb;
 	}
 
+	/**
+	* @brief removes a mesh from the scene, the children of its node are attached to its parent node
+	* @param sName the mesh name
+	* @return false if there is no such mesh in the scene
+	*/
 	bool Scene::removeMesh ( const std::string& sName )
 	{
 		for (rIt = m_renderingFXmeshAttachmentList.begin(); rIt != m_renderingFXmeshAttachmentList.end(); ++rIt )
@@ -91,7 +152,9 @@ namespace Oglf
 			{
 				if( !(* mIt )->getName().compare( sName ) )
 				{
-					m_renderingFXmeshAttachmentList.erase( rIt );
+					m_oGraph.removeNode( ( *mIt )->getSceneNode() );
+					( *mIt )->setSceneNode( -1 );
+					(*rIt).attachedMeshes.erase( mIt );
 					return true;
 				}
 			}
@@ -100,6 +163,8 @@ namespace Oglf
 		{
 			if( !( *mIt )->getName().compare( sName ) )
 			{
+				m_oGraph.removeNode( ( *mIt )->getSceneNode() );
+				( *mIt )->setSceneNode( -1 );
 				m_defaultShadingMeshList.erase( mIt );
 				return true;
 			}
@@ -107,10 +172,24 @@ namespace Oglf
 		return false;
 	}
 
+	/**
+	* @brief removes all meshes, instance groups and rendering effects from the scene and clears the scene graph
+	*/
 	void Scene::removeAllMeshes()
 	{
+		for (rIt = m_renderingFXmeshAttachmentList.begin(); rIt != m_renderingFXmeshAttachmentList.end(); ++rIt )
+		{
+			for (mIt = (*rIt).attachedMeshes.begin(); mIt != (*rIt).attachedMeshes.end(); ++mIt )
+				( *mIt )->setSceneNode( -1 );
+		}
+		for (mIt = m_defaultShadingMeshList.begin(); mIt != m_defaultShadingMeshList.end(); ++mIt )
+			( *mIt )->setSceneNode( -1 );
+
 		m_renderingFXmeshAttachmentList.clear();
 		m_defaultShadingMeshList.clear();
+		m_defaultShadingInstanceGroupList.clear();
+		m_iInstanceGroupNb = 0;
+		m_oGraph.clear();
 	}
 }
 
@@ -4,9 +4,12 @@
 #include <vector>
 #include "RenderingFX.h"
 #include "Mesh.h"
+#include "InstanceGroup.h"
 #include "Camera.h"
 #include "Light.h"
+#include "SceneGraph.h"
 #include "RenderingConfiguration.h"
+#include "Core.h"
 
 
 namespace Oglf
@@ -18,6 +21,7 @@ namespace Oglf
 	{
 		RenderingFX* rFX;
 		std::vector<Mesh*> attachedMeshes;
+		std::vector<InstanceGroup*> attachedInstanceGroups;
 
 		RenderingFXmeshAttachment(RenderingFX& FX) : rFX(&FX)
 		{
@@ -28,13 +32,16 @@ namespace Oglf
 	/**
 	* @brief Manage a scene for real-time rendering with OpenGL.
 	*/
-	class Scene
+	class Scene : public Core< MEMORY_SCENE >
 	{
 		std::vector<Camera*> m_cameras;                                         // constains all the cameras in the scene
 		std::vector<Light*> m_lights;                                           // contains all the lights in the scene
 		std::vector<RenderingFXmeshAttachment> m_renderingFXmeshAttachmentList; // list of rendering effects associated to a list of meshes
 		std::vector<Mesh*> m_defaultShadingMeshList;                            // list of all meshes rendered using the fixed pipeline
+		std::vector<InstanceGroup*> m_defaultShadingInstanceGroupList;          // list of the instance groups rendered using the fixed pipeline
 		RenderingConfiguration* m_rConf;                                        // a pointer to a rendering configuration object
+		SceneGraph m_oGraph;                                                    // the meshes transform hierarchy
+		int m_iInstanceGroupNb;                                                 // instance groups of all the lists
 
 		int curActiveCam; // current active camera in the scene
 
@@ -44,11 +51,12 @@ namespace Oglf
 		std::vector<RenderingFXmeshAttachment>::iterator rIt;
 
 		int m_iMatID;
-		Matrix4x4* m_pWorldMat;
+		const Matrix4x4* m_pWorldMat;
 
 	public:
 		Scene()
 			: m_rConf(NULL)
+			, m_iInstanceGroupNb( 0 )
 			, curActiveCam(-1)
 			, m_iMatID( -1 )
 			, m_pWorldMat( NULL )
@@ -90,16 +98,42 @@ namespace Oglf
 		inline int addRenderingFX(RenderingFX& rFX);
 
 		/**
-		* @brief Adds a mesh in the scene.
+		* @brief Adds a mesh in the scene and binds it to a new scene graph node, whose local transform is the mesh transformer.
 		* @param  m a mesh
 		* @param rFXid the rendering effect id to attach to.
+		* @param iParentNode the parent node handle in the scene graph, -1 to place the mesh in the world space
+		*/
+		void addMesh ( Mesh& m, int rFXid = -1, int iParentNode = -1 );
+
+		/**
+		* @brief Adds an instance group in the scene, its instances are culled and drawn at once. They are placed in
+		* the world space, outside of the scene graph.
+		* @param oGroup an instance group
+		* @param rFXid the rendering effect id to attach to, -1 for the fixed pipeline
 		*/
-		void addMesh ( Mesh& m, int rFXid = -1 );
+		void addInstanceGroup( InstanceGroup& oGroup, int rFXid = -1 );
 
+		/**
+		* @brief Removes a mesh from the scene, the children of its node are attached to its parent node.
+		* @param sName the mesh name
+		* @return false if there is no such mesh in the scene
+		*/
 		bool removeMesh ( const std::string& sName );
 
+		/**
+		* @brief Removes all meshes, instance groups and rendering effects from the scene and clears the scene graph.
+		*/
 		void removeAllMeshes();
 
+		/**
+		* @brief Returns the scene graph, in which group nodes may be added to build the meshes hierarchy.
+		* @return the scene graph
+		*/
+		SceneGraph& getGraph()
+		{
+			return m_oGraph;
+		}
+
 		/**
 		* @brief Adds a mesh in the scene.
 		* @param  m a mesh
@@ -175,7 +209,7 @@ namespace Oglf
 	{
 		m_renderingFXmeshAttachmentList.push_back(RenderingFXmeshAttachment(rFX));
 
-		m_iMatID = rFX.addParameter( m_pWorldMat, FR_FLOAT_MAT4, 1, "u_mWorldMatrix" );
+		m_iMatID = rFX.addParameter< FR_FLOAT_MAT4 >( m_pWorldMat, 1, "u_mWorldMatrix" );
 
 		return m_renderingFXmeshAttachmentList.size()-1;
 	}
@@ -0,0 +1,274 @@
+#include <algorithm>
+#include "SceneGraph.h"
+#include "Error.h"
+
+using namespace std;
+
+namespace Oglf
+{
+	/**
+	* @brief constructor: creates an empty graph
+	*/
+	SceneGraph::SceneGraph()
+		: m_bSortNeeded( false )
+		, m_iUpdatedNb( 0 )
+	{
+	}
+
+	/**
+	* @brief returns the position of a node in the node array
+	* @param iNode the node handle
+	* @param pcCaller the calling method name, for the error message
+	* @return the node position
+	*/
+	int SceneGraph::getPosition( int iNode, const char* pcCaller ) const
+	{
+		if( iNode < 0 || iNode >= ( int )m_vPositions.size() || m_vPositions[ iNode ] < 0 )
+			throw Error( string( pcCaller ) + " error : invalid node handle" );
+
+		return m_vPositions[ iNode ];
+	}
+
+	/**
+	* @brief adds a node as the last child of a given one
+	* @param iParent the parent handle, -1 to add a root
+	* @param pObject the object whose transformer is the node local transform, NULL for a group node
+	* @return the node handle
+	*/
+	int SceneGraph::addNode( int iParent, Object3D* pObject )
+	{
+		Node oNode;
+		oNode.iParent = iParent >= 0 ? getPosition( iParent, "SceneGraph::addNode" ) : -1;
+		oNode.pObject = pObject;
+		oNode.iLocalVersion = 0;
+		oNode.bForceUpdate = true;
+
+		// the node is appended after its parent, the array stays sorted
+		if( !m_vFreeHandles.empty() )
+		{
+			oNode.iHandle = m_vFreeHandles.back();
+			m_vFreeHandles.pop_back();
+		}
+		else
+		{
+			oNode.iHandle = ( int )m_vPositions.size();
+			m_vPositions.push_back( -1 );
+		}
+		m_vPositions[ oNode.iHandle ] = ( int )m_vNodes.size();
+
+		m_vNodes.push_back( oNode );
+		m_vWorldMatrices.push_back( Matrix4x4() );
+		m_vChanged.push_back( 0 );
+
+		return oNode.iHandle;
+	}
+
+	/**
+	* @brief removes a node, its children are attached to its parent and keep their local transforms
+	* @param iNode the node handle
+	*/
+	void SceneGraph::removeNode( int iNode )
+	{
+		// a node reparented after the removed one may be one of its children: the array is sorted first so that
+		// the children all come after it
+		if( m_bSortNeeded )
+			sort();
+
+		int iPosition = getPosition( iNode, "SceneGraph::removeNode" );
+		int iParent = m_vNodes[ iPosition ].iParent;
+
+		// the parent comes before the removed node, hence before its children: the order stays valid and the
+		// removed node is only left as a hole, compacted by the next sort
+		for( size_t i = iPosition + 1; i < m_vNodes.size(); ++i )
+		{
+			if( m_vNodes[ i ].iParent == iPosition )
+			{
+				m_vNodes[ i ].iParent = iParent;
+				m_vNodes[ i ].bForceUpdate = true;
+			}
+		}
+
+		m_vNodes[ iPosition ].iHandle = -1;
+		m_vNodes[ iPosition ].pObject = NULL;
+		m_vPositions[ iNode ] = -1;
+		m_vFreeHandles.push_back( iNode );
+		m_bSortNeeded = true;
+	}
+
+	/**
+	* @brief removes every node
+	*/
+	void SceneGraph::clear()
+	{
+		m_vNodes.clear();
+		m_vWorldMatrices.clear();
+		m_vChanged.clear();
+		m_vPositions.clear();
+		m_vFreeHandles.clear();
+		m_bSortNeeded = false;
+		m_iUpdatedNb = 0;
+	}
+
+	/**
+	* @brief attaches a node and its subtree to another parent, the node keeps its local transform
+	* @param iNode the node handle
+	* @param iParent the new parent handle, -1 to make the node a root. It must not be in the node subtree.
+	*/
+	void SceneGraph::setParent( int iNode, int iParent )
+	{
+		int iPosition = getPosition( iNode, "SceneGraph::setParent" );
+		int iParentPosition = iParent >= 0 ? getPosition( iParent, "SceneGraph::setParent" ) : -1;
+
+		for( int i = iParentPosition; i >= 0; i = m_vNodes[ i ].iParent )
+		{
+			if( i == iPosition )
+				throw Error( "SceneGraph::setParent error : the new parent is in the node subtree" );
+		}
+
+		m_vNodes[ iPosition ].iParent = iParentPosition;
+		m_vNodes[ iPosition ].bForceUpdate = true;
+
+		if( iParentPosition > iPosition )
+			m_bSortNeeded = true;
+	}
+
+	/**
+	* @brief returns the parent of a node
+	* @param iNode the node handle
+	* @return the parent handle, -1 for a root
+	*/
+	int SceneGraph::getParent( int iNode ) const
+	{
+		int iParent = m_vNodes[ getPosition( iNode, "SceneGraph::getParent" ) ].iParent;
+
+		return iParent >= 0 ? m_vNodes[ iParent ].iHandle : -1;
+	}
+
+	/**
+	* @brief returns the local transform of a node, relative to its parent
+	* @param iNode the node handle
+	* @return the transformer of the object bound to the node, or the node own one
+	*/
+	GLtransformer3D& SceneGraph::getLocalTransform( int iNode )
+	{
+		return getLocal( m_vNodes[ getPosition( iNode, "SceneGraph::getLocalTransform" ) ] );
+	}
+
+	/**
+	* @brief returns the object bound to a node
+	* @param iNode the node handle
+	* @return the object, NULL for a group node
+	*/
+	Object3D* SceneGraph::getObject( int iNode ) const
+	{
+		return m_vNodes[ getPosition( iNode, "SceneGraph::getObject" ) ].pObject;
+	}
+
+	/**
+	* @brief reorders the nodes depth first, so that each parent comes before its children and each subtree is
+	* contiguous, and drops the removed nodes
+	*/
+	void SceneGraph::sort()
+	{
+		int iNb = ( int )m_vNodes.size();
+
+		// children lists, built as linked lists to keep the children in their current order
+		vector< int > vFirstChild( iNb, -1 );
+		vector< int > vLastChild( iNb, -1 );
+		vector< int > vNextSibling( iNb, -1 );
+		vector< int > vStack;
+
+		for( int i = 0; i < iNb; ++i )
+		{
+			if( m_vNodes[ i ].iHandle < 0 )
+				continue;
+
+			int iParent = m_vNodes[ i ].iParent;
+			if( iParent < 0 )
+			{
+				vStack.push_back( i );
+				continue;
+			}
+
+			if( vLastChild[ iParent ] < 0 )
+				vFirstChild[ iParent ] = i;
+			else
+				vNextSibling[ vLastChild[ iParent ] ] = i;
+			vLastChild[ iParent ] = i;
+		}
+
+		// the roots are popped from the back of the stack, pushing them reversed keeps their order
+		reverse( vStack.begin(), vStack.end() );
+
+		vector< int > vNewPositions( iNb, -1 );
+		std::vector< Node, CoreAllocator< Node, MEMORY_SCENE > > vNodes;
+		MatrixArray vWorldMatrices;
+		vector< char > vChanged;
+		vNodes.reserve( iNb );
+		vWorldMatrices.reserve( iNb );
+		vChanged.reserve( iNb );
+
+		vector< int > vChildren;
+		while( !vStack.empty() )
+		{
+			int i = vStack.back();
+			vStack.pop_back();
+
+			vNewPositions[ i ] = ( int )vNodes.size();
+			vNodes.push_back( m_vNodes[ i ] );
+			vWorldMatrices.push_back( m_vWorldMatrices[ i ] );
+			vChanged.push_back( m_vChanged[ i ] );
+
+			Node& oNode = vNodes.back();
+			if( oNode.iParent >= 0 )
+				oNode.iParent = vNewPositions[ oNode.iParent ];
+			m_vPositions[ oNode.iHandle ] = vNewPositions[ i ];
+
+			vChildren.clear();
+			for( int c = vFirstChild[ i ]; c >= 0; c = vNextSibling[ c ] )
+				vChildren.push_back( c );
+			vStack.insert( vStack.end(), vChildren.rbegin(), vChildren.rend() );
+		}
+
+		m_vNodes.swap( vNodes );
+		m_vWorldMatrices.swap( vWorldMatrices );
+		m_vChanged.swap( vChanged );
+		m_bSortNeeded = false;
+	}
+
+	/**
+	* @brief sorts the nodes if needed and recomputes the world matrices of the nodes whose local transform or
+	* an ancestor's changed since the previous update, in one pass over the nodes
+	*/
+	void SceneGraph::update()
+	{
+		if( m_bSortNeeded )
+			sort();
+
+		m_iUpdatedNb = 0;
+
+		for( size_t i = 0; i < m_vNodes.size(); ++i )
+		{
+			Node& oNode = m_vNodes[ i ];
+			const GLtransformer3D& oLocal = getLocal( oNode );
+			unsigned int iVersion = oLocal.getVersion();
+
+			// the parents come first, their changed flag is already set for this pass
+			bool bChanged = oNode.bForceUpdate || iVersion != oNode.iLocalVersion ||
+				( oNode.iParent >= 0 && m_vChanged[ oNode.iParent ] );
+
+			m_vChanged[ i ] = bChanged;
+			if( !bChanged )
+				continue;
+
+			if( oNode.iParent >= 0 )
+				m_vWorldMatrices[ i ] = m_vWorldMatrices[ oNode.iParent ] * oLocal.getTransformMatrix();
+			else
+				m_vWorldMatrices[ i ] = oLocal.getTransformMatrix();
+
+			oNode.iLocalVersion = iVersion;
+			oNode.bForceUpdate = false;
+			++m_iUpdatedNb;
+		}
+	}
+}
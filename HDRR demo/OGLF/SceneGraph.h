@@ -0,0 +1,174 @@
+#ifndef SCENEGRAPH_H
+#define SCENEGRAPH_H
+
+#include <vector>
+#include "Matrix.h"
+#include "GLtransformer3D.h"
+#include "Object3D.h"
+#include "Core.h"
+
+
+namespace Oglf
+{
+	/**
+	* class SceneGraph holds a hierarchy of transforms and computes their local-to-world matrices. The nodes are
+	* stored in a flat array sorted so that each parent comes before its children, the world matrices are then
+	* computed in one linear pass, in which only the nodes whose local transform or an ancestor's changed since
+	* the previous pass are recomputed. The world matrices are stored in the same order in a contiguous array handed
+	* to the renderer. A node is designated by a handle, which stays valid while the nodes are reordered. Its local
+	* transform is that of the object bound to it, or its own one for the group nodes, bound to no object.
+	*/
+	class SceneGraph
+	{
+		/**
+		* @brief a node, at its position in the sorted array
+		*/
+		struct Node
+		{
+			int					iHandle;
+			int					iParent;		// the parent position, -1 for a root
+			Object3D*			pObject;		// the object whose transformer is the local transform, may be NULL
+			GLtransformer3D		oTransform;		// the local transform of a node bound to no object
+			unsigned int		iLocalVersion;	// the local transform version the world matrix was computed with
+			bool				bForceUpdate;	// the world matrix must be computed whatever the version
+		};
+
+		typedef std::vector< Matrix4x4, CoreAllocator< Matrix4x4, MEMORY_SCENE > > MatrixArray;
+
+		std::vector< Node, CoreAllocator< Node, MEMORY_SCENE > >	m_vNodes;
+		MatrixArray								m_vWorldMatrices;	// in the node order
+		std::vector< char >						m_vChanged;			// the world matrix changed in the last update()
+		std::vector< int >						m_vPositions;		// the node positions by handle, -1 for a free handle
+		std::vector< int >						m_vFreeHandles;
+		bool									m_bSortNeeded;		// a node was reparented or removed since the last sort
+		int										m_iUpdatedNb;		// world matrices computed by the last update()
+
+		int getPosition( int iNode, const char* pcCaller ) const;
+		void sort();
+
+		GLtransformer3D& getLocal( Node& oNode )
+		{
+			return oNode.pObject != NULL ? oNode.pObject->getTransformer() : oNode.oTransform;
+		}
+
+	public:
+
+		/**
+		* @brief constructor: creates an empty graph
+		*/
+		SceneGraph();
+
+		/**
+		* @brief adds a node as the last child of a given one
+		* @param iParent the parent handle, -1 to add a root
+		* @param pObject the object whose transformer is the node local transform, NULL for a group node
+		* @return the node handle
+		*/
+		int addNode( int iParent = -1, Object3D* pObject = NULL );
+
+		/**
+		* @brief removes a node, its children are attached to its parent and keep their local transforms
+		* @param iNode the node handle
+		*/
+		void removeNode( int iNode );
+
+		/**
+		* @brief removes every node
+		*/
+		void clear();
+
+		/**
+		* @brief attaches a node and its subtree to another parent, the node keeps its local transform
+		* @param iNode the node handle
+		* @param iParent the new parent handle, -1 to make the node a root. It must not be in the node subtree.
+		*/
+		void setParent( int iNode, int iParent );
+
+		/**
+		* @brief returns the parent of a node
+		* @param iNode the node handle
+		* @return the parent handle, -1 for a root
+		*/
+		int getParent( int iNode ) const;
+
+		/**
+		* @brief returns the local transform of a node, relative to its parent
+		* @param iNode the node handle
+		* @return the transformer of the object bound to the node, or the node own one
+		*/
+		GLtransformer3D& getLocalTransform( int iNode );
+
+		/**
+		* @brief returns the object bound to a node
+		* @param iNode the node handle
+		* @return the object, NULL for a group node
+		*/
+		Object3D* getObject( int iNode ) const;
+
+		/**
+		* @brief sorts the nodes if needed and recomputes the world matrices of the nodes whose local transform or
+		* an ancestor's changed since the previous update, in one pass over the nodes
+		*/
+		void update();
+
+		/**
+		* @brief returns the world matrix of a node computed by the last update()
+		* @param iNode the node handle
+		* @return the world matrix, valid until the next update() or removeNode()
+		*/
+		const Matrix4x4& getWorldMatrix( int iNode ) const
+		{
+			return m_vWorldMatrices[ getPosition( iNode, "SceneGraph::getWorldMatrix" ) ];
+		}
+
+		/**
+		* @brief returns whether the world matrix of a node changed in the last update()
+		* @param iNode the node handle
+		* @return true if the matrix was recomputed
+		*/
+		bool hasChanged( int iNode ) const
+		{
+			return m_vChanged[ getPosition( iNode, "SceneGraph::hasChanged" ) ] != 0;
+		}
+
+		/**
+		* @brief returns the position of a node in the world matrix array, valid until the next update() or removeNode()
+		* @param iNode the node handle
+		* @return the node position
+		*/
+		int getNodePosition( int iNode ) const
+		{
+			return getPosition( iNode, "SceneGraph::getNodePosition" );
+		}
+
+		/**
+		* @brief returns the world matrices computed by the last update(), in the node order, each parent before its
+		* children
+		* @return the matrix array, valid until the graph changes, NULL if it is empty
+		*/
+		const Matrix4x4* getWorldMatrices() const
+		{
+			return m_vWorldMatrices.empty() ? NULL : &m_vWorldMatrices[ 0 ];
+		}
+
+		/**
+		* @brief returns the number of nodes
+		* @return the number of nodes
+		*/
+		int getNodeNb() const
+		{
+			return ( int )m_vNodes.size();
+		}
+
+		/**
+		* @brief returns the number of world matrices computed by the last update()
+		* @return the number of matrices
+		*/
+		int getUpdatedNb() const
+		{
+			return m_iUpdatedNb;
+		}
+	};
+}
+
+#endif /* SCENEGRAPH_H */
@@ -0,0 +1,280 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+// SIMD code paths are only compiled on x86 targets, every other platform uses the scalar code.
+#if defined( _M_IX86 ) || defined( _M_X64 ) || defined( __i386__ ) || defined( __x86_64__ )
+	#define OGLF_SSE2
+#endif
+
+// the inline packet types may only use AVX when the whole program is compiled for it (/arch:AVX)
+#if defined( OGLF_SSE2 ) && defined( __AVX__ )
+	#define OGLF_AVX
+#endif
+
+#include <math.h>
+
+#ifdef OGLF_SSE2
+	#include <emmintrin.h>
+	#include <immintrin.h>
+	#ifdef _MSC_VER
+		#include <intrin.h>
+	#else
+		#include <cpuid.h>
+	#endif
+#endif
+
+#ifdef _MSC_VER
+	#define OGLF_ALIGN( n ) __declspec( align( n ) )
+	#define OGLF_TARGET( isa )
+#else
+	#define OGLF_ALIGN( n ) __attribute__( ( aligned( n ) ) )
+	#define OGLF_TARGET( isa ) __attribute__( ( target( isa ) ) )
+#endif
+
+
+namespace Oglf
+{
+	/**
+	* @brief CPU instruction set extensions detected at runtime
+	*/
+	struct CpuFeatures
+	{
+		bool bSSE2;
+		bool bSSE41;
+		bool bAVX;
+		bool bF16C;
+
+		CpuFeatures()
+			: bSSE2( false )
+			, bSSE41( false )
+			, bAVX( false )
+			, bF16C( false )
+		{
+#ifdef OGLF_SSE2
+			unsigned int iEcx = 0, iEdx = 0;
+
+#ifdef _MSC_VER
+			int pInfo[ 4 ];
+			__cpuid( pInfo, 1 );
+			iEcx = ( unsigned int )pInfo[ 2 ];
+			iEdx = ( unsigned int )pInfo[ 3 ];
+#else
+			unsigned int iEax = 0, iEbx = 0;
+			__get_cpuid( 1, &iEax, &iEbx, &iEcx, &iEdx );
+#endif
+			bSSE2  = ( iEdx & ( 1 << 26 ) ) != 0;
+			bSSE41 = ( iEcx & ( 1 << 19 ) ) != 0;
+
+			// AVX and F16C are VEX encoded: the OS must also save the YMM registers
+			bool bOSXSave = ( iEcx & ( 1 << 27 ) ) != 0;
+			if( bOSXSave && ( iEcx & ( 1 << 28 ) ) != 0 )
+			{
+#ifdef _MSC_VER
+				unsigned long long iXcr0 = _xgetbv( 0 );
+#else
+				unsigned int iXcrLo, iXcrHi;
+				__asm__ __volatile__( "xgetbv" : "=a"( iXcrLo ), "=d"( iXcrHi ) : "c"( 0 ) );
+				unsigned long long iXcr0 = ( ( unsigned long long )iXcrHi << 32 ) | iXcrLo;
+#endif
+				bAVX  = ( iXcr0 & 6 ) == 6;
+				bF16C = bAVX && ( iEcx & ( 1 << 29 ) ) != 0;
+			}
+#endif
+		}
+
+		/**
+		* @brief returns the features of the CPU the program is running on
+		* @return the CPU features, detected once
+		*/
+		static const CpuFeatures& get()
+		{
+			static CpuFeatures s_oFeatures;
+			return s_oFeatures;
+		}
+	};
+
+	/**
+	* struct Float4 is a packet of 4 floats held in a SSE register on x86 targets, the lane type of the Vec3x4
+	* packets. Its code only uses SSE1 instructions, which every x86 CPU supports, so it needs no runtime dispatch.
+	* Packets are meant to be locals: arrays are stored as floats and loaded into packets, since heap blocks are only
+	* 8 bytes aligned on 32 bits targets. Packets are passed by reference, MSVC cannot pass aligned types by value.
+	*/
+	struct Float4
+	{
+		static const int SIZE = 4;
+
+#ifdef OGLF_SSE2
+		__m128 v;
+
+		Float4()							{ v = _mm_setzero_ps(); }
+		explicit Float4( float f )			{ v = _mm_set1_ps( f ); }
+		explicit Float4( __m128 o )			{ v = o; }
+
+		/**
+		* @brief loads a packet from memory, which does not need to be aligned
+		* @param pData the 4 floats
+		* @return the packet
+		*/
+		static Float4 load( const float* pData )	{ return Float4( _mm_loadu_ps( pData ) ); }
+
+		/**
+		* @brief stores the packet to memory, which does not need to be aligned
+		* @param pData the 4 floats
+		*/
+		void store( float* pData ) const			{ _mm_storeu_ps( pData, v ); }
+
+		Float4 sqrt() const						{ return Float4( _mm_sqrt_ps( v ) ); }
+
+		/**
+		* @brief approximates 1 / sqrt(), the estimate is refined by a Newton-Raphson step to about 22 bits
+		* @return the approximation
+		*/
+		Float4 rsqrt() const
+		{
+			__m128 oEstimate = _mm_rsqrt_ps( v );
+			__m128 oHalf = _mm_mul_ps( _mm_set1_ps( 0.5f ), v );
+			__m128 oStep = _mm_sub_ps( _mm_set1_ps( 1.5f ), _mm_mul_ps( oHalf, _mm_mul_ps( oEstimate, oEstimate ) ) );
+			return Float4( _mm_mul_ps( oEstimate, oStep ) );
+		}
+
+		static Float4 minimum( const Float4& a, const Float4& b )	{ return Float4( _mm_min_ps( a.v, b.v ) ); }
+		static Float4 maximum( const Float4& a, const Float4& b )	{ return Float4( _mm_max_ps( a.v, b.v ) ); }
+
+		/**
+		* @brief returns the sum of the 4 floats
+		* @return the sum
+		*/
+		float sum() const
+		{
+			__m128 oPairs = _mm_add_ps( v, _mm_movehl_ps( v, v ) );
+			return _mm_cvtss_f32( _mm_add_ss( oPairs, _mm_shuffle_ps( oPairs, oPairs, _MM_SHUFFLE( 1, 1, 1, 1 ) ) ) );
+		}
+
+		friend Float4 operator + ( const Float4& a, const Float4& b )	{ return Float4( _mm_add_ps( a.v, b.v ) ); }
+		friend Float4 operator - ( const Float4& a, const Float4& b )	{ return Float4( _mm_sub_ps( a.v, b.v ) ); }
+		friend Float4 operator * ( const Float4& a, const Float4& b )	{ return Float4( _mm_mul_ps( a.v, b.v ) ); }
+		friend Float4 operator / ( const Float4& a, const Float4& b )	{ return Float4( _mm_div_ps( a.v, b.v ) ); }
+		friend Float4 operator - ( const Float4& a )					{ return Float4( _mm_sub_ps( _mm_setzero_ps(), a.v ) ); }
+#else
+		float v[ 4 ];
+
+		Float4()							{ v[ 0 ] = v[ 1 ] = v[ 2 ] = v[ 3 ] = 0.f; }
+		explicit Float4( float f )			{ v[ 0 ] = v[ 1 ] = v[ 2 ] = v[ 3 ] = f; }
+
+		static Float4 load( const float* pData )	{ Float4 r; for( int i = 0; i < 4; ++i ) r.v[ i ] = pData[ i ]; return r; }
+		void store( float* pData ) const			{ for( int i = 0; i < 4; ++i ) pData[ i ] = v[ i ]; }
+
+		Float4 sqrt() const						{ Float4 r; for( int i = 0; i < 4; ++i ) r.v[ i ] = ::sqrtf( v[ i ] ); return r; }
+		Float4 rsqrt() const					{ Float4 r; for( int i = 0; i < 4; ++i ) r.v[ i ] = 1.f / ::sqrtf( v[ i ] ); return r; }
+
+		static Float4 minimum( const Float4& a, const Float4& b )	{ Float4 r; for( int i = 0; i < 4; ++i ) r.v[ i ] = a.v[ i ] < b.v[ i ] ? a.v[ i ] : b.v[ i ]; return r; }
+		static Float4 maximum( const Float4& a, const Float4& b )	{ Float4 r; for( int i = 0; i < 4; ++i ) r.v[ i ] = a.v[ i ] > b.v[ i ] ? a.v[ i ] : b.v[ i ]; return r; }
+
+		float sum() const						{ return ( v[ 0 ] + v[ 2 ] ) + ( v[ 1 ] + v[ 3 ] ); }
+
+		friend Float4 operator + ( const Float4& a, const Float4& b )	{ Float4 r; for( int i = 0; i < 4; ++i ) r.v[ i ] = a.v[ i ] + b.v[ i ]; return r; }
+		friend Float4 operator - ( const Float4& a, const Float4& b )	{ Float4 r; for( int i = 0; i < 4; ++i ) r.v[ i ] = a.v[ i ] - b.v[ i ]; return r; }
+		friend Float4 operator * ( const Float4& a, const Float4& b )	{ Float4 r; for( int i = 0; i < 4; ++i ) r.v[ i ] = a.v[ i ] * b.v[ i ]; return r; }
+		friend Float4 operator / ( const Float4& a, const Float4& b )	{ Float4 r; for( int i = 0; i < 4; ++i ) r.v[ i ] = a.v[ i ] / b.v[ i ]; return r; }
+		friend Float4 operator - ( const Float4& a )					{ Float4 r; for( int i = 0; i < 4; ++i ) r.v[ i ] = -a.v[ i ]; return r; }
+#endif
+
+		/**
+		* @brief returns a float of the packet
+		* @param i the lane
+		* @return the float
+		*/
+		float operator[]( int i ) const
+		{
+			OGLF_ALIGN( 16 ) float pData[ 4 ];
+			store( pData );
+			return pData[ i ];
+		}
+	};
+
+	/**
+	* struct Float8 is a packet of 8 floats, the lane type of the Vec3x8 packets. It is held in an AVX register when
+	* the compiler targets AVX (/arch:AVX), since inline code cannot be dispatched at runtime, and in two Float4
+	* otherwise.
+	*/
+	struct Float8
+	{
+		static const int SIZE = 8;
+
+#ifdef OGLF_AVX
+		__m256 v;
+
+		Float8()							{ v = _mm256_setzero_ps(); }
+		explicit Float8( float f )			{ v = _mm256_set1_ps( f ); }
+		explicit Float8( __m256 o )			{ v = o; }
+
+		static Float8 load( const float* pData )	{ return Float8( _mm256_loadu_ps( pData ) ); }
+		void store( float* pData ) const			{ _mm256_storeu_ps( pData, v ); }
+
+		Float8 sqrt() const						{ return Float8( _mm256_sqrt_ps( v ) ); }
+
+		/**
+		* @brief approximates 1 / sqrt(), the estimate is refined by a Newton-Raphson step to about 22 bits
+		* @return the approximation
+		*/
+		Float8 rsqrt() const
+		{
+			__m256 oEstimate = _mm256_rsqrt_ps( v );
+			__m256 oHalf = _mm256_mul_ps( _mm256_set1_ps( 0.5f ), v );
+			__m256 oStep = _mm256_sub_ps( _mm256_set1_ps( 1.5f ), _mm256_mul_ps( oHalf, _mm256_mul_ps( oEstimate, oEstimate ) ) );
+			return Float8( _mm256_mul_ps( oEstimate, oStep ) );
+		}
+
+		static Float8 minimum( const Float8& a, const Float8& b )	{ return Float8( _mm256_min_ps( a.v, b.v ) ); }
+		static Float8 maximum( const Float8& a, const Float8& b )	{ return Float8( _mm256_max_ps( a.v, b.v ) ); }
+
+		float sum() const
+		{
+			return Float4( _mm_add_ps( _mm256_castps256_ps128( v ), _mm256_extractf128_ps( v, 1 ) ) ).sum();
+		}
+
+		friend Float8 operator + ( const Float8& a, const Float8& b )	{ return Float8( _mm256_add_ps( a.v, b.v ) ); }
+		friend Float8 operator - ( const Float8& a, const Float8& b )	{ return Float8( _mm256_sub_ps( a.v, b.v ) ); }
+		friend Float8 operator * ( const Float8& a, const Float8& b )	{ return Float8( _mm256_mul_ps( a.v, b.v ) ); }
+		friend Float8 operator / ( const Float8& a, const Float8& b )	{ return Float8( _mm256_div_ps( a.v, b.v ) ); }
+		friend Float8 operator - ( const Float8& a )					{ return Float8( _mm256_sub_ps( _mm256_setzero_ps(), a.v ) ); }
+#else
+		Float4 lo, hi;
+
+		Float8()							{}
+		explicit Float8( float f )			: lo( f ), hi( f ) {}
+		Float8( const Float4& oLo, const Float4& oHi )	: lo( oLo ), hi( oHi ) {}
+
+		static Float8 load( const float* pData )	{ return Float8( Float4::load( pData ), Float4::load( pData + 4 ) ); }
+		void store( float* pData ) const			{ lo.store( pData ); hi.store( pData + 4 ); }
+
+		Float8 sqrt() const						{ return Float8( lo.sqrt(), hi.sqrt() ); }
+		Float8 rsqrt() const					{ return Float8( lo.rsqrt(), hi.rsqrt() ); }
+
+		static Float8 minimum( const Float8& a, const Float8& b )	{ return Float8( Float4::minimum( a.lo, b.lo ), Float4::minimum( a.hi, b.hi ) ); }
+		static Float8 maximum( const Float8& a, const Float8& b )	{ return Float8( Float4::maximum( a.lo, b.lo ), Float4::maximum( a.hi, b.hi ) ); }
+
+		float sum() const						{ return ( lo + hi ).sum(); }
+
+		friend Float8 operator + ( const Float8& a, const Float8& b )	{ return Float8( a.lo + b.lo, a.hi + b.hi ); }
+		friend Float8 operator - ( const Float8& a, const Float8& b )	{ return Float8( a.lo - b.lo, a.hi - b.hi ); }
+		friend Float8 operator * ( const Float8& a, const Float8& b )	{ return Float8( a.lo * b.lo, a.hi * b.hi ); }
+		friend Float8 operator / ( const Float8& a, const Float8& b )	{ return Float8( a.lo / b.lo, a.hi / b.hi ); }
+		friend Float8 operator - ( const Float8& a )					{ return Float8( -a.lo, -a.hi ); }
+#endif
+
+		/**
+		* @brief returns a float of the packet
+		* @param i the lane
+		* @return the float
+		*/
+		float operator[]( int i ) const
+		{
+			OGLF_ALIGN( 32 ) float pData[ 8 ];
+			store( pData );
+			return pData[ i ];
+		}
+	};
+}
+
+#endif /* SIMD_H */
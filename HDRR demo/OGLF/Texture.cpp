@@ -1,6 +1,12 @@
 #include <iostream>
 #include <IL/il.h>
 #include "Texture.h"
+#ifdef WIN32
+#include <Windows.h>
+#endif
+#include <GL/glfw.h>
+#include "HalfFloat.h"
+#include "utils.h"
 
 // #include <ImfRgbaFile.h>
 // #include <ImfArray.h>
@@ -47,8 +53,8 @@ namespace Oglf
 		EXR_PIC,
 		RGBA16F,
 		RGBA,
-		FLOAT, // or HALF if it read with the OpenEXR lib
-		16
+		HALF, // converted from floats on load, see loadFileDevIL()
+		8
 	};
 
 	PicFormatInfo HDR =
@@ -152,22 +158,26 @@ namespace Oglf
 
 			if( formatInfo.eName == EXR_PIC )
 			{
-// 				int iSize = width * height * 4;
-// 				GLfloat* pfData = new GLfloat[ iSize ];
-				ilCopyPixels( 0, 0, 0, width, height, 1, IL_RGBA, IL_FLOAT, pData );
-				
-// 				GLfloat* pfData = ( GLfloat* )pData;
-// 
-// 				int size = width * height * 4;
-// 				for( int i = 0; i < size; ++i )
-// 				{
-// 					 float val = pfData[ i ];
-// 
-// 					if( val > 1.f )
-// 						cout << "Val = " << val << endl;
-// 				}
-				
-				//delete[] pfData;
+				// DevIL only gives us 32 bits floats: convert them to half floats by chunks of rows so
+				// that the full precision picture is never held in memory.
+				const int iChunkRows = 32;
+				const int iRowSize = width * 4;
+				GLfloat* pfChunk = new GLfloat[ iChunkRows * iRowSize ];
+				Half* pHalfData = ( Half* )pData;
+
+				double dStart = getTime();
+
+				for( int iRow = 0; iRow < ( int )height; iRow += iChunkRows )
+				{
+					int iRows = ( int )height - iRow < iChunkRows ? ( int )height - iRow : iChunkRows;
+					ilCopyPixels( 0, iRow, 0, width, iRows, 1, IL_RGBA, IL_FLOAT, pfChunk );
+					floatToHalf( pfChunk, pHalfData + iRow * iRowSize, iRows * iRowSize );
+				}
+
+				delete[] pfChunk;
+
+				cout << "Converted " << filename << " to half floats in " << ( getTime() - dStart ) * 1000.0 << " ms, "
+					<< iDataSize / 1024 << " KB saved" << endl;
 			}
 			else
 			{
@@ -190,6 +200,246 @@ namespace Oglf
 		return pData;;
 	}
 
+	/**
+	* @brief  writes a picture with DevIL, from its bottom row to its top one as OpenGL reads them back
+	* @param  filename the picture filename, overwritten if it exists
+	* @param  formatInfo the picture format info: PNG from RGB or RGBA bytes, or EXR from RGBA half floats
+	* @param  width the picture width
+	* @param  height the picture height
+	* @param  pData the picture data
+	*/
+	void saveFileDevIL( const char* filename, PicFormatInfo& formatInfo, GLuint width, GLuint height, const GLvoid* pData )
+	{
+		ILuint iHandle;
+		ilGenImages( 1, &iHandle );
+		ilBindImage( iHandle );
+
+		ILboolean bCreated;
+		ILenum eType;
+		if( formatInfo.eName == EXR_PIC )
+		{
+			// DevIL only takes 32 bits floats
+			GLfloat* pfData = new GLfloat[ 4 * width * height ];
+			halfToFloat( ( const Half* )pData, pfData, 4 * width * height );
+			bCreated = ilTexImage( width, height, 1, 4, IL_RGBA, IL_FLOAT, pfData );
+			delete[] pfData;
+			eType = IL_EXR;
+		}
+		else if( formatInfo.eName == PNG_PIC )
+		{
+			if( formatInfo.ePixelFormat == RGBA )
+				bCreated = ilTexImage( width, height, 1, 4, IL_RGBA, IL_UNSIGNED_BYTE, ( void* )pData );
+			else
+				bCreated = ilTexImage( width, height, 1, 3, IL_RGB, IL_UNSIGNED_BYTE, ( void* )pData );
+			eType = IL_PNG;
+		}
+		else
+		{
+			ilDeleteImages( 1, &iHandle );
+			throw Error( "Texture::saveFile error: picture format is not supported for writing", filename );
+		}
+
+		bool bSaved = bCreated == IL_TRUE;
+		if( bSaved )
+		{
+			ilRegisterOrigin( IL_ORIGIN_LOWER_LEFT );
+			ilEnable( IL_FILE_OVERWRITE );
+			bSaved = ilSave( eType, filename ) == IL_TRUE;
+		}
+
+		ilDeleteImages( 1, &iHandle );
+
+		if( !bSaved || ilGetError() != IL_NO_ERROR )
+			throw Error( "Texture::saveFile error: Failed to write file", filename );
+	}
+
+	static GLFWmutex s_oDevILLock = NULL;
+
+	/**
+	* @brief initializes DevIL, pictures are loaded from their upper left corner, and creates the mutex serializing
+	* the DevIL calls of several threads. To be called by the main thread before any other thread uses DevIL.
+	*/
+	void initDevIL()
+	{
+		ilInit();
+		ilEnable( IL_ORIGIN_SET );
+		ilSetInteger( IL_ORIGIN_MODE, IL_ORIGIN_UPPER_LEFT );
+
+		if( s_oDevILLock == NULL )
+			s_oDevILLock = glfwCreateMutex();
+	}
+
+	/**
+	* @brief locks the mutex serializing the DevIL calls, DevIL is not thread safe. Nothing is locked when
+	* initDevIL() was not called, in single threaded tools.
+	*/
+	void lockDevIL()
+	{
+		if( s_oDevILLock != NULL )
+			glfwLockMutex( s_oDevILLock );
+	}
+
+	/**
+	* @brief unlocks the mutex serializing the DevIL calls
+	*/
+	void unlockDevIL()
+	{
+		if( s_oDevILLock != NULL )
+			glfwUnlockMutex( s_oDevILLock );
+	}
+
+	/**
+	* @brief returns the size of a texel of an uncompressed internal format, padded as drivers usually store it
+	* @param eFormat the internal format
+	* @return the texel size in bytes
+	*/
+	GLuint getTexelSize( DataFormat eFormat )
+	{
+		switch( eFormat )
+		{
+		case RGB16F:
+		case RGBA16F:
+			return 8;
+		case RGB32F:
+			return 12;
+		case RGBA32F:
+			return 16;
+		case DEPTH16:
+			return 2;
+		default:
+			return 4;
+		}
+	}
+
+	/**
+	* @brief returns the number of levels of a full mipmap chain
+	* @param iWidth the first level width
+	* @param iHeight the first level height
+	* @return the number of mipmap levels
+	*/
+	int getMipChainLength( GLuint iWidth, GLuint iHeight )
+	{
+		GLuint iSize = maxT( iWidth, iHeight );
+		int iMipCount = 1;
+
+		while( ( iSize >> iMipCount ) > 0 )
+			++iMipCount;
+
+		return iMipCount;
+	}
+
+	GLuint			Texture::s_iTotalMemorySize = 0;
+	GLuint			Texture::s_iPeakMemorySize = 0;
+	unsigned int	Texture::s_iFrame = 0;
+
+	/**
+	* @brief  updates the video memory used by the texture and the total texture memory
+	* @param  iSize the memory size in bytes
+	*/
+	void Texture::setMemorySize( GLuint iSize )
+	{
+		s_iTotalMemorySize = s_iTotalMemorySize - m_iMemorySize + iSize;
+		m_iMemorySize = iSize;
+
+		if( s_iTotalMemorySize > s_iPeakMemorySize )
+			s_iPeakMemorySize = s_iTotalMemorySize;
+	}
+
+	/**
+	* @brief  computes the video memory used by mipmap levels in the texture format
+	* @param  iWidth the first level width
+	* @param  iHeight the first level height
+	* @param  iMipCount the number of levels
+	* @return the memory size in bytes
+	*/
+	GLuint Texture::getLevelsMemorySize( GLuint iWidth, GLuint iHeight, int iMipCount ) const
+	{
+		GLuint iSize = 0;
+
+		for( int i = 0; i < iMipCount; ++i )
+		{
+			GLuint w = maxT( iWidth >> i, 1u );
+			GLuint h = maxT( iHeight >> i, 1u );
+
+			// the supported compressed formats store 4x4 texel blocks in 16 bytes
+			if( m_iCompressedFormat != 0 )
+				iSize += ( ( w + 3 ) / 4 ) * ( ( h + 3 ) / 4 ) * 16;
+			else
+				iSize += w * h * getTexelSize( m_oFormat.eDataFormat );
+		}
+
+		return iSize;
+	}
+
+	/**
+	* @brief  reads back mipmap levels of a texture image, the texture must be bound
+	* @param  eTarget the texture image target
+	* @param  iFirstLevel the first level to read, the next ones are read up to the last defined level
+	* @param  vLevels the levels data
+	*/
+	void Texture::readLevels( GLenum eTarget, int iFirstLevel, vector< vector< GLubyte > >& vLevels ) const
+	{
+		vLevels.resize( m_iMipCount - iFirstLevel );
+		glPixelStorei( GL_PACK_ALIGNMENT, 1 );
+
+		for( int i = iFirstLevel; i < m_iMipCount; ++i )
+		{
+			vector< GLubyte >& vLevel = vLevels[ i - iFirstLevel ];
+
+			if( m_iCompressedFormat != 0 )
+			{
+				GLint iSize = 0;
+				glGetTexLevelParameteriv( eTarget, i, GL_TEXTURE_COMPRESSED_IMAGE_SIZE_ARB, &iSize );
+				vLevel.resize( iSize );
+				glGetCompressedTexImageARB( eTarget, i, &vLevel[ 0 ] );
+			}
+			else
+			{
+				vLevel.resize( maxT( width >> i, 1u ) * maxT( height >> i, 1u ) * m_oFormat.iPixelSize );
+				glGetTexImage( eTarget, i, m_oFormat.ePixelFormat, m_oFormat.eDataType, &vLevel[ 0 ] );
+			}
+		}
+
+		glPixelStorei( GL_PACK_ALIGNMENT, 4 );
+		Error::checkGLerror( "Texture::readLevels" );
+	}
+
+	/**
+	* @brief  defines the mipmap levels of a texture image from data read by readLevels(), the texture must be bound
+	* @param  eTarget the texture image target
+	* @param  iWidth the first level width
+	* @param  iHeight the first level height
+	* @param  vLevels the levels data
+	*/
+	void Texture::writeLevels( GLenum eTarget, GLuint iWidth, GLuint iHeight, const vector< vector< GLubyte > >& vLevels ) const
+	{
+		glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+
+		for( int i = 0; i < ( int )vLevels.size(); ++i )
+		{
+			GLuint w = maxT( iWidth >> i, 1u );
+			GLuint h = maxT( iHeight >> i, 1u );
+
+			if( m_iCompressedFormat != 0 )
+				glCompressedTexImage2DARB( eTarget, i, m_iCompressedFormat, w, h, 0, ( GLsizei )vLevels[ i ].size(), &vLevels[ i ][ 0 ] );
+			else
+				glTexImage2D( eTarget, i, m_oFormat.eDataFormat, w, h, 0, m_oFormat.ePixelFormat, m_oFormat.eDataType, &vLevels[ i ][ 0 ] );
+		}
+
+		glPixelStorei( GL_UNPACK_ALIGNMENT, 4 );
+		Error::checkGLerror( "Texture::writeLevels" );
+	}
+
+	/**
+	* @brief  replaces the gl texture by a new one without storage, which releases the old texture memory
+	*/
+	void Texture::recreate()
+	{
+		glDeleteTextures( 1, &glID );
+		glGenTextures( 1, &glID );
+		setMemorySize( 0 );
+	}
+
 	/**
 	* @brief  loads a picture in memory with the specified format
 	* @param  format the picture format: TGA, JPG, EXR48...
@@ -201,7 +451,19 @@ namespace Oglf
 		GLubyte* pData = NULL;
 
 		if( formatInfo.eName & DEVIL_SUPPORTED_PIC )
-			pData = loadFileDevIL( filename.c_str(), formatInfo, width, height );
+		{
+			lockDevIL();
+			try
+			{
+				pData = loadFileDevIL( filename.c_str(), formatInfo, width, height );
+			}
+			catch( Error e )
+			{
+				unlockDevIL();
+				throw;
+			}
+			unlockDevIL();
+		}
 // 		else if( formatInfo.eName & EXR48_PIC )
 // 			pData = loadEXR48( filename, width, height );
 		else
@@ -209,4 +471,27 @@ namespace Oglf
 
 		return pData;
 	}
+
+	/**
+	* @brief write a picture data on the hard disk in the specified format
+	* @param format the picture format: PNG from RGB or RGBA bytes, or EXR from RGBA half floats
+	* @param filename the picture filename
+	* @param w the picture width
+	* @param h the picture height
+	* @param data the picture data, from the bottom row to the top one
+	*/
+	void Texture::writeFile( PicFormatInfo& formatInfo, const char* filename, GLuint w, GLuint h, const GLubyte* data )
+	{
+		lockDevIL();
+		try
+		{
+			saveFileDevIL( filename, formatInfo, w, h, data );
+		}
+		catch( Error e )
+		{
+			unlockDevIL();
+			throw;
+		}
+		unlockDevIL();
+	}
 }
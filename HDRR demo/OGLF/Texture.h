@@ -1,8 +1,11 @@
 #ifndef TEXTURE_H
 #define TEXTURE_H
 
+#include <vector>
 #include <GL/glew.h>
 #include "Error.h"
+#include "Core.h"
+#include "RenderStats.h"
 
 namespace Oglf
 {
@@ -88,10 +91,62 @@ namespace Oglf
 	extern PicFormatInfo DEPTH_24;
 	extern PicFormatInfo DEPTH_32;
 
+	/**
+	* @brief  loads a picture in memory with DevIL, EXR pictures are converted to half floats
+	* @param  filename the picture filename
+	* @param  formatInfo the picture format info
+	* @param  width the picture width
+	* @param  height the picture height
+	* @return GLubyte* the picture data, to be deleted with delete[]
+	*/
+	GLubyte* loadFileDevIL( const char* filename, PicFormatInfo& formatInfo, GLuint& width, GLuint& height );
+
+	/**
+	* @brief  writes a picture with DevIL, from its bottom row to its top one as OpenGL reads them back
+	* @param  filename the picture filename, overwritten if it exists
+	* @param  formatInfo the picture format info: PNG from RGB or RGBA bytes, or EXR from RGBA half floats
+	* @param  width the picture width
+	* @param  height the picture height
+	* @param  pData the picture data
+	*/
+	void saveFileDevIL( const char* filename, PicFormatInfo& formatInfo, GLuint width, GLuint height, const GLvoid* pData );
+
+	/**
+	* @brief initializes DevIL, pictures are loaded from their upper left corner, and creates the mutex serializing
+	* the DevIL calls of several threads. To be called by the main thread before any other thread uses DevIL.
+	*/
+	void initDevIL();
+
+	/**
+	* @brief locks the mutex serializing the DevIL calls, DevIL is not thread safe. Nothing is locked when
+	* initDevIL() was not called, in single threaded tools.
+	*/
+	void lockDevIL();
+
+	/**
+	* @brief unlocks the mutex serializing the DevIL calls
+	*/
+	void unlockDevIL();
+
+	/**
+	* @brief returns the size of a texel of an uncompressed internal format, padded as drivers usually store it
+	* @param eFormat the internal format
+	* @return the texel size in bytes
+	*/
+	GLuint getTexelSize( DataFormat eFormat );
+
+	/**
+	* @brief returns the number of levels of a full mipmap chain
+	* @param iWidth the first level width
+	* @param iHeight the first level height
+	* @return the number of mipmap levels
+	*/
+	int getMipChainLength( GLuint iWidth, GLuint iHeight );
+
 	/**
 	* class Texture2D
 	*/
-	class Texture
+	class Texture : public Core< MEMORY_TEXTURE >
 	{
 	protected:
 		GLuint		width;
@@ -102,6 +157,53 @@ namespace Oglf
 		TexFilter	magFilter;
 		bool		m_bStorageDefined;
 
+		PicFormatInfo			m_oFormat;				// format of the texture levels
+		GLenum					m_iCompressedFormat;	// gl compressed internal format of the levels, 0 when uncompressed
+		int						m_iMipCount;			// number of defined mipmap levels
+		GLuint					m_iMemorySize;			// video memory used by the defined levels, in bytes
+		mutable unsigned int	m_iLastBindFrame;		// frame of the last bind, see nextFrame()
+
+		static GLuint		s_iTotalMemorySize;
+		static GLuint		s_iPeakMemorySize;
+		static unsigned int	s_iFrame;
+
+		/**
+		* @brief  updates the video memory used by the texture and the total texture memory
+		* @param  iSize the memory size in bytes
+		*/
+		void setMemorySize( GLuint iSize );
+
+		/**
+		* @brief  computes the video memory used by mipmap levels in the texture format
+		* @param  iWidth the first level width
+		* @param  iHeight the first level height
+		* @param  iMipCount the number of levels
+		* @return the memory size in bytes
+		*/
+		GLuint getLevelsMemorySize( GLuint iWidth, GLuint iHeight, int iMipCount ) const;
+
+		/**
+		* @brief  reads back mipmap levels of a texture image, the texture must be bound
+		* @param  eTarget the texture image target
+		* @param  iFirstLevel the first level to read, the next ones are read up to the last defined level
+		* @param  vLevels the levels data
+		*/
+		void readLevels( GLenum eTarget, int iFirstLevel, std::vector< std::vector< GLubyte > >& vLevels ) const;
+
+		/**
+		* @brief  defines the mipmap levels of a texture image from data read by readLevels(), the texture must be bound
+		* @param  eTarget the texture image target
+		* @param  iWidth the first level width
+		* @param  iHeight the first level height
+		* @param  vLevels the levels data
+		*/
+		void writeLevels( GLenum eTarget, GLuint iWidth, GLuint iHeight, const std::vector< std::vector< GLubyte > >& vLevels ) const;
+
+		/**
+		* @brief  replaces the gl texture by a new one without storage, which releases the old texture memory
+		*/
+		void recreate();
+
 	public:
 
 		/**
@@ -118,13 +220,19 @@ namespace Oglf
 			, minFilter( NEAREST )
 			, magFilter( NEAREST )
 			, m_bStorageDefined(false)
+			, m_oFormat( EXR )
+			, m_iCompressedFormat( 0 )
+			, m_iMipCount( 0 )
+			, m_iMemorySize( 0 )
+			, m_iLastBindFrame( 0 )
 		{
 			glGenTextures(1, &glID);
 		}
 
 		virtual ~Texture()
 		{
-
+			setMemorySize( 0 );
+			glDeleteTextures(1, &glID);
 		}
 
 		void setSize( GLuint w, GLuint h )
@@ -173,6 +281,78 @@ namespace Oglf
 		*/
 		virtual void setMipMapBaseLevel (int lod ) = 0;
 
+		/**
+		* @brief returns whether the texture storage is defined: streamed textures are only
+		* complete once their first mipmap level has been uploaded
+		* @return true if the storage is defined
+		*/
+		bool isStorageDefined() const
+		{
+			return m_bStorageDefined;
+		}
+
+		/**
+		* @brief returns the number of defined mipmap levels
+		* @return the number of levels
+		*/
+		int getMipCount() const
+		{
+			return m_iMipCount;
+		}
+
+		/**
+		* @brief returns the video memory used by the texture, including its mipmap levels and cube map faces
+		* @return the memory size in bytes
+		*/
+		virtual GLuint getMemorySize() const
+		{
+			return m_iMemorySize;
+		}
+
+		/**
+		* @brief returns the frame the texture has been bound for the last time
+		* @return the frame number, see nextFrame()
+		*/
+		virtual unsigned int getLastBindFrame() const
+		{
+			return m_iLastBindFrame;
+		}
+
+		/**
+		* @brief starts a new frame: binds are stamped with the frame number to know which textures are in use
+		*/
+		static void nextFrame()
+		{
+			++s_iFrame;
+		}
+
+		/**
+		* @brief returns the current frame number
+		* @return the number of nextFrame() calls
+		*/
+		static unsigned int getFrame()
+		{
+			return s_iFrame;
+		}
+
+		/**
+		* @brief returns the video memory used by all the textures
+		* @return the memory size in bytes
+		*/
+		static GLuint getTotalMemorySize()
+		{
+			return s_iTotalMemorySize;
+		}
+
+		/**
+		* @brief returns the highest video memory used by all the textures at once
+		* @return the memory size in bytes
+		*/
+		static GLuint getPeakMemorySize()
+		{
+			return s_iPeakMemorySize;
+		}
+
 		/**
 		* @return glID the texture gl handle
 		*/
@@ -209,20 +389,13 @@ namespace Oglf
 
 		/**
 		* @brief write a picture data on the hard disk in the specified format
-		* @param format the picture format: PNG format is the only format supported at the present time
+		* @param format the picture format: PNG from RGB or RGBA bytes, or EXR from RGBA half floats
 		* @param filename the picture filename
-		* @param data the picture data
+		* @param w the picture width
+		* @param h the picture height
+		* @param data the picture data, from the bottom row to the top one
 		*/
-		static void writeFile(PicFormatInfo& formatInfo, char* filename, GLuint w, GLuint h, GLubyte* data)
-		{
-// 			switch (formatInfo.name)
-// 			{
-// 			case PNG_PIC: writePNG(filename, w, h, data);
-// 				break;
-// 			default:
-// 				throw Error("Texture::writeFile error: invalid format: ", filename);
-// 			}
-		}
+		static void writeFile(PicFormatInfo& formatInfo, const char* filename, GLuint w, GLuint h, const GLubyte* data);
 	};
 }
 
@@ -1,6 +1,8 @@
 #include "Texture.h"
 #include "Texture2D.h"
 
+using namespace std;
+
 
 namespace Oglf
 {
@@ -18,4 +20,39 @@ namespace Oglf
 
 		delete[] data;
 	}
+
+	/**
+	* @brief  releases the finest mipmap levels: the texture is redefined from the level iFirstLevel,
+	* which becomes its first level
+	* @param  iFirstLevel the first kept level
+	*/
+	void Texture2D::evictLevels( int iFirstLevel )
+	{
+		if( iFirstLevel <= 0 || iFirstLevel >= m_iMipCount )
+			return;
+
+		vector< vector< GLubyte > > vLevels;
+		unsigned int iLastBindFrame = m_iLastBindFrame;
+
+		this->bind();
+		readLevels( GL_TEXTURE_2D, iFirstLevel, vLevels );
+
+		recreate();
+		width  = maxT( width >> iFirstLevel, 1u );
+		height = maxT( height >> iFirstLevel, 1u );
+		m_iMipCount -= iFirstLevel;
+
+		this->bind();
+		writeLevels( GL_TEXTURE_2D, width, height, vLevels );
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, m_iMipCount - 1);
+		setWrapMode( wrapMode );
+		setFilters( minFilter, magFilter );
+		setMemorySize( getLevelsMemorySize( width, height, m_iMipCount ) );
+
+		// eviction is not a use of the texture
+		m_iLastBindFrame = iLastBindFrame;
+
+		Error::checkGLerror("Texture2D::evictLevels");
+		m_bStorageDefined=true;
+	}
 }
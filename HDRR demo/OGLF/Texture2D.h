@@ -4,6 +4,7 @@
 #include <GL/glew.h>
 #include "Texture.h"
 #include "Error.h"
+#include "utils.h"
 
 namespace Oglf
 {
@@ -14,6 +15,20 @@ namespace Oglf
 	{
 		bool          m_bAutoGenerateMipmap;
 
+		/**
+		* @brief  disables mipmap generation and restricts sampling to the smallest of the allocated levels
+		* @param  iMipCount the number of allocated mipmap levels
+		*/
+		void setStreamedLevels( int iMipCount )
+		{
+			glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_FALSE);
+			m_bAutoGenerateMipmap = false;
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, iMipCount - 1);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, iMipCount - 1);
+			m_iMipCount = iMipCount;
+			m_bStorageDefined = false;
+		}
+
 	public:
 
 		/**
@@ -63,12 +78,115 @@ namespace Oglf
 				glTexImage2D(GL_TEXTURE_2D, 0, formatInfo.eDataFormat, width, height, border, formatInfo.ePixelFormat, formatInfo.eDataType, data);
 			}
 
-			
-			
+			m_oFormat = formatInfo;
+			m_iCompressedFormat = 0;
+			m_iMipCount = m_bAutoGenerateMipmap ? getMipChainLength( width, height ) : 1;
+			setMemorySize( getLevelsMemorySize( width, height, m_iMipCount ) );
+
 			Error::checkGLerror("Texture2D::storage");
 			m_bStorageDefined=true;
 		}
 
+		/**
+		* @brief  sets one mipmap level of the texture storage from compressed data
+		* @param  iFormat the gl compressed internal format
+		* @param  iLevel the mipmap level
+		* @param  iWidth the level width
+		* @param  iHeight the level height
+		* @param  iSize the compressed data size in bytes
+		* @param  data a pointer to the compressed data
+		*/
+		void setCompressedData( GLenum iFormat, GLint iLevel, GLuint iWidth, GLuint iHeight, GLsizei iSize, const GLvoid* data )
+		{
+			this->bind();
+			glCompressedTexImage2DARB(GL_TEXTURE_2D, iLevel, iFormat, iWidth, iHeight, 0, iSize, data);
+
+			// compressed levels are provided one by one, they must not be generated
+			glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_FALSE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, iLevel);
+
+			m_iCompressedFormat = iFormat;
+			m_iMipCount = iLevel + 1;
+			setMemorySize( ( iLevel == 0 ? 0 : m_iMemorySize ) + iSize );
+
+			Error::checkGLerror("Texture2D::setCompressedData");
+			m_bStorageDefined=true;
+		}
+
+		/**
+		* @brief  allocates every mipmap level of the texture storage without data, to be filled with setSubData().
+		* Only the smallest level is sampled until setResidentLevel() is called.
+		* @param  formatInfo the picture format info
+		* @param  iMipCount the number of mipmap levels
+		*/
+		void allocateStorage( PicFormatInfo& formatInfo, int iMipCount )
+		{
+			this->bind();
+			for( int i = 0; i < iMipCount; ++i )
+				glTexImage2D(GL_TEXTURE_2D, i, formatInfo.eDataFormat, maxT( width >> i, 1u ), maxT( height >> i, 1u ), 0, formatInfo.ePixelFormat, formatInfo.eDataType, NULL);
+
+			m_oFormat = formatInfo;
+			m_iCompressedFormat = 0;
+			setStreamedLevels( iMipCount );
+			setMemorySize( getLevelsMemorySize( width, height, iMipCount ) );
+		}
+
+		/**
+		* @brief  allocates every mipmap level of a compressed texture storage without data, to be filled with setSubData().
+		* Only the smallest level is sampled until setResidentLevel() is called.
+		* @param  iFormat the gl compressed internal format
+		* @param  iMipCount the number of mipmap levels
+		* @param  pLevelSizes the compressed size of each level in bytes
+		*/
+		void allocateCompressedStorage( GLenum iFormat, int iMipCount, const GLsizei* pLevelSizes )
+		{
+			this->bind();
+			for( int i = 0; i < iMipCount; ++i )
+				glCompressedTexImage2DARB(GL_TEXTURE_2D, i, iFormat, maxT( width >> i, 1u ), maxT( height >> i, 1u ), 0, pLevelSizes[ i ], NULL);
+
+			GLuint iMemorySize = 0;
+			for( int i = 0; i < iMipCount; ++i )
+				iMemorySize += pLevelSizes[ i ];
+
+			m_iCompressedFormat = iFormat;
+			setStreamedLevels( iMipCount );
+			setMemorySize( iMemorySize );
+		}
+
+		/**
+		* @brief  fills a mipmap level allocated by allocateStorage() or allocateCompressedStorage()
+		* @param  iLevel the mipmap level
+		* @param  data a pointer to the level data, or an offset in the bound pixel unpack buffer
+		* @param  iSize the data size in bytes
+		*/
+		void setSubData( int iLevel, const GLvoid* data, GLsizei iSize )
+		{
+			// may be called on the upload context resource thread: the bind is neither a state change nor a use of the texture
+			glBindTexture(GL_TEXTURE_2D, glID);
+			if( m_iCompressedFormat != 0 )
+				glCompressedTexSubImage2DARB(GL_TEXTURE_2D, iLevel, 0, 0, maxT( width >> iLevel, 1u ), maxT( height >> iLevel, 1u ), m_iCompressedFormat, iSize, data);
+			else
+				glTexSubImage2D(GL_TEXTURE_2D, iLevel, 0, 0, maxT( width >> iLevel, 1u ), maxT( height >> iLevel, 1u ), m_oFormat.ePixelFormat, m_oFormat.eDataType, data);
+		}
+
+		/**
+		* @brief  makes the texture sample its levels from iLevel, once they have all been filled
+		* @param  iLevel the finest filled mipmap level
+		*/
+		void setResidentLevel( int iLevel )
+		{
+			setMipMapBaseLevel( iLevel );
+			if( iLevel == 0 )
+				m_bStorageDefined = true;
+		}
+
+		/**
+		* @brief  releases the finest mipmap levels: the texture is redefined from the level iFirstLevel,
+		* which becomes its first level
+		* @param  iFirstLevel the first kept level
+		*/
+		void evictLevels( int iFirstLevel );
+
 		/**
 		* @brief  loads a picture in memory with the specified format
 		* @param  formatInfo the picture format info
@@ -83,8 +201,10 @@ namespace Oglf
 		*/
 		void bind (bool state=true) const
 		{
+			RenderStats::addStateChange();
 			if( state )
 			{
+				m_iLastBindFrame = s_iFrame;
 				glBindTexture(GL_TEXTURE_2D, glID);
 			}
 			else
@@ -111,8 +231,12 @@ namespace Oglf
 				glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_TRUE); 
 
 				m_bAutoGenerateMipmap = true;
-				if( m_bStorageDefined )
+				if( m_bStorageDefined && m_iCompressedFormat == 0 )
+				{
 					glGenerateMipmapEXT( GL_TEXTURE_2D );
+					m_iMipCount = getMipChainLength( width, height );
+					setMemorySize( getLevelsMemorySize( width, height, m_iMipCount ) );
+				}
 			}
 		}
 
@@ -82,6 +82,7 @@ namespace Oglf
 			glVertex2f(0.0, 1.0);
 
 			glEnd();
+			RenderStats::addDrawCall( 2 );
 
 			m_pRfx->disable();
 			m_pRTex->bind( false );
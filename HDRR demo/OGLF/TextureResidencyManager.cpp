@@ -0,0 +1,213 @@
+#include "TextureResidencyManager.h"
+#include "Profiler.h"
+
+using namespace std;
+
+namespace Oglf
+{
+	/**
+	* @brief constructor
+	* @param oStreamer the streamer used to load and restore the managed textures
+	* @param iBudget the video memory all the textures may use, in bytes
+	* @param iEvictedSize the faces width and height evicted cube maps are reduced to
+	*/
+	TextureResidencyManager::TextureResidencyManager( TextureStreamer& oStreamer, GLuint iBudget, GLuint iEvictedSize )
+		: m_oStreamer( oStreamer )
+		, m_iBudget( iBudget )
+		, m_iEvictedSize( iEvictedSize )
+		, m_iEvictionNb( 0 )
+		, m_iRestorationNb( 0 )
+	{
+	}
+
+	/**
+	* @brief manages a cube map and streams it
+	* @param pCubeMap the cube map, it must be removed before being deleted
+	* @param sFilename the cube map file, see TextureStreamer::streamCubeMap()
+	*/
+	void TextureResidencyManager::addCubeMap( CubeMap* pCubeMap, const string& sFilename )
+	{
+		ManagedTexture oTexture;
+		oTexture.pCubeMap = pCubeMap;
+		oTexture.sFilename = sFilename;
+		oTexture.bEvicted = false;
+		oTexture.bPinned = false;
+		oTexture.iEvictionFrame = 0;
+		oTexture.iResidentSize = 0;
+		m_vTextures.push_back( oTexture );
+
+		m_oStreamer.streamCubeMap( pCubeMap, sFilename );
+	}
+
+	/**
+	* @brief stops managing a texture and cancels its streaming, it can be deleted once this returns
+	* @param pTexture the texture
+	*/
+	void TextureResidencyManager::remove( const Texture* pTexture )
+	{
+		m_oStreamer.cancel( pTexture );
+
+		for( size_t i = 0; i < m_vTextures.size(); ++i )
+		{
+			if( m_vTextures[ i ].pCubeMap == pTexture )
+			{
+				m_vTextures.erase( m_vTextures.begin() + i );
+				return;
+			}
+		}
+	}
+
+	/**
+	* @brief returns the managed texture of a texture
+	* @param pTexture the texture
+	* @return the managed texture, NULL if the texture is not managed
+	*/
+	TextureResidencyManager::ManagedTexture* TextureResidencyManager::find( const Texture* pTexture )
+	{
+		for( size_t i = 0; i < m_vTextures.size(); ++i )
+			if( m_vTextures[ i ].pCubeMap == pTexture )
+				return &m_vTextures[ i ];
+
+		return NULL;
+	}
+
+	/**
+	* @brief returns the managed texture of a texture
+	* @param pTexture the texture
+	* @return the managed texture, NULL if the texture is not managed
+	*/
+	const TextureResidencyManager::ManagedTexture* TextureResidencyManager::find( const Texture* pTexture ) const
+	{
+		for( size_t i = 0; i < m_vTextures.size(); ++i )
+			if( m_vTextures[ i ].pCubeMap == pTexture )
+				return &m_vTextures[ i ];
+
+		return NULL;
+	}
+
+	/**
+	* @brief pins or unpins a texture: a pinned texture is kept resident even when it is not used, and is
+	* restored by the next update() when it is evicted
+	* @param pTexture the texture
+	* @param bPinned true: the texture is pinned, false: it can be evicted
+	*/
+	void TextureResidencyManager::setPinned( const Texture* pTexture, bool bPinned )
+	{
+		ManagedTexture* pManagedTexture = find( pTexture );
+
+		if( pManagedTexture != NULL )
+			pManagedTexture->bPinned = bPinned;
+	}
+
+	/**
+	* @brief returns the memory a texture uses when all its levels are resident, evicted or not
+	* @param pTexture the texture
+	* @return the memory size in bytes, 0 when the texture has never been completely resident
+	*/
+	GLuint TextureResidencyManager::getResidentSize( const Texture* pTexture ) const
+	{
+		const ManagedTexture* pManagedTexture = find( pTexture );
+
+		return pManagedTexture != NULL ? pManagedTexture->iResidentSize : 0;
+	}
+
+	/**
+	* @brief reduces a cube map to its levels no larger than the evicted size
+	* @param oTexture the managed cube map
+	*/
+	void TextureResidencyManager::evict( ManagedTexture& oTexture )
+	{
+		CubeMap* pCubeMap = oTexture.pCubeMap;
+		int iFirstLevel = 0;
+
+		while( ( pCubeMap->getWidth() >> iFirstLevel ) > m_iEvictedSize && iFirstLevel < pCubeMap->getMipCount() - 1 )
+			++iFirstLevel;
+
+		pCubeMap->evictLevels( iFirstLevel );
+
+		oTexture.bEvicted = true;
+		oTexture.iEvictionFrame = Texture::getFrame();
+		++m_iEvictionNb;
+	}
+
+	/**
+	* @brief starts a new frame: restores the evicted textures bound during the last frames or pinned and evicts
+	* the least recently bound ones while the budget is exceeded, to be called once per frame before drawing
+	*/
+	void TextureResidencyManager::update()
+	{
+		OGLF_PROFILE_SCOPE( "TextureResidencyManager::update" );
+
+		Texture::nextFrame();
+		unsigned int iFrame = Texture::getFrame();
+
+		// evicted textures in use again are streamed from their file, they are drawn
+		// from their low resolution levels until their finest levels are uploaded
+		for( size_t i = 0; i < m_vTextures.size(); ++i )
+		{
+			ManagedTexture& oTexture = m_vTextures[ i ];
+
+			if( !oTexture.bEvicted && oTexture.pCubeMap->isStorageDefined() && !m_oStreamer.isStreaming( oTexture.pCubeMap ) )
+				oTexture.iResidentSize = oTexture.pCubeMap->getMemorySize();
+
+			if( oTexture.bEvicted && ( oTexture.bPinned || oTexture.pCubeMap->getLastBindFrame() > oTexture.iEvictionFrame ) )
+			{
+				oTexture.bEvicted = false;
+				m_oStreamer.streamCubeMap( oTexture.pCubeMap, oTexture.sFilename );
+				++m_iRestorationNb;
+			}
+		}
+
+		while( Texture::getTotalMemorySize() > m_iBudget )
+		{
+			// textures pinned, being streamed or bound during the last frame are never evicted, the
+			// budget is exceeded when they do not fit in it on their own
+			ManagedTexture* pVictim = NULL;
+
+			for( size_t i = 0; i < m_vTextures.size(); ++i )
+			{
+				ManagedTexture& oTexture = m_vTextures[ i ];
+				CubeMap* pCubeMap = oTexture.pCubeMap;
+				unsigned int iLastBindFrame = pCubeMap->getLastBindFrame();
+
+				if( oTexture.bEvicted || oTexture.bPinned || iLastBindFrame + 1 >= iFrame || pCubeMap->getWidth() <= m_iEvictedSize ||
+					pCubeMap->getMipCount() <= 1 || m_oStreamer.isStreaming( pCubeMap ) )
+					continue;
+
+				if( pVictim == NULL || iLastBindFrame < pVictim->pCubeMap->getLastBindFrame() )
+					pVictim = &oTexture;
+			}
+
+			if( pVictim == NULL )
+				break;
+
+			evict( *pVictim );
+		}
+	}
+
+	/**
+	* @brief returns whether a texture is currently evicted
+	* @param pTexture the texture
+	* @return true if the texture only holds its low resolution levels
+	*/
+	bool TextureResidencyManager::isEvicted( const Texture* pTexture ) const
+	{
+		const ManagedTexture* pManagedTexture = find( pTexture );
+
+		return pManagedTexture != NULL && pManagedTexture->bEvicted;
+	}
+
+	/**
+	* @brief returns the video memory used by the managed textures
+	* @return the memory size in bytes
+	*/
+	GLuint TextureResidencyManager::getManagedUsage() const
+	{
+		GLuint iUsage = 0;
+
+		for( size_t i = 0; i < m_vTextures.size(); ++i )
+			iUsage += m_vTextures[ i ].pCubeMap->getMemorySize();
+
+		return iUsage;
+	}
+}
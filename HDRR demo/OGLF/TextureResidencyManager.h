@@ -0,0 +1,156 @@
+#ifndef TEXTURERESIDENCYMANAGER_H
+#define TEXTURERESIDENCYMANAGER_H
+
+#include <string>
+#include <vector>
+#include "CubeMap.h"
+#include "TextureStreamer.h"
+
+namespace Oglf
+{
+	/**
+	* class TextureResidencyManager keeps the texture video memory under a budget: when the textures use
+	* more than the budget, the least recently bound cube maps are evicted down to a low resolution mipmap
+	* level. An evicted cube map keeps being usable at that resolution and is streamed again from its file
+	* by the TextureStreamer as soon as it is bound or pinned. Pinned cube maps are never evicted.
+	*/
+	class TextureResidencyManager
+	{
+		/**
+		* @brief a cube map whose residency is managed
+		*/
+		struct ManagedTexture
+		{
+			CubeMap*		pCubeMap;
+			std::string		sFilename;			// the file the cube map is streamed from when it is restored
+			bool			bEvicted;
+			bool			bPinned;
+			unsigned int	iEvictionFrame;
+			GLuint			iResidentSize;		// memory used when all the levels are resident, 0 until they have been
+		};
+
+		TextureStreamer&				m_oStreamer;
+		GLuint							m_iBudget;
+		GLuint							m_iEvictedSize;		// faces size of evicted cube maps
+		std::vector< ManagedTexture >	m_vTextures;
+		unsigned int					m_iEvictionNb;
+		unsigned int					m_iRestorationNb;
+
+		void evict( ManagedTexture& oTexture );
+		ManagedTexture* find( const Texture* pTexture );
+		const ManagedTexture* find( const Texture* pTexture ) const;
+
+	public:
+
+		/**
+		* @brief constructor
+		* @param oStreamer the streamer used to load and restore the managed textures
+		* @param iBudget the video memory all the textures may use, in bytes
+		* @param iEvictedSize the faces width and height evicted cube maps are reduced to
+		*/
+		TextureResidencyManager( TextureStreamer& oStreamer, GLuint iBudget, GLuint iEvictedSize = 32 );
+
+		/**
+		* @brief manages a cube map and streams it
+		* @param pCubeMap the cube map, it must be removed before being deleted
+		* @param sFilename the cube map file, see TextureStreamer::streamCubeMap()
+		*/
+		void addCubeMap( CubeMap* pCubeMap, const std::string& sFilename );
+
+		/**
+		* @brief stops managing a texture and cancels its streaming, it can be deleted once this returns
+		* @param pTexture the texture
+		*/
+		void remove( const Texture* pTexture );
+
+		/**
+		* @brief pins or unpins a texture: a pinned texture is kept resident even when it is not used, and is
+		* restored by the next update() when it is evicted
+		* @param pTexture the texture
+		* @param bPinned true: the texture is pinned, false: it can be evicted
+		*/
+		void setPinned( const Texture* pTexture, bool bPinned );
+
+		/**
+		* @brief returns the memory a texture uses when all its levels are resident, evicted or not
+		* @param pTexture the texture
+		* @return the memory size in bytes, 0 when the texture has never been completely resident
+		*/
+		GLuint getResidentSize( const Texture* pTexture ) const;
+
+		/**
+		* @brief starts a new frame: restores the evicted textures bound during the last frames or pinned and evicts
+		* the least recently bound ones while the budget is exceeded, to be called once per frame before drawing
+		*/
+		void update();
+
+		/**
+		* @brief returns whether a texture is currently evicted
+		* @param pTexture the texture
+		* @return true if the texture only holds its low resolution levels
+		*/
+		bool isEvicted( const Texture* pTexture ) const;
+
+		/**
+		* @brief sets the video memory budget
+		* @param iBudget the video memory all the textures may use, in bytes
+		*/
+		void setBudget( GLuint iBudget )
+		{
+			m_iBudget = iBudget;
+		}
+
+		/**
+		* @brief returns the video memory budget
+		* @return the video memory all the textures may use, in bytes
+		*/
+		GLuint getBudget() const
+		{
+			return m_iBudget;
+		}
+
+		/**
+		* @brief returns the video memory currently used by all the textures
+		* @return the memory size in bytes
+		*/
+		GLuint getUsage() const
+		{
+			return Texture::getTotalMemorySize();
+		}
+
+		/**
+		* @brief returns the highest video memory used by all the textures at once
+		* @return the memory size in bytes
+		*/
+		GLuint getPeakUsage() const
+		{
+			return Texture::getPeakMemorySize();
+		}
+
+		/**
+		* @brief returns the video memory used by the managed textures
+		* @return the memory size in bytes
+		*/
+		GLuint getManagedUsage() const;
+
+		/**
+		* @brief returns the number of evictions since the manager creation
+		* @return the number of evictions
+		*/
+		unsigned int getEvictionCount() const
+		{
+			return m_iEvictionNb;
+		}
+
+		/**
+		* @brief returns the number of restorations since the manager creation
+		* @return the number of evicted textures streamed again
+		*/
+		unsigned int getRestorationCount() const
+		{
+			return m_iRestorationNb;
+		}
+	};
+}
+
+#endif /* TEXTURERESIDENCYMANAGER_H */
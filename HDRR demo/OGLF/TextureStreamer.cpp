@@ -0,0 +1,740 @@
+#include <cstring>
+#include "TextureStreamer.h"
+#include "CompressedCubeMap.h"
+#include "HalfFloat.h"
+#include "utils.h"
+#include "Profiler.h"
+
+using namespace std;
+
+namespace Oglf
+{
+	static const unsigned int s_iStagingAlignment = 64;
+
+	/**
+	* @brief returns the staging memory used by an upload
+	* @param iSize the upload size in bytes
+	* @return the size rounded up to the staging alignment
+	*/
+	static inline unsigned int alignStaging( unsigned int iSize )
+	{
+		return ( iSize + s_iStagingAlignment - 1 ) & ~( s_iStagingAlignment - 1 );
+	}
+
+	/**
+	* @brief the mipmap chains of the 6 faces of a cube map decoded from a cross, level 0 first. The level 0 of each
+	* face is extracted from the cross as bytes, the other levels are downsampled half floats: each is freed with the
+	* type it was allocated with when the chains go out of scope, even if staging them throws.
+	*/
+	struct CubeMapLevels
+	{
+		int					iMipCount;
+		vector< GLubyte* >	vFaces;		// the level 0 of each face
+		vector< Half* >		vLevels;	// the levels of each face, level 0 points to the face
+
+		CubeMapLevels( int iMipCount )
+			: iMipCount( iMipCount )
+			, vFaces( 6, ( GLubyte* )NULL )
+			, vLevels( 6 * iMipCount, ( Half* )NULL )
+		{
+		}
+
+		~CubeMapLevels()
+		{
+			for( size_t i = 0; i < vFaces.size(); ++i )
+				delete[] vFaces[ i ];
+
+			for( size_t i = 0; i < vLevels.size(); ++i )
+			{
+				if( i % iMipCount != 0 )
+					delete[] vLevels[ i ];
+			}
+		}
+
+	private:
+		CubeMapLevels( const CubeMapLevels& );
+		CubeMapLevels& operator=( const CubeMapLevels& );
+	};
+
+	/**
+	* @brief constructor: creates the staging buffer and starts the worker threads, must be called with a current GL context
+	* @param iStagingSize the staging buffer size in bytes, it must hold the largest face mipmap level
+	* @param iBytesPerFrame the number of bytes uploaded at most by update()
+	* @param iThreadNb the number of worker threads
+	* @param pUploadContext uploads the levels on its resource thread when it is shared, may be NULL. It must outlive the streamer.
+	*/
+	TextureStreamer::TextureStreamer( unsigned int iStagingSize, unsigned int iBytesPerFrame, int iThreadNb, UploadContext* pUploadContext )
+		: m_iStagingSize( iStagingSize )
+		, m_iStagingHead( 0 )
+		, m_iStagingTail( 0 )
+		, m_iStagingUsed( 0 )
+		, m_pStaging( NULL )
+		, m_iStagingPBO( 0 )
+		, m_pUploadContext( pUploadContext )
+		, m_iBytesPerFrame( iBytesPerFrame )
+		, m_iLastFrameBytes( 0 )
+		, m_bShutdown( false )
+	{
+		if( GLEW_ARB_buffer_storage && GLEW_ARB_sync && GLEW_ARB_pixel_buffer_object )
+		{
+			// worker threads write the mapped memory directly, the GL reads it asynchronously
+			const GLbitfield iFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+			glGenBuffersARB( 1, &m_iStagingPBO );
+			glBindBufferARB( GL_PIXEL_UNPACK_BUFFER_ARB, m_iStagingPBO );
+			glBufferStorage( GL_PIXEL_UNPACK_BUFFER_ARB, m_iStagingSize, NULL, iFlags );
+			m_pStaging = ( unsigned char* )glMapBufferRange( GL_PIXEL_UNPACK_BUFFER_ARB, 0, m_iStagingSize, iFlags );
+			glBindBufferARB( GL_PIXEL_UNPACK_BUFFER_ARB, 0 );
+
+			if( m_pStaging == NULL )
+			{
+				glDeleteBuffersARB( 1, &m_iStagingPBO );
+				m_iStagingPBO = 0;
+			}
+		}
+
+		// without persistent mapping the levels are uploaded from client memory
+		if( m_pStaging == NULL )
+			m_pStaging = new unsigned char[ m_iStagingSize ];
+
+		Error::checkGLerror( "TextureStreamer::TextureStreamer" );
+
+		m_oLock = glfwCreateMutex();
+		m_oRequestCond = glfwCreateCond();
+		m_oStagingCond = glfwCreateCond();
+		m_oUploadLock = glfwCreateMutex();
+
+		for( int i = 0; i < iThreadNb; ++i )
+			m_vThreads.push_back( glfwCreateThread( workerThread, this ) );
+	}
+
+	TextureStreamer::~TextureStreamer()
+	{
+		glfwLockMutex( m_oLock );
+		m_bShutdown = true;
+		for( size_t i = 0; i < m_vActiveRequests.size(); ++i )
+			m_vActiveRequests[ i ]->bCancelled = true;
+		glfwBroadcastCond( m_oRequestCond );
+		glfwBroadcastCond( m_oStagingCond );
+		glfwUnlockMutex( m_oLock );
+
+		for( size_t i = 0; i < m_vThreads.size(); ++i )
+			glfwWaitThread( m_vThreads[ i ], GLFW_WAIT );
+
+		// the cancelled levels queued on the upload context are skipped
+		if( m_pUploadContext != NULL )
+			m_pUploadContext->flush();
+
+		// every worker is stopped: flush the remaining uploads without touching their textures
+		while( !m_vPendingUploads.empty() )
+		{
+			m_vInFlightUploads.push_back( m_vPendingUploads.front() );
+			m_vPendingUploads.pop_front();
+		}
+		retireUploads( true );
+
+		for( size_t i = 0; i < m_vActiveRequests.size(); ++i )
+			delete m_vActiveRequests[ i ];
+
+		if( m_iStagingPBO != 0 )
+		{
+			glBindBufferARB( GL_PIXEL_UNPACK_BUFFER_ARB, m_iStagingPBO );
+			glUnmapBufferARB( GL_PIXEL_UNPACK_BUFFER_ARB );
+			glBindBufferARB( GL_PIXEL_UNPACK_BUFFER_ARB, 0 );
+			glDeleteBuffersARB( 1, &m_iStagingPBO );
+		}
+		else
+		{
+			delete[] m_pStaging;
+		}
+
+		glfwDestroyMutex( m_oUploadLock );
+		glfwDestroyCond( m_oStagingCond );
+		glfwDestroyCond( m_oRequestCond );
+		glfwDestroyMutex( m_oLock );
+	}
+
+	/**
+	* @brief queues a cube map to stream: a BC6H cache file written by the CubeMapCompressor tool or a vertical cross EXR picture
+	* @param pCubeMap the cube map, it must not be deleted before the streaming is completed or cancelled
+	* @param sFilename the picture file name
+	*/
+	void TextureStreamer::streamCubeMap( CubeMap* pCubeMap, const string& sFilename )
+	{
+		cancel( pCubeMap );
+
+		StreamRequest* pRequest = new StreamRequest( pCubeMap, sFilename );
+
+		glfwLockMutex( m_oLock );
+		m_vRequests.push_back( pRequest );
+		m_vActiveRequests.push_back( pRequest );
+		glfwSignalCond( m_oRequestCond );
+		glfwUnlockMutex( m_oLock );
+	}
+
+	/**
+	* @brief cancels the streaming of a texture, it can be deleted once this returns
+	* @param pTexture the texture
+	*/
+	void TextureStreamer::cancel( const Texture* pTexture )
+	{
+		glfwLockMutex( m_oLock );
+		for( size_t i = 0; i < m_vActiveRequests.size(); ++i )
+		{
+			if( m_vActiveRequests[ i ]->pCubeMap == pTexture )
+				m_vActiveRequests[ i ]->bCancelled = true;
+		}
+		glfwBroadcastCond( m_oStagingCond );
+		glfwUnlockMutex( m_oLock );
+
+		// waits for a level of the texture being uploaded by the resource thread, the next ones are skipped
+		glfwLockMutex( m_oUploadLock );
+		glfwUnlockMutex( m_oUploadLock );
+	}
+
+	/**
+	* @brief returns whether a texture is still being streamed
+	* @param pTexture the texture
+	* @return true if the texture is not complete yet
+	*/
+	bool TextureStreamer::isStreaming( const Texture* pTexture )
+	{
+		bool bStreaming = false;
+
+		glfwLockMutex( m_oLock );
+		for( size_t i = 0; i < m_vActiveRequests.size(); ++i )
+		{
+			if( m_vActiveRequests[ i ]->pCubeMap == pTexture && !m_vActiveRequests[ i ]->bCancelled )
+				bStreaming = true;
+		}
+		glfwUnlockMutex( m_oLock );
+
+		return bStreaming;
+	}
+
+	/**
+	* @brief returns whether every requested texture has been streamed
+	* @return true if there is nothing left to stream
+	*/
+	bool TextureStreamer::isIdle()
+	{
+		glfwLockMutex( m_oLock );
+		bool bIdle = m_vActiveRequests.empty();
+		glfwUnlockMutex( m_oLock );
+
+		return bIdle;
+	}
+
+	/**
+	* @brief returns the depth of the streaming queues
+	* @param iRequestNb the number of textures not completely streamed yet
+	* @param iUploadNb the number of decoded levels waiting in the staging buffer for their upload
+	*/
+	void TextureStreamer::getQueueDepth( int& iRequestNb, int& iUploadNb )
+	{
+		glfwLockMutex( m_oLock );
+		iRequestNb = ( int )m_vActiveRequests.size();
+		iUploadNb = ( int )m_vPendingUploads.size();
+		glfwUnlockMutex( m_oLock );
+	}
+
+	/**
+	* @brief worker thread: decodes the queued requests until the streamer is destroyed
+	* @param pData the texture streamer
+	*/
+	void GLFWCALL TextureStreamer::workerThread( void* pData )
+	{
+		TextureStreamer* pStreamer = ( TextureStreamer* )pData;
+
+		for( ;; )
+		{
+			glfwLockMutex( pStreamer->m_oLock );
+			while( pStreamer->m_vRequests.empty() && !pStreamer->m_bShutdown )
+				glfwWaitCond( pStreamer->m_oRequestCond, pStreamer->m_oLock, GLFW_INFINITY );
+
+			if( pStreamer->m_bShutdown )
+			{
+				glfwUnlockMutex( pStreamer->m_oLock );
+				return;
+			}
+
+			StreamRequest* pRequest = pStreamer->m_vRequests.front();
+			pStreamer->m_vRequests.pop_front();
+			glfwUnlockMutex( pStreamer->m_oLock );
+
+			pStreamer->decode( pRequest );
+
+			glfwLockMutex( pStreamer->m_oLock );
+			pRequest->bStaged = true;
+			glfwUnlockMutex( pStreamer->m_oLock );
+		}
+	}
+
+	/**
+	* @brief decodes a request and stages its levels, from the smallest to the largest one
+	* @param pRequest the request
+	*/
+	void TextureStreamer::decode( StreamRequest* pRequest )
+	{
+		glfwLockMutex( m_oLock );
+		bool bCancelled = pRequest->bCancelled;
+		glfwUnlockMutex( m_oLock );
+
+		if( bCancelled )
+			return;
+
+		try
+		{
+			const string& sFilename = pRequest->sFilename;
+
+			if( sFilename.size() > 5 && sFilename.compare( sFilename.size() - 5, 5, ".bc6h" ) == 0 )
+				decodeCompressed( pRequest );
+			else
+				decodeEXR( pRequest );
+		}
+		catch( Error e )
+		{
+			e.showError();
+
+			glfwLockMutex( m_oLock );
+			pRequest->bCancelled = true;
+			glfwUnlockMutex( m_oLock );
+		}
+	}
+
+	void TextureStreamer::decodeCompressed( StreamRequest* pRequest )
+	{
+		CompressedCubeMapData oCubeMap;
+		readCompressedCubeMap( pRequest->sFilename, oCubeMap );
+
+		glfwLockMutex( m_oLock );
+		pRequest->bCompressed = true;
+		pRequest->iCompressedFormat = oCubeMap.iFormat;
+		pRequest->iSize = oCubeMap.iFaceSize;
+		pRequest->iMipCount = oCubeMap.iMipCount;
+		for( unsigned int i = 0; i < oCubeMap.iMipCount; ++i )
+			pRequest->vLevelSizes.push_back( oCubeMap.getFaceDataSize( i ) );
+		pRequest->vLevelFacesLeft.assign( oCubeMap.iMipCount, 6 );
+		glfwUnlockMutex( m_oLock );
+
+		for( int iMip = oCubeMap.iMipCount - 1; iMip >= 0; --iMip )
+		{
+			for( int iFace = 0; iFace < 6; ++iFace )
+			{
+				if( !stage( pRequest, iFace, iMip, &oCubeMap.vData[ oCubeMap.getFaceDataOffset( iFace, iMip ) ], oCubeMap.getFaceDataSize( iMip ) ) )
+					return;
+			}
+		}
+	}
+
+	void TextureStreamer::decodeEXR( StreamRequest* pRequest )
+	{
+		GLuint iWidth, iHeight;
+		GLubyte* pCross;
+
+		lockDevIL();
+		try
+		{
+			pCross = loadFileDevIL( pRequest->sFilename.c_str(), EXR, iWidth, iHeight );
+		}
+		catch( Error e )
+		{
+			unlockDevIL();
+			throw;
+		}
+		unlockDevIL();
+
+		GLuint iFaceSize = iWidth / 3;
+		if( iFaceSize == 0 || iWidth != 3 * iFaceSize || iHeight != 4 * iFaceSize )
+		{
+			delete[] pCross;
+			throw Error( "TextureStreamer error: the picture is not a vertical cross cube map", pRequest->sFilename );
+		}
+
+		int iMipCount = 1;
+		while( ( iFaceSize >> iMipCount ) > 0 )
+			++iMipCount;
+
+		glfwLockMutex( m_oLock );
+		pRequest->bCompressed = false;
+		pRequest->iSize = iFaceSize;
+		pRequest->iMipCount = iMipCount;
+		for( int i = 0; i < iMipCount; ++i )
+			pRequest->vLevelSizes.push_back( EXR.iPixelSize * maxT( iFaceSize >> i, 1u ) * maxT( iFaceSize >> i, 1u ) );
+		pRequest->vLevelFacesLeft.assign( iMipCount, 6 );
+		glfwUnlockMutex( m_oLock );
+
+		CubeMapLevels oLevels( iMipCount );
+		vector< Half* >& vLevels = oLevels.vLevels;
+
+		for( int iFace = 0; iFace < 6; ++iFace )
+		{
+			oLevels.vFaces[ iFace ] = extractCubeMapFace( pCross, iFaceSize, EXR.iPixelSize, iFace );
+			vLevels[ iFace * iMipCount ] = ( Half* )oLevels.vFaces[ iFace ];
+
+			for( int iMip = 1; iMip < iMipCount; ++iMip )
+			{
+				vLevels[ iFace * iMipCount + iMip ] = new Half[ pRequest->vLevelSizes[ iMip ] / sizeof( Half ) ];
+				downsampleHalfRGBA( vLevels[ iFace * iMipCount + iMip - 1 ], maxT( iFaceSize >> ( iMip - 1 ), 1u ), maxT( iFaceSize >> ( iMip - 1 ), 1u ),
+					vLevels[ iFace * iMipCount + iMip ] );
+			}
+		}
+		delete[] pCross;
+
+		bool bStaged = true;
+		for( int iMip = iMipCount - 1; iMip >= 0 && bStaged; --iMip )
+		{
+			for( int iFace = 0; iFace < 6 && bStaged; ++iFace )
+				bStaged = stage( pRequest, iFace, iMip, vLevels[ iFace * iMipCount + iMip ], pRequest->vLevelSizes[ iMip ] );
+		}
+	}
+
+	/**
+	* @brief copies a face mipmap level in the staging buffer and queues its upload, waits for staging memory when the buffer is full
+	* @param pRequest the request
+	* @param iFace the face index, in GL_TEXTURE_CUBE_MAP_POSITIVE_X_ARB + i order
+	* @param iLevel the mipmap level
+	* @param pData the level data
+	* @param iSize the level data size in bytes
+	* @return false if the request has been cancelled
+	*/
+	bool TextureStreamer::stage( StreamRequest* pRequest, int iFace, int iLevel, const void* pData, unsigned int iSize )
+	{
+		unsigned int iAllocSize = alignStaging( iSize );
+
+		if( iAllocSize > m_iStagingSize )
+			throw Error( "TextureStreamer error: a mipmap level does not fit in the staging buffer", pRequest->sFilename );
+
+		StreamUpload* pUpload = new StreamUpload;
+		pUpload->pStreamer = this;
+		pUpload->pRequest = pRequest;
+		pUpload->iFace = iFace;
+		pUpload->iLevel = iLevel;
+		pUpload->iSize = iSize;
+		pUpload->bReady = false;
+		pUpload->bUploading = false;
+		pUpload->oFence = 0;
+
+		glfwLockMutex( m_oLock );
+		for( ;; )
+		{
+			if( pRequest->bCancelled )
+			{
+				glfwUnlockMutex( m_oLock );
+				delete pUpload;
+				return false;
+			}
+
+			if( allocateStaging( iAllocSize, pUpload->iOffset, pUpload->iPadding ) )
+				break;
+
+			glfwWaitCond( m_oStagingCond, m_oLock, GLFW_INFINITY );
+		}
+
+		// queued before the copy to keep the uploads in staging allocation order
+		m_vPendingUploads.push_back( pUpload );
+		++pRequest->iQueuedUploads;
+		glfwUnlockMutex( m_oLock );
+
+		memcpy( m_pStaging + pUpload->iOffset, pData, iSize );
+
+		glfwLockMutex( m_oLock );
+		pUpload->bReady = true;
+		glfwUnlockMutex( m_oLock );
+
+		return true;
+	}
+
+	/**
+	* @brief allocates contiguous memory in the staging ring buffer, must be called with m_oLock locked
+	* @param iSize the size in bytes
+	* @param iOffset the allocation offset in the staging buffer
+	* @param iPadding the bytes skipped at the end of the staging buffer when the allocation wraps around
+	* @return false if the staging buffer has not enough free memory
+	*/
+	bool TextureStreamer::allocateStaging( unsigned int iSize, unsigned int& iOffset, unsigned int& iPadding )
+	{
+		if( m_iStagingUsed == 0 )
+		{
+			m_iStagingHead = 0;
+			m_iStagingTail = 0;
+		}
+
+		if( m_iStagingUsed == 0 || m_iStagingHead > m_iStagingTail )
+		{
+			// free memory lies after the head and before the tail
+			if( m_iStagingSize - m_iStagingHead >= iSize )
+			{
+				iOffset = m_iStagingHead;
+				iPadding = 0;
+			}
+			else if( m_iStagingTail >= iSize )
+			{
+				iOffset = 0;
+				iPadding = m_iStagingSize - m_iStagingHead;
+			}
+			else
+			{
+				return false;
+			}
+		}
+		else if( m_iStagingTail - m_iStagingHead >= iSize )
+		{
+			// free memory lies between the head and the tail
+			iOffset = m_iStagingHead;
+			iPadding = 0;
+		}
+		else
+		{
+			return false;
+		}
+
+		m_iStagingHead = iOffset + iSize;
+		m_iStagingUsed += iSize + iPadding;
+
+		return true;
+	}
+
+	/**
+	* @brief releases the staging memory of the uploads the GL is done with, in allocation order
+	* @param bWait true: waits for every upload to complete
+	*/
+	void TextureStreamer::retireUploads( bool bWait )
+	{
+		bool bReleased = false;
+
+		while( !m_vInFlightUploads.empty() )
+		{
+			StreamUpload* pUpload = m_vInFlightUploads.front();
+
+			if( pUpload->bUploading )
+				break;
+
+			if( pUpload->oFence != 0 )
+			{
+				GLenum iStatus = glClientWaitSync( pUpload->oFence, 0, bWait ? GL_TIMEOUT_IGNORED : 0 );
+				if( iStatus != GL_ALREADY_SIGNALED && iStatus != GL_CONDITION_SATISFIED )
+					break;
+
+				glDeleteSync( pUpload->oFence );
+			}
+
+			glfwLockMutex( m_oLock );
+			m_iStagingUsed -= alignStaging( pUpload->iSize ) + pUpload->iPadding;
+			m_iStagingTail = pUpload->iOffset + alignStaging( pUpload->iSize );
+			glfwUnlockMutex( m_oLock );
+
+			m_vInFlightUploads.pop_front();
+			delete pUpload;
+			bReleased = true;
+		}
+
+		if( bReleased )
+		{
+			glfwLockMutex( m_oLock );
+			glfwBroadcastCond( m_oStagingCond );
+			glfwUnlockMutex( m_oLock );
+		}
+	}
+
+	/**
+	* @brief allocates the texture storage of a request before its first upload, on the main thread
+	* @param pRequest the request
+	*/
+	void TextureStreamer::allocate( StreamRequest* pRequest )
+	{
+		if( pRequest->bAllocated )
+			return;
+
+		if( pRequest->bCompressed )
+			pRequest->pCubeMap->allocateCompressedStorage( pRequest->iCompressedFormat, pRequest->iSize, pRequest->iMipCount, &pRequest->vLevelSizes[ 0 ] );
+		else
+			pRequest->pCubeMap->allocateStorage( EXR, pRequest->iSize, pRequest->iMipCount );
+
+		pRequest->bAllocated = true;
+	}
+
+	/**
+	* @brief copies a staged face mipmap level to its cube map, with the staging buffer bound when it is a PBO
+	* @param pUpload the upload
+	*/
+	void TextureStreamer::copyToTexture( StreamUpload* pUpload )
+	{
+		CubeMap* pCubeMap = pUpload->pRequest->pCubeMap;
+
+		if( m_iStagingPBO != 0 )
+			pCubeMap->setFaceSubData( pUpload->iFace, pUpload->iLevel, ( const GLvoid* )( size_t )pUpload->iOffset, pUpload->iSize );
+		else
+			pCubeMap->setFaceSubData( pUpload->iFace, pUpload->iLevel, m_pStaging + pUpload->iOffset, pUpload->iSize );
+	}
+
+	/**
+	* @brief makes a level sampled once all its faces are uploaded, on the main thread
+	* @param pUpload the upload
+	*/
+	void TextureStreamer::completeUpload( StreamUpload* pUpload )
+	{
+		StreamRequest* pRequest = pUpload->pRequest;
+
+		// levels are staged from the smallest one: once all the faces are uploaded the level can be sampled
+		if( --pRequest->vLevelFacesLeft[ pUpload->iLevel ] == 0 )
+			pRequest->pCubeMap->setResidentLevel( pUpload->iLevel );
+	}
+
+	/**
+	* @brief uploads a staged face mipmap level to its cube map on the main thread, with the staging buffer bound when it is a PBO
+	* @param pUpload the upload
+	*/
+	void TextureStreamer::processUpload( StreamUpload* pUpload )
+	{
+		allocate( pUpload->pRequest );
+		copyToTexture( pUpload );
+		completeUpload( pUpload );
+	}
+
+	/**
+	* @brief upload function run by the resource thread of the upload context, the storage is already allocated
+	* @param pData the upload
+	*/
+	void TextureStreamer::uploadLevel( void* pData )
+	{
+		StreamUpload* pUpload = ( StreamUpload* )pData;
+		TextureStreamer* pStreamer = pUpload->pStreamer;
+
+		// cancel() waits for the lock: the texture is not deleted while its level is uploaded
+		glfwLockMutex( pStreamer->m_oUploadLock );
+
+		glfwLockMutex( pStreamer->m_oLock );
+		bool bCancelled = pUpload->pRequest->bCancelled;
+		glfwUnlockMutex( pStreamer->m_oLock );
+
+		if( !bCancelled )
+		{
+			if( pStreamer->m_iStagingPBO != 0 )
+				glBindBufferARB( GL_PIXEL_UNPACK_BUFFER_ARB, pStreamer->m_iStagingPBO );
+
+			pStreamer->copyToTexture( pUpload );
+
+			if( pStreamer->m_iStagingPBO != 0 )
+				glBindBufferARB( GL_PIXEL_UNPACK_BUFFER_ARB, 0 );
+		}
+
+		glfwUnlockMutex( pStreamer->m_oUploadLock );
+	}
+
+	/**
+	* @brief completion function run by the main thread once the GL is done with a level uploaded by the resource thread
+	* @param pData the upload
+	*/
+	void TextureStreamer::levelUploaded( void* pData )
+	{
+		StreamUpload* pUpload = ( StreamUpload* )pData;
+		TextureStreamer* pStreamer = pUpload->pStreamer;
+
+		glfwLockMutex( pStreamer->m_oLock );
+		bool bCancelled = pUpload->pRequest->bCancelled;
+		--pUpload->pRequest->iQueuedUploads;
+		glfwUnlockMutex( pStreamer->m_oLock );
+
+		// the staging memory is released by the next retireUploads()
+		pUpload->bUploading = false;
+
+		if( !bCancelled )
+			pStreamer->completeUpload( pUpload );
+	}
+
+	/**
+	* @brief deletes the requests whose uploads are all done or which have been cancelled
+	*/
+	void TextureStreamer::deleteFinishedRequests()
+	{
+		glfwLockMutex( m_oLock );
+		for( size_t i = 0; i < m_vActiveRequests.size(); )
+		{
+			StreamRequest* pRequest = m_vActiveRequests[ i ];
+
+			if( pRequest->bStaged && pRequest->iQueuedUploads == 0 )
+			{
+				m_vActiveRequests[ i ] = m_vActiveRequests.back();
+				m_vActiveRequests.pop_back();
+				delete pRequest;
+			}
+			else
+			{
+				++i;
+			}
+		}
+		glfwUnlockMutex( m_oLock );
+	}
+
+	/**
+	* @brief uploads the staged levels to their textures within the per frame budget, to be called once per frame
+	*/
+	void TextureStreamer::update()
+	{
+		OGLF_PROFILE_GPU_SCOPE( "TextureStreamer::update" );
+
+		retireUploads( false );
+
+		m_iLastFrameBytes = 0;
+
+		bool bAsync = m_pUploadContext != NULL && m_pUploadContext->isShared();
+
+		if( m_iStagingPBO != 0 && !bAsync )
+			glBindBufferARB( GL_PIXEL_UNPACK_BUFFER_ARB, m_iStagingPBO );
+
+		for( ;; )
+		{
+			glfwLockMutex( m_oLock );
+			StreamUpload* pUpload = NULL;
+			bool bCancelled = false;
+
+			// at least one level is uploaded per frame, even when larger than the budget
+			if( !m_vPendingUploads.empty() && m_vPendingUploads.front()->bReady &&
+				( bAsync || m_iLastFrameBytes == 0 || m_iLastFrameBytes + m_vPendingUploads.front()->iSize <= m_iBytesPerFrame ) )
+			{
+				pUpload = m_vPendingUploads.front();
+				m_vPendingUploads.pop_front();
+				bCancelled = pUpload->pRequest->bCancelled;
+
+				// the request is kept until the resource thread is done with the upload
+				if( !bAsync || bCancelled )
+					--pUpload->pRequest->iQueuedUploads;
+			}
+			glfwUnlockMutex( m_oLock );
+
+			if( pUpload == NULL )
+				break;
+
+			if( !bCancelled && bAsync )
+			{
+				// the storage allocation is ordered before the upload by the upload context
+				allocate( pUpload->pRequest );
+				pUpload->bUploading = true;
+				m_pUploadContext->upload( uploadLevel, pUpload, levelUploaded );
+				m_iLastFrameBytes += pUpload->iSize;
+			}
+			else if( !bCancelled )
+			{
+				processUpload( pUpload );
+				m_iLastFrameBytes += pUpload->iSize;
+
+				if( m_iStagingPBO != 0 )
+					pUpload->oFence = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+			}
+
+			m_vInFlightUploads.push_back( pUpload );
+		}
+
+		if( m_iStagingPBO != 0 && !bAsync )
+			glBindBufferARB( GL_PIXEL_UNPACK_BUFFER_ARB, 0 );
+
+		Error::checkGLerror( "TextureStreamer::update" );
+
+		// uploads from client memory are already copied by the GL
+		if( m_iStagingPBO == 0 )
+			retireUploads( false );
+
+		deleteFinishedRequests();
+	}
+}
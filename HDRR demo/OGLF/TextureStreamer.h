@@ -0,0 +1,199 @@
+#ifndef TEXTURESTREAMER_H
+#define TEXTURESTREAMER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <GL/glew.h>
+
+#ifdef WIN32
+#include <Windows.h>
+#endif
+
+#include <GL/glfw.h>
+#include "CubeMap.h"
+#include "UploadContext.h"
+
+namespace Oglf
+{
+	/**
+	* class TextureStreamer loads cube maps in the background: worker threads decode the pictures and copy their
+	* mipmap levels in a staging ring buffer, persistently mapped when GL_ARB_buffer_storage is supported, and the
+	* main thread uploads them to the textures under a bytes per frame budget. Levels are uploaded from the smallest
+	* to the largest one, so that a streamed cube map shows a low resolution version of itself until it is complete.
+	* With a shared upload context, the main thread only allocates the textures storage and the levels are uploaded
+	* on the resource thread, without budget.
+	*/
+	class TextureStreamer
+	{
+		/**
+		* @brief a cube map being streamed
+		*/
+		struct StreamRequest
+		{
+			CubeMap*				pCubeMap;
+			std::string				sFilename;
+			bool					bCancelled;
+			bool					bStaged;			// the worker thread is done with the request
+			bool					bCompressed;
+			GLenum					iCompressedFormat;
+			GLuint					iSize;				// faces width and height
+			int						iMipCount;
+			std::vector< GLsizei >	vLevelSizes;		// size of a face of each level in bytes
+			std::vector< int >		vLevelFacesLeft;	// faces of each level still to upload
+			int						iQueuedUploads;		// staged uploads not processed yet by the main thread
+			bool					bAllocated;			// the texture storage is allocated
+
+			StreamRequest( CubeMap* pCubeMap, const std::string& sFilename )
+				: pCubeMap( pCubeMap )
+				, sFilename( sFilename )
+				, bCancelled( false )
+				, bStaged( false )
+				, bCompressed( false )
+				, iCompressedFormat( 0 )
+				, iSize( 0 )
+				, iMipCount( 0 )
+				, iQueuedUploads( 0 )
+				, bAllocated( false )
+			{
+			}
+		};
+
+		/**
+		* @brief a face mipmap level copied in the staging buffer
+		*/
+		struct StreamUpload
+		{
+			TextureStreamer*	pStreamer;
+			StreamRequest*		pRequest;
+			int					iFace;
+			int					iLevel;
+			unsigned int		iOffset;	// offset in the staging buffer
+			unsigned int		iSize;		// data size in bytes
+			unsigned int		iPadding;	// bytes skipped at the end of the staging buffer before this upload
+			bool				bReady;		// the data has been copied in the staging buffer
+			bool				bUploading;	// queued on the upload context and not done yet
+			GLsync				oFence;		// signaled when the GL is done reading the staging buffer
+		};
+
+		unsigned int					m_iStagingSize;
+		unsigned int					m_iStagingHead;		// where the next staging allocation starts
+		unsigned int					m_iStagingTail;		// where the oldest staging allocation starts
+		unsigned int					m_iStagingUsed;
+		unsigned char*					m_pStaging;			// mapped pixel buffer or client memory
+		GLuint							m_iStagingPBO;		// 0 when uploading from client memory
+
+		UploadContext*					m_pUploadContext;	// uploads the levels on its resource thread when it is shared, may be NULL
+
+		unsigned int					m_iBytesPerFrame;
+		unsigned int					m_iLastFrameBytes;
+
+		std::deque< StreamRequest* >	m_vRequests;		// requests waiting for a worker thread
+		std::vector< StreamRequest* >	m_vActiveRequests;	// every request not completed or cancelled yet
+		std::deque< StreamUpload* >		m_vPendingUploads;	// staged uploads, in staging allocation order
+		std::deque< StreamUpload* >		m_vInFlightUploads;	// uploads the GL may still be reading
+
+		std::vector< GLFWthread >		m_vThreads;
+		GLFWmutex						m_oLock;
+		GLFWcond						m_oRequestCond;		// signaled when a request is queued
+		GLFWcond						m_oStagingCond;		// signaled when staging memory is released
+		GLFWmutex						m_oUploadLock;		// held by the resource thread while it uploads a level
+		bool							m_bShutdown;
+
+		static void GLFWCALL workerThread( void* pData );
+		void decode( StreamRequest* pRequest );
+		void decodeCompressed( StreamRequest* pRequest );
+		void decodeEXR( StreamRequest* pRequest );
+		bool stage( StreamRequest* pRequest, int iFace, int iLevel, const void* pData, unsigned int iSize );
+		bool allocateStaging( unsigned int iSize, unsigned int& iOffset, unsigned int& iPadding );
+		void retireUploads( bool bWait );
+		void allocate( StreamRequest* pRequest );
+		void copyToTexture( StreamUpload* pUpload );
+		void completeUpload( StreamUpload* pUpload );
+		void processUpload( StreamUpload* pUpload );
+		static void uploadLevel( void* pData );
+		static void levelUploaded( void* pData );
+		void deleteFinishedRequests();
+
+	public:
+
+		/**
+		* @brief constructor: creates the staging buffer and starts the worker threads, must be called with a current GL context
+		* @param iStagingSize the staging buffer size in bytes, it must hold the largest face mipmap level
+		* @param iBytesPerFrame the number of bytes uploaded at most by update()
+		* @param iThreadNb the number of worker threads
+		* @param pUploadContext uploads the levels on its resource thread when it is shared, may be NULL. It must outlive the streamer.
+		*/
+		TextureStreamer( unsigned int iStagingSize = 32 << 20, unsigned int iBytesPerFrame = 4 << 20, int iThreadNb = 2, UploadContext* pUploadContext = NULL );
+
+		~TextureStreamer();
+
+		/**
+		* @brief queues a cube map to stream: a BC6H cache file written by the CubeMapCompressor tool or a vertical cross EXR picture
+		* @param pCubeMap the cube map, it must not be deleted before the streaming is completed or cancelled
+		* @param sFilename the picture file name
+		*/
+		void streamCubeMap( CubeMap* pCubeMap, const std::string& sFilename );
+
+		/**
+		* @brief cancels the streaming of a texture, it can be deleted once this returns
+		* @param pTexture the texture
+		*/
+		void cancel( const Texture* pTexture );
+
+		/**
+		* @brief uploads the staged levels to their textures within the per frame budget, to be called once per frame
+		*/
+		void update();
+
+		/**
+		* @brief returns whether a texture is still being streamed
+		* @param pTexture the texture
+		* @return true if the texture is not complete yet
+		*/
+		bool isStreaming( const Texture* pTexture );
+
+		/**
+		* @brief returns whether every requested texture has been streamed
+		* @return true if there is nothing left to stream
+		*/
+		bool isIdle();
+
+		/**
+		* @brief returns the depth of the streaming queues
+		* @param iRequestNb the number of textures not completely streamed yet
+		* @param iUploadNb the number of decoded levels waiting in the staging buffer for their upload
+		*/
+		void getQueueDepth( int& iRequestNb, int& iUploadNb );
+
+		/**
+		* @brief sets the upload budget
+		* @param iBytesPerFrame the number of bytes uploaded at most by update(), at least one level is uploaded per frame.
+		* The budget does not apply to the levels uploaded by a shared upload context.
+		*/
+		void setBytesPerFrame( unsigned int iBytesPerFrame )
+		{
+			m_iBytesPerFrame = iBytesPerFrame;
+		}
+
+		/**
+		* @brief returns the upload budget
+		* @return the number of bytes uploaded at most by update()
+		*/
+		unsigned int getBytesPerFrame() const
+		{
+			return m_iBytesPerFrame;
+		}
+
+		/**
+		* @brief returns the number of bytes uploaded by the last update()
+		* @return the number of bytes
+		*/
+		unsigned int getLastFrameBytes() const
+		{
+			return m_iLastFrameBytes;
+		}
+	};
+}
+
+#endif /* TEXTURESTREAMER_H */
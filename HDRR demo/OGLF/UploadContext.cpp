@@ -0,0 +1,398 @@
+#include <cstring>
+#include "UploadContext.h"
+#include "Error.h"
+
+#if !defined( WIN32 ) && !defined( OGLF_OSMESA )
+#include <EGL/egl.h>
+#endif
+
+using namespace std;
+
+namespace Oglf
+{
+	/**
+	* @brief constructor: creates the shared context and starts the resource thread, must be called by the main
+	* thread with the main GL context current
+	*/
+	UploadContext::UploadContext()
+		: m_pDisplay( NULL )
+		, m_pSurface( NULL )
+		, m_pContext( NULL )
+		, m_iMainThreadID( glfwGetThreadID() )
+		, m_iRunningNb( 0 )
+		, m_iThread( -1 )
+		, m_bStarted( false )
+		, m_bShutdown( false )
+	{
+		m_oLock = glfwCreateMutex();
+		m_oUploadCond = glfwCreateCond();
+		m_oDoneCond = glfwCreateCond();
+
+		// the fences order the uploads with the main context commands
+		if( !GLEW_ARB_sync || !createSharedContext() )
+			return;
+
+		m_iThread = glfwCreateThread( resourceThread, this );
+
+		bool bFailed = m_iThread < 0;
+		if( !bFailed )
+		{
+			glfwLockMutex( m_oLock );
+			while( !m_bStarted )
+				glfwWaitCond( m_oDoneCond, m_oLock, GLFW_INFINITY );
+			bFailed = m_bShutdown;
+			glfwUnlockMutex( m_oLock );
+
+			if( bFailed )
+				glfwWaitThread( m_iThread, GLFW_WAIT );
+		}
+
+		// the uploads are run by the main thread
+		if( bFailed )
+		{
+			destroySharedContext();
+			m_iThread = -1;
+			m_bShutdown = false;
+		}
+	}
+
+	/**
+	* @brief destructor: runs the queued uploads and their completion functions, stops the resource thread and
+	* deletes the shared context, must be called by the main thread
+	*/
+	UploadContext::~UploadContext()
+	{
+		flush();
+
+		if( isShared() )
+		{
+			glfwLockMutex( m_oLock );
+			m_bShutdown = true;
+			glfwBroadcastCond( m_oUploadCond );
+			glfwUnlockMutex( m_oLock );
+
+			glfwWaitThread( m_iThread, GLFW_WAIT );
+			destroySharedContext();
+		}
+
+		glfwDestroyCond( m_oDoneCond );
+		glfwDestroyCond( m_oUploadCond );
+		glfwDestroyMutex( m_oLock );
+	}
+
+	/**
+	* @brief creates a context sharing its objects with the current one
+	* @return false if shared contexts are not supported
+	*/
+	bool UploadContext::createSharedContext()
+	{
+#if defined( OGLF_OSMESA )
+		return false;
+
+#elif defined( WIN32 )
+		HDC hDC = wglGetCurrentDC();
+		HGLRC hMainContext = wglGetCurrentContext();
+		if( hDC == NULL || hMainContext == NULL )
+			return false;
+
+		// the lists must be shared before the context holds any object
+		HGLRC hContext = wglCreateContext( hDC );
+		if( hContext == NULL )
+			return false;
+		if( !wglShareLists( hMainContext, hContext ) )
+		{
+			wglDeleteContext( hContext );
+			return false;
+		}
+
+		m_pDisplay = hDC;
+		m_pContext = hContext;
+		return true;
+
+#else
+		// only EGL contexts are shared, GLX ones such as the GLFW window one are not
+		EGLDisplay pDisplay = eglGetCurrentDisplay();
+		EGLContext pMainContext = eglGetCurrentContext();
+		if( pDisplay == EGL_NO_DISPLAY || pMainContext == EGL_NO_CONTEXT )
+			return false;
+
+		EGLint iConfigID = 0;
+		if( !eglQueryContext( pDisplay, pMainContext, EGL_CONFIG_ID, &iConfigID ) )
+			return false;
+
+		EGLint pConfigAttributes[] = { EGL_CONFIG_ID, iConfigID, EGL_NONE };
+		EGLConfig pConfig;
+		EGLint iConfigNb = 0;
+		if( !eglChooseConfig( pDisplay, pConfigAttributes, &pConfig, 1, &iConfigNb ) || iConfigNb == 0 )
+			return false;
+
+		// a pbuffer is only created when the display does not support contexts without surface
+		const char* sExtensions = eglQueryString( pDisplay, EGL_EXTENSIONS );
+		EGLSurface pSurface = EGL_NO_SURFACE;
+		if( sExtensions == NULL || strstr( sExtensions, "EGL_KHR_surfaceless_context" ) == NULL )
+		{
+			EGLint pSurfaceAttributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+			pSurface = eglCreatePbufferSurface( pDisplay, pConfig, pSurfaceAttributes );
+			if( pSurface == EGL_NO_SURFACE )
+				return false;
+		}
+
+		EGLContext pContext = eglCreateContext( pDisplay, pConfig, pMainContext, NULL );
+		if( pContext == EGL_NO_CONTEXT )
+		{
+			if( pSurface != EGL_NO_SURFACE )
+				eglDestroySurface( pDisplay, pSurface );
+			return false;
+		}
+
+		m_pDisplay = pDisplay;
+		m_pSurface = pSurface;
+		m_pContext = pContext;
+		return true;
+#endif
+	}
+
+	/**
+	* @brief deletes the shared context, once the resource thread is stopped
+	*/
+	void UploadContext::destroySharedContext()
+	{
+#if defined( WIN32 ) && !defined( OGLF_OSMESA )
+		wglDeleteContext( ( HGLRC )m_pContext );
+
+#elif !defined( OGLF_OSMESA )
+		eglDestroyContext( m_pDisplay, m_pContext );
+		if( m_pSurface != EGL_NO_SURFACE )
+			eglDestroySurface( m_pDisplay, m_pSurface );
+#endif
+
+		m_pContext = NULL;
+	}
+
+	/**
+	* @brief makes the shared context current on the calling thread, or releases it
+	* @param bCurrent true: makes the context current, false: releases it
+	* @return false if the context could not be made current
+	*/
+	bool UploadContext::makeCurrent( bool bCurrent )
+	{
+#if defined( OGLF_OSMESA )
+		return false;
+
+#elif defined( WIN32 )
+		if( bCurrent )
+			return wglMakeCurrent( ( HDC )m_pDisplay, ( HGLRC )m_pContext ) != FALSE;
+
+		return wglMakeCurrent( NULL, NULL ) != FALSE;
+
+#else
+		if( bCurrent )
+		{
+			// the bound API is a per thread state
+			return eglBindAPI( EGL_OPENGL_API ) && eglMakeCurrent( m_pDisplay, m_pSurface, m_pSurface, m_pContext );
+		}
+
+		bool bReleased = eglMakeCurrent( m_pDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT ) != EGL_FALSE;
+		eglReleaseThread();
+		return bReleased;
+#endif
+	}
+
+	/**
+	* @brief resource thread: runs the queued uploads with the shared context current until the upload context is destroyed
+	* @param pData the upload context
+	*/
+	void GLFWCALL UploadContext::resourceThread( void* pData )
+	{
+		UploadContext* pContext = ( UploadContext* )pData;
+
+		bool bCurrent = pContext->makeCurrent( true );
+
+		glfwLockMutex( pContext->m_oLock );
+		pContext->m_bStarted = true;
+		pContext->m_bShutdown = !bCurrent;
+		glfwBroadcastCond( pContext->m_oDoneCond );
+		glfwUnlockMutex( pContext->m_oLock );
+
+		if( !bCurrent )
+			return;
+
+		for( ;; )
+		{
+			glfwLockMutex( pContext->m_oLock );
+			while( pContext->m_dUploads.empty() && !pContext->m_bShutdown )
+				glfwWaitCond( pContext->m_oUploadCond, pContext->m_oLock, GLFW_INFINITY );
+
+			if( pContext->m_dUploads.empty() )
+			{
+				glfwUnlockMutex( pContext->m_oLock );
+				break;
+			}
+
+			Upload oUpload = pContext->m_dUploads.front();
+			pContext->m_dUploads.pop_front();
+			++pContext->m_iRunningNb;
+			glfwUnlockMutex( pContext->m_oLock );
+
+			// the GL waits for the main context commands, the thread does not
+			if( oUpload.oReadyFence != 0 )
+			{
+				glWaitSync( oUpload.oReadyFence, 0, GL_TIMEOUT_IGNORED );
+				glDeleteSync( oUpload.oReadyFence );
+			}
+
+			runUpload( oUpload );
+
+			oUpload.oDoneFence = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+			glFlush();
+
+			glfwLockMutex( pContext->m_oLock );
+			--pContext->m_iRunningNb;
+			pContext->m_dDoneUploads.push_back( oUpload );
+			glfwBroadcastCond( pContext->m_oDoneCond );
+			glfwUnlockMutex( pContext->m_oLock );
+		}
+
+		pContext->makeCurrent( false );
+	}
+
+	/**
+	* @brief runs an upload function
+	* @param oUpload the upload
+	*/
+	void UploadContext::runUpload( const Upload& oUpload )
+	{
+		try
+		{
+			oUpload.pUpload( oUpload.pData );
+		}
+		catch( Error e )
+		{
+			e.showError();
+		}
+	}
+
+	/**
+	* @brief runs the completion functions of the uploads the GL is done with, in their queue order
+	* @param bWait true: waits for every upload run by the resource thread
+	*/
+	void UploadContext::retireUploads( bool bWait )
+	{
+		for( ;; )
+		{
+			glfwLockMutex( m_oLock );
+			if( m_dDoneUploads.empty() )
+			{
+				glfwUnlockMutex( m_oLock );
+				return;
+			}
+			Upload oUpload = m_dDoneUploads.front();
+			glfwUnlockMutex( m_oLock );
+
+			GLenum iStatus = glClientWaitSync( oUpload.oDoneFence, 0, bWait ? GL_TIMEOUT_IGNORED : 0 );
+			if( iStatus == GL_TIMEOUT_EXPIRED )
+				return;
+
+			glDeleteSync( oUpload.oDoneFence );
+
+			glfwLockMutex( m_oLock );
+			m_dDoneUploads.pop_front();
+			glfwUnlockMutex( m_oLock );
+
+			if( oUpload.pDone != NULL )
+				oUpload.pDone( oUpload.pData );
+		}
+	}
+
+	/**
+	* @brief queues an upload, may be called by any thread
+	* @param pUpload the upload function, run with the shared context current, or the main one without shared context
+	* @param pData the upload data
+	* @param pDone the completion function, run by the main thread once the GL is done with the upload, may be NULL
+	*/
+	void UploadContext::upload( UploadFunction pUpload, void* pData, UploadFunction pDone )
+	{
+		Upload oUpload;
+		oUpload.pUpload = pUpload;
+		oUpload.pDone = pDone;
+		oUpload.pData = pData;
+		oUpload.oReadyFence = 0;
+		oUpload.oDoneFence = 0;
+
+		// flushed for the resource thread to wait for it
+		if( isShared() && glfwGetThreadID() == m_iMainThreadID )
+		{
+			oUpload.oReadyFence = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+			glFlush();
+		}
+
+		glfwLockMutex( m_oLock );
+		m_dUploads.push_back( oUpload );
+		glfwSignalCond( m_oUploadCond );
+		glfwUnlockMutex( m_oLock );
+	}
+
+	/**
+	* @brief runs the completion functions of the uploads the GL is done with, to be called once per frame by the
+	* main thread. Without shared context, it also runs the oldest queued upload.
+	*/
+	void UploadContext::update()
+	{
+		if( isShared() )
+		{
+			retireUploads( false );
+			return;
+		}
+
+		glfwLockMutex( m_oLock );
+		if( m_dUploads.empty() )
+		{
+			glfwUnlockMutex( m_oLock );
+			return;
+		}
+		Upload oUpload = m_dUploads.front();
+		m_dUploads.pop_front();
+		glfwUnlockMutex( m_oLock );
+
+		runUpload( oUpload );
+		if( oUpload.pDone != NULL )
+			oUpload.pDone( oUpload.pData );
+	}
+
+	/**
+	* @brief runs every queued upload and their completion functions, must be called by the main thread
+	*/
+	void UploadContext::flush()
+	{
+		// the completion functions may queue other uploads
+		while( getPendingNb() > 0 )
+		{
+			if( isShared() )
+			{
+				glfwLockMutex( m_oLock );
+				while( !m_dUploads.empty() || m_iRunningNb > 0 )
+					glfwWaitCond( m_oDoneCond, m_oLock, GLFW_INFINITY );
+				glfwUnlockMutex( m_oLock );
+
+				retireUploads( true );
+			}
+			else
+			{
+				update();
+			}
+		}
+	}
+
+	/**
+	* @brief returns the number of uploads whose completion functions have not been run yet
+	* @return the number of uploads
+	*/
+	int UploadContext::getPendingNb()
+	{
+		glfwLockMutex( m_oLock );
+		int iPendingNb = ( int )( m_dUploads.size() + m_dDoneUploads.size() ) + m_iRunningNb;
+		glfwUnlockMutex( m_oLock );
+
+		return iPendingNb;
+	}
+}
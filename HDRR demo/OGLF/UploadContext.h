@@ -0,0 +1,112 @@
+#ifndef UPLOADCONTEXT_H
+#define UPLOADCONTEXT_H
+
+#include <deque>
+#include <GL/glew.h>
+
+#ifdef WIN32
+#include <Windows.h>
+#endif
+
+#include <GL/glfw.h>
+
+namespace Oglf
+{
+	typedef void ( *UploadFunction )( void* pData );
+
+	/**
+	* class UploadContext runs the GL uploads on a resource thread, with a second GL context sharing its objects
+	* with the main one, so that large uploads never stall the frame. An upload queued by the main thread waits for
+	* the GL commands it issued before, such as the storage allocation of the uploaded texture. Once the GL is done
+	* with an upload, its completion function is run by the main thread in update(), the uploaded object can then be
+	* used by the main context. The shared context is created through WGL on Windows and through EGL when the main
+	* context is an EGL one; otherwise the uploads are run by the main thread in update(), one per call.
+	*/
+	class UploadContext
+	{
+		/**
+		* @brief an upload and its completion function
+		*/
+		struct Upload
+		{
+			UploadFunction	pUpload;
+			UploadFunction	pDone;			// run by the main thread once the GL is done with the upload, may be NULL
+			void*			pData;
+			GLsync			oReadyFence;	// signaled when the main context is done with the commands issued before the upload
+			GLsync			oDoneFence;		// signaled when the GL is done with the upload
+		};
+
+		void*				m_pDisplay;			// EGLDisplay or HDC
+		void*				m_pSurface;			// EGLSurface, a pbuffer when the display does not support contexts without surface
+		void*				m_pContext;			// EGLContext or HGLRC, NULL when shared contexts are not supported
+		GLFWthread			m_iMainThreadID;
+
+		std::deque< Upload >	m_dUploads;			// uploads waiting for the resource thread
+		std::deque< Upload >	m_dDoneUploads;		// uploads run by the resource thread, in their queue order
+		int					m_iRunningNb;		// uploads being run by the resource thread
+
+		GLFWthread			m_iThread;
+		GLFWmutex			m_oLock;
+		GLFWcond			m_oUploadCond;		// signaled when an upload is queued
+		GLFWcond			m_oDoneCond;		// signaled when an upload is run or the resource thread is started
+		bool				m_bStarted;			// the resource thread made the shared context current or failed to
+		bool				m_bShutdown;
+
+		static void GLFWCALL resourceThread( void* pData );
+		bool createSharedContext();
+		void destroySharedContext();
+		bool makeCurrent( bool bCurrent );
+		static void runUpload( const Upload& oUpload );
+		void retireUploads( bool bWait );
+
+	public:
+
+		/**
+		* @brief constructor: creates the shared context and starts the resource thread, must be called by the main
+		* thread with the main GL context current
+		*/
+		UploadContext();
+
+		/**
+		* @brief destructor: runs the queued uploads and their completion functions, stops the resource thread and
+		* deletes the shared context, must be called by the main thread
+		*/
+		~UploadContext();
+
+		/**
+		* @brief queues an upload, may be called by any thread
+		* @param pUpload the upload function, run with the shared context current, or the main one without shared context
+		* @param pData the upload data
+		* @param pDone the completion function, run by the main thread once the GL is done with the upload, may be NULL
+		*/
+		void upload( UploadFunction pUpload, void* pData, UploadFunction pDone = NULL );
+
+		/**
+		* @brief runs the completion functions of the uploads the GL is done with, to be called once per frame by the
+		* main thread. Without shared context, it also runs the oldest queued upload.
+		*/
+		void update();
+
+		/**
+		* @brief runs every queued upload and their completion functions, must be called by the main thread
+		*/
+		void flush();
+
+		/**
+		* @brief returns the number of uploads whose completion functions have not been run yet
+		* @return the number of uploads
+		*/
+		int getPendingNb();
+
+		/**
+		* @brief returns whether the uploads are run on the resource thread
+		* @return false if the uploads are run by the main thread
+		*/
+		bool isShared() const
+		{
+			return m_pContext != NULL;
+		}
+	};
+}
+
+#endif /* UPLOADCONTEXT_H */
@@ -4,6 +4,9 @@
 #include <iostream>
 #include <stdio.h>
 #include <math.h>
+#include <vector>
+#include <algorithm>
+#include "Simd.h"
 
 namespace Oglf
 {
@@ -169,7 +172,7 @@ namespace Oglf
 
 	inline void Vec3::flipX()
 	{
-		static float t;
+		float t;
 
 		t    = v[2]; // t = dz;
 		v[2] = v[1]; // dz = dy;
@@ -178,7 +181,7 @@ namespace Oglf
 
 	inline void Vec3::flipY()
 	{
-		static float t;
+		float t;
 
 		t    = v[2];
 		v[2] = v[0];
@@ -187,7 +190,7 @@ namespace Oglf
 
 	inline void Vec3::flipZ()
 	{
-		static float t;
+		float t;
 
 		t    = v[0];
 		v[0] = v[1];
@@ -198,6 +201,204 @@ namespace Oglf
 	{
 		return out<<"("<<v.v[0]<<", "<<v.v[1]<<", "<<v.v[2]<<")";
 	}
+
+	/**
+	* struct Vec4 is a 4 floats vector, 16 bytes aligned so that SIMD code may load it in one instruction.
+	* Vectors allocated on the heap may only be 8 bytes aligned on 32 bits targets, SIMD code must use unaligned
+	* loads, as fast when aligned.
+	*/
+	struct Vec4
+	{
+		OGLF_ALIGN( 16 ) float v[4]; // x, y, z, w
+
+		Vec4()                                       { v[0] = v[1] = v[2] = v[3] = 0.f; }
+		Vec4( float x, float y, float z, float w )   { v[0] = x; v[1] = y; v[2] = z; v[3] = w; }
+		Vec4( const Vec3& u, float w )               { v[0] = u.v[0]; v[1] = u.v[1]; v[2] = u.v[2]; v[3] = w; }
+
+		float length() const                         { return sqrt( length2() ); }
+		float length2() const                        { return v[0]*v[0] + v[1]*v[1] + v[2]*v[2] + v[3]*v[3]; }
+		void  normalize()                            { *this /= length(); }
+
+		/**
+		* @brief returns the x, y and z components
+		* @return the vector x, y and z components
+		*/
+		Vec3  xyz() const                            { return Vec3( v[0], v[1], v[2] ); }
+
+		Vec4& operator += ( const Vec4& u )          { v[0] += u.v[0]; v[1] += u.v[1]; v[2] += u.v[2]; v[3] += u.v[3]; return *this; }
+		Vec4& operator -= ( const Vec4& u )          { v[0] -= u.v[0]; v[1] -= u.v[1]; v[2] -= u.v[2]; v[3] -= u.v[3]; return *this; }
+		Vec4& operator *= ( const float d )          { v[0] *= d; v[1] *= d; v[2] *= d; v[3] *= d; return *this; }
+		Vec4& operator /= ( const float d )          { return *this *= 1.f / d; }
+
+		float  operator[]( int i ) const             { return v[i]; }
+		float& operator[]( int i )                   { return v[i]; }
+	};
+
+	inline Vec4 operator - ( const Vec4& a )                  { return Vec4( -a.v[0], -a.v[1], -a.v[2], -a.v[3] ); }
+	inline Vec4 operator + ( const Vec4& a, const Vec4& b )   { Vec4 r( a ); return r += b; }
+	inline Vec4 operator - ( const Vec4& a, const Vec4& b )   { Vec4 r( a ); return r -= b; }
+	inline Vec4 operator * ( const Vec4& a, const float d )   { Vec4 r( a ); return r *= d; }
+	inline Vec4 operator * ( const float d, const Vec4& a )   { return a * d; }
+	inline Vec4 operator / ( const Vec4& a, const float d )   { Vec4 r( a ); return r /= d; }
+	inline float operator | ( const Vec4& a, const Vec4& b )  { return a.v[0]*b.v[0] + a.v[1]*b.v[1] + a.v[2]*b.v[2] + a.v[3]*b.v[3]; }
+	inline bool operator == ( const Vec4& a, const Vec4& b )  { return a.v[0] == b.v[0] && a.v[1] == b.v[1] && a.v[2] == b.v[2] && a.v[3] == b.v[3]; }
+	inline bool operator != ( const Vec4& a, const Vec4& b )  { return !( a == b ); }
+
+	/**
+	* struct Vec3Packet holds Vec3 in structure of arrays layout: the x, y and z components of F::SIZE vectors are
+	* each held in a SIMD register, so that each operation runs on all the vectors at once. The operators are those
+	* of Vec3: | is the dot product and ^ the cross product, both computed per lane. Packets are meant to be locals:
+	* vectors are loaded from Vec3 arrays or from x, y and z streams and stored back, see Float4 about the alignment.
+	*/
+	template< typename F >
+	struct Vec3Packet
+	{
+		static const int SIZE = F::SIZE;
+
+		F x, y, z;
+
+		Vec3Packet() {}
+		Vec3Packet( const F& oX, const F& oY, const F& oZ ) : x( oX ), y( oY ), z( oZ ) {}
+		explicit Vec3Packet( const Vec3& u ) : x( u.v[0] ), y( u.v[1] ), z( u.v[2] ) {}
+
+		/**
+		* @brief loads vectors from x, y and z streams
+		* @param pX, pY, pZ the SIZE first components of the vectors
+		* @return the packet
+		*/
+		static Vec3Packet loadStreams( const float* pX, const float* pY, const float* pZ )
+		{
+			return Vec3Packet( F::load( pX ), F::load( pY ), F::load( pZ ) );
+		}
+
+		/**
+		* @brief stores the vectors to x, y and z streams
+		* @param pX, pY, pZ the SIZE first components of the vectors
+		*/
+		void storeStreams( float* pX, float* pY, float* pZ ) const
+		{
+			x.store( pX );
+			y.store( pY );
+			z.store( pZ );
+		}
+
+		/**
+		* @brief loads vectors from an array of Vec3
+		* @param pVectors the vectors
+		* @param iNb the number of vectors, at most SIZE, the remaining lanes are zeros
+		* @return the packet
+		*/
+		static Vec3Packet load( const Vec3* pVectors, int iNb = SIZE )
+		{
+			OGLF_ALIGN( 32 ) float pComponents[ 3 ][ SIZE ];
+
+			for( int i = 0; i < SIZE; ++i )
+				for( int j = 0; j < 3; ++j )
+					pComponents[ j ][ i ] = i < iNb ? pVectors[ i ].v[ j ] : 0.f;
+
+			return loadStreams( pComponents[ 0 ], pComponents[ 1 ], pComponents[ 2 ] );
+		}
+
+		/**
+		* @brief stores the vectors to an array of Vec3
+		* @param pVectors the vectors
+		* @param iNb the number of vectors stored, at most SIZE
+		*/
+		void store( Vec3* pVectors, int iNb = SIZE ) const
+		{
+			OGLF_ALIGN( 32 ) float pComponents[ 3 ][ SIZE ];
+			storeStreams( pComponents[ 0 ], pComponents[ 1 ], pComponents[ 2 ] );
+
+			for( int i = 0; i < iNb; ++i )
+				for( int j = 0; j < 3; ++j )
+					pVectors[ i ].v[ j ] = pComponents[ j ][ i ];
+		}
+
+		/**
+		* @brief loads vectors from a vector of Vec3, past its end the lanes are zeros
+		* @param vVectors the vectors
+		* @param iFirst the first vector loaded
+		* @return the packet
+		*/
+		template< typename A >
+		static Vec3Packet load( const std::vector< Vec3, A >& vVectors, size_t iFirst )
+		{
+			if( iFirst >= vVectors.size() )
+				return Vec3Packet();
+
+			return load( &vVectors[ iFirst ], ( int )std::min< size_t >( SIZE, vVectors.size() - iFirst ) );
+		}
+
+		/**
+		* @brief stores the vectors to a vector of Vec3, the lanes past its end are dropped
+		* @param vVectors the vectors
+		* @param iFirst the first vector stored
+		*/
+		template< typename A >
+		void store( std::vector< Vec3, A >& vVectors, size_t iFirst ) const
+		{
+			if( iFirst < vVectors.size() )
+				store( &vVectors[ iFirst ], ( int )std::min< size_t >( SIZE, vVectors.size() - iFirst ) );
+		}
+
+		/**
+		* @brief returns a vector of the packet
+		* @param i the lane
+		* @return the vector
+		*/
+		Vec3 get( int i ) const
+		{
+			return Vec3( x[ i ], y[ i ], z[ i ] );
+		}
+
+		F length() const	{ return length2().sqrt(); }
+		F length2() const	{ return x * x + y * y + z * z; }
+
+		/**
+		* @brief normalizes the vectors, dividing them by their length as Vec3::normalize() does
+		*/
+		void normalize()
+		{
+			F oLength = length();
+			x = x / oLength;
+			y = y / oLength;
+			z = z / oLength;
+		}
+
+		/**
+		* @brief normalizes the vectors with the approximate reciprocal square root, about 22 bits accurate
+		*/
+		void normalizeFast()
+		{
+			F oInvLength = length2().rsqrt();
+			x = x * oInvLength;
+			y = y * oInvLength;
+			z = z * oInvLength;
+		}
+
+		Vec3Packet& operator += ( const Vec3Packet& u )	{ x = x + u.x; y = y + u.y; z = z + u.z; return *this; }
+		Vec3Packet& operator -= ( const Vec3Packet& u )	{ x = x - u.x; y = y - u.y; z = z - u.z; return *this; }
+		Vec3Packet& operator *= ( const F& d )			{ x = x * d; y = y * d; z = z * d; return *this; }
+		Vec3Packet& operator /= ( const F& d )			{ x = x / d; y = y / d; z = z / d; return *this; }
+	};
+
+	template< typename F > inline Vec3Packet< F > operator - ( const Vec3Packet< F >& a )								{ return Vec3Packet< F >( -a.x, -a.y, -a.z ); }
+	template< typename F > inline Vec3Packet< F > operator + ( const Vec3Packet< F >& a, const Vec3Packet< F >& b )	{ return Vec3Packet< F >( a.x + b.x, a.y + b.y, a.z + b.z ); }
+	template< typename F > inline Vec3Packet< F > operator - ( const Vec3Packet< F >& a, const Vec3Packet< F >& b )	{ return Vec3Packet< F >( a.x - b.x, a.y - b.y, a.z - b.z ); }
+	template< typename F > inline Vec3Packet< F > operator * ( const Vec3Packet< F >& a, const F& d )					{ return Vec3Packet< F >( d * a.x, d * a.y, d * a.z ); }
+	template< typename F > inline Vec3Packet< F > operator * ( const F& d, const Vec3Packet< F >& a )					{ return a * d; }
+	template< typename F > inline Vec3Packet< F > operator / ( const Vec3Packet< F >& a, const F& d )					{ return Vec3Packet< F >( a.x / d, a.y / d, a.z / d ); }
+	template< typename F > inline F operator | ( const Vec3Packet< F >& a, const Vec3Packet< F >& b )				{ return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+	template< typename F > inline Vec3Packet< F > operator ^ ( const Vec3Packet< F >& a, const Vec3Packet< F >& b )
+	{
+		return Vec3Packet< F >( a.y * b.z - a.z * b.y,
+			a.z * b.x - a.x * b.z,
+			a.x * b.y - a.y * b.x );
+	}
+
+	typedef Vec3Packet< Float4 > Vec3x4;
+	typedef Vec3Packet< Float8 > Vec3x8;
 }
 
 #endif
@@ -1,5 +1,12 @@
+#include <cstring>
 #include "utils.h"
 
+#ifdef WIN32
+	#include <Windows.h>
+#else
+	#include <time.h>
+#endif
+
 namespace Oglf
 {
 	/**
@@ -15,6 +22,123 @@ namespace Oglf
 			
 		return i >> 1;
 	}
+
+	/**
+	* @brief  extract a piece of data from from a picture data
+	* @param  i the vertical coordinate of the copy beginning in the picture data (pixels)
+	* @param  j the horizontal coordinate of the copy beginning in the picture data (pixels)
+	* @param  sizei the piece height (pixels)
+	* @param  sizej the piece width (pixels)
+	* @param  w the picture data area width (pixels)
+	* @param  h the picture data area height (pixels)
+	* @param  bulkSize the size of each copied elements (bytes)
+	* @param  data the picture data address
+	* @param  rowMajOrder true: the data is read in row major order, false: the data is read in column major order
+	* @param  iPositive true: data is read from top to bottom, false: data is read from bottom to top
+	* @param  jPositive true: data is read from left to right, false: data is read from right to left
+	* @return  bulk the extracted piece of data, to be deleted with delete[]
+	*/
+	unsigned char* extract(int i, int j, int sizei, int sizej, int w, int h, int bulkSize, const unsigned char* data, bool rowMajorOrder, bool iPositive, bool jPositive)
+	{	
+		if(i+sizei>h || j+sizej>w)
+		{
+			//throw Error("extract() Error: bad size", NULL, true);
+		}
+
+		int endi, stepi, endj, stepj;
+
+		unsigned char* bulk=new unsigned char[sizei*sizej*bulkSize];
+
+		if(iPositive && jPositive)
+		{
+			endi=i+sizei;
+			stepi=1;
+
+			endj=j+sizej;
+			stepj=1;
+		}
+		else if(iPositive && !jPositive)
+		{
+			endi=i+sizei;
+			stepi=1;
+
+			endj=j-sizej;
+			stepj=-1;
+		}
+		else if(!iPositive && jPositive)
+		{
+			endi=i-sizei;
+			stepi=-1;
+
+			endj=j+sizej;
+			stepj=1;
+		}
+		else
+		{
+			endi=i-sizei;
+			stepi=-1;
+
+			endj=j-sizej;
+			stepj=-1;
+		}
+
+		if(rowMajorOrder)
+		{
+			for(int k=i; k!=endi; k+=stepi)
+			{
+				for(int m=j; m!=endj; m+=stepj)
+				{
+					unsigned int iBulkOffset = ( ((k-i)*stepi)*sizej + (m-j)*stepj ) * bulkSize;
+					unsigned int iDataOffset = ( k*w + m ) * bulkSize;
+
+					memcpy(bulk + iBulkOffset, data + iDataOffset, bulkSize);
+
+					//std::cout<<"bulk="<<( (k-i)*sizej + m-j ) * bulkSize<<" data="<<( k*w + m ) * bulkSize<<std::endl;
+					//std::cout<<"  k-i"<<k-i<<std::endl;
+				}
+			}
+		}
+		else
+		{
+			for(int k=j; k!=endj; k+=stepj)
+			{
+				for(int m=i; m!=endi; m+=stepi)
+				{
+					memcpy(bulk + ( ((k-j)*stepj)*sizei + (m-i)*stepi ) * bulkSize, data + ( m*w + k ) * bulkSize, bulkSize);
+
+					//std::cout<<"bulk="<<( (k-j)*sizei + m-i ) * bulkSize<<" data="<<( m*w + k ) * bulkSize<<std::endl;
+					//std::cout<<"  k-j"<<k-j<<std::endl;
+				}
+			}
+		}
+
+		return bulk;
+	}
+
+	/**
+	* @brief returns a high resolution monotonic time
+	* @return the time in seconds since an arbitrary point in the past
+	*/
+	double getTime()
+	{
+#ifdef WIN32
+		static double s_dPeriod = 0.0;
+		if( s_dPeriod == 0.0 )
+		{
+			LARGE_INTEGER iFrequency;
+			QueryPerformanceFrequency( &iFrequency );
+			s_dPeriod = 1.0 / ( double )iFrequency.QuadPart;
+		}
+
+		LARGE_INTEGER iCounter;
+		QueryPerformanceCounter( &iCounter );
+		return ( double )iCounter.QuadPart * s_dPeriod;
+#else
+		timespec oTime;
+		clock_gettime( CLOCK_MONOTONIC, &oTime );
+		return ( double )oTime.tv_sec + ( double )oTime.tv_nsec * 1e-9;
+#endif
+	}
 }
 
 
@@ -12,6 +12,15 @@ namespace Oglf
 		return b;
 	}
 
+	template< typename T>
+	T minT( T a, T b )
+	{
+		if( a < b )
+			return a;
+
+		return b;
+	}
+
 	/**
 	* @brief computes the maximum power of two value less than the argument
 	* @param an integer
@@ -19,6 +28,29 @@ namespace Oglf
 	*/
 	int powerOf2(int val);
 
+	/**
+	* @brief  extract a piece of data from from a picture data
+	* @param  i the vertical coordinate of the copy beginning in the picture data (pixels)
+	* @param  j the horizontal coordinate of the copy beginning in the picture data (pixels)
+	* @param  sizei the piece height (pixels)
+	* @param  sizej the piece width (pixels)
+	* @param  w the picture data area width (pixels)
+	* @param  h the picture data area height (pixels)
+	* @param  bulkSize the size of each copied elements (bytes)
+	* @param  data the picture data address
+	* @param  rowMajOrder true: the data is read in row major order, false: the data is read in column major order
+	* @param  iPositive true: data is read from top to bottom, false: data is read from bottom to top
+	* @param  jPositive true: data is read from left to right, false: data is read from right to left
+	* @return  bulk the extracted piece of data, to be deleted with delete[]
+	*/
+	unsigned char* extract(int i, int j, int sizei, int sizej, int w, int h, int bulkSize, const unsigned char* data, bool rowMajorOrder, bool iPositive, bool jPositive);
+
+	/**
+	* @brief returns a high resolution monotonic time
+	* @return the time in seconds since an arbitrary point in the past
+	*/
+	double getTime();
+
 
 // 	int max( int a, int b );
 // 	float max( float a, float b );
@@ -0,0 +1,282 @@
+/**
+* CubeMapCompressor: compresses a vertical cross EXR cube map and its mipmaps to BC6H and writes
+* the cache file loaded by CubeMap::loadCompressedFile().
+*
+* usage: CubeMapCompressor <input.exr> <output.bc6h> [-fast|-quality] [-threads N] [-nomips]
+*/
+
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <vector>
+#include <string>
+#include <GL/glew.h>
+#include <IL/il.h>
+
+#ifdef WIN32
+#include <Windows.h>
+#endif
+
+#include <GL/glfw.h>
+#include "Texture.h"
+#include "HalfFloat.h"
+#include "BC6H.h"
+#include "CompressedCubeMap.h"
+#include "utils.h"
+
+using namespace std;
+using namespace Oglf;
+
+
+const int g_iBlockRowsPerJob = 16;	// rows of blocks compressed by a job, small enough to balance the threads
+
+/**
+* @brief a piece of a face mipmap level to compress
+*/
+struct EncodeJob
+{
+	int iFace;
+	int iMip;
+	int iFirstBlockRow;
+};
+
+/**
+* @brief the data shared by the encoding threads
+*/
+struct EncodeContext
+{
+	vector< Half >			pLevels[ 6 ][ 16 ];	// source faces mipmap levels, RGBA half floats
+	CompressedCubeMapData	oCubeMap;
+	BC6Hquality				eQuality;
+	vector< EncodeJob >		vJobs;
+	size_t					iNextJob;
+	GLFWmutex				oJobLock;
+};
+
+/**
+* @brief encoding thread: compresses jobs until there are no more left
+* @param pData the encode context
+*/
+void GLFWCALL encodeThread( void* pData )
+{
+	EncodeContext* pContext = ( EncodeContext* )pData;
+
+	for( ;; )
+	{
+		glfwLockMutex( pContext->oJobLock );
+		size_t iJob = pContext->iNextJob++;
+		glfwUnlockMutex( pContext->oJobLock );
+
+		if( iJob >= pContext->vJobs.size() )
+			return;
+
+		const EncodeJob& oJob = pContext->vJobs[ iJob ];
+		CompressedCubeMapData& oCubeMap = pContext->oCubeMap;
+		unsigned int iSize = oCubeMap.getMipSize( oJob.iMip );
+
+		encodeBC6H( &pContext->pLevels[ oJob.iFace ][ oJob.iMip ][ 0 ], iSize, iSize, pContext->eQuality,
+			&oCubeMap.vData[ oCubeMap.getFaceDataOffset( oJob.iFace, oJob.iMip ) ], oJob.iFirstBlockRow, g_iBlockRowsPerJob );
+	}
+}
+
+/**
+* @brief measures the compressed cube map quality: decodes every face and level and computes
+* the PSNR of the RGB channels against the source, the peak being the source maximum value
+* @param pContext the encode context
+*/
+void reportPSNR( EncodeContext* pContext )
+{
+	const CompressedCubeMapData& oCubeMap = pContext->oCubeMap;
+	float fPeak = 0.f;
+
+	for( int iFace = 0; iFace < 6; ++iFace )
+	{
+		const vector< Half >& vLevel = pContext->pLevels[ iFace ][ 0 ];
+		for( size_t i = 0; i < vLevel.size(); ++i )
+		{
+			float fVal = halfToFloat( vLevel[ i ] );
+			if( i % 4 != 3 && fVal > fPeak && fVal < 65504.f )
+				fPeak = fVal;
+		}
+	}
+
+	double dTotalError = 0.0;
+	double dTotalCount = 0.0;
+
+	for( unsigned int iMip = 0; iMip < oCubeMap.iMipCount; ++iMip )
+	{
+		unsigned int iSize = oCubeMap.getMipSize( iMip );
+		vector< Half > vDecoded( 4 * iSize * iSize );
+		double dError = 0.0;
+
+		for( int iFace = 0; iFace < 6; ++iFace )
+		{
+			const vector< Half >& vLevel = pContext->pLevels[ iFace ][ iMip ];
+			decodeBC6H( &oCubeMap.vData[ oCubeMap.getFaceDataOffset( iFace, iMip ) ], iSize, iSize, &vDecoded[ 0 ] );
+
+			for( size_t i = 0; i < vLevel.size(); ++i )
+			{
+				if( i % 4 == 3 )
+					continue;
+
+				// BC6H unsigned float cannot store negative values
+				double dSrc = maxT( halfToFloat( vLevel[ i ] ), 0.f );
+				double dDiff = halfToFloat( vDecoded[ i ] ) - dSrc;
+				dError += dDiff * dDiff;
+			}
+		}
+
+		double dCount = 6.0 * 3.0 * iSize * iSize;
+		dTotalError += dError;
+		dTotalCount += dCount;
+
+		if( dError > 0.0 )
+			cout << "  mip " << iMip << " (" << iSize << "x" << iSize << "): PSNR " << 10.0 * log10( fPeak * fPeak * dCount / dError ) << " dB" << endl;
+		else
+			cout << "  mip " << iMip << " (" << iSize << "x" << iSize << "): lossless" << endl;
+	}
+
+	if( dTotalError > 0.0 )
+		cout << "PSNR " << 10.0 * log10( fPeak * fPeak * dTotalCount / dTotalError ) << " dB (peak " << fPeak << ")" << endl;
+	else
+		cout << "PSNR: lossless" << endl;
+}
+
+int main( int argc, char* argv[] )
+{
+	if( argc < 3 )
+	{
+		cout << "usage: CubeMapCompressor <input.exr> <output.bc6h> [-fast|-quality] [-threads N] [-nomips]" << endl;
+		return 1;
+	}
+
+	string sInput = argv[ 1 ];
+	string sOutput = argv[ 2 ];
+	BC6Hquality eQuality = BC6H_QUALITY;
+	int iThreadNb = 0;
+	bool bMips = true;
+
+	for( int i = 3; i < argc; ++i )
+	{
+		if( strcmp( argv[ i ], "-fast" ) == 0 )
+			eQuality = BC6H_FAST;
+		else if( strcmp( argv[ i ], "-quality" ) == 0 )
+			eQuality = BC6H_QUALITY;
+		else if( strcmp( argv[ i ], "-threads" ) == 0 && i + 1 < argc )
+			iThreadNb = atoi( argv[ ++i ] );
+		else if( strcmp( argv[ i ], "-nomips" ) == 0 )
+			bMips = false;
+		else
+		{
+			cout << "Error! unknown option " << argv[ i ] << endl;
+			return 1;
+		}
+	}
+
+	// GLFW is only used for its threads: no window, no GL context
+	if( glfwInit() != GL_TRUE )
+	{
+		cout << "Error! failed to initialize GLFW" << endl;
+		return 1;
+	}
+
+	if( iThreadNb <= 0 )
+		iThreadNb = glfwGetNumberOfProcessors();
+
+	ilInit();
+	ilEnable( IL_ORIGIN_SET );
+	ilSetInteger( IL_ORIGIN_MODE, IL_ORIGIN_UPPER_LEFT );
+
+	EncodeContext* pContext = new EncodeContext;
+
+	try
+	{
+		GLuint iWidth, iHeight;
+		GLubyte* pCross = loadFileDevIL( sInput.c_str(), EXR, iWidth, iHeight );
+
+		unsigned int iFaceSize = iWidth / 3;
+		if( iFaceSize == 0 || iWidth != 3 * iFaceSize || iHeight != 4 * iFaceSize )
+		{
+			delete[] pCross;
+			throw Error( "CubeMapCompressor error: the picture is not a vertical cross cube map", sInput );
+		}
+
+		CompressedCubeMapData& oCubeMap = pContext->oCubeMap;
+		oCubeMap.iFaceSize = iFaceSize;
+		oCubeMap.iMipCount = 1;
+		if( bMips )
+			while( ( iFaceSize >> oCubeMap.iMipCount ) > 0 )
+				++oCubeMap.iMipCount;
+		oCubeMap.allocate();
+
+		for( int iFace = 0; iFace < 6; ++iFace )
+		{
+			Half* pFace = ( Half* )extractCubeMapFace( pCross, iFaceSize, EXR.iPixelSize, iFace );
+			pContext->pLevels[ iFace ][ 0 ].assign( pFace, pFace + 4 * iFaceSize * iFaceSize );
+			delete[] pFace;
+
+			for( unsigned int iMip = 1; iMip < oCubeMap.iMipCount; ++iMip )
+			{
+				unsigned int iSize = oCubeMap.getMipSize( iMip );
+				pContext->pLevels[ iFace ][ iMip ].resize( 4 * iSize * iSize );
+				downsampleHalfRGBA( &pContext->pLevels[ iFace ][ iMip - 1 ][ 0 ], oCubeMap.getMipSize( iMip - 1 ), oCubeMap.getMipSize( iMip - 1 ),
+					&pContext->pLevels[ iFace ][ iMip ][ 0 ] );
+			}
+		}
+		delete[] pCross;
+
+		for( unsigned int iMip = 0; iMip < oCubeMap.iMipCount; ++iMip )
+		{
+			int iBlockRows = ( oCubeMap.getMipSize( iMip ) + 3 ) / 4;
+
+			for( int iFace = 0; iFace < 6; ++iFace )
+			{
+				for( int iRow = 0; iRow < iBlockRows; iRow += g_iBlockRowsPerJob )
+				{
+					EncodeJob oJob = { iFace, ( int )iMip, iRow };
+					pContext->vJobs.push_back( oJob );
+				}
+			}
+		}
+
+		cout << "Compressing " << sInput << ": " << iFaceSize << "x" << iFaceSize << " faces, " << oCubeMap.iMipCount << " mip levels, "
+			<< ( eQuality == BC6H_QUALITY ? "quality" : "fast" ) << " preset, " << iThreadNb << " threads" << endl;
+
+		pContext->eQuality = eQuality;
+		pContext->iNextJob = 0;
+		pContext->oJobLock = glfwCreateMutex();
+
+		double dStart = getTime();
+
+		vector< GLFWthread > vThreads;
+		for( int i = 0; i < iThreadNb; ++i )
+			vThreads.push_back( glfwCreateThread( encodeThread, pContext ) );
+		for( size_t i = 0; i < vThreads.size(); ++i )
+			glfwWaitThread( vThreads[ i ], GLFW_WAIT );
+
+		double dTime = getTime() - dStart;
+		glfwDestroyMutex( pContext->oJobLock );
+
+		unsigned int iSourceSize = 6 * 4 * sizeof( Half ) * iFaceSize * iFaceSize * 4 / 3;
+		cout << "Compressed in " << dTime * 1000.0 << " ms, " << oCubeMap.vData.size() / 1024 << " KB (RGBA16F with mips: "
+			<< iSourceSize / 1024 << " KB)" << endl;
+
+		reportPSNR( pContext );
+
+		writeCompressedCubeMap( sOutput, oCubeMap );
+		cout << "Written " << sOutput << endl;
+	}
+	catch( Error e )
+	{
+		e.showError();
+		delete pContext;
+		glfwTerminate();
+		return 1;
+	}
+
+	delete pContext;
+	glfwTerminate();
+
+	return 0;
+}
@@ -0,0 +1,228 @@
+/**
+* InstancingTest: draws InstanceGroup instances through a Scene in a 64x64 frame and checks the culled instances
+* and the pixels they cover: a group drawn at once by the instanced shaders reading a_mInstanceMatrix and
+* a_vInstanceParameter, a group drawn one by one by shaders without these attributes and a group drawn by the
+* fixed pipeline. Prints each failed check and returns a failure when any check fails. To be run from its
+* directory, which holds the shaders and the quad mesh.
+*
+* usage: InstancingTest [-headless]
+*        -headless: renders with an offscreen context instead of a window (not supported on Windows)
+*/
+
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <GL/glew.h>
+#include <GL/glfw.h>
+
+#include "Scene.h"
+#include "InstanceGroup.h"
+#include "HeadlessContext.h"
+#include "Error.h"
+
+using namespace std;
+using namespace Oglf;
+
+
+const int g_iFrameSize = 64;
+
+int g_iFailedNb = 0;
+
+/**
+* @brief counts and prints a failed check
+* @param bSuccess the check result
+* @param pcCheck the check description
+*/
+void check( bool bSuccess, const char* pcCheck )
+{
+	if( bSuccess )
+		return;
+
+	cout << "Failed: " << pcCheck << endl;
+	++g_iFailedNb;
+}
+
+/**
+* @brief returns an instance world matrix
+* @param fX the instance x position
+* @param fY the instance y position
+* @param fScale the instance uniform scale
+*/
+Matrix4x4 instance( float fX, float fY, float fScale )
+{
+	Matrix4x4 oWorld;
+	oWorld.m[ 0 ] = oWorld.m[ 5 ] = oWorld.m[ 10 ] = fScale;
+	oWorld.m[ 12 ] = fX;
+	oWorld.m[ 13 ] = fY;
+
+	return oWorld;
+}
+
+/**
+* @brief reads a pixel of the frame, the frame spans the [-10, 10] square of the xy plane
+* @param iX the pixel column, from the left
+* @param iY the pixel row, from the bottom
+* @param pColor the pixel RGBA color
+*/
+void readPixel( int iX, int iY, GLubyte* pColor )
+{
+	glPixelStorei( GL_PACK_ALIGNMENT, 1 );
+	glReadPixels( iX, iY, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pColor );
+}
+
+/**
+* @brief checks the color of a pixel
+* @param iX the pixel column
+* @param iY the pixel row
+* @param iRed the expected red, 0 or 255
+* @param iGreen the expected green, 0 or 255
+* @param iBlue the expected blue, 0 or 255
+* @param pcCheck the check description
+*/
+void checkPixel( int iX, int iY, int iRed, int iGreen, int iBlue, const char* pcCheck )
+{
+	GLubyte pColor[ 4 ];
+	readPixel( iX, iY, pColor );
+	check( pColor[ 0 ] == iRed && pColor[ 1 ] == iGreen && pColor[ 2 ] == iBlue, pcCheck );
+}
+
+/**
+* @brief clears the frame and draws the scene
+*/
+void drawFrame( Scene& oScene )
+{
+	glClear( GL_COLOR_BUFFER_BIT );
+	oScene.drawElements();
+	glFinish();
+}
+
+/**
+* @brief draws the groups and checks the frames
+*/
+void testInstanceGroups()
+{
+	glMatrixMode( GL_PROJECTION );
+	glLoadIdentity();
+	glOrtho( -10.0, 10.0, -10.0, 10.0, -10.0, 10.0 );
+	glMatrixMode( GL_MODELVIEW );
+	glLoadIdentity();
+	glClearColor( 0.f, 0.f, 0.f, 0.f );
+
+	Mesh oQuad( "quad" );
+	oQuad.importOBJ( "obj/quad.obj" );
+	oQuad.prepareRenderableBatch();
+
+	RenderingFX oInstancedFx;
+	oInstancedFx.setShaders( "shaders/Instanced.vert", "shaders/Color.frag" );
+	RenderingFX oOneByOneFx;
+	oOneByOneFx.setShaders( "shaders/OneByOne.vert", "shaders/Color.frag" );
+
+	Scene oScene;
+	int iInstancedFx = oScene.addRenderingFX( oInstancedFx );
+	int iOneByOneFx = oScene.addRenderingFX( oOneByOneFx );
+
+	// a red quad, a blue one twice larger, one outside of the frustum and one across its top plane
+	const float pfRed[ 4 ] = { 1.f, 0.f, 0.f, 1.f };
+	const float pfBlue[ 4 ] = { 0.f, 0.f, 1.f, 1.f };
+	InstanceGroup oInstanced( oQuad );
+	oInstanced.addInstance( instance( -5.f, -5.f, 1.f ), pfRed );
+	oInstanced.addInstance( instance( 5.f, 5.f, 2.f ), pfBlue );
+	oInstanced.addInstance( instance( 50.f, 0.f, 1.f ), pfRed );
+	oInstanced.addInstance( instance( 0.f, 10.5f, 1.f ), pfBlue );
+	oScene.addInstanceGroup( oInstanced, iInstancedFx );
+
+	if( GLEW_ARB_draw_instanced && GLEW_ARB_instanced_arrays && GLEW_ARB_vertex_buffer_object )
+	{
+		drawFrame( oScene );
+		check( oInstanced.getVisibleNb() == 3, "the instance outside of the frustum is culled" );
+		checkPixel( 16, 16, 255, 0, 0, "instanced quad colored by its parameter" );
+		checkPixel( 48, 48, 0, 0, 255, "instanced quad placed by its matrix" );
+		checkPixel( 42, 42, 0, 0, 255, "instanced quad scaled by its matrix" );
+		checkPixel( 32, 62, 0, 0, 255, "instance across a frustum plane" );
+		checkPixel( 32, 32, 0, 0, 0, "no instance between the quads" );
+
+		oInstanced.setCulling( false );
+		drawFrame( oScene );
+		check( oInstanced.getVisibleNb() == 4, "every instance is drawn without culling" );
+		oInstanced.setCulling( true );
+	}
+	else
+	{
+		cout << "Instancing not supported, the instanced draw is not checked" << endl;
+	}
+
+	// the effect does not read the instance attributes: its instances are drawn with the modelview matrix
+	InstanceGroup oOneByOne( oQuad );
+	oOneByOne.addInstance( instance( -5.f, 5.f, 1.f ) );
+	oOneByOne.addInstance( instance( 5.f, -5.f, 1.f ) );
+	oOneByOne.addInstance( instance( -50.f, 0.f, 1.f ) );
+	oScene.addInstanceGroup( oOneByOne, iOneByOneFx );
+
+	InstanceGroup oFixedPipeline( oQuad );
+	oFixedPipeline.addInstance( instance( 0.f, -8.f, 1.f ) );
+	oScene.addInstanceGroup( oFixedPipeline );
+
+	drawFrame( oScene );
+	check( oOneByOne.getVisibleNb() == 2, "the instance drawn one by one outside of the frustum is culled" );
+	checkPixel( 16, 48, 0, 255, 0, "first instance drawn one by one" );
+	checkPixel( 48, 16, 0, 255, 0, "second instance drawn one by one" );
+
+	GLubyte pColor[ 4 ];
+	readPixel( 32, 6, pColor );
+	check( pColor[ 0 ] != 0 || pColor[ 1 ] != 0 || pColor[ 2 ] != 0, "instance drawn by the fixed pipeline" );
+
+	check( glGetError() == GL_NO_ERROR, "no OpenGL error" );
+}
+
+int main( int argc, char** argv )
+{
+	bool bHeadless = argc > 1 && strcmp( argv[ 1 ], "-headless" ) == 0;
+	HeadlessContext* pHeadlessContext = NULL;
+
+	try
+	{
+		if( bHeadless )
+		{
+			pHeadlessContext = new HeadlessContext( g_iFrameSize, g_iFrameSize );
+		}
+		else
+		{
+			glfwInit();
+			if( !glfwOpenWindow( g_iFrameSize, g_iFrameSize, 8, 8, 8, 8, 24, 0, GLFW_WINDOW ) )
+			{
+				cout << "Error! failed to open a window" << endl;
+				glfwTerminate();
+				return EXIT_FAILURE;
+			}
+			glfwSetWindowTitle( "InstancingTest" );
+		}
+
+		// GLEW builds without EGL support fail to load their GLX entry points with an EGL context, after the OpenGL ones
+		if( glewInit() != GLEW_OK && !( pHeadlessContext != NULL && GLEW_VERSION_2_0 ) )
+			throw Error( "InstancingTest error : Failed to load the OpenGL extensions" );
+
+		if( pHeadlessContext != NULL )
+			pHeadlessContext->initRenderTarget();
+		glViewport( 0, 0, g_iFrameSize, g_iFrameSize );
+
+		testInstanceGroups();
+	}
+	catch( Error& e )
+	{
+		cout << "Failed: " << e.getMessage() << endl;
+		++g_iFailedNb;
+	}
+
+	delete pHeadlessContext;
+	if( !bHeadless )
+		glfwTerminate();
+
+	if( g_iFailedNb > 0 )
+	{
+		cout << g_iFailedNb << " checks failed" << endl;
+		return EXIT_FAILURE;
+	}
+
+	cout << "All the checks passed" << endl;
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,7 @@
+// InstancingTest: flat color of the instance
+varying vec4 v_vColor;
+
+void main()
+{
+	gl_FragColor = v_vColor;
+}
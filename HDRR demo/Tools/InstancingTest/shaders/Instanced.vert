@@ -0,0 +1,11 @@
+// InstancingTest: places each instance with its per-instance world matrix and colors it with its parameter
+attribute mat4 a_mInstanceMatrix;
+attribute vec4 a_vInstanceParameter;
+
+varying vec4 v_vColor;
+
+void main()
+{
+	v_vColor = a_vInstanceParameter;
+	gl_Position = gl_ModelViewProjectionMatrix * ( a_mInstanceMatrix * gl_Vertex );
+}
@@ -0,0 +1,8 @@
+// InstancingTest: without the instance attributes the world matrix of each instance is in the modelview matrix
+varying vec4 v_vColor;
+
+void main()
+{
+	v_vColor = vec4( 0.0, 1.0, 0.0, 1.0 );
+	gl_Position = gl_ModelViewProjectionMatrix * gl_Vertex;
+}
@@ -0,0 +1,1072 @@
+/**
+* MathBenchmark: measures the OGLF math primitives over realistic data sizes, scalar and SIMD variants side by side:
+* the Vec3 operators against the Vec3x4 and Vec3x8 packets, the Matrix4x4 product and inverses against the former
+* implementation, the product through the (row,column) accessor and the Gauss-Jordan inverse with partial pivoting,
+* the Quaternion products and conversions, the bounding volumes of a mesh and the batch transforms of points. It checks
+* that the variants give the same results, prints the time per operation and writes the results to a JSON report.
+* It only needs the OGLF math sources and the job system, which runs on the native threads: neither GL nor GLFW is
+* linked. Besides the Visual Studio project, the CMakeLists.txt of the solution directory builds it on Linux.
+*
+* usage: MathBenchmark [-count N] [-jobs] [-report file.json]
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <vector>
+
+#include "Vec.h"
+#include "Matrix.h"
+#include "Quaternion.h"
+#include "BoundingBox.h"
+#include "JobSystem.h"
+#include "Simd.h"
+#include "utils.h"
+
+using namespace std;
+using namespace Oglf;
+
+
+const int g_iMatrixNb = 1024;		// matrices the operations loop over, they fit in the L1 and L2 caches
+const int g_iVectorNb = 1 << 16;	// vectors of the Vec3 operations, a mesh worth of data that fits in the L2 cache
+const int g_iQuaternionNb = 4096;	// quaternions of the conversions, the bones of a few dozens animated characters
+const int g_iPointNb = 1 << 20;		// points of the batch transforms and vertices of the bounds, they do not fit in the caches
+
+/**
+* @brief the former product, through the (row,column) accessor
+* @param a the left matrix
+* @param b the right matrix
+* @return the product
+*/
+Matrix4x4 legacyMultiply( const Matrix4x4& a, const Matrix4x4& b )
+{
+	Matrix4x4 m;
+
+	for( int l = 0; l < 4; l++ )
+		for( int c = 0; c < 4; c++ )
+			m(l,c) = a(l,0) * b(0,c) + a(l,1) * b(1,c) + a(l,2) * b(2,c) + a(l,3) * b(3, c);
+
+	return m;
+}
+
+/**
+* @brief the former inverse, a Gauss-Jordan elimination with partial pivoting
+* @param m the matrix to invert, overwritten by its inverse
+*/
+void legacyInvert( Matrix4x4& m )
+{
+	Matrix4x4 a( m ), b;
+	int i, j, i1, i2;
+	float temp, pivot;
+	float factor = 0.0;
+
+	b.identity();
+
+	for( j = 0; j < 4; j++ )
+	{
+		i1 = j;
+		for( i = j; i < 4; i++ )
+			if( fabs( a(i,j) ) > fabs( a(i1,j) ) ) i1 = i;
+		if( i1 != j )
+		{
+			for( i2 = 0; i2 < 4; i2++ )
+			{
+				temp = b(i1,i2);
+				b(i1,i2) = b(j,i2);
+				b(j,i2) = temp;
+				if( i2 >= j )
+				{
+					temp = a(i1,i2);
+					a(i1,i2) = a(j,i2);
+					a(j,i2) = temp;
+				}
+			}
+		}
+		pivot = a(j,j);
+		for( i2 = 0; i2 < 4; i2++ )
+		{
+			b(j,i2) = b(j,i2) / pivot;
+			if( i2 >= j ) a(j,i2) = a(j,i2) / pivot;
+		}
+
+		for( i = 0; i < 4; i++ )
+		{
+			if( i != j ) factor = a(i,j);
+			for( i2 = 0; i2 < 4; i2++ )
+			{
+				if( i != j )
+				{
+					b(i,i2) = b(i,i2) - factor * b(j,i2);
+					a(i,i2) = a(i,i2) - factor * a(j,i2);
+				}
+			}
+		}
+	}
+
+	m = b;
+}
+
+/**
+* @brief returns a random float
+* @param fMin the minimum value
+* @param fMax the maximum value
+* @return the random value
+*/
+float randomFloat( float fMin, float fMax )
+{
+	return fMin + ( fMax - fMin ) * ( float )rand() / ( float )RAND_MAX;
+}
+
+/**
+* @brief builds a random rotation and translation
+* @param oMat the matrix built
+*/
+void randomRigid( Matrix4x4& oMat )
+{
+	Matrix4x4 oRot;
+	oMat.rotationX( randomFloat( -3.f, 3.f ) );
+	oRot.rotationY( randomFloat( -3.f, 3.f ) );
+	oMat = oMat * oRot;
+	oRot.rotationZ( randomFloat( -3.f, 3.f ) );
+	oMat = oMat * oRot;
+
+	oMat(0,3) = randomFloat( -10.f, 10.f );
+	oMat(1,3) = randomFloat( -10.f, 10.f );
+	oMat(2,3) = randomFloat( -10.f, 10.f );
+}
+
+/**
+* @brief builds a random rotation, scale and translation
+* @param oMat the matrix built
+*/
+void randomAffine( Matrix4x4& oMat )
+{
+	Matrix4x4 oScale;
+	randomRigid( oMat );
+	oScale(0,0) = randomFloat( 0.5f, 2.f );
+	oScale(1,1) = randomFloat( 0.5f, 2.f );
+	oScale(2,2) = randomFloat( 0.5f, 2.f );
+	oMat = oMat * oScale;
+}
+
+/**
+* @brief builds a random projective matrix, whose last row is not 0 0 0 1
+* @param oMat the matrix built
+*/
+void randomProjective( Matrix4x4& oMat )
+{
+	randomAffine( oMat );
+	oMat(3,0) = randomFloat( -0.5f, 0.5f );
+	oMat(3,1) = randomFloat( -0.5f, 0.5f );
+	oMat(3,2) = randomFloat( -0.5f, 0.5f );
+	oMat(3,3) = randomFloat( 1.f, 2.f );
+}
+
+/**
+* @brief returns the largest coefficient difference between two matrices, relative to the largest coefficient
+* @param a the first matrix
+* @param b the second matrix
+* @return the relative error
+*/
+float maxError( const Matrix4x4& a, const Matrix4x4& b )
+{
+	float fError = 0.f, fMax = 1.f;
+	for( int i = 0; i < 16; i++ )
+	{
+		fError = maxT( fError, ( float )fabs( a.m[ i ] - b.m[ i ] ) );
+		fMax = maxT( fMax, ( float )fabs( a.m[ i ] ) );
+	}
+
+	return fError / fMax;
+}
+
+#ifdef OGLF_AVX
+const char* g_pcFloat8Simd = "AVX";
+#else
+const char* g_pcFloat8Simd = "two Float4";	// Float8 is only held in an AVX register when the compiler targets AVX
+#endif
+
+// the results are summed so that the compiler does not remove the benchmarked operations
+volatile float g_fSink;
+
+/**
+* @brief times the product of each matrix with the next one
+* @param vMatrices the matrices
+* @param iCount the number of products
+* @param bLegacy true: former implementation
+* @return the time per product in nanoseconds
+*/
+double benchmarkMultiply( const vector< Matrix4x4 >& vMatrices, int iCount, bool bLegacy )
+{
+	float fSum = 0.f;
+	double dStart = getTime();
+
+	for( int i = 0; i < iCount; ++i )
+	{
+		const Matrix4x4& a = vMatrices[ i % g_iMatrixNb ];
+		const Matrix4x4& b = vMatrices[ ( i + 1 ) % g_iMatrixNb ];
+		Matrix4x4 r = bLegacy ? legacyMultiply( a, b ) : a * b;
+		fSum += r.m[ i & 15 ];
+	}
+
+	double dTime = ( getTime() - dStart ) * 1e9 / iCount;
+	g_fSink = fSum;
+	return dTime;
+}
+
+enum InvertMethod
+{
+	INVERT_LEGACY,
+	INVERT,
+	INVERT_AFFINE,
+	INVERT_RIGID
+};
+
+/**
+* @brief times the inverse of the matrices
+* @param vMatrices the matrices
+* @param iCount the number of inverses
+* @param eMethod the inverse
+* @return the time per inverse in nanoseconds
+*/
+double benchmarkInvert( const vector< Matrix4x4 >& vMatrices, int iCount, InvertMethod eMethod )
+{
+	float fSum = 0.f;
+	double dStart = getTime();
+
+	for( int i = 0; i < iCount; ++i )
+	{
+		Matrix4x4 r = vMatrices[ i % g_iMatrixNb ];
+		switch( eMethod )
+		{
+		case INVERT_LEGACY: legacyInvert( r ); break;
+		case INVERT:		r.invert(); break;
+		case INVERT_AFFINE:	r.invertAffine(); break;
+		case INVERT_RIGID:	r.invertRigid(); break;
+		}
+		fSum += r.m[ i & 15 ];
+	}
+
+	double dTime = ( getTime() - dStart ) * 1e9 / iCount;
+	g_fSink = fSum;
+	return dTime;
+}
+
+/**
+* @brief checks an inverse against the former one over the matrices
+* @param vMatrices the matrices
+* @param eMethod the inverse
+* @return the largest relative error
+*/
+float checkInvert( const vector< Matrix4x4 >& vMatrices, InvertMethod eMethod )
+{
+	float fError = 0.f;
+
+	for( int i = 0; i < g_iMatrixNb; ++i )
+	{
+		Matrix4x4 oReference = vMatrices[ i ];
+		Matrix4x4 r = vMatrices[ i ];
+		legacyInvert( oReference );
+		switch( eMethod )
+		{
+		case INVERT_LEGACY: legacyInvert( r ); break;
+		case INVERT:		r.invert(); break;
+		case INVERT_AFFINE:	r.invertAffine(); break;
+		case INVERT_RIGID:	r.invertRigid(); break;
+		}
+		fError = maxT( fError, maxError( oReference, r ) );
+	}
+
+	return fError;
+}
+
+enum BatchMethod
+{
+	BATCH_LOOP,			// Vec3 product loop
+	BATCH_PROJECT_LOOP,	// Vec3 + operator loop
+	BATCH_POINTS,
+	BATCH_PROJECT,
+	BATCH_STREAMS
+};
+
+/**
+* @brief times a batch transform of the points
+* @param oMat the matrix
+* @param vPoints the points, as an array of Vec3
+* @param ppStreams the points, as x, y and z streams
+* @param vResults the transformed points
+* @param ppResultStreams the transformed points streams
+* @param iCount the number of transformed points
+* @param eMethod the transform
+* @param pJobSystem spreads the batches over its workers, may be NULL
+* @return the time per point in nanoseconds
+*/
+double benchmarkBatch( const Matrix4x4& oMat, const vector< Vec3 >& vPoints, const float* const ppStreams[ 3 ], vector< Vec3 >& vResults,
+	float* const ppResultStreams[ 3 ], int iCount, BatchMethod eMethod, JobSystem* pJobSystem )
+{
+	int iPassNb = maxT( iCount / g_iPointNb, 1 );
+	double dStart = getTime();
+
+	for( int iPass = 0; iPass < iPassNb; ++iPass )
+	{
+		switch( eMethod )
+		{
+		case BATCH_LOOP:
+			for( int i = 0; i < g_iPointNb; ++i )
+				vResults[ i ] = oMat * vPoints[ i ];
+			break;
+		case BATCH_PROJECT_LOOP:
+			for( int i = 0; i < g_iPointNb; ++i )
+				vResults[ i ] = oMat + vPoints[ i ];
+			break;
+		case BATCH_POINTS:	oMat.transformPoints( &vPoints[ 0 ], &vResults[ 0 ], g_iPointNb, pJobSystem ); break;
+		case BATCH_PROJECT:	oMat.projectPoints( &vPoints[ 0 ], &vResults[ 0 ], g_iPointNb, pJobSystem ); break;
+		case BATCH_STREAMS:	oMat.transformPoints( ppStreams, ppResultStreams, g_iPointNb, pJobSystem ); break;
+		}
+	}
+
+	double dTime = ( getTime() - dStart ) * 1e9 / ( ( double )iPassNb * g_iPointNb );
+	g_fSink = vResults[ iPassNb ].v[ 0 ] + ppResultStreams[ 0 ][ iPassNb ];
+	return dTime;
+}
+
+/**
+* @brief returns the largest difference between the points transformed one by one and by a batch transform
+* @param vReference the points transformed one by one
+* @param vResults the points transformed by the batch
+* @param ppResultStreams the points streams transformed by the batch, NULL to check vResults
+* @return the largest relative error
+*/
+float batchError( const vector< Vec3 >& vReference, const vector< Vec3 >& vResults, const float* const* ppResultStreams )
+{
+	float fError = 0.f;
+
+	for( int i = 0; i < g_iPointNb; ++i )
+	{
+		for( int j = 0; j < 3; ++j )
+		{
+			float fResult = ppResultStreams != NULL ? ppResultStreams[ j ][ i ] : vResults[ i ].v[ j ];
+			fError = maxT( fError, ( float )fabs( fResult - vReference[ i ].v[ j ] ) / maxT( 1.f, ( float )fabs( vReference[ i ].v[ j ] ) ) );
+		}
+	}
+
+	return fError;
+}
+
+
+/**
+* @brief returns a vector whose 3 coordinates are a value, for the operations giving a scalar
+* @param f the value
+* @return the vector
+*/
+inline Vec3 splat( float f )
+{
+	return Vec3( f, f, f );
+}
+
+/**
+* @brief returns a packet whose 3 coordinates are a value, for the operations giving a scalar
+* @param f the value
+* @return the packet
+*/
+template< typename F >
+inline Vec3Packet< F > splat( const F& f )
+{
+	return Vec3Packet< F >( f, f, f );
+}
+
+/**
+* @brief the benchmarked Vec3 operations, applied the same way to Vec3 and to packets
+*/
+struct Vec3Add
+{
+	static const char* getName() { return "add"; }
+	template< typename V > static V apply( const V& a, const V& b ) { return a + b; }
+};
+
+struct Vec3Dot
+{
+	static const char* getName() { return "dot product"; }
+	template< typename V > static V apply( const V& a, const V& b ) { return splat( a | b ); }
+};
+
+struct Vec3Cross
+{
+	static const char* getName() { return "cross product"; }
+	template< typename V > static V apply( const V& a, const V& b ) { return a ^ b; }
+};
+
+struct Vec3Normalize
+{
+	static const char* getName() { return "normalize"; }
+	template< typename V > static V apply( const V& a, const V& ) { V r( a ); r.normalize(); return r; }
+};
+
+/**
+* @brief times an operation over arrays of Vec3
+* @param vA the first operands
+* @param vB the second operands
+* @param vResults the results
+* @param iCount the number of operations
+* @return the time per operation in nanoseconds
+*/
+template< typename Op >
+double benchmarkVec3( const vector< Vec3 >& vA, const vector< Vec3 >& vB, vector< Vec3 >& vResults, int iCount )
+{
+	int iPassNb = maxT( iCount / g_iVectorNb, 1 );
+	double dStart = getTime();
+
+	for( int iPass = 0; iPass < iPassNb; ++iPass )
+	{
+		for( int i = 0; i < g_iVectorNb; ++i )
+			vResults[ i ] = Op::apply( vA[ i ], vB[ i ] );
+	}
+
+	double dTime = ( getTime() - dStart ) * 1e9 / ( ( double )iPassNb * g_iVectorNb );
+	g_fSink = vResults[ iPassNb ].v[ 0 ];
+	return dTime;
+}
+
+/**
+* @brief times an operation over x, y and z streams loaded into packets
+* @param vA the first operands streams
+* @param vB the second operands streams
+* @param vResults the results streams
+* @param iCount the number of operations
+* @return the time per operation in nanoseconds
+*/
+template< typename Op, typename F >
+double benchmarkPackets( const vector< float >& vA, const vector< float >& vB, vector< float >& vResults, int iCount )
+{
+	typedef Vec3Packet< F > Packet;
+
+	const float* pA[ 3 ] = { &vA[ 0 ], &vA[ g_iVectorNb ], &vA[ 2 * g_iVectorNb ] };
+	const float* pB[ 3 ] = { &vB[ 0 ], &vB[ g_iVectorNb ], &vB[ 2 * g_iVectorNb ] };
+	float* pR[ 3 ] = { &vResults[ 0 ], &vResults[ g_iVectorNb ], &vResults[ 2 * g_iVectorNb ] };
+	int iPassNb = maxT( iCount / g_iVectorNb, 1 );
+	double dStart = getTime();
+
+	for( int iPass = 0; iPass < iPassNb; ++iPass )
+	{
+		for( int i = 0; i < g_iVectorNb; i += Packet::SIZE )
+		{
+			Packet a = Packet::loadStreams( pA[ 0 ] + i, pA[ 1 ] + i, pA[ 2 ] + i );
+			Packet b = Packet::loadStreams( pB[ 0 ] + i, pB[ 1 ] + i, pB[ 2 ] + i );
+			Op::apply( a, b ).storeStreams( pR[ 0 ] + i, pR[ 1 ] + i, pR[ 2 ] + i );
+		}
+	}
+
+	double dTime = ( getTime() - dStart ) * 1e9 / ( ( double )iPassNb * g_iVectorNb );
+	g_fSink = vResults[ iPassNb ];
+	return dTime;
+}
+
+/**
+* @brief returns the largest difference between the results of the Vec3 operations and of the packets
+* @param vReference the Vec3 results
+* @param vResults the packets results streams
+* @return the largest relative error
+*/
+float vec3Error( const vector< Vec3 >& vReference, const vector< float >& vResults )
+{
+	float fError = 0.f;
+
+	for( int i = 0; i < g_iVectorNb; ++i )
+	{
+		for( int j = 0; j < 3; ++j )
+		{
+			float fReference = vReference[ i ].v[ j ];
+			fError = maxT( fError, ( float )fabs( vResults[ j * g_iVectorNb + i ] - fReference ) / maxT( 1.f, ( float )fabs( fReference ) ) );
+		}
+	}
+
+	return fError;
+}
+
+/**
+* @brief times the product of each quaternion with the next one
+* @param vQuaternions the quaternions
+* @param iCount the number of products
+* @return the time per product in nanoseconds
+*/
+double benchmarkQuaternionProduct( const vector< Quaternion >& vQuaternions, int iCount )
+{
+	float fSum = 0.f;
+	double dStart = getTime();
+
+	for( int i = 0; i < iCount; ++i )
+	{
+		Quaternion r = vQuaternions[ i % g_iMatrixNb ] * vQuaternions[ ( i + 1 ) % g_iMatrixNb ];
+		fSum += r.getW();
+	}
+
+	double dTime = ( getTime() - dStart ) * 1e9 / iCount;
+	g_fSink = fSum;
+	return dTime;
+}
+
+/**
+* @brief times the conversion of the quaternions to matrices
+* @param vQuaternions the quaternions
+* @param vMatrices the matrices
+* @param iCount the number of conversions
+* @param bBatch true: Quaternion::toMatrices(), false: a loop of Quaternion::toMatrix()
+* @return the time per conversion in nanoseconds
+*/
+double benchmarkToMatrix( const vector< Quaternion >& vQuaternions, vector< Matrix4x4 >& vMatrices, int iCount, bool bBatch )
+{
+	int iPassNb = maxT( iCount / g_iQuaternionNb, 1 );
+	double dStart = getTime();
+
+	for( int iPass = 0; iPass < iPassNb; ++iPass )
+	{
+		if( bBatch )
+		{
+			Quaternion::toMatrices( &vQuaternions[ 0 ], &vMatrices[ 0 ], g_iQuaternionNb );
+			continue;
+		}
+
+		for( int i = 0; i < g_iQuaternionNb; ++i )
+		{
+			float* pM = vMatrices[ i ].m;
+			vQuaternions[ i ].toMatrix( pM );
+			pM[ 3 ] = pM[ 7 ] = pM[ 11 ] = 0.f;
+			pM[ 12 ] = pM[ 13 ] = pM[ 14 ] = 0.f;
+			pM[ 15 ] = 1.f;
+		}
+	}
+
+	double dTime = ( getTime() - dStart ) * 1e9 / ( ( double )iPassNb * g_iQuaternionNb );
+	g_fSink = vMatrices[ iPassNb ].m[ 0 ];
+	return dTime;
+}
+
+/**
+* @brief times the interpolation of each quaternion with the next one
+* @param vQuaternions the quaternions
+* @param vResults the interpolated quaternions
+* @param iCount the number of interpolations
+* @param bSlerp true: Quaternion::slerp(), false: Quaternion::nlerp()
+* @return the time per interpolation in nanoseconds
+*/
+double benchmarkInterpolation( const vector< Quaternion >& vQuaternions, vector< Quaternion >& vResults, int iCount, bool bSlerp )
+{
+	int iPassNb = maxT( iCount / g_iQuaternionNb, 1 );
+	double dStart = getTime();
+
+	for( int iPass = 0; iPass < iPassNb; ++iPass )
+	{
+		for( int i = 0; i < g_iQuaternionNb; ++i )
+		{
+			const Quaternion& a = vQuaternions[ i ];
+			const Quaternion& b = vQuaternions[ ( i + 1 ) % g_iQuaternionNb ];
+			float t = ( float )( i & 255 ) / 255.f;
+			vResults[ i ] = bSlerp ? Quaternion::slerp( a, b, t ) : Quaternion::nlerp( a, b, t );
+		}
+	}
+
+	double dTime = ( getTime() - dStart ) * 1e9 / ( ( double )iPassNb * g_iQuaternionNb );
+	g_fSink = vResults[ iPassNb ].getW();
+	return dTime;
+}
+
+/**
+* @brief returns the largest angle between two arrays of unit quaternions
+* @param vReference the first quaternions
+* @param vResults the second quaternions
+* @return the largest angle in radians
+*/
+float quaternionError( const vector< Quaternion >& vReference, const vector< Quaternion >& vResults )
+{
+	float fError = 0.f;
+
+	for( int i = 0; i < g_iQuaternionNb; ++i )
+	{
+		float fCos = minT( ( float )fabs( vReference[ i ].dot( vResults[ i ] ) ), 1.f );
+		fError = maxT( fError, 2.f * acos( fCos ) );
+	}
+
+	return fError;
+}
+
+/**
+* @brief the former BoundingBox::build(), a scalar loop comparing each coordinate to the box planes
+* @param vVertices the vertices
+* @param oBox the box
+*/
+void legacyBuild( const MeshVec3Array& vVertices, BoundingBox& oBox )
+{
+	oBox.left = oBox.right = vVertices[ 0 ].v[ 0 ];
+	oBox.bottom = oBox.top = vVertices[ 0 ].v[ 1 ];
+	oBox.back = oBox.front = vVertices[ 0 ].v[ 2 ];
+
+	for( int i = 0; i < ( int )vVertices.size(); ++i )
+	{
+		if( vVertices[ i ].v[ 0 ] <= oBox.left )
+			oBox.left = vVertices[ i ].v[ 0 ];
+		else if( vVertices[ i ].v[ 0 ] > oBox.right )
+			oBox.right = vVertices[ i ].v[ 0 ];
+
+		if( vVertices[ i ].v[ 2 ] <= oBox.back )
+			oBox.back = vVertices[ i ].v[ 2 ];
+		else if( vVertices[ i ].v[ 2 ] > oBox.front )
+			oBox.front = vVertices[ i ].v[ 2 ];
+
+		if( vVertices[ i ].v[ 1 ] <= oBox.bottom )
+			oBox.bottom = vVertices[ i ].v[ 1 ];
+		else if( vVertices[ i ].v[ 1 ] > oBox.top )
+			oBox.top = vVertices[ i ].v[ 1 ];
+	}
+}
+
+enum BoundsMethod
+{
+	BOUNDS_LEGACY,
+	BOUNDS_BOX,
+	BOUNDS_SPHERE,
+	BOUNDS_ORIENTED
+};
+
+/**
+* @brief times the bounding volume computation of the vertices
+* @param vVertices the vertices
+* @param iCount the number of vertices bounded
+* @param eMethod the volume
+* @param pJobSystem spreads the reductions over its workers, may be NULL
+* @param oBox the volumes computed, the box is built beforehand for the sphere and the oriented box
+* @return the time per vertex in nanoseconds
+*/
+double benchmarkBounds( MeshVec3Array& vVertices, int iCount, BoundsMethod eMethod, JobSystem* pJobSystem, BoundingBox& oBox )
+{
+	int iPassNb = maxT( iCount / g_iPointNb, 1 );
+	if( eMethod == BOUNDS_SPHERE || eMethod == BOUNDS_ORIENTED )
+		oBox.build();
+
+	double dStart = getTime();
+
+	for( int iPass = 0; iPass < iPassNb; ++iPass )
+	{
+		switch( eMethod )
+		{
+		case BOUNDS_LEGACY:		legacyBuild( vVertices, oBox );				break;
+		case BOUNDS_BOX:		oBox.build( pJobSystem );					break;
+		case BOUNDS_SPHERE:		oBox.buildSphere( pJobSystem );				break;
+		case BOUNDS_ORIENTED:	oBox.buildOrientedBox( pJobSystem );		break;
+		}
+	}
+
+	double dTime = ( getTime() - dStart ) * 1e9 / ( ( double )iPassNb * g_iPointNb );
+	g_fSink = oBox.left + oBox.sphereRadius + oBox.obbHalfSizes.v[ 0 ];
+	return dTime;
+}
+
+/**
+* @brief returns the largest difference between the planes of two boxes
+*/
+float boxError( const BoundingBox& oReference, const BoundingBox& oBox )
+{
+	float pReference[ 6 ] = { oReference.left, oReference.right, oReference.bottom, oReference.top, oReference.back, oReference.front };
+	float pBox[ 6 ] = { oBox.left, oBox.right, oBox.bottom, oBox.top, oBox.back, oBox.front };
+	float fError = 0.f;
+
+	for( int i = 0; i < 6; ++i )
+		fError = maxT( fError, ( float )fabs( pReference[ i ] - pBox[ i ] ) );
+
+	return fError;
+}
+
+/**
+* @brief returns the largest distance of the vertices to the bounding sphere or oriented box, zero when they all
+* lie inside
+*/
+float containmentError( const MeshVec3Array& vVertices, const BoundingBox& oBox, BoundsMethod eMethod )
+{
+	float fError = 0.f;
+
+	for( size_t i = 0; i < vVertices.size(); ++i )
+	{
+		if( eMethod == BOUNDS_SPHERE )
+		{
+			fError = maxT( fError, ( vVertices[ i ] - oBox.sphereCenter ).length() - oBox.sphereRadius );
+			continue;
+		}
+
+		Vec3 oOffset = vVertices[ i ] - oBox.obbCenter;
+		for( int c = 0; c < 3; ++c )
+			fError = maxT( fError, ( float )fabs( oOffset | oBox.obbAxes[ c ] ) - oBox.obbHalfSizes.v[ c ] );
+	}
+
+	return fError;
+}
+
+/**
+* @brief a benchmark result, for the report
+*/
+struct BenchmarkResult
+{
+	string	sGroup;
+	string	sName;
+	double	dTime;
+	double	dReference;
+	float	fError;
+};
+
+vector< BenchmarkResult >	g_vResults;
+string						g_sGroup;
+
+/**
+* @brief starts a group of results, the variants of an operation
+* @param sGroup the group name
+*/
+void beginGroup( const string& sGroup )
+{
+	g_sGroup = sGroup;
+	cout << sGroup << ":" << endl;
+}
+
+/**
+* @brief prints a benchmark result and adds it to the report
+* @param sName the benchmark name
+* @param dTime the time per operation in nanoseconds
+* @param dReference the time of the reference variant, the first of the group, dTime when there is none
+* @param fError the largest relative error against the reference variant, or the own error of a variant without
+* reference
+*/
+void printResult( const char* sName, double dTime, double dReference, float fError )
+{
+	cout << "  " << left << setw( 30 ) << sName << right << fixed << setprecision( 1 ) << setw( 8 ) << dTime << " ns";
+	if( dTime != dReference )
+		cout << "  (x" << setprecision( 2 ) << dReference / dTime << ", error " << scientific << setprecision( 1 ) << fError << ")";
+	else if( fError != 0.f )
+		cout << "  (error " << scientific << setprecision( 1 ) << fError << ")";
+	cout << endl;
+
+	BenchmarkResult oResult;
+	oResult.sGroup = g_sGroup;
+	oResult.sName = sName;
+	oResult.dTime = dTime;
+	oResult.dReference = dReference;
+	oResult.fError = fError;
+	g_vResults.push_back( oResult );
+}
+
+/**
+* @brief writes the results to a JSON file, the names are written as is and must not contain quotes
+* @param sFilename the file name
+* @param sSimd the instruction set of the SIMD variants
+* @param iCount the number of operations of each benchmark
+* @return false if the file could not be written
+*/
+bool writeReport( const string& sFilename, const string& sSimd, int iCount )
+{
+	ofstream oFile( sFilename.c_str() );
+	if( !oFile )
+		return false;
+
+	oFile << "{" << endl;
+	oFile << "\t\"name\": \"MathBenchmark\"," << endl;
+	oFile << "\t\"simd\": \"" << sSimd << "\"," << endl;
+	oFile << "\t\"count\": " << iCount << "," << endl;
+	oFile << "\t\"results\": [";
+	for( size_t i = 0; i < g_vResults.size(); ++i )
+	{
+		const BenchmarkResult& oResult = g_vResults[ i ];
+		oFile << ( i > 0 ? "," : "" ) << endl << "\t\t{ \"group\": \"" << oResult.sGroup << "\", \"name\": \"" << oResult.sName << "\", "
+			<< fixed << setprecision( 3 ) << "\"ns\": " << oResult.dTime << ", \"speedup\": " << oResult.dReference / oResult.dTime << ", "
+			<< scientific << setprecision( 2 ) << "\"error\": " << oResult.fError << " }";
+	}
+	oFile << endl << "\t]" << endl;
+	oFile << "}" << endl;
+
+	return !oFile.fail();
+}
+
+/**
+* @brief benchmarks a Vec3 operation against the packets
+* @param vA, vB the operands, as arrays of Vec3
+* @param vStreamsA, vStreamsB the operands, as x, y and z streams
+* @param vReference the Vec3 results
+* @param vResults the packets results streams
+* @param iCount the number of operations
+* @return the largest relative error of the packets
+*/
+template< typename Op >
+float benchmarkVec3Operation( const vector< Vec3 >& vA, const vector< Vec3 >& vB, const vector< float >& vStreamsA, const vector< float >& vStreamsB,
+	vector< Vec3 >& vReference, vector< float >& vResults, int iCount )
+{
+	beginGroup( string( "Vec3 " ) + Op::getName() );
+
+	double dReference = benchmarkVec3< Op >( vA, vB, vReference, iCount );
+	printResult( "Vec3", dReference, dReference, 0.f );
+
+	double dTime = benchmarkPackets< Op, Float4 >( vStreamsA, vStreamsB, vResults, iCount );
+	float fError = vec3Error( vReference, vResults );
+	printResult( "Vec3x4 streams", dTime, dReference, fError );
+
+	dTime = benchmarkPackets< Op, Float8 >( vStreamsA, vStreamsB, vResults, iCount );
+	float fError8 = vec3Error( vReference, vResults );
+	printResult( "Vec3x8 streams", dTime, dReference, fError8 );
+
+	return maxT( fError, fError8 );
+}
+
+/**
+* @brief fills x, y and z streams from an array of Vec3
+* @param vVectors the vectors
+* @param vStreams the streams, the x coordinates followed by the y and the z ones
+*/
+void toStreams( const vector< Vec3 >& vVectors, vector< float >& vStreams )
+{
+	int iNb = ( int )vVectors.size();
+	vStreams.resize( 3 * iNb );
+
+	for( int i = 0; i < iNb; ++i )
+		for( int j = 0; j < 3; ++j )
+			vStreams[ j * iNb + i ] = vVectors[ i ].v[ j ];
+}
+
+int main( int argc, char* argv[] )
+{
+	int iCount = 1 << 24;
+	bool bJobs = false;
+	string sReport = "MathBenchmark.json";
+	const float fTolerance = 1e-3f;		// both matrix implementations round in single precision
+	const float fSimdTolerance = 1e-5f;	// the SIMD variants round as the scalar ones but may sum in another order
+
+	for( int i = 1; i < argc; ++i )
+	{
+		if( strcmp( argv[ i ], "-count" ) == 0 && i + 1 < argc )
+			iCount = atoi( argv[ ++i ] );
+		else if( strcmp( argv[ i ], "-jobs" ) == 0 )
+			bJobs = true;
+		else if( strcmp( argv[ i ], "-report" ) == 0 && i + 1 < argc )
+			sReport = argv[ ++i ];
+		else
+		{
+			cout << "usage: MathBenchmark [-count N] [-jobs] [-report file.json]" << endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	const CpuFeatures& oFeatures = CpuFeatures::get();
+	string sSimd = oFeatures.bAVX ? "AVX" : oFeatures.bSSE2 ? "SSE2" : "none";
+	cout << iCount << " operations per benchmark, Matrix4x4 product on " << ( oFeatures.bSSE2 ? sSimd : "the FPU" )
+		<< ", Vec3x8 packets on " << g_pcFloat8Simd << endl;
+
+	srand( 1 );
+
+	// Vec3 operations
+	vector< Vec3 > vA( g_iVectorNb ), vB( g_iVectorNb ), vVec3Reference( g_iVectorNb );
+	for( int i = 0; i < g_iVectorNb; ++i )
+	{
+		vA[ i ] = Vec3( randomFloat( -10.f, 10.f ), randomFloat( -10.f, 10.f ), randomFloat( -10.f, 10.f ) );
+		vB[ i ] = Vec3( randomFloat( -10.f, 10.f ), randomFloat( -10.f, 10.f ), randomFloat( -10.f, 10.f ) );
+	}
+	vector< float > vStreamsA, vStreamsB, vStreamsResult( 3 * g_iVectorNb );
+	toStreams( vA, vStreamsA );
+	toStreams( vB, vStreamsB );
+
+	float fVec3Error = benchmarkVec3Operation< Vec3Add >( vA, vB, vStreamsA, vStreamsB, vVec3Reference, vStreamsResult, iCount );
+	fVec3Error = maxT( fVec3Error, benchmarkVec3Operation< Vec3Dot >( vA, vB, vStreamsA, vStreamsB, vVec3Reference, vStreamsResult, iCount ) );
+	fVec3Error = maxT( fVec3Error, benchmarkVec3Operation< Vec3Cross >( vA, vB, vStreamsA, vStreamsB, vVec3Reference, vStreamsResult, iCount ) );
+	fVec3Error = maxT( fVec3Error, benchmarkVec3Operation< Vec3Normalize >( vA, vB, vStreamsA, vStreamsB, vVec3Reference, vStreamsResult, iCount ) );
+
+	// matrices
+	vector< Matrix4x4 > vRigid( g_iMatrixNb ), vAffine( g_iMatrixNb ), vProjective( g_iMatrixNb );
+	for( int i = 0; i < g_iMatrixNb; ++i )
+	{
+		randomRigid( vRigid[ i ] );
+		randomAffine( vAffine[ i ] );
+		randomProjective( vProjective[ i ] );
+	}
+
+	float fProductError = 0.f;
+	for( int i = 0; i < g_iMatrixNb; ++i )
+		fProductError = maxT( fProductError, maxError( legacyMultiply( vProjective[ i ], vAffine[ i ] ), vProjective[ i ] * vAffine[ i ] ) );
+
+	beginGroup( "Matrix4x4 product" );
+	double dLegacy = benchmarkMultiply( vProjective, iCount, true );
+	printResult( "(row,column) accessor", dLegacy, dLegacy, 0.f );
+	printResult( "operator *", benchmarkMultiply( vProjective, iCount, false ), dLegacy, fProductError );
+
+	float pErrors[ 5 ] = { fProductError, checkInvert( vProjective, INVERT ), checkInvert( vAffine, INVERT_AFFINE ),
+		checkInvert( vRigid, INVERT_RIGID ), checkInvert( vAffine, INVERT ) };
+
+	beginGroup( "Matrix4x4 projective inverse" );
+	dLegacy = benchmarkInvert( vProjective, iCount, INVERT_LEGACY );
+	printResult( "Gauss-Jordan", dLegacy, dLegacy, 0.f );
+	printResult( "invert", benchmarkInvert( vProjective, iCount, INVERT ), dLegacy, pErrors[ 1 ] );
+
+	beginGroup( "Matrix4x4 affine inverse" );
+	dLegacy = benchmarkInvert( vAffine, iCount, INVERT_LEGACY );
+	printResult( "Gauss-Jordan", dLegacy, dLegacy, 0.f );
+	printResult( "invert", benchmarkInvert( vAffine, iCount, INVERT ), dLegacy, pErrors[ 4 ] );
+	printResult( "invertAffine", benchmarkInvert( vAffine, iCount, INVERT_AFFINE ), dLegacy, pErrors[ 2 ] );
+
+	beginGroup( "Matrix4x4 rigid inverse" );
+	dLegacy = benchmarkInvert( vRigid, iCount, INVERT_LEGACY );
+	printResult( "Gauss-Jordan", dLegacy, dLegacy, 0.f );
+	printResult( "invertRigid", benchmarkInvert( vRigid, iCount, INVERT_RIGID ), dLegacy, pErrors[ 3 ] );
+
+	// quaternions
+	vector< Quaternion > vQuaternions( g_iQuaternionNb ), vInterpolated( g_iQuaternionNb ), vSlerp( g_iQuaternionNb );
+	for( int i = 0; i < g_iQuaternionNb; ++i )
+		vQuaternions[ i ].createRotation( randomFloat( -180.f, 180.f ), randomFloat( -1.f, 1.f ), randomFloat( -1.f, 1.f ), randomFloat( 0.1f, 1.f ) );
+	vector< Matrix4x4 > vRotations( g_iQuaternionNb ), vConverted( g_iQuaternionNb );
+
+	beginGroup( "Quaternion to matrix" );
+	dLegacy = benchmarkToMatrix( vQuaternions, vRotations, iCount, false );
+	printResult( "toMatrix loop", dLegacy, dLegacy, 0.f );
+	double dTime = benchmarkToMatrix( vQuaternions, vConverted, iCount, true );
+	float fQuaternionError = 0.f;
+	for( int i = 0; i < g_iQuaternionNb; ++i )
+		fQuaternionError = maxT( fQuaternionError, maxError( vRotations[ i ], vConverted[ i ] ) );
+	printResult( "toMatrices", dTime, dLegacy, fQuaternionError );
+
+	float fCompositionError = 0.f;
+	for( int i = 0; i < g_iMatrixNb; ++i )
+	{
+		Quaternion oComposition = vQuaternions[ i ] * vQuaternions[ i + 1 ];
+		Matrix4x4 oComposed;
+		Quaternion::toMatrices( &oComposition, &oComposed, 1 );
+		fCompositionError = maxT( fCompositionError, maxError( vRotations[ i ] * vRotations[ i + 1 ], oComposed ) );
+	}
+
+	beginGroup( "Rotation composition" );
+	dLegacy = benchmarkMultiply( vRotations, iCount, false );
+	printResult( "Matrix4x4 operator *", dLegacy, dLegacy, 0.f );
+	printResult( "Quaternion operator *", benchmarkQuaternionProduct( vQuaternions, iCount ), dLegacy, fCompositionError );
+
+	beginGroup( "Quaternion interpolation" );
+	dLegacy = benchmarkInterpolation( vQuaternions, vSlerp, iCount, true );
+	printResult( "slerp", dLegacy, dLegacy, 0.f );
+	dTime = benchmarkInterpolation( vQuaternions, vInterpolated, iCount, false );
+	printResult( "nlerp (angle error, rad)", dTime, dLegacy, quaternionError( vSlerp, vInterpolated ) );
+
+	// bounds and batch transforms
+	Matrix4x4 oProjection;
+	randomProjective( oProjection );
+	vector< Vec3 > vPoints( g_iPointNb ), vReference( g_iPointNb ), vResults( g_iPointNb );
+	for( int i = 0; i < g_iPointNb; ++i )
+		vPoints[ i ] = Vec3( randomFloat( -1.f, 1.f ), randomFloat( -1.f, 1.f ), randomFloat( -1.f, 1.f ) );
+	vector< float > vStreams, vResultStreams( 3 * g_iPointNb );
+	toStreams( vPoints, vStreams );
+	const float* ppStreams[ 3 ] = { &vStreams[ 0 ], &vStreams[ g_iPointNb ], &vStreams[ 2 * g_iPointNb ] };
+	float* ppResultStreams[ 3 ] = { &vResultStreams[ 0 ], &vResultStreams[ g_iPointNb ], &vResultStreams[ 2 * g_iPointNb ] };
+
+	JobSystem* pJobSystem = NULL;
+	if( bJobs )
+		pJobSystem = new JobSystem;
+
+	MeshVec3Array vVertices( vPoints.begin(), vPoints.end() );
+	BoundingBox oReferenceBox( vVertices ), oBox( vVertices );
+	beginGroup( "Bounding box, 1M vertices" );
+	dLegacy = benchmarkBounds( vVertices, iCount, BOUNDS_LEGACY, NULL, oReferenceBox );
+	printResult( "former build", dLegacy, dLegacy, 0.f );
+	// each row prints its own error, the largest one is checked against the tolerance
+	dTime = benchmarkBounds( vVertices, iCount, BOUNDS_BOX, NULL, oBox );
+	float fError = boxError( oReferenceBox, oBox );
+	float fBoundsError = fError;
+	printResult( "build", dTime, dLegacy, fError );
+	if( pJobSystem != NULL )
+	{
+		dTime = benchmarkBounds( vVertices, iCount, BOUNDS_BOX, pJobSystem, oBox );
+		fError = boxError( oReferenceBox, oBox );
+		fBoundsError = maxT( fBoundsError, fError );
+		printResult( "build jobs", dTime, dLegacy, fError );
+	}
+
+	// the error is the distance of the farthest vertex outside the volume, there is no former build to compare with
+	beginGroup( "Bounding sphere and oriented box, 1M vertices" );
+	dTime = benchmarkBounds( vVertices, iCount, BOUNDS_SPHERE, NULL, oBox );
+	fError = containmentError( vVertices, oBox, BOUNDS_SPHERE );
+	fBoundsError = maxT( fBoundsError, fError );
+	printResult( "buildSphere", dTime, dTime, fError );
+	dTime = benchmarkBounds( vVertices, iCount, BOUNDS_ORIENTED, NULL, oBox );
+	fError = containmentError( vVertices, oBox, BOUNDS_ORIENTED );
+	fBoundsError = maxT( fBoundsError, fError );
+	printResult( "buildOrientedBox", dTime, dTime, fError );
+	if( pJobSystem != NULL )
+	{
+		dTime = benchmarkBounds( vVertices, iCount, BOUNDS_SPHERE, pJobSystem, oBox );
+		fError = containmentError( vVertices, oBox, BOUNDS_SPHERE );
+		fBoundsError = maxT( fBoundsError, fError );
+		printResult( "buildSphere jobs", dTime, dTime, fError );
+		dTime = benchmarkBounds( vVertices, iCount, BOUNDS_ORIENTED, pJobSystem, oBox );
+		fError = containmentError( vVertices, oBox, BOUNDS_ORIENTED );
+		fBoundsError = maxT( fBoundsError, fError );
+		printResult( "buildOrientedBox jobs", dTime, dTime, fError );
+	}
+
+	beginGroup( "Point transform, 1M points" );
+	dLegacy = benchmarkBatch( oProjection, vPoints, ppStreams, vReference, ppResultStreams, iCount, BATCH_LOOP, NULL );
+	printResult( "Vec3 product loop", dLegacy, dLegacy, 0.f );
+	dTime = benchmarkBatch( oProjection, vPoints, ppStreams, vResults, ppResultStreams, iCount, BATCH_POINTS, NULL );
+	float fBatchError = batchError( vReference, vResults, NULL );
+	printResult( "transformPoints", dTime, dLegacy, fBatchError );
+	dTime = benchmarkBatch( oProjection, vPoints, ppStreams, vResults, ppResultStreams, iCount, BATCH_STREAMS, NULL );
+	fBatchError = maxT( fBatchError, batchError( vReference, vResults, ppResultStreams ) );
+	printResult( "transformPoints streams", dTime, dLegacy, fBatchError );
+	if( pJobSystem != NULL )
+	{
+		dTime = benchmarkBatch( oProjection, vPoints, ppStreams, vResults, ppResultStreams, iCount, BATCH_POINTS, pJobSystem );
+		fBatchError = maxT( fBatchError, batchError( vReference, vResults, NULL ) );
+		printResult( "transformPoints jobs", dTime, dLegacy, fBatchError );
+		dTime = benchmarkBatch( oProjection, vPoints, ppStreams, vResults, ppResultStreams, iCount, BATCH_STREAMS, pJobSystem );
+		fBatchError = maxT( fBatchError, batchError( vReference, vResults, ppResultStreams ) );
+		printResult( "transformPoints streams jobs", dTime, dLegacy, fBatchError );
+	}
+
+	beginGroup( "Point projection, 1M points" );
+	dLegacy = benchmarkBatch( oProjection, vPoints, ppStreams, vReference, ppResultStreams, iCount, BATCH_PROJECT_LOOP, NULL );
+	printResult( "+ operator loop", dLegacy, dLegacy, 0.f );
+	dTime = benchmarkBatch( oProjection, vPoints, ppStreams, vResults, ppResultStreams, iCount, BATCH_PROJECT, NULL );
+	fBatchError = maxT( fBatchError, batchError( vReference, vResults, NULL ) );
+	printResult( "projectPoints", dTime, dLegacy, fBatchError );
+	if( pJobSystem != NULL )
+	{
+		dTime = benchmarkBatch( oProjection, vPoints, ppStreams, vResults, ppResultStreams, iCount, BATCH_PROJECT, pJobSystem );
+		fBatchError = maxT( fBatchError, batchError( vReference, vResults, NULL ) );
+		printResult( "projectPoints jobs", dTime, dLegacy, fBatchError );
+
+		delete pJobSystem;
+	}
+
+	if( !writeReport( sReport, sSimd, iCount ) )
+	{
+		cout << "Error! failed to write the report " << sReport << endl;
+		return EXIT_FAILURE;
+	}
+	cout << "Report written to " << sReport << endl;
+
+	if( !( fBatchError <= 1e-6f ) )
+	{
+		cout << "Error! the batch transforms differ from the Vec3 operators by more than " << 1e-6f << endl;
+		return EXIT_FAILURE;
+	}
+
+	float pSimdErrors[ 4 ] = { fVec3Error, fQuaternionError, fCompositionError, fBoundsError };
+	for( int i = 0; i < 4; ++i )
+	{
+		if( !( pSimdErrors[ i ] <= fSimdTolerance ) )
+		{
+			cout << "Error! the SIMD variants differ from the scalar ones by more than " << fSimdTolerance << endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	for( int i = 0; i < 5; ++i )
+	{
+		if( !( pErrors[ i ] <= fTolerance ) )
+		{
+			cout << "Error! the results differ from the former implementation by more than " << fTolerance << endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
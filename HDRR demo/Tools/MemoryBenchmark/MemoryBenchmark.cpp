@@ -0,0 +1,229 @@
+/**
+* MemoryBenchmark: measures the overhead of the tracked allocations of the Core classes against the global
+* operator new and against the former std::map tracker, single threaded and with one thread per processor.
+*
+* usage: MemoryBenchmark [-count N] [-threads N]
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <vector>
+
+#ifdef WIN32
+#include <Windows.h>
+#endif
+
+#include <GL/glfw.h>
+#include "Core.h"
+
+using namespace std;
+using namespace Oglf;
+
+
+const int g_iBatchSize = 256;	// objects allocated before being freed, so that the allocator does not only recycle one block
+
+/**
+* @brief a small object allocated with the global operator new
+*/
+struct PlainObject
+{
+	float pData[ 12 ];
+};
+
+/**
+* @brief the same object whose allocations are tracked
+*/
+struct TrackedObject : public Core< MEMORY_MESH >
+{
+	float pData[ 12 ];
+};
+
+/**
+* @brief the same object tracked the way Core did before: every allocation is inserted in a global map
+*/
+struct MapTrackedObject
+{
+	static map< char*, size_t >	s_mAllocations;
+	static size_t				s_iAllocatedBytes;
+
+	float pData[ 12 ];
+
+	void* operator new( size_t size )
+	{
+		char* pData = ( char* )malloc( size );
+		if( pData == NULL )
+			throw bad_alloc();
+
+		s_mAllocations[ pData ] = size;
+		s_iAllocatedBytes += size;
+		return pData;
+	}
+
+	void operator delete( void* data )
+	{
+		map< char*, size_t >::iterator it = s_mAllocations.find( ( char* )data );
+		if( it != s_mAllocations.end() )
+		{
+			s_iAllocatedBytes -= it->second;
+			s_mAllocations.erase( it );
+		}
+		free( data );
+	}
+};
+
+map< char*, size_t >	MapTrackedObject::s_mAllocations;
+size_t					MapTrackedObject::s_iAllocatedBytes = 0;
+
+/**
+* @brief the work of a benchmark thread
+*/
+struct BenchmarkJob
+{
+	int		iObjectNb;
+	void	( *pRun )( int );
+};
+
+/**
+* @brief allocates and frees objects by batches
+* @param iObjectNb the number of objects to allocate
+*/
+template< typename T >
+void allocateObjects( int iObjectNb )
+{
+	T* pObjects[ g_iBatchSize ];
+
+	for( int i = 0; i < iObjectNb; i += g_iBatchSize )
+	{
+		for( int j = 0; j < g_iBatchSize; ++j )
+			pObjects[ j ] = new T;
+		for( int j = 0; j < g_iBatchSize; ++j )
+			delete pObjects[ j ];
+	}
+}
+
+/**
+* @brief benchmark thread
+* @param pData the benchmark job
+*/
+void GLFWCALL benchmarkThread( void* pData )
+{
+	BenchmarkJob* pJob = ( BenchmarkJob* )pData;
+	pJob->pRun( pJob->iObjectNb );
+}
+
+/**
+* @brief runs a benchmark on several threads and returns its time per allocation and free pair
+* @param pRun the benchmark function
+* @param iObjectNb the number of objects allocated by each thread
+* @param iThreadNb the number of threads, the calling thread is used when 1
+* @return the time in nanoseconds
+*/
+double runBenchmark( void ( *pRun )( int ), int iObjectNb, int iThreadNb )
+{
+	BenchmarkJob oJob;
+	oJob.iObjectNb = iObjectNb;
+	oJob.pRun = pRun;
+
+	// warm up the allocator and the thread counters
+	pRun( g_iBatchSize );
+
+	double dStart = glfwGetTime();
+
+	if( iThreadNb == 1 )
+		pRun( iObjectNb );
+	else
+	{
+		vector< GLFWthread > vThreads;
+		for( int i = 0; i < iThreadNb; ++i )
+			vThreads.push_back( glfwCreateThread( benchmarkThread, &oJob ) );
+		for( int i = 0; i < iThreadNb; ++i )
+			glfwWaitThread( vThreads[ i ], GLFW_WAIT );
+	}
+
+	return ( glfwGetTime() - dStart ) * 1e9 / ( ( double )iObjectNb * iThreadNb );
+}
+
+/**
+* @brief prints a benchmark result
+* @param sName the benchmark name
+* @param dTime the time per allocation and free pair in nanoseconds
+* @param dReference the time of the untracked allocations
+*/
+void printResult( const char* sName, double dTime, double dReference )
+{
+	cout << "  " << left << setw( 20 ) << sName << right << fixed << setprecision( 1 ) << setw( 8 ) << dTime << " ns";
+	if( dTime != dReference )
+		cout << "  (+" << dTime - dReference << " ns, x" << setprecision( 2 ) << dTime / dReference << ")";
+	cout << endl;
+}
+
+int main( int argc, char* argv[] )
+{
+	int iObjectNb = 1 << 22;
+	int iThreadNb = 0;
+
+	for( int i = 1; i < argc; ++i )
+	{
+		if( strcmp( argv[ i ], "-count" ) == 0 && i + 1 < argc )
+			iObjectNb = atoi( argv[ ++i ] );
+		else if( strcmp( argv[ i ], "-threads" ) == 0 && i + 1 < argc )
+			iThreadNb = atoi( argv[ ++i ] );
+		else
+		{
+			cout << "usage: MemoryBenchmark [-count N] [-threads N]" << endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	if( glfwInit() != GL_TRUE )
+	{
+		cout << "Error! failed to initialize GLFW" << endl;
+		return EXIT_FAILURE;
+	}
+
+	if( iThreadNb <= 0 )
+		iThreadNb = glfwGetNumberOfProcessors();
+	iObjectNb = max( g_iBatchSize, iObjectNb / g_iBatchSize * g_iBatchSize );
+
+	MemoryStats oStartStats;
+	MemoryTracker::getStats( oStartStats );
+
+	cout << iObjectNb << " allocations of " << sizeof( TrackedObject ) << " bytes objects" << endl;
+
+	cout << "1 thread:" << endl;
+	double dPlain = runBenchmark( allocateObjects< PlainObject >, iObjectNb, 1 );
+	printResult( "operator new", dPlain, dPlain );
+	printResult( "Core", runBenchmark( allocateObjects< TrackedObject >, iObjectNb, 1 ), dPlain );
+	printResult( "std::map tracker", runBenchmark( allocateObjects< MapTrackedObject >, iObjectNb, 1 ), dPlain );
+
+	// the map tracker is not thread safe and is only measured on one thread
+	cout << iThreadNb << ( iThreadNb > 1 ? " threads:" : " thread:" ) << endl;
+	dPlain = runBenchmark( allocateObjects< PlainObject >, iObjectNb, iThreadNb );
+	printResult( "operator new", dPlain, dPlain );
+	printResult( "Core", runBenchmark( allocateObjects< TrackedObject >, iObjectNb, iThreadNb ), dPlain );
+
+	MemoryStats oStats;
+	MemoryTracker::getStats( oStats );
+
+	size_t iAllocationNb = oStats.pTotalAllocationNb[ MEMORY_MESH ] - oStartStats.pTotalAllocationNb[ MEMORY_MESH ];
+	cout << "Tracked " << iAllocationNb << " " << MemoryTracker::getCategoryName( MEMORY_MESH ) << " allocations on "
+		<< oStats.iThreadNb << " threads, " << oStats.pAllocationNb[ MEMORY_MESH ] << " live, "
+		<< oStats.pAllocatedBytes[ MEMORY_MESH ] << " bytes allocated" << endl;
+
+	glfwTerminate();
+
+	// every run allocates a batch on the calling thread to warm up
+	size_t iExpectedNb = ( size_t )iObjectNb * ( iThreadNb + 1 ) + 2 * g_iBatchSize;
+	if( iAllocationNb != iExpectedNb || oStats.pAllocationNb[ MEMORY_MESH ] != oStartStats.pAllocationNb[ MEMORY_MESH ] ||
+		oStats.pAllocatedBytes[ MEMORY_MESH ] != oStartStats.pAllocatedBytes[ MEMORY_MESH ] )
+	{
+		cout << "Error! the tracked allocations do not match, " << iExpectedNb << " expected" << endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,164 @@
+/**
+* MeshImportBenchmark: imports an OBJ file with Mesh::importOBJ() and reports the import time, the number of
+* heap allocations and the peak memory of the process. It can generate a test grid mesh of a given triangle count.
+*
+* usage: MeshImportBenchmark <input.obj>
+*        MeshImportBenchmark -generate <triangles> <output.obj>
+*/
+
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <new>
+#include <GL/glew.h>
+
+#ifdef WIN32
+#include <Windows.h>
+#include <Psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include <GL/glfw.h>
+#include "Mesh.h"
+#include "Error.h"
+
+using namespace std;
+using namespace Oglf;
+
+
+// heap allocations made with the global operator new, by the standard containers in particular
+static size_t g_iAllocationNb = 0;
+
+void* operator new( size_t iSize )
+{
+	++g_iAllocationNb;
+
+	void* pData = malloc( iSize > 0 ? iSize : 1 );
+	if( pData == NULL )
+		throw bad_alloc();
+
+	return pData;
+}
+
+void operator delete( void* pData )
+{
+	free( pData );
+}
+
+/**
+* @brief returns the peak memory used by the process
+* @return the peak resident memory in KB
+*/
+size_t getPeakMemory()
+{
+#ifdef WIN32
+	PROCESS_MEMORY_COUNTERS oCounters;
+	GetProcessMemoryInfo( GetCurrentProcess(), &oCounters, sizeof( oCounters ) );
+	return oCounters.PeakWorkingSetSize / 1024;
+#else
+	struct rusage oUsage;
+	getrusage( RUSAGE_SELF, &oUsage );
+	return ( size_t )oUsage.ru_maxrss;
+#endif
+}
+
+/**
+* @brief writes a grid mesh with texture coordinates
+* @param iTriangleNb the minimum number of triangles
+* @param sFilename the obj file
+*/
+void generateGrid( int iTriangleNb, const char* sFilename )
+{
+	ofstream oFile( sFilename );
+	if( !oFile )
+		throw Error( "MeshImportBenchmark error : Failed to create the obj file", sFilename );
+
+	int iSize = ( int )ceil( sqrt( iTriangleNb / 2.0 ) );
+
+	oFile << "# " << iSize << "x" << iSize << " grid" << endl;
+	for( int y = 0; y <= iSize; ++y )
+		for( int x = 0; x <= iSize; ++x )
+			oFile << "v " << x << " " << sin( x * 0.1f ) * cos( y * 0.1f ) << " " << y << "\n";
+	for( int y = 0; y <= iSize; ++y )
+		for( int x = 0; x <= iSize; ++x )
+			oFile << "vt " << ( float )x / iSize << " " << ( float )y / iSize << "\n";
+
+	for( int y = 0; y < iSize; ++y )
+	{
+		for( int x = 0; x < iSize; ++x )
+		{
+			int i0 = y * ( iSize + 1 ) + x + 1;
+			int i1 = i0 + 1;
+			int i2 = i0 + iSize + 1;
+			int i3 = i2 + 1;
+
+			oFile << "f " << i0 << "/" << i0 << " " << i2 << "/" << i2 << " " << i1 << "/" << i1 << "\n";
+			oFile << "f " << i1 << "/" << i1 << " " << i2 << "/" << i2 << " " << i3 << "/" << i3 << "\n";
+		}
+	}
+
+	cout << "Written " << sFilename << ": " << 2 * iSize * iSize << " triangles" << endl;
+}
+
+int main( int argc, char* argv[] )
+{
+	if( !( argc == 2 || ( argc == 4 && strcmp( argv[ 1 ], "-generate" ) == 0 ) ) )
+	{
+		cout << "usage: MeshImportBenchmark <input.obj>" << endl;
+		cout << "       MeshImportBenchmark -generate <triangles> <output.obj>" << endl;
+		return EXIT_FAILURE;
+	}
+
+	if( glfwInit() != GL_TRUE )
+	{
+		cout << "Error! failed to initialize GLFW" << endl;
+		return EXIT_FAILURE;
+	}
+
+	try
+	{
+		if( argc == 4 )
+		{
+			generateGrid( atoi( argv[ 2 ] ), argv[ 3 ] );
+		}
+		else
+		{
+			size_t iStartMemory = getPeakMemory();
+			size_t iStartAllocationNb = g_iAllocationNb;
+			MemoryStats oStartStats;
+			MemoryTracker::getStats( oStartStats );
+
+			double dStart = glfwGetTime();
+
+			Mesh* pMesh = new Mesh( "benchmark" );
+			pMesh->importOBJ( argv[ 1 ] );
+
+			double dTime = glfwGetTime() - dStart;
+
+			MemoryStats oStats;
+			MemoryTracker::getStats( oStats );
+
+			cout << "Imported in " << dTime * 1000.0 << " ms" << endl;
+			cout << "Allocations: " << g_iAllocationNb - iStartAllocationNb << " operator new, "
+				<< oStats.pTotalAllocationNb[ MEMORY_MESH ] - oStartStats.pTotalAllocationNb[ MEMORY_MESH ] << " tracked "
+				<< MemoryTracker::getCategoryName( MEMORY_MESH ) << " allocations" << endl;
+			cout << "Mesh memory: " << oStats.pAllocatedBytes[ MEMORY_MESH ] / 1024 << " KB" << endl;
+			cout << "Peak RSS: " << getPeakMemory() << " KB (" << iStartMemory << " KB before the import)" << endl;
+
+			delete pMesh;
+		}
+	}
+	catch( Error e )
+	{
+		e.showError();
+		glfwTerminate();
+		return EXIT_FAILURE;
+	}
+
+	glfwTerminate();
+
+	return EXIT_SUCCESS;
+}
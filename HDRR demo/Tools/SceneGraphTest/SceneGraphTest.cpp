@@ -0,0 +1,164 @@
+/**
+* SceneGraphTest: checks the world matrices, the parents and the node handles of the SceneGraph through the
+* sequences that reorder its node array: reparenting a node under a later one, removing nodes before and after
+* the array is sorted again, and reusing the handles of the removed nodes. Prints each failed check and returns
+* a failure when any check fails.
+*
+* usage: SceneGraphTest
+*/
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+
+#include "SceneGraph.h"
+#include "Error.h"
+
+using namespace std;
+using namespace Oglf;
+
+
+int g_iFailedNb = 0;
+
+/**
+* @brief counts and prints a failed check
+* @param bSuccess the check result
+* @param pcCheck the check description
+*/
+void check( bool bSuccess, const char* pcCheck )
+{
+	if( bSuccess )
+		return;
+
+	cout << "Failed: " << pcCheck << endl;
+	++g_iFailedNb;
+}
+
+/**
+* @brief compares two matrices
+* @return true when their elements are equal up to the float rounding errors
+*/
+bool equals( const Matrix4x4& oMatrix1, const Matrix4x4& oMatrix2 )
+{
+	for( int i = 0; i < 16; ++i )
+	{
+		if( fabs( oMatrix1.m[ i ] - oMatrix2.m[ i ] ) > 1e-4f )
+			return false;
+	}
+
+	return true;
+}
+
+/**
+* @brief returns the local matrix of a node
+*/
+Matrix4x4 local( SceneGraph& oGraph, int iNode )
+{
+	return oGraph.getLocalTransform( iNode ).getTransformMatrix();
+}
+
+/**
+* @brief updates a hierarchy and changes it: a local transform, a parent after its child, then a removed node
+*/
+void testHierarchy()
+{
+	SceneGraph oGraph;
+	int r = oGraph.addNode();
+	int a = oGraph.addNode( r );
+	int b = oGraph.addNode( a );
+	int c = oGraph.addNode( r );
+	oGraph.getLocalTransform( r ).translate( 1.f, 0.f, 0.f );
+	oGraph.getLocalTransform( a ).rotate( 0.5f, 0.f, 0.f );
+	oGraph.getLocalTransform( b ).translate( 0.f, 2.f, 0.f );
+	oGraph.getLocalTransform( c ).uniformScale( 2.f );
+
+	oGraph.update();
+	check( oGraph.getUpdatedNb() == 4, "the first update computes every node" );
+	check( equals( oGraph.getWorldMatrix( b ), local( oGraph, r ) * local( oGraph, a ) * local( oGraph, b ) ), "world matrix of a grandchild" );
+
+	oGraph.update();
+	check( oGraph.getUpdatedNb() == 0, "an update without change computes no node" );
+
+	oGraph.getLocalTransform( a ).translate( 0.f, 0.f, 1.f );
+	oGraph.update();
+	check( oGraph.getUpdatedNb() == 2, "a changed node updates its subtree only" );
+	check( oGraph.hasChanged( b ) && !oGraph.hasChanged( c ), "changed flags of the subtree" );
+
+	// c comes after a in the array: the nodes are sorted by the update
+	oGraph.setParent( a, c );
+	oGraph.update();
+	check( oGraph.getParent( a ) == c && oGraph.getParent( b ) == a, "parents after setParent()" );
+	check( oGraph.getNodePosition( c ) < oGraph.getNodePosition( a ) && oGraph.getNodePosition( a ) < oGraph.getNodePosition( b ), "parents before their children" );
+	check( equals( oGraph.getWorldMatrix( b ), local( oGraph, r ) * local( oGraph, c ) * local( oGraph, a ) * local( oGraph, b ) ), "world matrix after setParent()" );
+
+	bool bThrown = false;
+	try
+	{
+		oGraph.setParent( c, b );
+	}
+	catch( Error& )
+	{
+		bThrown = true;
+	}
+	check( bThrown, "setParent() under a descendant throws" );
+
+	oGraph.removeNode( a );
+	oGraph.update();
+	check( oGraph.getNodeNb() == 3 && oGraph.getParent( b ) == c, "children of a removed node attached to its parent" );
+	check( equals( oGraph.getWorldMatrix( b ), local( oGraph, r ) * local( oGraph, c ) * local( oGraph, b ) ), "world matrix after removeNode()" );
+
+	int d = oGraph.addNode( b );
+	oGraph.update();
+	check( d == a, "the handle of a removed node is reused" );
+	check( equals( oGraph.getWorldMatrix( d ), oGraph.getWorldMatrix( b ) ), "world matrix of a node added to a reused handle" );
+}
+
+/**
+* @brief removes a node which a former node was just reparented under, before the array is sorted again
+*/
+void testRemoveAfterSetParent()
+{
+	SceneGraph oGraph;
+	int a = oGraph.addNode();
+	int b = oGraph.addNode();
+	int c = oGraph.addNode( b );
+	oGraph.getLocalTransform( a ).translate( 3.f, 0.f, 0.f );
+	oGraph.getLocalTransform( b ).translate( 0.f, 5.f, 0.f );
+	oGraph.getLocalTransform( c ).translate( 0.f, 0.f, 7.f );
+	oGraph.update();
+
+	// a is a child of b while it is still before b in the array
+	oGraph.setParent( a, b );
+	oGraph.removeNode( b );
+	oGraph.update();
+
+	check( oGraph.getNodeNb() == 2, "nodes left after removing the new parent" );
+	check( oGraph.getParent( a ) == -1 && oGraph.getParent( c ) == -1, "children of the removed parent become roots" );
+	check( oGraph.getNodePosition( a ) != oGraph.getNodePosition( c ), "the remaining nodes keep their own positions" );
+	check( equals( oGraph.getWorldMatrix( a ), local( oGraph, a ) ), "world matrix of the node reparented then orphaned" );
+	check( equals( oGraph.getWorldMatrix( c ), local( oGraph, c ) ), "world matrix of the child of the removed node" );
+	check( fabs( oGraph.getWorldMatrix( a ).m[ 12 ] - 3.f ) < 1e-4f, "translation of the node reparented then orphaned" );
+}
+
+int main()
+{
+	try
+	{
+		testHierarchy();
+		testRemoveAfterSetParent();
+	}
+	catch( Error& e )
+	{
+		cout << "Failed: " << e.getMessage() << endl;
+		++g_iFailedNb;
+	}
+
+	if( g_iFailedNb > 0 )
+	{
+		cout << g_iFailedNb << " checks failed" << endl;
+		return EXIT_FAILURE;
+	}
+
+	cout << "All the checks passed" << endl;
+	return EXIT_SUCCESS;
+}